@@ -0,0 +1,376 @@
+#include <ArrayFile.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Math
+{
+	namespace
+	{
+		// "SMAF" read as a little-endian integer
+		constexpr uint32_t k_magic = 0x46414D53u;
+		constexpr uint32_t k_version = 1;
+		constexpr uint64_t k_alignment = 64;
+		// Most scalars gathered per write of an SoA stream
+		constexpr size_t k_scatterBlockSize = 16384;
+
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t arrayCount;
+			uint64_t reserved[6];
+		};
+
+		struct ArrayHeader
+		{
+			uint32_t type;
+			uint32_t layout;
+			uint64_t count;
+			// Bytes between SoA component streams, zero for AoS arrays
+			uint64_t componentStride;
+			// Bytes of element data following the header, including padding
+			uint64_t dataSize;
+			uint64_t reserved[4];
+		};
+
+		static_assert(sizeof(FileHeader) == k_alignment, "File header must keep arrays aligned");
+		static_assert(sizeof(ArrayHeader) == k_alignment, "Array header must keep element data aligned");
+		static_assert(sizeof(Vector3f) == 3 * sizeof(float) && sizeof(Quaternionf) == 4 * sizeof(float)
+			&& sizeof(Matrix3x3f) == 9 * sizeof(float) && sizeof(Matrix4x4d) == 16 * sizeof(double),
+			"Elements are stored in their in-memory layout");
+
+		uint64_t AlignUp(const uint64_t n)
+		{
+			return (n + k_alignment - 1) / k_alignment * k_alignment;
+		}
+
+		// Scalar size and component count of type, or false for an unknown type
+		bool GetElementFormat(const uint32_t type, size_t& scalarSize, int& componentCount)
+		{
+			static const int k_componentCounts[] = { 2, 3, 4, 4, 9, 16 };
+			if (type < static_cast<uint32_t>(ArrayElementType::Vector2f) || type > static_cast<uint32_t>(ArrayElementType::Matrix4x4d))
+			{
+				return false;
+			}
+			const uint32_t i = type - static_cast<uint32_t>(ArrayElementType::Vector2f);
+			scalarSize = i < 6 ? sizeof(float) : sizeof(double);
+			componentCount = k_componentCounts[i % 6];
+			return true;
+		}
+
+		// Bytes of element data an array takes, and the stride of its SoA streams
+		void GetDataSize(const ArrayLayout layout, const uint64_t count, const size_t scalarSize, const int componentCount,
+			uint64_t& componentStride, uint64_t& dataSize)
+		{
+			if (layout == ArrayLayout::SoA)
+			{
+				componentStride = AlignUp(count * scalarSize);
+				dataSize = componentStride * componentCount;
+			}
+			else
+			{
+				componentStride = 0;
+				dataSize = AlignUp(count * scalarSize * componentCount);
+			}
+		}
+	}
+
+	ArrayFileReader::~ArrayFileReader()
+	{
+		Close();
+	}
+
+	bool ArrayFileReader::Open(const char* path)
+	{
+		Close();
+
+#if defined(_WIN32)
+		HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader)))
+		{
+			CloseHandle(fileHandle);
+			return false;
+		}
+		// The view keeps the mapping alive once both handles are closed
+		HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(fileHandle);
+		if (mappingHandle == nullptr)
+		{
+			return false;
+		}
+		const void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mappingHandle);
+		if (view == nullptr)
+		{
+			return false;
+		}
+		mapping = static_cast<const uint8_t*>(view);
+		size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		const int descriptor = open(path, O_RDONLY);
+		if (descriptor < 0)
+		{
+			return false;
+		}
+		struct stat status;
+		if (fstat(descriptor, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(FileHeader)))
+		{
+			close(descriptor);
+			return false;
+		}
+		// The mapping outlives the descriptor
+		void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+		close(descriptor);
+		if (view == MAP_FAILED)
+		{
+			return false;
+		}
+		mapping = static_cast<const uint8_t*>(view);
+		size = static_cast<size_t>(status.st_size);
+#endif
+
+		FileHeader header;
+		std::memcpy(&header, mapping, sizeof(header));
+		if (header.magic != k_magic || header.version != k_version)
+		{
+			Close();
+			return false;
+		}
+
+		// Walk the array headers, checking every array lies within the file
+		arrays.reserve(static_cast<size_t>(std::min<uint64_t>(header.arrayCount, size / sizeof(ArrayHeader))));
+		uint64_t offset = sizeof(FileHeader);
+		for (uint64_t a = 0; a < header.arrayCount; ++a)
+		{
+			if (size - offset < sizeof(ArrayHeader))
+			{
+				Close();
+				return false;
+			}
+			ArrayHeader arrayHeader;
+			std::memcpy(&arrayHeader, mapping + offset, sizeof(arrayHeader));
+			offset += sizeof(ArrayHeader);
+
+			size_t scalarSize;
+			int componentCount;
+			if (!GetElementFormat(arrayHeader.type, scalarSize, componentCount) || arrayHeader.layout > static_cast<uint32_t>(ArrayLayout::SoA)
+				|| arrayHeader.count > size / (scalarSize * componentCount))
+			{
+				Close();
+				return false;
+			}
+			const ArrayLayout layout = static_cast<ArrayLayout>(arrayHeader.layout);
+			uint64_t componentStride;
+			uint64_t dataSize;
+			GetDataSize(layout, arrayHeader.count, scalarSize, componentCount, componentStride, dataSize);
+			if (arrayHeader.componentStride != componentStride || arrayHeader.dataSize != dataSize || size - offset < dataSize)
+			{
+				Close();
+				return false;
+			}
+
+			const ArrayInfo info = { static_cast<ArrayElementType>(arrayHeader.type), layout, arrayHeader.count };
+			arrays.push_back({ info, mapping + offset, componentStride });
+			offset += dataSize;
+		}
+		return true;
+	}
+
+	void ArrayFileReader::Close()
+	{
+		if (mapping != nullptr)
+		{
+#if defined(_WIN32)
+			UnmapViewOfFile(mapping);
+#else
+			munmap(const_cast<uint8_t*>(mapping), size);
+#endif
+		}
+		mapping = nullptr;
+		size = 0;
+		arrays.clear();
+	}
+
+	ArrayFileWriter::~ArrayFileWriter()
+	{
+		Close();
+	}
+
+	bool ArrayFileWriter::Open(const char* path)
+	{
+		Close();
+		file = std::fopen(path, "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+		std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+		failed = false;
+		inArray = false;
+		arrayCount = 0;
+		// The header is written again with the array count on Close
+		const FileHeader header = { k_magic, k_version, 0, {} };
+		failed = std::fwrite(&header, sizeof(header), 1, file) != 1;
+		end = sizeof(FileHeader);
+		return !failed;
+	}
+
+	bool ArrayFileWriter::Close()
+	{
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		const FileHeader header = { k_magic, k_version, arrayCount, {} };
+		if (!failed && Seek(0))
+		{
+			failed = std::fwrite(&header, sizeof(header), 1, file) != 1;
+		}
+		failed = std::fclose(file) != 0 || failed;
+		file = nullptr;
+		inArray = false;
+		scratch.clear();
+		scratch.shrink_to_fit();
+		return !failed;
+	}
+
+	bool ArrayFileWriter::BeginArray(const ArrayElementType type, const ArrayLayout layout, const uint64_t count)
+	{
+		assert(file != nullptr && !inArray);
+		if (failed)
+		{
+			return false;
+		}
+
+		size_t scalarSize = 0;
+		int componentCount = 0;
+		const bool known = GetElementFormat(static_cast<uint32_t>(type), scalarSize, componentCount);
+		assert(known);
+		(void)known;
+		uint64_t dataSize;
+		GetDataSize(layout, count, scalarSize, componentCount, componentStride, dataSize);
+
+		const ArrayHeader header = { static_cast<uint32_t>(type), static_cast<uint32_t>(layout), count, componentStride, dataSize, {} };
+		if (!Seek(end) || std::fwrite(&header, sizeof(header), 1, file) != 1)
+		{
+			failed = true;
+			return false;
+		}
+		current = { type, layout, count };
+		appended = 0;
+		dataOffset = end + sizeof(ArrayHeader);
+		end = dataOffset + dataSize;
+		inArray = true;
+		return true;
+	}
+
+	bool ArrayFileWriter::Append(const void* elements, const size_t n, const size_t scalarSize, const int componentCount)
+	{
+		assert(inArray && appended + n <= current.count);
+		assert(elements != nullptr || n == 0);
+		if (failed)
+		{
+			return false;
+		}
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(elements);
+		const size_t elementSize = scalarSize * componentCount;
+		if (current.layout == ArrayLayout::AoS)
+		{
+			// Elements are appended in order, so this continues the previous write
+			failed = std::fwrite(bytes, elementSize, n, file) != n;
+		}
+		else
+		{
+			// Gather each component in blocks and write it to the end of its stream
+			scratch.resize(std::min(n, k_scatterBlockSize) * scalarSize);
+			for (int c = 0; c < componentCount && !failed; ++c)
+			{
+				failed = !Seek(dataOffset + c * componentStride + appended * scalarSize);
+				for (size_t first = 0; first < n && !failed; first += k_scatterBlockSize)
+				{
+					const size_t last = std::min(n, first + k_scatterBlockSize);
+					for (size_t i = first; i < last; ++i)
+					{
+						std::memcpy(&scratch[(i - first) * scalarSize], bytes + i * elementSize + c * scalarSize, scalarSize);
+					}
+					failed = std::fwrite(scratch.data(), scalarSize, last - first, file) != last - first;
+				}
+			}
+		}
+		appended += n;
+		return !failed;
+	}
+
+	bool ArrayFileWriter::EndArray()
+	{
+		assert(inArray && appended == current.count);
+		inArray = false;
+		if (failed)
+		{
+			return false;
+		}
+
+		size_t scalarSize = 0;
+		int componentCount = 0;
+		GetElementFormat(static_cast<uint32_t>(current.type), scalarSize, componentCount);
+		if (current.layout == ArrayLayout::AoS)
+		{
+			WriteZeros(end - (dataOffset + current.count * scalarSize * componentCount));
+		}
+		else
+		{
+			const uint64_t streamSize = current.count * scalarSize;
+			for (int c = 0; c < componentCount && !failed; ++c)
+			{
+				if (Seek(dataOffset + c * componentStride + streamSize))
+				{
+					WriteZeros(componentStride - streamSize);
+				}
+			}
+		}
+		++arrayCount;
+		return !failed;
+	}
+
+	bool ArrayFileWriter::Seek(const uint64_t offset)
+	{
+#if defined(_WIN32)
+		failed = _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) != 0 || failed;
+#else
+		failed = fseeko(file, static_cast<off_t>(offset), SEEK_SET) != 0 || failed;
+#endif
+		return !failed;
+	}
+
+	bool ArrayFileWriter::WriteZeros(uint64_t n)
+	{
+		static const uint8_t k_zeros[k_alignment] = {};
+		while (n > 0 && !failed)
+		{
+			const size_t chunk = static_cast<size_t>(std::min<uint64_t>(n, sizeof(k_zeros)));
+			failed = std::fwrite(k_zeros, 1, chunk, file) != chunk;
+			n -= chunk;
+		}
+		return !failed;
+	}
+}
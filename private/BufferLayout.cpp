@@ -0,0 +1,189 @@
+#include <BufferLayout.h>
+
+#include <Parallel.h>
+
+#include <cstring>
+
+#include "Simd.h"
+
+namespace Math
+{
+	static_assert(sizeof(Vector2f) == 8 && sizeof(Vector3f) == 12 && sizeof(Vector4f) == 16, "Float vectors must be tightly packed");
+	static_assert(sizeof(Matrix3x3f) == 36 && sizeof(Matrix4x4f) == 64, "Float matrices must be tightly packed");
+
+	namespace
+	{
+		// Writes count matrices stored as 3 contiguous major vectors, each padded to a
+		// vec4. With transpose set, the minor vectors are written instead.
+		void WriteMatrices3(const float* src, size_t count, bool transpose, float* out)
+		{
+			const Simd::Float4 zero = Simd::Zero();
+			for (size_t i = 0; i < count; ++i, src += 9, out += 12)
+			{
+				// The last vector is loaded from the tail of the matrix, so a full
+				// vector load never reads past the end of the source array
+				Simd::Float4 a = Simd::Load(src);
+				Simd::Float4 b = Simd::Load(src + 3);
+				const float c[4] = { src[6], src[7], src[8], 0.f };
+				Simd::Float4 v = Simd::Load(c);
+				Simd::Float4 w = zero;
+				if (transpose)
+				{
+					Simd::Transpose4(a, b, v, w);
+				}
+				// Only the first three lanes of each row are meaningful; clear the fourth
+				float lanes[12];
+				Simd::Store(lanes, a);
+				Simd::Store(lanes + 4, b);
+				Simd::Store(lanes + 8, v);
+				lanes[3] = lanes[7] = lanes[11] = 0.f;
+				std::memcpy(out, lanes, sizeof(lanes));
+			}
+		}
+
+		void WriteMatrices4(const float* src, size_t count, bool transpose, float* out)
+		{
+			if (!transpose)
+			{
+				std::memcpy(out, src, count * 16 * sizeof(float));
+				return;
+			}
+			for (size_t i = 0; i < count; ++i, src += 16, out += 16)
+			{
+				Simd::Float4 c0, c1, c2, c3;
+				Simd::LoadTransposed4(src, c0, c1, c2, c3);
+				Simd::Store(out, c0);
+				Simd::Store(out + 4, c1);
+				Simd::Store(out + 8, c2);
+				Simd::Store(out + 12, c3);
+			}
+		}
+
+		void WriteFloats(const float* src, size_t count, BufferLayout layout, float* out)
+		{
+			if (layout == BufferLayout::Std430)
+			{
+				std::memcpy(out, src, count * sizeof(float));
+				return;
+			}
+
+			// Each scalar becomes the x of a zero-padded vec4
+			const Simd::Float4 zero = Simd::Zero();
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				Simd::StoreTransposed4(out + i * 4, Simd::Load(src + i), zero, zero, zero);
+			}
+			for (; i < count; ++i)
+			{
+				const float padded[4] = { src[i], 0.f, 0.f, 0.f };
+				std::memcpy(out + i * 4, padded, sizeof(padded));
+			}
+		}
+
+		void WriteVectors2(const Vector2f* src, size_t count, BufferLayout layout, float* out)
+		{
+			if (layout == BufferLayout::Std430)
+			{
+				std::memcpy(out, src, count * sizeof(Vector2f));
+				return;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float padded[4] = { src[i].x, src[i].y, 0.f, 0.f };
+				std::memcpy(out + i * 4, padded, sizeof(padded));
+			}
+		}
+
+		// vec3 arrays are padded to vec4 in both layouts
+		void WriteVectors3(const Vector3f* src, size_t count, float* out)
+		{
+			const Simd::Float4 zero = Simd::Zero();
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				Simd::Float4 x, y, z;
+				Simd::LoadTransposed3(&src[i].x, x, y, z);
+				Simd::StoreTransposed4(out + i * 4, x, y, z, zero);
+			}
+			for (; i < count; ++i)
+			{
+				const float padded[4] = { src[i].x, src[i].y, src[i].z, 0.f };
+				std::memcpy(out + i * 4, padded, sizeof(padded));
+			}
+		}
+
+		// Runs write(src, count, out) over chunks of the array, spread over executor,
+		// and returns the bytes written. Chunks are whole SIMD blocks, so the output
+		// is the same as in one pass.
+		template <typename T, typename Write>
+		size_t WriteChunks(const T* src, size_t count, BufferLayout layout, void* dst, Executor* executor, Write write)
+		{
+			const size_t stride = ArrayStride<T>(layout);
+			float* out = static_cast<float*>(dst);
+			ParallelFor(count, GetChunkSize(sizeof(T) + stride), [&](const size_t first, const size_t last) {
+				write(src + first, last - first, out + first * (stride / sizeof(float)));
+			}, executor);
+			return count * stride;
+		}
+	}
+
+	size_t WriteArray(const float* src, size_t count, BufferLayout layout, void* dst, Executor* executor)
+	{
+		return WriteChunks(src, count, layout, dst, executor, [layout](const float* s, size_t n, float* out) {
+			WriteFloats(s, n, layout, out);
+		});
+	}
+
+	size_t WriteArray(const Vector2f* src, size_t count, BufferLayout layout, void* dst, Executor* executor)
+	{
+		return WriteChunks(src, count, layout, dst, executor, [layout](const Vector2f* s, size_t n, float* out) {
+			WriteVectors2(s, n, layout, out);
+		});
+	}
+
+	size_t WriteArray(const Vector3f* src, size_t count, BufferLayout layout, void* dst, Executor* executor)
+	{
+		return WriteChunks(src, count, layout, dst, executor, WriteVectors3);
+	}
+
+	size_t WriteArray(const Vector4f* src, size_t count, BufferLayout layout, void* dst, Executor* executor)
+	{
+		return WriteChunks(src, count, layout, dst, executor, [](const Vector4f* s, size_t n, float* out) {
+			std::memcpy(out, s, n * sizeof(Vector4f));
+		});
+	}
+
+	size_t WriteArray(const Matrix3x3f* src, size_t count, BufferLayout layout, void* dst, StorageOrder order, Executor* executor)
+	{
+		const bool transpose = order != Matrix3x3f::k_order;
+		return WriteChunks(src, count, layout, dst, executor, [transpose](const Matrix3x3f* s, size_t n, float* out) {
+			WriteMatrices3(reinterpret_cast<const float*>(s), n, transpose, out);
+		});
+	}
+
+	size_t WriteArray(const Matrix4x4f* src, size_t count, BufferLayout layout, void* dst, StorageOrder order, Executor* executor)
+	{
+		const bool transpose = order != Matrix4x4f::k_order;
+		return WriteChunks(src, count, layout, dst, executor, [transpose](const Matrix4x4f* s, size_t n, float* out) {
+			WriteMatrices4(reinterpret_cast<const float*>(s), n, transpose, out);
+		});
+	}
+
+	size_t WriteArray(const ColumnMajorMatrix3x3f* src, size_t count, BufferLayout layout, void* dst, StorageOrder order, Executor* executor)
+	{
+		const bool transpose = order != ColumnMajorMatrix3x3f::k_order;
+		return WriteChunks(src, count, layout, dst, executor, [transpose](const ColumnMajorMatrix3x3f* s, size_t n, float* out) {
+			WriteMatrices3(reinterpret_cast<const float*>(s), n, transpose, out);
+		});
+	}
+
+	size_t WriteArray(const ColumnMajorMatrix4x4f* src, size_t count, BufferLayout layout, void* dst, StorageOrder order, Executor* executor)
+	{
+		const bool transpose = order != ColumnMajorMatrix4x4f::k_order;
+		return WriteChunks(src, count, layout, dst, executor, [transpose](const ColumnMajorMatrix4x4f* s, size_t n, float* out) {
+			WriteMatrices4(reinterpret_cast<const float*>(s), n, transpose, out);
+		});
+	}
+}
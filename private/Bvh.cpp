@@ -0,0 +1,827 @@
+#include <Bvh.h>
+
+#include <Parallel.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <mutex>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		using Simd::Float4;
+		using BvhDetail::Node;
+		using BvhDetail::Triangle;
+
+		constexpr int k_binCount = 16;
+		// Cost of visiting a node relative to intersecting one triangle
+		constexpr float k_traversalCost = 1.f;
+		// Ranges at least this large are split before the parallel subtree builds, with
+		// their triangles binned in parallel
+		constexpr size_t k_parallelSplitSize = 16384;
+		constexpr size_t k_grainSize = 4096;
+		// Below this depth the binary tree falls back to median splits, which bounds the
+		// traversal stack
+		constexpr int k_sahDepthLimit = 48;
+		constexpr size_t k_stackSize = 1024;
+		constexpr uint32_t k_noNode = 0xFFFFFFFFu;
+
+		struct BuildNode
+		{
+			Aabbf bounds;
+			uint32_t left;
+			uint32_t right;
+			uint32_t first;
+			uint32_t count;			// Leaves have a non-zero count
+		};
+
+		struct BuildTask
+		{
+			uint32_t node;
+			uint32_t begin;
+			uint32_t end;
+			int depth;
+		};
+
+		struct Primitives
+		{
+			std::vector<Aabbf> bounds;
+			std::vector<Vector3f> centroids;
+			std::vector<uint32_t> order;
+		};
+
+		struct RangeBounds
+		{
+			Aabbf bounds = Aabbf::Empty();
+			Aabbf centroids = Aabbf::Empty();
+
+			void Merge(const RangeBounds& other)
+			{
+				bounds.Merge(other.bounds);
+				centroids.Merge(other.centroids);
+			}
+		};
+
+		struct Bins
+		{
+			Aabbf bounds[3][k_binCount];
+			uint32_t counts[3][k_binCount];
+
+			Bins()
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					for (int b = 0; b < k_binCount; ++b)
+					{
+						bounds[axis][b] = Aabbf::Empty();
+						counts[axis][b] = 0;
+					}
+				}
+			}
+
+			void Merge(const Bins& other)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					for (int b = 0; b < k_binCount; ++b)
+					{
+						bounds[axis][b].Merge(other.bounds[axis][b]);
+						counts[axis][b] += other.counts[axis][b];
+					}
+				}
+			}
+		};
+
+		// Accumulates accumulate(begin, end, partial) over [begin, end), in parallel for
+		// large ranges. Partials are combined with Merge, which is exact for bounds and
+		// counts, so the result does not depend on how the range was divided.
+		template <typename Result, typename Accumulate>
+		Result Reduce(const uint32_t begin, const uint32_t end, const bool parallel, Accumulate accumulate)
+		{
+			Result result;
+			if (!parallel)
+			{
+				accumulate(begin, end, result);
+				return result;
+			}
+
+			std::mutex mutex;
+			ParallelFor(end - begin, k_grainSize, [&](size_t first, size_t last) {
+				Result partial;
+				accumulate(static_cast<uint32_t>(begin + first), static_cast<uint32_t>(begin + last), partial);
+				std::lock_guard<std::mutex> lock(mutex);
+				result.Merge(partial);
+			});
+			return result;
+		}
+
+		RangeBounds MeasureRange(const Primitives& primitives, const uint32_t begin, const uint32_t end, const bool parallel)
+		{
+			return Reduce<RangeBounds>(begin, end, parallel, [&primitives](uint32_t first, uint32_t last, RangeBounds& out) {
+				for (uint32_t i = first; i < last; ++i)
+				{
+					const uint32_t primitive = primitives.order[i];
+					out.bounds.Merge(primitives.bounds[primitive]);
+					out.centroids.Expand(primitives.centroids[primitive]);
+				}
+			});
+		}
+
+		int GetBin(const float centroid, const float lower, const float scale)
+		{
+			const int bin = static_cast<int>((centroid - lower) * scale);
+			return std::min(std::max(bin, 0), k_binCount - 1);
+		}
+
+		// Partitions [begin, end) in place and returns where the right half starts, or
+		// end if the range should stay a leaf
+		uint32_t SplitRange(Primitives& primitives, const uint32_t begin, const uint32_t end, const RangeBounds& range,
+			const int depth, const bool parallel)
+		{
+			const uint32_t count = end - begin;
+			if (count <= 1)
+			{
+				return end;
+			}
+
+			const Vector3f extent = range.centroids.max - range.centroids.min;
+			float scale[3];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				scale[axis] = extent[axis] > 0.f ? k_binCount / extent[axis] : 0.f;
+			}
+
+			int bestAxis = -1;
+			int bestBin = 0;
+			float bestCost = std::numeric_limits<float>::max();
+			if (depth < k_sahDepthLimit)
+			{
+				const Bins bins = Reduce<Bins>(begin, end, parallel, [&](uint32_t first, uint32_t last, Bins& out) {
+					for (uint32_t i = first; i < last; ++i)
+					{
+						const uint32_t primitive = primitives.order[i];
+						const Vector3f& centroid = primitives.centroids[primitive];
+						for (int axis = 0; axis < 3; ++axis)
+						{
+							const int bin = GetBin(centroid[axis], range.centroids.min[axis], scale[axis]);
+							out.bounds[axis][bin].Merge(primitives.bounds[primitive]);
+							++out.counts[axis][bin];
+						}
+					}
+				});
+
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					if (scale[axis] == 0.f)
+					{
+						continue;
+					}
+
+					// Sweep from the right first, then evaluate each split from the left
+					float rightCosts[k_binCount];
+					Aabbf accumulated = Aabbf::Empty();
+					uint32_t accumulatedCount = 0;
+					for (int b = k_binCount - 1; b > 0; --b)
+					{
+						accumulated.Merge(bins.bounds[axis][b]);
+						accumulatedCount += bins.counts[axis][b];
+						rightCosts[b] = accumulatedCount > 0 ? accumulated.GetSurfaceArea() * accumulatedCount : 0.f;
+					}
+					accumulated = Aabbf::Empty();
+					accumulatedCount = 0;
+					for (int b = 0; b < k_binCount - 1; ++b)
+					{
+						accumulated.Merge(bins.bounds[axis][b]);
+						accumulatedCount += bins.counts[axis][b];
+						if (accumulatedCount == 0 || accumulatedCount == count)
+						{
+							continue;
+						}
+						const float cost = accumulated.GetSurfaceArea() * accumulatedCount + rightCosts[b + 1];
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							bestAxis = axis;
+							bestBin = b;
+						}
+					}
+				}
+			}
+
+			uint32_t* order = primitives.order.data();
+			if (bestAxis >= 0)
+			{
+				const float area = range.bounds.GetSurfaceArea();
+				if (count <= Bvh::k_maxLeafSize && area * count <= area * k_traversalCost + bestCost)
+				{
+					return end;
+				}
+				const float lower = range.centroids.min[bestAxis];
+				const float axisScale = scale[bestAxis];
+				const uint32_t* mid = std::partition(order + begin, order + end, [&](uint32_t primitive) {
+					return GetBin(primitives.centroids[primitive][bestAxis], lower, axisScale) <= bestBin;
+				});
+				return static_cast<uint32_t>(mid - order);
+			}
+
+			// Past the depth limit, or every centroid in the same place
+			if (count <= Bvh::k_maxLeafSize)
+			{
+				return end;
+			}
+			int axis = 0;
+			if (extent.y > extent[axis])
+			{
+				axis = 1;
+			}
+			if (extent.z > extent[axis])
+			{
+				axis = 2;
+			}
+			const uint32_t mid = begin + count / 2;
+			std::nth_element(order + begin, order + mid, order + end, [&](uint32_t a, uint32_t b) {
+				const float ca = primitives.centroids[a][axis];
+				const float cb = primitives.centroids[b][axis];
+				return ca < cb || (ca == cb && a < b);
+			});
+			return mid;
+		}
+
+		// Builds the binary tree below task serially, with task.node as the local root
+		std::vector<BuildNode> BuildSubtree(Primitives& primitives, const BuildTask& root)
+		{
+			std::vector<BuildNode> nodes;
+			nodes.push_back({});
+			std::vector<BuildTask> stack;
+			stack.push_back({ 0, root.begin, root.end, root.depth });
+			while (!stack.empty())
+			{
+				const BuildTask task = stack.back();
+				stack.pop_back();
+
+				const RangeBounds range = MeasureRange(primitives, task.begin, task.end, false);
+				const uint32_t mid = SplitRange(primitives, task.begin, task.end, range, task.depth, false);
+				BuildNode& node = nodes[task.node];
+				node.bounds = range.bounds;
+				if (mid == task.end)
+				{
+					node.left = node.right = k_noNode;
+					node.first = task.begin;
+					node.count = task.end - task.begin;
+					continue;
+				}
+
+				const uint32_t left = static_cast<uint32_t>(nodes.size());
+				node.left = left;
+				node.right = left + 1;
+				node.count = 0;
+				nodes.push_back({});
+				nodes.push_back({});
+				stack.push_back({ left, task.begin, mid, task.depth + 1 });
+				stack.push_back({ left + 1, mid, task.end, task.depth + 1 });
+			}
+			return nodes;
+		}
+
+		// Splits the large ranges at the top serially, with parallel binning, then builds
+		// the subtrees below them in parallel and joins everything into one tree
+		std::vector<BuildNode> BuildBinaryTree(Primitives& primitives)
+		{
+			const uint32_t triangleCount = static_cast<uint32_t>(primitives.order.size());
+			std::vector<BuildNode> nodes(1);
+			std::vector<BuildTask> subtrees;
+			std::vector<BuildTask> stack;
+			stack.push_back({ 0, 0, triangleCount, 0 });
+			while (!stack.empty())
+			{
+				const BuildTask task = stack.back();
+				stack.pop_back();
+				if (task.end - task.begin < k_parallelSplitSize)
+				{
+					subtrees.push_back(task);
+					continue;
+				}
+
+				const RangeBounds range = MeasureRange(primitives, task.begin, task.end, true);
+				const uint32_t mid = SplitRange(primitives, task.begin, task.end, range, task.depth, true);
+				assert(mid != task.end);
+				const uint32_t left = static_cast<uint32_t>(nodes.size());
+				nodes[task.node] = { range.bounds, left, left + 1, 0, 0 };
+				nodes.push_back({});
+				nodes.push_back({});
+				stack.push_back({ left, task.begin, mid, task.depth + 1 });
+				stack.push_back({ left + 1, mid, task.end, task.depth + 1 });
+			}
+
+			std::vector<std::vector<BuildNode>> built(subtrees.size());
+			ParallelFor(subtrees.size(), 1, [&](size_t first, size_t last) {
+				for (size_t s = first; s < last; ++s)
+				{
+					built[s] = BuildSubtree(primitives, subtrees[s]);
+				}
+			});
+
+			for (size_t s = 0; s < subtrees.size(); ++s)
+			{
+				// The local root replaces the placeholder and the rest are appended
+				const std::vector<BuildNode>& local = built[s];
+				const uint32_t offset = static_cast<uint32_t>(nodes.size()) - 1;
+				const uint32_t rootIndex = subtrees[s].node;
+				auto remap = [offset, rootIndex](uint32_t index) {
+					return index == k_noNode ? k_noNode : (index == 0 ? rootIndex : offset + index);
+				};
+				for (size_t k = 0; k < local.size(); ++k)
+				{
+					BuildNode node = local[k];
+					node.left = remap(node.left);
+					node.right = remap(node.right);
+					if (k == 0)
+					{
+						nodes[rootIndex] = node;
+					}
+					else
+					{
+						nodes.push_back(node);
+					}
+				}
+			}
+			return nodes;
+		}
+
+		void SetChild(Node& node, const int slot, const Aabbf& bounds, const uint32_t child)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				node.bounds[c][slot] = bounds.min[c];
+				node.bounds[3 + c][slot] = bounds.max[c];
+			}
+			node.children[slot] = child;
+		}
+
+		Node MakeEmptyNode()
+		{
+			Node node;
+			for (int slot = 0; slot < BvhDetail::k_width; ++slot)
+			{
+				for (int c = 0; c < 6; ++c)
+				{
+					node.bounds[c][slot] = std::numeric_limits<float>::quiet_NaN();
+				}
+				node.children[slot] = BvhDetail::k_emptyChild;
+			}
+			return node;
+		}
+
+		// Collapses the binary tree into nodes of up to k_width children, repeatedly
+		// opening the interior child with the largest surface area
+		std::vector<Node> CollapseTree(const std::vector<BuildNode>& binary)
+		{
+			std::vector<Node> nodes;
+			nodes.push_back(MakeEmptyNode());
+			if (binary[0].count > 0)
+			{
+				SetChild(nodes[0], 0, binary[0].bounds, BvhDetail::MakeLeaf(binary[0].first, binary[0].count));
+				return nodes;
+			}
+
+			struct Pending
+			{
+				uint32_t binary;
+				uint32_t node;
+			};
+			std::vector<Pending> stack;
+			stack.push_back({ 0, 0 });
+			while (!stack.empty())
+			{
+				const Pending pending = stack.back();
+				stack.pop_back();
+
+				uint32_t children[BvhDetail::k_width] = { binary[pending.binary].left, binary[pending.binary].right };
+				int childCount = 2;
+				while (childCount < BvhDetail::k_width)
+				{
+					int largest = -1;
+					float largestArea = -1.f;
+					for (int k = 0; k < childCount; ++k)
+					{
+						const BuildNode& child = binary[children[k]];
+						const float area = child.bounds.GetSurfaceArea();
+						if (child.count == 0 && area > largestArea)
+						{
+							largest = k;
+							largestArea = area;
+						}
+					}
+					if (largest < 0)
+					{
+						break;
+					}
+					const BuildNode& opened = binary[children[largest]];
+					children[largest] = opened.left;
+					children[childCount++] = opened.right;
+				}
+
+				for (int k = 0; k < childCount; ++k)
+				{
+					const BuildNode& child = binary[children[k]];
+					uint32_t reference;
+					if (child.count > 0)
+					{
+						reference = BvhDetail::MakeLeaf(child.first, child.count);
+					}
+					else
+					{
+						reference = static_cast<uint32_t>(nodes.size());
+						nodes.push_back(MakeEmptyNode());
+						stack.push_back({ children[k], reference });
+					}
+					SetChild(nodes[pending.node], k, child.bounds, reference);
+				}
+			}
+			return nodes;
+		}
+
+		bool IntersectTriangle(const Rayf& ray, const Triangle& triangle, const float tMax, BvhHit& hit)
+		{
+			const Vector3f p = Cross(ray.direction, triangle.edge2);
+			const float determinant = Dot(triangle.edge1, p);
+			if (determinant == 0.f)
+			{
+				return false;
+			}
+			const float invDeterminant = 1.f / determinant;
+			const Vector3f s = ray.origin - triangle.v0;
+			const float u = Dot(s, p) * invDeterminant;
+			if (!(u >= 0.f && u <= 1.f))
+			{
+				return false;
+			}
+			const Vector3f q = Cross(s, triangle.edge1);
+			const float v = Dot(ray.direction, q) * invDeterminant;
+			if (!(v >= 0.f && u + v <= 1.f))
+			{
+				return false;
+			}
+			const float t = Dot(triangle.edge2, q) * invDeterminant;
+			if (!(t >= 0.f && t <= tMax))
+			{
+				return false;
+			}
+			hit = { t, triangle.index, u, v };
+			return true;
+		}
+
+		struct RayLanes
+		{
+			Float4 origin[3];
+			Float4 inverse[3];
+		};
+
+		RayLanes BroadcastRay(const Rayf& ray)
+		{
+			const Vector3f inverse = ray.GetInverseDirection();
+			RayLanes lanes;
+			for (int c = 0; c < 3; ++c)
+			{
+				lanes.origin[c] = Simd::Set1(ray.origin[c]);
+				lanes.inverse[c] = Simd::Set1(inverse[c]);
+			}
+			return lanes;
+		}
+
+		// Slab test of one ray against the eight children of a node, four at a time.
+		// Returns the mask of children hit within [0, tMax] and their entry distances.
+		int TestChildren(const Node& node, const RayLanes& ray, const float tMax, float* entry)
+		{
+			int mask = 0;
+			for (int half = 0; half < BvhDetail::k_width; half += 4)
+			{
+				Float4 nearT = Simd::Zero();
+				Float4 farT = Simd::Set1(tMax);
+				for (int c = 0; c < 3; ++c)
+				{
+					const Float4 t1 = (Simd::Load(node.bounds[c] + half) - ray.origin[c]) * ray.inverse[c];
+					const Float4 t2 = (Simd::Load(node.bounds[3 + c] + half) - ray.origin[c]) * ray.inverse[c];
+					nearT = Simd::Max(nearT, Simd::Min(t1, t2));
+					farT = Simd::Min(farT, Simd::Max(t1, t2));
+				}
+				Simd::Store(entry + half, nearT);
+				mask |= Simd::MoveMask(Simd::CmpLe(nearT, farT)) << half;
+			}
+			return mask;
+		}
+
+		struct StackEntry
+		{
+			uint32_t reference;
+			float entry;
+		};
+
+		// Pushes the children in mask so the nearest is popped first
+		void PushChildren(const Node& node, int mask, const float* entry, StackEntry* stack, size_t& size)
+		{
+			const size_t first = size;
+			while (mask != 0)
+			{
+				int k = 0;
+				while (((mask >> k) & 1) == 0)
+				{
+					++k;
+				}
+				mask &= mask - 1;
+
+				assert(size < k_stackSize);
+				size_t i = size++;
+				for (; i > first && stack[i - 1].entry < entry[k]; --i)
+				{
+					stack[i] = stack[i - 1];
+				}
+				stack[i] = { node.children[k], entry[k] };
+			}
+		}
+
+		bool IsLeaf(const uint32_t reference)
+		{
+			return (reference & BvhDetail::k_leafFlag) != 0;
+		}
+
+		uint32_t GetLeafFirst(const uint32_t reference)
+		{
+			return reference & BvhDetail::k_leafFirstMask;
+		}
+
+		uint32_t GetLeafCount(const uint32_t reference)
+		{
+			return (reference & ~BvhDetail::k_leafFlag) >> BvhDetail::k_leafCountShift;
+		}
+	}
+
+	void Bvh::Build(const VectorSpan<const float, 3>& vertices, const uint32_t* indices, size_t triangleCount)
+	{
+		assert(triangleCount <= BvhDetail::k_leafFirstMask);
+		assert(indices != nullptr || triangleCount * 3 <= vertices.Count());
+
+		nodes.clear();
+		triangles.clear();
+		bounds = Aabbf::Empty();
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		auto getVertex = [&vertices, indices](const size_t triangle, const size_t corner) {
+			const size_t index = indices != nullptr ? indices[triangle * 3 + corner] : triangle * 3 + corner;
+			assert(index < vertices.Count());
+			return vertices.Load(index);
+		};
+
+		Primitives primitives;
+		primitives.bounds.resize(triangleCount);
+		primitives.centroids.resize(triangleCount);
+		primitives.order.resize(triangleCount);
+		ParallelFor(triangleCount, k_grainSize, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				Aabbf box = Aabbf::Empty();
+				for (size_t corner = 0; corner < 3; ++corner)
+				{
+					box.Expand(getVertex(i, corner));
+				}
+				primitives.bounds[i] = box;
+				primitives.centroids[i] = box.GetCenter();
+				primitives.order[i] = static_cast<uint32_t>(i);
+			}
+		});
+
+		const std::vector<BuildNode> binary = BuildBinaryTree(primitives);
+		bounds = binary[0].bounds;
+		nodes = CollapseTree(binary);
+
+		triangles.resize(triangleCount);
+		ParallelFor(triangleCount, k_grainSize, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				const uint32_t index = primitives.order[i];
+				const Vector3f v0 = getVertex(index, 0);
+				triangles[i] = { v0, getVertex(index, 1) - v0, getVertex(index, 2) - v0, index };
+			}
+		});
+	}
+
+	bool Bvh::Intersect(const Rayf& ray, float tMax, BvhHit& hit) const
+	{
+		if (nodes.empty())
+		{
+			return false;
+		}
+
+		const RayLanes lanes = BroadcastRay(ray);
+		StackEntry stack[k_stackSize];
+		size_t size = 0;
+		stack[size++] = { 0, 0.f };
+		bool found = false;
+		float entry[BvhDetail::k_width];
+		while (size > 0)
+		{
+			const StackEntry top = stack[--size];
+			if (top.entry > tMax)
+			{
+				continue;
+			}
+
+			if (IsLeaf(top.reference))
+			{
+				const uint32_t end = GetLeafFirst(top.reference) + GetLeafCount(top.reference);
+				for (uint32_t i = GetLeafFirst(top.reference); i < end; ++i)
+				{
+					if (IntersectTriangle(ray, triangles[i], tMax, hit))
+					{
+						tMax = hit.t;
+						found = true;
+					}
+				}
+				continue;
+			}
+
+			const Node& node = nodes[top.reference];
+			PushChildren(node, TestChildren(node, lanes, tMax, entry), entry, stack, size);
+		}
+		return found;
+	}
+
+	bool Bvh::IsOccluded(const Rayf& ray, float tMax) const
+	{
+		if (nodes.empty())
+		{
+			return false;
+		}
+
+		const RayLanes lanes = BroadcastRay(ray);
+		uint32_t stack[k_stackSize];
+		size_t size = 0;
+		stack[size++] = 0;
+		float entry[BvhDetail::k_width];
+		BvhHit hit;
+		while (size > 0)
+		{
+			const uint32_t reference = stack[--size];
+			if (IsLeaf(reference))
+			{
+				const uint32_t end = GetLeafFirst(reference) + GetLeafCount(reference);
+				for (uint32_t i = GetLeafFirst(reference); i < end; ++i)
+				{
+					if (IntersectTriangle(ray, triangles[i], tMax, hit))
+					{
+						return true;
+					}
+				}
+				continue;
+			}
+
+			const Node& node = nodes[reference];
+			int mask = TestChildren(node, lanes, tMax, entry);
+			while (mask != 0)
+			{
+				int k = 0;
+				while (((mask >> k) & 1) == 0)
+				{
+					++k;
+				}
+				mask &= mask - 1;
+				assert(size < k_stackSize);
+				stack[size++] = node.children[k];
+			}
+		}
+		return false;
+	}
+
+	void Bvh::Intersect(const Rayf* rays, size_t count, float tMax, BvhHit* hits) const
+	{
+		assert(rays != nullptr || count == 0);
+
+		struct PacketEntry
+		{
+			uint32_t reference;
+			int lanes;				// Rays that hit the node's bounds
+			float entry;			// Nearest entry distance over those rays
+		};
+		PacketEntry stack[k_stackSize];
+
+		for (size_t first = 0; first < count; first += 4)
+		{
+			const int rayCount = static_cast<int>(std::min<size_t>(4, count - first));
+			const Rayf* packet = rays + first;
+			BvhHit* packetHits = hits + first;
+
+			// Ray components one per lane. Missing rays repeat the last one with a
+			// negative tMax, so they never hit.
+			float components[6][4];
+			float limits[4];
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				const Rayf& ray = packet[std::min(lane, rayCount - 1)];
+				const Vector3f inverse = ray.GetInverseDirection();
+				for (int c = 0; c < 3; ++c)
+				{
+					components[c][lane] = ray.origin[c];
+					components[3 + c][lane] = inverse[c];
+				}
+				limits[lane] = lane < rayCount ? tMax : -1.f;
+				if (lane < rayCount)
+				{
+					packetHits[lane] = { tMax, k_noHit, 0.f, 0.f };
+				}
+			}
+			if (nodes.empty())
+			{
+				continue;
+			}
+
+			Float4 origin[3];
+			Float4 inverse[3];
+			for (int c = 0; c < 3; ++c)
+			{
+				origin[c] = Simd::Load(components[c]);
+				inverse[c] = Simd::Load(components[3 + c]);
+			}
+			Float4 limit = Simd::Load(limits);
+
+			size_t size = 0;
+			stack[size++] = { 0, (1 << rayCount) - 1, 0.f };
+			while (size > 0)
+			{
+				const PacketEntry top = stack[--size];
+				float farthest = -1.f;
+				for (int lane = 0; lane < rayCount; ++lane)
+				{
+					if ((top.lanes >> lane) & 1)
+					{
+						farthest = std::max(farthest, limits[lane]);
+					}
+				}
+				if (top.entry > farthest)
+				{
+					continue;
+				}
+
+				if (IsLeaf(top.reference))
+				{
+					const uint32_t end = GetLeafFirst(top.reference) + GetLeafCount(top.reference);
+					for (uint32_t i = GetLeafFirst(top.reference); i < end; ++i)
+					{
+						for (int lane = 0; lane < rayCount; ++lane)
+						{
+							if (((top.lanes >> lane) & 1) && IntersectTriangle(packet[lane], triangles[i], limits[lane], packetHits[lane]))
+							{
+								limits[lane] = packetHits[lane].t;
+							}
+						}
+					}
+					limit = Simd::Load(limits);
+					continue;
+				}
+
+				// Each child against the four rays, nearest child pushed last
+				const Node& node = nodes[top.reference];
+				const size_t firstChild = size;
+				for (int k = 0; k < BvhDetail::k_width && node.children[k] != BvhDetail::k_emptyChild; ++k)
+				{
+					Float4 nearT = Simd::Zero();
+					Float4 farT = limit;
+					for (int c = 0; c < 3; ++c)
+					{
+						const Float4 t1 = (Simd::Set1(node.bounds[c][k]) - origin[c]) * inverse[c];
+						const Float4 t2 = (Simd::Set1(node.bounds[3 + c][k]) - origin[c]) * inverse[c];
+						nearT = Simd::Max(nearT, Simd::Min(t1, t2));
+						farT = Simd::Min(farT, Simd::Max(t1, t2));
+					}
+					const int mask = Simd::MoveMask(Simd::CmpLe(nearT, farT)) & top.lanes;
+					if (mask == 0)
+					{
+						continue;
+					}
+
+					float nearest = std::numeric_limits<float>::max();
+					for (int lane = 0; lane < 4; ++lane)
+					{
+						if ((mask >> lane) & 1)
+						{
+							nearest = std::min(nearest, Simd::GetLane(nearT, lane));
+						}
+					}
+					assert(size < k_stackSize);
+					size_t i = size++;
+					for (; i > firstChild && stack[i - 1].entry < nearest; --i)
+					{
+						stack[i] = stack[i - 1];
+					}
+					stack[i] = { node.children[k], mask, nearest };
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,645 @@
+#include <Colour.h>
+
+#include <cmath>
+
+#include "Simd.h"
+
+namespace Math
+{
+	static_assert(sizeof(Colour4b) == 4, "Colour4b must be tightly packed");
+	static_assert(sizeof(Colour4s) == 8, "Colour4s must be tightly packed");
+	static_assert(sizeof(Colour4i) == 16, "Colour4i must be tightly packed");
+	static_assert(sizeof(Colour4f) == 16, "Colour4f must be tightly packed");
+
+	namespace
+	{
+		constexpr float k_inv255 = 1.f / 255.f;
+		constexpr float k_inv65535 = 1.f / 65535.f;
+		constexpr float k_inv4294967295 = static_cast<float>(1.0 / 4294967295.0);
+
+		// Clamp to [0, 1], mapping NaN to 0 the same way max/min do in SSE
+		inline float Saturate(const float f)
+		{
+			return f > 0.f ? (f < 1.f ? f : 1.f) : 0.f;
+		}
+
+		inline uint8_t ToUnorm8(const float f)
+		{
+			return static_cast<uint8_t>(Saturate(f) * 255.f + 0.5f);
+		}
+
+		inline uint16_t ToUnorm16(const float f)
+		{
+			return static_cast<uint16_t>(Saturate(f) * 65535.f + 0.5f);
+		}
+
+		inline uint32_t ToUnorm32(const float f)
+		{
+			const float s = Saturate(f);
+			if (s >= 1.f)
+			{
+				return 0xFFFFFFFFu;
+			}
+			return static_cast<uint32_t>(s * 4294967295.f + 0.5f);
+		}
+
+#if MATH_SIMD_SSE2
+		inline __m128 Saturate(const __m128 v)
+		{
+			return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.f));
+		}
+
+		// Exact uint32 -> float conversion; SSE2 only has a signed conversion
+		inline __m128 ConvertU32(const __m128i v)
+		{
+			const __m128 hi = _mm_cvtepi32_ps(_mm_srli_epi32(v, 16));
+			const __m128 lo = _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0xFFFF)));
+			return _mm_add_ps(_mm_mul_ps(hi, _mm_set1_ps(65536.f)), lo);
+		}
+
+		// Truncating float -> uint32 conversion for values in [0, 2^32)
+		inline __m128i TruncateU32(const __m128 v)
+		{
+			const __m128 two31 = _mm_set1_ps(2147483648.f);
+			const __m128 isLarge = _mm_cmpge_ps(v, two31);
+			const __m128 shifted = _mm_sub_ps(v, _mm_and_ps(isLarge, two31));
+			const __m128i sign = _mm_slli_epi32(_mm_castps_si128(isLarge), 31);
+			return _mm_xor_si128(_mm_cvttps_epi32(shifted), sign);
+		}
+#endif
+	}
+
+// Unorm -> float
+	void ConvertColours(const Colour4b* src, Colour4f* dst, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		const __m128 scale = _mm_set1_ps(k_inv255);
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i lo16 = _mm_unpacklo_epi8(bytes, zero);
+			const __m128i hi16 = _mm_unpackhi_epi8(bytes, zero);
+			float* out = dst[i].e;
+			_mm_storeu_ps(out + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo16, zero)), scale));
+			_mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo16, zero)), scale));
+			_mm_storeu_ps(out + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi16, zero)), scale));
+			_mm_storeu_ps(out + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi16, zero)), scale));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			dst[i] = { src[i].x * k_inv255, src[i].y * k_inv255, src[i].z * k_inv255, src[i].w * k_inv255 };
+		}
+	}
+
+	void ConvertColours(const Colour4s* src, Colour4f* dst, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		const __m128 scale = _mm_set1_ps(k_inv65535);
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			float* out = dst[i].e;
+			_mm_storeu_ps(out + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(shorts, zero)), scale));
+			_mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(shorts, zero)), scale));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			dst[i] = { src[i].x * k_inv65535, src[i].y * k_inv65535, src[i].z * k_inv65535, src[i].w * k_inv65535 };
+		}
+	}
+
+	void ConvertColours(const Colour4i* src, Colour4f* dst, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		const __m128 scale = _mm_set1_ps(k_inv4294967295);
+		for (; i < count; ++i)
+		{
+			const __m128i ints = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_ps(dst[i].e, _mm_mul_ps(ConvertU32(ints), scale));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			dst[i] = {
+				static_cast<float>(src[i].x) * k_inv4294967295,
+				static_cast<float>(src[i].y) * k_inv4294967295,
+				static_cast<float>(src[i].z) * k_inv4294967295,
+				static_cast<float>(src[i].w) * k_inv4294967295
+			};
+		}
+	}
+
+// Float -> unorm
+	void ConvertColours(const Colour4f* src, Colour4b* dst, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		const __m128 scale = _mm_set1_ps(255.f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		for (; i + 4 <= count; i += 4)
+		{
+			const float* in = src[i].e;
+			const __m128i p0 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Saturate(_mm_loadu_ps(in + 0)), scale), half));
+			const __m128i p1 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Saturate(_mm_loadu_ps(in + 4)), scale), half));
+			const __m128i p2 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Saturate(_mm_loadu_ps(in + 8)), scale), half));
+			const __m128i p3 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Saturate(_mm_loadu_ps(in + 12)), scale), half));
+			const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			dst[i] = { ToUnorm8(src[i].x), ToUnorm8(src[i].y), ToUnorm8(src[i].z), ToUnorm8(src[i].w) };
+		}
+	}
+
+	void ConvertColours(const Colour4f* src, Colour4s* dst, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		const __m128 scale = _mm_set1_ps(65535.f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		for (; i + 2 <= count; i += 2)
+		{
+			const float* in = src[i].e;
+			const __m128i p0 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Saturate(_mm_loadu_ps(in + 0)), scale), half));
+			const __m128i p1 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Saturate(_mm_loadu_ps(in + 4)), scale), half));
+#if MATH_SIMD_SSE41
+			const __m128i packed = _mm_packus_epi32(p0, p1);
+#else
+			// Bias into signed range so the signed saturating pack can be used, then unbias
+			const __m128i bias32 = _mm_set1_epi32(0x8000);
+			const __m128i biased = _mm_packs_epi32(_mm_sub_epi32(p0, bias32), _mm_sub_epi32(p1, bias32));
+			const __m128i packed = _mm_xor_si128(biased, _mm_set1_epi16(static_cast<short>(0x8000)));
+#endif
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			dst[i] = { ToUnorm16(src[i].x), ToUnorm16(src[i].y), ToUnorm16(src[i].z), ToUnorm16(src[i].w) };
+		}
+	}
+
+	void ConvertColours(const Colour4f* src, Colour4i* dst, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		const __m128 scale = _mm_set1_ps(4294967295.f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 one = _mm_set1_ps(1.f);
+		for (; i < count; ++i)
+		{
+			const __m128 s = Saturate(_mm_loadu_ps(src[i].e));
+			const __m128i ints = TruncateU32(_mm_add_ps(_mm_mul_ps(s, scale), half));
+			// 1.0 scales to 2^32, which does not fit; saturate it explicitly
+			const __m128i full = _mm_castps_si128(_mm_cmpge_ps(s, one));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(ints, full));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			dst[i] = { ToUnorm32(src[i].x), ToUnorm32(src[i].y), ToUnorm32(src[i].z), ToUnorm32(src[i].w) };
+		}
+	}
+
+// Channel swizzles
+	void SwizzleRedBlue(const Colour4b* src, Colour4b* dst, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSSE3
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(px, shuffle));
+		}
+#elif MATH_SIMD_SSE2
+		const __m128i greenAlpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+		const __m128i redBlue = _mm_set1_epi32(0x00FF00FF);
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i rb = _mm_and_si128(px, redBlue);
+			const __m128i swapped = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_and_si128(px, greenAlpha), swapped));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			const Colour4b px = src[i];
+			dst[i] = { px.z, px.y, px.x, px.w };
+		}
+	}
+
+	void SwizzleRedBlue(const Colour4f* src, Colour4f* dst, size_t count)
+	{
+		size_t i = 0;
+#if MATH_SIMD_SSE2
+		for (; i < count; ++i)
+		{
+			const __m128 px = _mm_loadu_ps(src[i].e);
+			_mm_storeu_ps(dst[i].e, _mm_shuffle_ps(px, px, _MM_SHUFFLE(3, 0, 1, 2)));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			const Colour4f px = src[i];
+			dst[i] = { px.z, px.y, px.x, px.w };
+		}
+	}
+
+	namespace
+	{
+		using Simd::Float4;
+
+		inline float SrgbToLinearExact(const float c)
+		{
+			const float s = Saturate(c);
+			return s <= 0.04045f ? s * (1.f / 12.92f) : std::pow((s + 0.055f) * (1.f / 1.055f), 2.4f);
+		}
+
+		inline float LinearToSrgbExact(const float c)
+		{
+			const float l = Saturate(c);
+			return l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+		}
+
+		inline Float4 SaturateLanes(const Float4 v)
+		{
+			return Simd::Min(Simd::Max(v, Simd::Zero()), Simd::Set1(1.f));
+		}
+
+		// Quartic fit to the power segment of the sRGB decoding curve, minimizing
+		// relative error with white pinned to 1, and the exact linear toe so shadows
+		// stay accurate
+		inline Float4 SrgbToLinearFast(const Float4 c)
+		{
+			const Float4 s = SaturateLanes(c);
+			Float4 curve = Simd::MulAdd(s, Simd::Set1(-0.135491074f), Simd::Set1(0.559992796f));
+			curve = Simd::MulAdd(s, curve, Simd::Set1(0.54373809f));
+			curve = Simd::MulAdd(s, curve, Simd::Set1(0.0307963331f));
+			curve = Simd::MulAdd(s, curve, Simd::Set1(0.000963854985f));
+			const Float4 toe = s * Simd::Set1(1.f / 12.92f);
+			// Clamped, as rounding can leave white a unit in the last place above 1
+			return SaturateLanes(Simd::Select(Simd::CmpLe(s, Simd::Set1(0.04045f)), toe, curve));
+		}
+
+		// Fit of the encoding curve using the 1/2, 1/4 and 1/8 powers, with the exact linear toe
+		inline Float4 LinearToSrgbFast(const Float4 c)
+		{
+			const Float4 l = SaturateLanes(c);
+			const Float4 s1 = Simd::Sqrt(l);
+			const Float4 s2 = Simd::Sqrt(s1);
+			const Float4 s3 = Simd::Sqrt(s2);
+			const Float4 curve = Simd::Set1(0.585122381f) * s1 + Simd::Set1(0.783140355f) * s2 - Simd::Set1(0.368262736f) * s3;
+			const Float4 toe = l * Simd::Set1(12.92f);
+			return SaturateLanes(Simd::Select(Simd::CmpLe(l, Simd::Set1(0.0031308f)), toe, curve));
+		}
+
+		const float* GetSrgb8ToLinearTable()
+		{
+			static const struct Table
+			{
+				Table()
+				{
+					for (int i = 0; i < 256; ++i)
+					{
+						values[i] = SrgbToLinearExact(i * k_inv255);
+					}
+				}
+				float values[256];
+			} s_table;
+			return s_table.values;
+		}
+
+		constexpr int k_linearToSrgb8TableSize = 4096;
+
+		const uint8_t* GetLinearToSrgb8Table()
+		{
+			static const struct Table
+			{
+				Table()
+				{
+					for (int i = 0; i < k_linearToSrgb8TableSize; ++i)
+					{
+						values[i] = ToUnorm8(LinearToSrgbExact(static_cast<float>(i) / (k_linearToSrgb8TableSize - 1)));
+					}
+				}
+				uint8_t values[k_linearToSrgb8TableSize];
+			} s_table;
+			return s_table.values;
+		}
+
+		// Run an RGB lane kernel over Colour3f or Colour4f buffers four colours at a time.
+		// The tail is padded out to a full block so every element takes the same path.
+		template <typename Kernel>
+		void ForEachBlock(const Colour3f* src, Colour3f* dst, size_t count, Kernel kernel)
+		{
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				Float4 r, g, b;
+				Simd::LoadTransposed3(src[i].e, r, g, b);
+				kernel(r, g, b);
+				Simd::StoreTransposed3(dst[i].e, r, g, b);
+			}
+			if (i < count)
+			{
+				Colour3f tail[4];
+				for (size_t j = i; j < count; ++j)
+				{
+					tail[j - i] = src[j];
+				}
+				ForEachBlock(tail, tail, 4, kernel);
+				for (size_t j = i; j < count; ++j)
+				{
+					dst[j] = tail[j - i];
+				}
+			}
+		}
+
+		template <typename Kernel>
+		void ForEachBlock(const Colour4f* src, Colour4f* dst, size_t count, Kernel kernel)
+		{
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				Float4 r, g, b, a;
+				Simd::LoadTransposed4(src[i].e, r, g, b, a);
+				kernel(r, g, b);
+				Simd::StoreTransposed4(dst[i].e, r, g, b, a);
+			}
+			if (i < count)
+			{
+				Colour4f tail[4];
+				for (size_t j = i; j < count; ++j)
+				{
+					tail[j - i] = src[j];
+				}
+				ForEachBlock(tail, tail, 4, kernel);
+				for (size_t j = i; j < count; ++j)
+				{
+					dst[j] = tail[j - i];
+				}
+			}
+		}
+
+		// Hue in [0, 1) from the per-channel max and the reciprocal of the chroma
+		inline Float4 Hue(const Float4 r, const Float4 g, const Float4 b, const Float4 maxC, const Float4 invChroma)
+		{
+			const Float4 hueR = (g - b) * invChroma;
+			const Float4 hueG = Simd::MulAdd(b - r, invChroma, Simd::Set1(2.f));
+			const Float4 hueB = Simd::MulAdd(r - g, invChroma, Simd::Set1(4.f));
+			const Float4 sextant = Simd::Select(Simd::CmpEq(maxC, r), hueR, Simd::Select(Simd::CmpEq(maxC, g), hueG, hueB));
+			const Float4 hue = sextant * Simd::Set1(1.f / 6.f);
+			return Simd::Select(Simd::CmpLt(hue, Simd::Zero()), hue + Simd::Set1(1.f), hue);
+		}
+
+		inline Float4 SafeReciprocal(const Float4 v)
+		{
+			const Float4 nonZero = Simd::CmpGt(v, Simd::Zero());
+			return Simd::And(nonZero, Simd::Set1(1.f) / Simd::Select(nonZero, v, Simd::Set1(1.f)));
+		}
+
+		inline Float4 Wrap(const Float4 v, const float period)
+		{
+			return v - Simd::Set1(period) * Simd::Floor(v * Simd::Set1(1.f / period));
+		}
+
+		void RgbToHsvLanes(Float4& r, Float4& g, Float4& b)
+		{
+			const Float4 maxC = Simd::Max(r, Simd::Max(g, b));
+			const Float4 minC = Simd::Min(r, Simd::Min(g, b));
+			const Float4 chroma = maxC - minC;
+			const Float4 hue = Hue(r, g, b, maxC, SafeReciprocal(chroma));
+			r = hue;
+			g = chroma * SafeReciprocal(maxC);
+			b = maxC;
+		}
+
+		// f(n) = v - v * s * clamp(min(k, 4 - k), 0, 1), k = (n + 6h) mod 6
+		void HsvToRgbLanes(Float4& h, Float4& s, Float4& v)
+		{
+			const Float4 h6 = h * Simd::Set1(6.f);
+			const Float4 vs = v * s;
+			Float4 channels[3];
+			const float offsets[3] = { 5.f, 3.f, 1.f };
+			for (int i = 0; i < 3; ++i)
+			{
+				const Float4 k = Wrap(h6 + Simd::Set1(offsets[i]), 6.f);
+				const Float4 ramp = SaturateLanes(Simd::Min(k, Simd::Set1(4.f) - k));
+				channels[i] = v - vs * ramp;
+			}
+			h = channels[0];
+			s = channels[1];
+			v = channels[2];
+		}
+
+		void RgbToHslLanes(Float4& r, Float4& g, Float4& b)
+		{
+			const Float4 maxC = Simd::Max(r, Simd::Max(g, b));
+			const Float4 minC = Simd::Min(r, Simd::Min(g, b));
+			const Float4 chroma = maxC - minC;
+			const Float4 lightness = (maxC + minC) * Simd::Set1(0.5f);
+			const Float4 denominator = Simd::Set1(1.f) - Simd::Abs(lightness + lightness - Simd::Set1(1.f));
+			const Float4 saturation = Simd::And(Simd::CmpGt(chroma, Simd::Zero()), chroma * SafeReciprocal(denominator));
+			r = Hue(r, g, b, maxC, SafeReciprocal(chroma));
+			g = SaturateLanes(saturation);
+			b = lightness;
+		}
+
+		// f(n) = l - a * clamp(min(k - 3, 9 - k), -1, 1), k = (n + 12h) mod 12
+		void HslToRgbLanes(Float4& h, Float4& s, Float4& l)
+		{
+			const Float4 h12 = h * Simd::Set1(12.f);
+			const Float4 a = s * Simd::Min(l, Simd::Set1(1.f) - l);
+			Float4 channels[3];
+			const float offsets[3] = { 0.f, 8.f, 4.f };
+			for (int i = 0; i < 3; ++i)
+			{
+				const Float4 k = Wrap(h12 + Simd::Set1(offsets[i]), 12.f);
+				const Float4 ramp = Simd::Min(Simd::Max(Simd::Min(k - Simd::Set1(3.f), Simd::Set1(9.f) - k), Simd::Set1(-1.f)), Simd::Set1(1.f));
+				channels[i] = l - a * ramp;
+			}
+			h = channels[0];
+			s = channels[1];
+			l = channels[2];
+		}
+	}
+
+// sRGB <-> linear
+	void SrgbToLinear(const Colour3f* src, Colour3f* dst, size_t count, ColourPrecision precision)
+	{
+		if (precision == ColourPrecision::Fast)
+		{
+			ForEachBlock(src, dst, count, [](Float4& r, Float4& g, Float4& b)
+			{
+				r = SrgbToLinearFast(r);
+				g = SrgbToLinearFast(g);
+				b = SrgbToLinearFast(b);
+			});
+			return;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			dst[i] = { SrgbToLinearExact(src[i].x), SrgbToLinearExact(src[i].y), SrgbToLinearExact(src[i].z) };
+		}
+	}
+
+	void SrgbToLinear(const Colour4f* src, Colour4f* dst, size_t count, ColourPrecision precision)
+	{
+		if (precision == ColourPrecision::Fast)
+		{
+			ForEachBlock(src, dst, count, [](Float4& r, Float4& g, Float4& b)
+			{
+				r = SrgbToLinearFast(r);
+				g = SrgbToLinearFast(g);
+				b = SrgbToLinearFast(b);
+			});
+			return;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			dst[i] = { SrgbToLinearExact(src[i].x), SrgbToLinearExact(src[i].y), SrgbToLinearExact(src[i].z), src[i].w };
+		}
+	}
+
+	void SrgbToLinear(const Colour4b* src, Colour4f* dst, size_t count)
+	{
+		const float* table = GetSrgb8ToLinearTable();
+		for (size_t i = 0; i < count; ++i)
+		{
+			dst[i] = { table[src[i].x], table[src[i].y], table[src[i].z], src[i].w * k_inv255 };
+		}
+	}
+
+	void LinearToSrgb(const Colour3f* src, Colour3f* dst, size_t count, ColourPrecision precision)
+	{
+		if (precision == ColourPrecision::Fast)
+		{
+			ForEachBlock(src, dst, count, [](Float4& r, Float4& g, Float4& b)
+			{
+				r = LinearToSrgbFast(r);
+				g = LinearToSrgbFast(g);
+				b = LinearToSrgbFast(b);
+			});
+			return;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			dst[i] = { LinearToSrgbExact(src[i].x), LinearToSrgbExact(src[i].y), LinearToSrgbExact(src[i].z) };
+		}
+	}
+
+	void LinearToSrgb(const Colour4f* src, Colour4f* dst, size_t count, ColourPrecision precision)
+	{
+		if (precision == ColourPrecision::Fast)
+		{
+			ForEachBlock(src, dst, count, [](Float4& r, Float4& g, Float4& b)
+			{
+				r = LinearToSrgbFast(r);
+				g = LinearToSrgbFast(g);
+				b = LinearToSrgbFast(b);
+			});
+			return;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			dst[i] = { LinearToSrgbExact(src[i].x), LinearToSrgbExact(src[i].y), LinearToSrgbExact(src[i].z), src[i].w };
+		}
+	}
+
+	void LinearToSrgb(const Colour4f* src, Colour4b* dst, size_t count, ColourPrecision precision)
+	{
+		if (precision == ColourPrecision::Fast)
+		{
+			const uint8_t* table = GetLinearToSrgb8Table();
+			const float scale = static_cast<float>(k_linearToSrgb8TableSize - 1);
+			for (size_t i = 0; i < count; ++i)
+			{
+				dst[i] = {
+					table[static_cast<int>(Saturate(src[i].x) * scale + 0.5f)],
+					table[static_cast<int>(Saturate(src[i].y) * scale + 0.5f)],
+					table[static_cast<int>(Saturate(src[i].z) * scale + 0.5f)],
+					ToUnorm8(src[i].w)
+				};
+			}
+			return;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			dst[i] = {
+				ToUnorm8(LinearToSrgbExact(src[i].x)),
+				ToUnorm8(LinearToSrgbExact(src[i].y)),
+				ToUnorm8(LinearToSrgbExact(src[i].z)),
+				ToUnorm8(src[i].w)
+			};
+		}
+	}
+
+// HSV/HSL
+	void RgbToHsv(const Colour3f* src, Colour3f* dst, size_t count)
+	{
+		ForEachBlock(src, dst, count, RgbToHsvLanes);
+	}
+
+	void HsvToRgb(const Colour3f* src, Colour3f* dst, size_t count)
+	{
+		ForEachBlock(src, dst, count, HsvToRgbLanes);
+	}
+
+	void RgbToHsl(const Colour3f* src, Colour3f* dst, size_t count)
+	{
+		ForEachBlock(src, dst, count, RgbToHslLanes);
+	}
+
+	void HslToRgb(const Colour3f* src, Colour3f* dst, size_t count)
+	{
+		ForEachBlock(src, dst, count, HslToRgbLanes);
+	}
+
+// Luminance
+	void Luminance(const Colour3f* src, float* dst, size_t count)
+	{
+		const Float4 kr = Simd::Set1(0.2126f);
+		const Float4 kg = Simd::Set1(0.7152f);
+		const Float4 kb = Simd::Set1(0.0722f);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			Float4 r, g, b;
+			Simd::LoadTransposed3(src[i].e, r, g, b);
+			Simd::Store(dst + i, kr * r + kg * g + kb * b);
+		}
+		for (; i < count; ++i)
+		{
+			dst[i] = 0.2126f * src[i].x + 0.7152f * src[i].y + 0.0722f * src[i].z;
+		}
+	}
+
+	void Luminance(const Colour4f* src, float* dst, size_t count)
+	{
+		const Float4 kr = Simd::Set1(0.2126f);
+		const Float4 kg = Simd::Set1(0.7152f);
+		const Float4 kb = Simd::Set1(0.0722f);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			Float4 r, g, b, a;
+			Simd::LoadTransposed4(src[i].e, r, g, b, a);
+			Simd::Store(dst + i, kr * r + kg * g + kb * b);
+		}
+		for (; i < count; ++i)
+		{
+			dst[i] = 0.2126f * src[i].x + 0.7152f * src[i].y + 0.0722f * src[i].z;
+		}
+	}
+}
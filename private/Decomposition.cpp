@@ -0,0 +1,845 @@
+#include <Decomposition.h>
+
+#include <Parallel.h>
+
+#include <limits>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		// Sweeps over the three off-diagonal elements. Jacobi converges quadratically,
+		// and these are one more than it takes to reach rounding level on any input.
+		constexpr int k_floatSweeps = 4;
+		constexpr int k_doubleSweeps = 5;
+		// One-sided sweeps on m * v, which starts close to orthogonal
+		constexpr int k_orthogonalizeSweeps = 2;
+
+		// Position of element (row, column) in the upper triangle
+		constexpr int k_upperIndex[3][3] = { { 0, 1, 2 }, { 1, 3, 4 }, { 2, 4, 5 } };
+		// Row-major element of each position of the upper triangle
+		constexpr int k_upperElements[6] = { 0, 1, 2, 4, 5, 8 };
+
+		// Scalar versions of the lane operations the solvers use, so that one matrix
+		// takes exactly the steps it would in a batch. Lanes resolve to the Simd
+		// functions instead.
+		template <typename S>
+		typename std::enable_if<std::is_floating_point<S>::value, S>::type Splat(const double value)
+		{
+			return static_cast<S>(value);
+		}
+
+		template <typename S>
+		typename std::enable_if<!std::is_floating_point<S>::value, S>::type Splat(const double value)
+		{
+			using Scalar = decltype(Simd::GetLane(S(), 0));
+			return Simd::Set1(static_cast<Scalar>(value));
+		}
+
+		template <typename T>
+		bool CmpEq(const T a, const T b)
+		{
+			return a == b;
+		}
+
+		template <typename T>
+		bool CmpLt(const T a, const T b)
+		{
+			return a < b;
+		}
+
+		template <typename T>
+		T Select(const bool mask, const T a, const T b)
+		{
+			return mask ? a : b;
+		}
+
+		template <typename T>
+		T Max(const T a, const T b)
+		{
+			return a < b ? b : a;
+		}
+
+		// Smallest positive normal value, below which squares have lost precision
+		template <typename S>
+		typename std::enable_if<std::is_floating_point<S>::value, S>::type SmallestNormal()
+		{
+			return std::numeric_limits<S>::min();
+		}
+
+		template <typename S>
+		typename std::enable_if<!std::is_floating_point<S>::value, S>::type SmallestNormal()
+		{
+			using Scalar = decltype(Simd::GetLane(S(), 0));
+			return Simd::Set1(std::numeric_limits<Scalar>::min());
+		}
+
+		// Conditionally swaps a and b where mask is set
+		template <typename S, typename Mask>
+		void SwapWhere(const Mask mask, S& a, S& b)
+		{
+			const S t = a;
+			a = Select(mask, b, a);
+			b = Select(mask, t, b);
+		}
+
+		// Zeroes element (p, q) of the symmetric matrix a with a Jacobi rotation, which
+		// it also applies to the columns of v. r is the remaining index.
+		template <typename S>
+		void Rotate(S* a, S* v, const int p, const int q, const int r)
+		{
+			const S zero = Splat<S>(0.0);
+			const S one = Splat<S>(1.0);
+
+			const S apq = a[k_upperIndex[p][q]];
+			const S app = a[k_upperIndex[p][p]];
+			const S aqq = a[k_upperIndex[q][q]];
+
+			// tan of the rotation angle, the smaller root of t^2 + 2 * theta * t - 1
+			const S theta = (aqq - app) / (Splat<S>(2.0) * apq);
+			S t = Select(CmpLt(theta, zero), -one, one) / (Abs(theta) + Sqrt(theta * theta + one));
+			// Already diagonal, where theta is 0/0
+			t = Select(CmpEq(apq, zero), zero, t);
+			const S c = one / Sqrt(t * t + one);
+			const S s = t * c;
+
+			a[k_upperIndex[p][p]] = app - t * apq;
+			a[k_upperIndex[q][q]] = aqq + t * apq;
+			a[k_upperIndex[p][q]] = zero;
+			const S arp = a[k_upperIndex[r][p]];
+			const S arq = a[k_upperIndex[r][q]];
+			a[k_upperIndex[r][p]] = c * arp - s * arq;
+			a[k_upperIndex[r][q]] = s * arp + c * arq;
+
+			for (int row = 0; row < 3; ++row)
+			{
+				const S vp = v[row * 3 + p];
+				const S vq = v[row * 3 + q];
+				v[row * 3 + p] = c * vp - s * vq;
+				v[row * 3 + q] = s * vp + c * vq;
+			}
+		}
+
+		// Swaps eigenpairs i and j where eigenvalue j is larger
+		template <typename S>
+		void OrderEigenpairs(S* values, S* vectors, const int i, const int j)
+		{
+			const auto mask = CmpLt(values[i], values[j]);
+			SwapWhere(mask, values[i], values[j]);
+			for (int row = 0; row < 3; ++row)
+			{
+				SwapWhere(mask, vectors[row * 3 + i], vectors[row * 3 + j]);
+			}
+		}
+
+		// Determinant of the row-major matrix m
+		template <typename S>
+		S Determinant3x3(const S* m)
+		{
+			return m[0] * (m[4] * m[8] - m[5] * m[7]) - m[1] * (m[3] * m[8] - m[5] * m[6]) + m[2] * (m[3] * m[7] - m[4] * m[6]);
+		}
+
+		// Branch-free, so it runs on four matrices at once in SIMD lanes
+		template <typename S>
+		void DecomposeSymmetric3x3(const S* upper, S* values, S* vectors, const int sweeps)
+		{
+			const S zero = Splat<S>(0.0);
+			const S one = Splat<S>(1.0);
+
+			S a[6];
+			for (int k = 0; k < 6; ++k)
+			{
+				a[k] = upper[k];
+			}
+			for (int k = 0; k < 9; ++k)
+			{
+				vectors[k] = k % 4 == 0 ? one : zero;
+			}
+
+			for (int sweep = 0; sweep < sweeps; ++sweep)
+			{
+				Rotate(a, vectors, 0, 1, 2);
+				Rotate(a, vectors, 0, 2, 1);
+				Rotate(a, vectors, 1, 2, 0);
+			}
+
+			values[0] = a[0];
+			values[1] = a[3];
+			values[2] = a[5];
+			OrderEigenpairs(values, vectors, 0, 1);
+			OrderEigenpairs(values, vectors, 0, 2);
+			OrderEigenpairs(values, vectors, 1, 2);
+
+			// Rotations keep the determinant at +1, but each swap flips it
+			const S sign = Select(CmpLt(Determinant3x3(vectors), zero), -one, one);
+			for (int row = 0; row < 3; ++row)
+			{
+				vectors[row * 3 + 2] = vectors[row * 3 + 2] * sign;
+			}
+		}
+
+		template <typename T>
+		int SweepCount()
+		{
+			return std::is_same<T, float>::value ? k_floatSweeps : k_doubleSweeps;
+		}
+
+		// Rotates rows p and q of the row-major matrix b to zero b(q, column), and
+		// applies the transpose of the rotation to the columns of u, so u * b is unchanged
+		template <typename S>
+		void Givens(S* b, S* u, const int p, const int q, const int column)
+		{
+			const S zero = Splat<S>(0.0);
+			const S one = Splat<S>(1.0);
+
+			const S x = b[p * 3 + column];
+			const S y = b[q * 3 + column];
+			const S lengthSq = x * x + y * y;
+			const S invLength = one / Sqrt(lengthSq);
+			// Nothing to rotate where x and y are zero, or so small that lengthSq is
+			// denormal and would leave c and s unnormalized. m is scaled to a largest
+			// element of 1, so what is left in b(q, column) then is far below rounding.
+			const auto empty = CmpLt(lengthSq, SmallestNormal<S>());
+			const S c = Select(empty, one, x * invLength);
+			const S s = Select(empty, zero, y * invLength);
+
+			for (int k = 0; k < 3; ++k)
+			{
+				const S bp = b[p * 3 + k];
+				const S bq = b[q * 3 + k];
+				b[p * 3 + k] = c * bp + s * bq;
+				b[q * 3 + k] = c * bq - s * bp;
+				const S up = u[k * 3 + p];
+				const S uq = u[k * 3 + q];
+				u[k * 3 + p] = c * up + s * uq;
+				u[k * 3 + q] = c * uq - s * up;
+			}
+		}
+
+		// Rotates columns p and q of the row-major matrix b to make them orthogonal, and
+		// applies the rotation to the columns of v, so b * v^T is unchanged. This is
+		// Rotate on the 2x2 block of b^T * b, formed from the columns as they are.
+		template <typename S>
+		void Orthogonalize(S* b, S* v, const int p, const int q)
+		{
+			const S zero = Splat<S>(0.0);
+			const S one = Splat<S>(1.0);
+
+			const S bpp = b[p] * b[p] + b[3 + p] * b[3 + p] + b[6 + p] * b[6 + p];
+			const S bqq = b[q] * b[q] + b[3 + q] * b[3 + q] + b[6 + q] * b[6 + q];
+			const S bpq = b[p] * b[q] + b[3 + p] * b[3 + q] + b[6 + p] * b[6 + q];
+
+			const S theta = (bqq - bpp) / (Splat<S>(2.0) * bpq);
+			S t = Select(CmpLt(theta, zero), -one, one) / (Abs(theta) + Sqrt(theta * theta + one));
+			t = Select(CmpEq(bpq, zero), zero, t);
+			const S c = one / Sqrt(t * t + one);
+			const S s = t * c;
+
+			for (int row = 0; row < 3; ++row)
+			{
+				const S xp = b[row * 3 + p];
+				const S xq = b[row * 3 + q];
+				b[row * 3 + p] = c * xp - s * xq;
+				b[row * 3 + q] = s * xp + c * xq;
+				const S vp = v[row * 3 + p];
+				const S vq = v[row * 3 + q];
+				v[row * 3 + p] = c * vp - s * vq;
+				v[row * 3 + q] = s * vp + c * vq;
+			}
+		}
+
+		// Swaps columns i and j of the row-major matrices b and v where column j of b
+		// is longer
+		template <typename S>
+		void OrderColumns(S* lengthsSq, S* b, S* v, const int i, const int j)
+		{
+			const auto mask = CmpLt(lengthsSq[i], lengthsSq[j]);
+			SwapWhere(mask, lengthsSq[i], lengthsSq[j]);
+			for (int row = 0; row < 3; ++row)
+			{
+				SwapWhere(mask, b[row * 3 + i], b[row * 3 + j]);
+				SwapWhere(mask, v[row * 3 + i], v[row * 3 + j]);
+			}
+		}
+
+		// v from the eigenvectors of m^T * m, then u and the singular values from the QR
+		// factorization of m * v by Givens rotations, which leaves u a rotation and puts
+		// the sign of the determinant on the last singular value
+		template <typename S>
+		void DecomposeSvd3x3(const S* input, S* u, S* singularValues, S* v, const int sweeps)
+		{
+			const S zero = Splat<S>(0.0);
+			const S one = Splat<S>(1.0);
+
+			// Scaled to a largest element of 1, so m^T * m can neither overflow nor
+			// underflow, for any finite input
+			S largest = Abs(input[0]);
+			for (int k = 1; k < 9; ++k)
+			{
+				largest = Max(largest, Abs(input[k]));
+			}
+			const S scale = Select(CmpEq(largest, zero), one, largest);
+			S m[9];
+			for (int k = 0; k < 9; ++k)
+			{
+				m[k] = input[k] / scale;
+			}
+
+			S gram[6];
+			for (int p = 0; p < 3; ++p)
+			{
+				for (int q = p; q < 3; ++q)
+				{
+					gram[k_upperIndex[p][q]] = m[p] * m[q] + m[3 + p] * m[3 + q] + m[6 + p] * m[6 + q];
+				}
+			}
+			S eigenvalues[3];
+			DecomposeSymmetric3x3(gram, eigenvalues, v, sweeps);
+
+			S b[9];
+			for (int row = 0; row < 3; ++row)
+			{
+				for (int column = 0; column < 3; ++column)
+				{
+					b[row * 3 + column] = m[row * 3] * v[column] + m[row * 3 + 1] * v[3 + column] + m[row * 3 + 2] * v[6 + column];
+				}
+			}
+			// Squaring m squares its condition number, which leaves the columns of v for
+			// small singular values off by up to eps * (largest / smallest)^2. One-sided
+			// Jacobi sweeps on the columns of m * v bring that back to eps * largest /
+			// smallest; they converge quadratically from there, so a fixed count does.
+			for (int sweep = 0; sweep < k_orthogonalizeSweeps; ++sweep)
+			{
+				Orthogonalize(b, v, 0, 1);
+				Orthogonalize(b, v, 0, 2);
+				Orthogonalize(b, v, 1, 2);
+			}
+
+			// The eigenvalue order is lost where the Gram matrix rounded small singular
+			// values together, and the sweeps can reorder columns, so order them again
+			// by length. The QR then puts each singular value on its own axis, and the
+			// sign of the determinant on the smallest.
+			S lengthsSq[3];
+			for (int column = 0; column < 3; ++column)
+			{
+				lengthsSq[column] = b[column] * b[column] + b[3 + column] * b[3 + column] + b[6 + column] * b[6 + column];
+			}
+			OrderColumns(lengthsSq, b, v, 0, 1);
+			OrderColumns(lengthsSq, b, v, 0, 2);
+			OrderColumns(lengthsSq, b, v, 1, 2);
+			// Flipping column 2 of v flips column 2 of b = m * v with it
+			const S sign = Select(CmpLt(Determinant3x3(v), zero), -one, one);
+			for (int row = 0; row < 3; ++row)
+			{
+				v[row * 3 + 2] = v[row * 3 + 2] * sign;
+				b[row * 3 + 2] = b[row * 3 + 2] * sign;
+			}
+
+			for (int k = 0; k < 9; ++k)
+			{
+				u[k] = k % 4 == 0 ? one : zero;
+			}
+			Givens(b, u, 0, 1, 0);
+			Givens(b, u, 0, 2, 0);
+			Givens(b, u, 1, 2, 1);
+
+			singularValues[0] = b[0] * scale;
+			singularValues[1] = b[4] * scale;
+			singularValues[2] = b[8] * scale;
+		}
+
+		// rotation = u * v^T and stretch = v * diag(singularValues) * v^T
+		template <typename S>
+		void DecomposePolar3x3(const S* m, S* rotation, S* stretch, const int sweeps)
+		{
+			S u[9];
+			S singularValues[3];
+			S v[9];
+			DecomposeSvd3x3(m, u, singularValues, v, sweeps);
+
+			for (int row = 0; row < 3; ++row)
+			{
+				for (int column = 0; column < 3; ++column)
+				{
+					rotation[row * 3 + column] = u[row * 3] * v[column * 3] + u[row * 3 + 1] * v[column * 3 + 1]
+						+ u[row * 3 + 2] * v[column * 3 + 2];
+					stretch[row * 3 + column] = v[row * 3] * singularValues[0] * v[column * 3]
+						+ v[row * 3 + 1] * singularValues[1] * v[column * 3 + 1]
+						+ v[row * 3 + 2] * singularValues[2] * v[column * 3 + 2];
+				}
+			}
+		}
+
+		// Runs kernel(in, out) over elements [first, last) of a batch, four at a time in
+		// SIMD lanes, then one at a time with exactly the same steps. gather(i, in)
+		// fills the In inputs of element i, and scatter(i, out) takes its Out results.
+		template <typename T, int In, int Out, typename Gather, typename Kernel, typename Scatter>
+		void ForEachInLanes(const size_t first, const size_t last, const Gather& gather, const Kernel& kernel,
+			const Scatter& scatter)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				T inputs[4][In];
+				T outputs[4][Out];
+				for (int j = 0; j < 4; ++j)
+				{
+					gather(i + j, inputs[j]);
+				}
+
+				Lanes in[In];
+				Lanes out[Out];
+				for (int k = 0; k < In; ++k)
+				{
+					const T lanes[4] = { inputs[0][k], inputs[1][k], inputs[2][k], inputs[3][k] };
+					in[k] = Simd::Load(lanes);
+				}
+				kernel(in, out);
+				for (int k = 0; k < Out; ++k)
+				{
+					T lanes[4];
+					Simd::Store(lanes, out[k]);
+					for (int j = 0; j < 4; ++j)
+					{
+						outputs[j][k] = lanes[j];
+					}
+				}
+
+				for (int j = 0; j < 4; ++j)
+				{
+					scatter(i + j, outputs[j]);
+				}
+			}
+			for (; i < last; ++i)
+			{
+				T in[In];
+				T out[Out];
+				gather(i, in);
+				kernel(in, out);
+				scatter(i, out);
+			}
+		}
+
+		// ForEachInLanes over a whole batch, chunked over executor
+		template <typename T, int In, int Out, typename Gather, typename Kernel, typename Scatter>
+		void RunBatch(const size_t count, Executor* executor, const Gather& gather, const Kernel& kernel, const Scatter& scatter)
+		{
+			ParallelFor(count, GetChunkSize((In + Out) * sizeof(T)), [&](const size_t first, const size_t last) {
+				ForEachInLanes<T, In, Out>(first, last, gather, kernel, scatter);
+			}, executor);
+		}
+
+		template <typename T>
+		void DecomposeSymmetric3x3(const Matrix3x3SoA<const T>& src, const SymmetricEigenSoA<T>& out, const size_t count,
+			Executor* executor)
+		{
+			RunBatch<T, 6, 12>(count, executor,
+				[&src](const size_t i, T* upper) {
+					for (int k = 0; k < 6; ++k)
+					{
+						upper[k] = src.e[k_upperElements[k]][i];
+					}
+				},
+				[](const auto* upper, auto* results) {
+					DecomposeSymmetric3x3(upper, results, results + 3, SweepCount<T>());
+				},
+				[&out](const size_t i, const T* results) {
+					for (int k = 0; k < 3; ++k)
+					{
+						out.values[k][i] = results[k];
+					}
+					for (int k = 0; k < 9; ++k)
+					{
+						out.vectors[k][i] = results[3 + k];
+					}
+				});
+		}
+
+		template <typename T>
+		void DecomposeSymmetric3x3(const Matrix3x3<T>* src, SymmetricEigen<T>* out, const size_t count, Executor* executor)
+		{
+			RunBatch<T, 6, 12>(count, executor,
+				[src](const size_t i, T* upper) {
+					for (int k = 0; k < 6; ++k)
+					{
+						upper[k] = src[i](k_upperElements[k] / 3, k_upperElements[k] % 3);
+					}
+				},
+				[](const auto* upper, auto* results) {
+					DecomposeSymmetric3x3(upper, results, results + 3, SweepCount<T>());
+				},
+				[out](const size_t i, const T* results) {
+					out[i].values = Vector3<T>(results[0], results[1], results[2]);
+					for (int k = 0; k < 9; ++k)
+					{
+						out[i].vectors(k / 3, k % 3) = results[3 + k];
+					}
+				});
+		}
+
+		template <typename T>
+		void DecomposeSvd3x3(const Matrix3x3SoA<const T>& src, const SvdSoA<T>& out, const size_t count, Executor* executor)
+		{
+			RunBatch<T, 9, 21>(count, executor,
+				[&src](const size_t i, T* m) {
+					for (int k = 0; k < 9; ++k)
+					{
+						m[k] = src.e[k][i];
+					}
+				},
+				[](const auto* m, auto* results) {
+					DecomposeSvd3x3(m, results, results + 9, results + 12, SweepCount<T>());
+				},
+				[&out](const size_t i, const T* results) {
+					for (int k = 0; k < 9; ++k)
+					{
+						out.u[k][i] = results[k];
+						out.v[k][i] = results[12 + k];
+					}
+					for (int k = 0; k < 3; ++k)
+					{
+						out.singularValues[k][i] = results[9 + k];
+					}
+				});
+		}
+
+		template <typename T>
+		void DecomposeSvd3x3(const Matrix3x3<T>* src, Svd<T>* out, const size_t count, Executor* executor)
+		{
+			RunBatch<T, 9, 21>(count, executor,
+				[src](const size_t i, T* m) {
+					for (int k = 0; k < 9; ++k)
+					{
+						m[k] = src[i](k / 3, k % 3);
+					}
+				},
+				[](const auto* m, auto* results) {
+					DecomposeSvd3x3(m, results, results + 9, results + 12, SweepCount<T>());
+				},
+				[out](const size_t i, const T* results) {
+					for (int k = 0; k < 9; ++k)
+					{
+						out[i].u(k / 3, k % 3) = results[k];
+						out[i].v(k / 3, k % 3) = results[12 + k];
+					}
+					out[i].singularValues = Vector3<T>(results[9], results[10], results[11]);
+				});
+		}
+
+		template <typename T>
+		void DecomposePolar3x3(const Matrix3x3SoA<const T>& src, const PolarDecompositionSoA<T>& out, const size_t count,
+			Executor* executor)
+		{
+			RunBatch<T, 9, 18>(count, executor,
+				[&src](const size_t i, T* m) {
+					for (int k = 0; k < 9; ++k)
+					{
+						m[k] = src.e[k][i];
+					}
+				},
+				[](const auto* m, auto* results) {
+					DecomposePolar3x3(m, results, results + 9, SweepCount<T>());
+				},
+				[&out](const size_t i, const T* results) {
+					for (int k = 0; k < 9; ++k)
+					{
+						out.rotation[k][i] = results[k];
+						out.stretch[k][i] = results[9 + k];
+					}
+				});
+		}
+
+		template <typename T>
+		void DecomposePolar3x3(const Matrix3x3<T>* src, PolarDecomposition<T>* out, const size_t count, Executor* executor)
+		{
+			RunBatch<T, 9, 18>(count, executor,
+				[src](const size_t i, T* m) {
+					for (int k = 0; k < 9; ++k)
+					{
+						m[k] = src[i](k / 3, k % 3);
+					}
+				},
+				[](const auto* m, auto* results) {
+					DecomposePolar3x3(m, results, results + 9, SweepCount<T>());
+				},
+				[out](const size_t i, const T* results) {
+					for (int k = 0; k < 9; ++k)
+					{
+						out[i].rotation(k / 3, k % 3) = results[k];
+						out[i].stretch(k / 3, k % 3) = results[9 + k];
+					}
+				});
+		}
+
+		// Sums of the products of the centered components: xx, xy, xz, yy, yz, zz
+		template <typename T>
+		struct SecondMoments
+		{
+			T e[6];
+		};
+
+		template <typename T>
+		SecondMoments<T> SecondMomentsOf(const VectorSpan<const T, 3>& points, const Vector3<T>& mean, const size_t first,
+			const size_t last)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			const size_t stride = points.GetStride() / sizeof(T);
+			Lanes sums[6];
+			for (int k = 0; k < 6; ++k)
+			{
+				sums[k] = Simd::Set1(static_cast<T>(0));
+			}
+			const Lanes meanX = Simd::Set1(mean.x);
+			const Lanes meanY = Simd::Set1(mean.y);
+			const Lanes meanZ = Simd::Set1(mean.z);
+
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Lanes x;
+				Lanes y;
+				Lanes z;
+				Simd::LoadTransposed3(points[i], x, y, z, stride);
+				x = x - meanX;
+				y = y - meanY;
+				z = z - meanZ;
+				sums[0] = sums[0] + x * x;
+				sums[1] = sums[1] + x * y;
+				sums[2] = sums[2] + x * z;
+				sums[3] = sums[3] + y * y;
+				sums[4] = sums[4] + y * z;
+				sums[5] = sums[5] + z * z;
+			}
+
+			SecondMoments<T> moments;
+			for (int k = 0; k < 6; ++k)
+			{
+				moments.e[k] = (Simd::GetLane(sums[k], 0) + Simd::GetLane(sums[k], 1)) + (Simd::GetLane(sums[k], 2) + Simd::GetLane(sums[k], 3));
+			}
+			for (; i < last; ++i)
+			{
+				const Vector3<T> d = points.Load(i) - mean;
+				moments.e[0] += d.x * d.x;
+				moments.e[1] += d.x * d.y;
+				moments.e[2] += d.x * d.z;
+				moments.e[3] += d.y * d.y;
+				moments.e[4] += d.y * d.z;
+				moments.e[5] += d.z * d.z;
+			}
+			return moments;
+		}
+
+		// Bounds of the points in the frame of axes about origin
+		template <typename T>
+		VectorBounds<T, 3> LocalBoundsOf(const VectorSpan<const T, 3>& points, const Vector3<T>& origin, const Matrix3x3<T>& axes,
+			const size_t first, const size_t last)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			const size_t stride = points.GetStride() / sizeof(T);
+			Lanes lo[3];
+			Lanes hi[3];
+			Lanes axisLanes[9];
+			for (int k = 0; k < 3; ++k)
+			{
+				lo[k] = Simd::Set1(std::numeric_limits<T>::max());
+				hi[k] = Simd::Set1(-std::numeric_limits<T>::max());
+			}
+			for (int k = 0; k < 9; ++k)
+			{
+				axisLanes[k] = Simd::Set1(axes(k / 3, k % 3));
+			}
+			const Lanes originX = Simd::Set1(origin.x);
+			const Lanes originY = Simd::Set1(origin.y);
+			const Lanes originZ = Simd::Set1(origin.z);
+
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Lanes x;
+				Lanes y;
+				Lanes z;
+				Simd::LoadTransposed3(points[i], x, y, z, stride);
+				x = x - originX;
+				y = y - originY;
+				z = z - originZ;
+				for (int k = 0; k < 3; ++k)
+				{
+					const Lanes local = x * axisLanes[k] + y * axisLanes[3 + k] + z * axisLanes[6 + k];
+					lo[k] = Simd::Min(local, lo[k]);
+					hi[k] = Simd::Max(local, hi[k]);
+				}
+			}
+
+			VectorBounds<T, 3> bounds = VectorBounds<T, 3>::Empty();
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					bounds.min.e[k] = GeometryDetail::Min(Simd::GetLane(lo[k], lane), bounds.min.e[k]);
+					bounds.max.e[k] = GeometryDetail::Max(Simd::GetLane(hi[k], lane), bounds.max.e[k]);
+				}
+			}
+			for (; i < last; ++i)
+			{
+				const Vector3<T> d = points.Load(i) - origin;
+				Vector3<T> local;
+				for (int k = 0; k < 3; ++k)
+				{
+					local.e[k] = d.x * axes(0, k) + d.y * axes(1, k) + d.z * axes(2, k);
+				}
+				bounds.Expand(local);
+			}
+			return bounds;
+		}
+	}
+
+	namespace DecompositionDetail
+	{
+		template <typename T>
+		void DecomposeSymmetric(const T* upper, T* values, T* vectors)
+		{
+			DecomposeSymmetric3x3(upper, values, vectors, SweepCount<T>());
+		}
+
+		template <typename T>
+		void DecomposeSvd(const T* m, T* u, T* singularValues, T* v)
+		{
+			DecomposeSvd3x3(m, u, singularValues, v, SweepCount<T>());
+		}
+
+		template <typename T>
+		void DecomposePolar(const T* m, T* rotation, T* stretch)
+		{
+			DecomposePolar3x3(m, rotation, stretch, SweepCount<T>());
+		}
+
+		template <typename T>
+		Matrix3x3<T> ComputeCovariance(const VectorSpan<const T, 3>& points, const Vector3<T>& mean, Executor* executor)
+		{
+			assert(points.Count() > 0);
+			const SecondMoments<T> moments = ParallelReduce(points.Count(), GetChunkSize(3 * sizeof(T)), SecondMoments<T>(),
+				[&](const size_t first, const size_t last) {
+					return SecondMomentsOf(points, mean, first, last);
+				},
+				[](SecondMoments<T> a, const SecondMoments<T>& b) {
+					for (int k = 0; k < 6; ++k)
+					{
+						a.e[k] += b.e[k];
+					}
+					return a;
+				}, executor);
+
+			const T scale = static_cast<T>(1) / static_cast<T>(points.Count());
+			Matrix3x3<T> covariance;
+			for (int row = 0; row < 3; ++row)
+			{
+				for (int column = 0; column < 3; ++column)
+				{
+					covariance(row, column) = moments.e[k_upperIndex[row][column]] * scale;
+				}
+			}
+			return covariance;
+		}
+
+		template <typename T>
+		Obb<T> FitObb(const VectorSpan<const T, 3>& points, Executor* executor)
+		{
+			const PrincipalComponents<T> components = ComputePrincipalComponents(points, executor);
+			const VectorBounds<T, 3> local = ParallelReduce(points.Count(), GetChunkSize(3 * sizeof(T)), VectorBounds<T, 3>::Empty(),
+				[&](const size_t first, const size_t last) {
+					return LocalBoundsOf(points, components.mean, components.axes, first, last);
+				},
+				[](VectorBounds<T, 3> a, const VectorBounds<T, 3>& b) {
+					a.Merge(b);
+					return a;
+				}, executor);
+
+			Obb<T> box;
+			box.center = components.mean + components.axes * ((local.min + local.max) * static_cast<T>(0.5));
+			box.halfExtents = (local.max - local.min) * static_cast<T>(0.5);
+			box.axes = components.axes;
+			return box;
+		}
+
+		template void DecomposeSymmetric(const float*, float*, float*);
+		template void DecomposeSymmetric(const double*, double*, double*);
+		template void DecomposeSvd(const float*, float*, float*, float*);
+		template void DecomposeSvd(const double*, double*, double*, double*);
+		template void DecomposePolar(const float*, float*, float*);
+		template void DecomposePolar(const double*, double*, double*);
+
+		template Matrix3x3f ComputeCovariance(const VectorSpan<const float, 3>&, const Vector3f&, Executor*);
+		template Matrix3x3d ComputeCovariance(const VectorSpan<const double, 3>&, const Vector3d&, Executor*);
+
+		template Obbf FitObb(const VectorSpan<const float, 3>&, Executor*);
+		template Obbd FitObb(const VectorSpan<const double, 3>&, Executor*);
+	}
+
+	void DecomposeSymmetric(const Matrix3x3SoA<const float>& src, const SymmetricEigenSoA<float>& out, size_t count, Executor* executor)
+	{
+		DecomposeSymmetric3x3(src, out, count, executor);
+	}
+
+	void DecomposeSymmetric(const Matrix3x3SoA<const double>& src, const SymmetricEigenSoA<double>& out, size_t count, Executor* executor)
+	{
+		DecomposeSymmetric3x3(src, out, count, executor);
+	}
+
+	void DecomposeSymmetric(const Matrix3x3f* src, SymmetricEigenf* out, size_t count, Executor* executor)
+	{
+		DecomposeSymmetric3x3(src, out, count, executor);
+	}
+
+	void DecomposeSymmetric(const Matrix3x3d* src, SymmetricEigend* out, size_t count, Executor* executor)
+	{
+		DecomposeSymmetric3x3(src, out, count, executor);
+	}
+
+	void DecomposeSvd(const Matrix3x3SoA<const float>& src, const SvdSoA<float>& out, size_t count, Executor* executor)
+	{
+		DecomposeSvd3x3(src, out, count, executor);
+	}
+
+	void DecomposeSvd(const Matrix3x3SoA<const double>& src, const SvdSoA<double>& out, size_t count, Executor* executor)
+	{
+		DecomposeSvd3x3(src, out, count, executor);
+	}
+
+	void DecomposeSvd(const Matrix3x3f* src, Svdf* out, size_t count, Executor* executor)
+	{
+		DecomposeSvd3x3(src, out, count, executor);
+	}
+
+	void DecomposeSvd(const Matrix3x3d* src, Svdd* out, size_t count, Executor* executor)
+	{
+		DecomposeSvd3x3(src, out, count, executor);
+	}
+
+	void DecomposePolar(const Matrix3x3SoA<const float>& src, const PolarDecompositionSoA<float>& out, size_t count,
+		Executor* executor)
+	{
+		DecomposePolar3x3(src, out, count, executor);
+	}
+
+	void DecomposePolar(const Matrix3x3SoA<const double>& src, const PolarDecompositionSoA<double>& out, size_t count,
+		Executor* executor)
+	{
+		DecomposePolar3x3(src, out, count, executor);
+	}
+
+	void DecomposePolar(const Matrix3x3f* src, PolarDecompositionf* out, size_t count, Executor* executor)
+	{
+		DecomposePolar3x3(src, out, count, executor);
+	}
+
+	void DecomposePolar(const Matrix3x3d* src, PolarDecompositiond* out, size_t count, Executor* executor)
+	{
+		DecomposePolar3x3(src, out, count, executor);
+	}
+}
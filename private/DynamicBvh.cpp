@@ -0,0 +1,454 @@
+#include <DynamicBvh.h>
+
+#include <algorithm>
+
+namespace Math
+{
+	namespace
+	{
+		template <typename T>
+		Aabb<T> Union(const Aabb<T>& a, const Aabb<T>& b)
+		{
+			Aabb<T> result = a;
+			result.Merge(b);
+			return result;
+		}
+
+		template <typename T>
+		bool Encloses(const Aabb<T>& outer, const Aabb<T>& inner)
+		{
+			return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+				&& inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+		}
+	}
+
+	template <typename T>
+	DynamicBvh<T>::DynamicBvh(T margin)
+		: margin(margin)
+	{
+		assert(margin >= static_cast<T>(0));
+	}
+
+	template <typename T>
+	T DynamicBvh<T>::GetAreaCost() const
+	{
+		T cost = static_cast<T>(0);
+		for (const Node& node : nodes)
+		{
+			if (node.height > 0)
+			{
+				cost += node.bounds.GetSurfaceArea();
+			}
+		}
+		return cost;
+	}
+
+	template <typename T>
+	typename DynamicBvh<T>::ProxyId DynamicBvh<T>::Insert(const Aabb<T>& bounds, uint32_t userData)
+	{
+		const uint32_t leaf = AllocateNode();
+		nodes[leaf].bounds = Fatten(bounds);
+		nodes[leaf].userData = userData;
+		++proxyCount;
+		InsertLeaf(leaf);
+		return leaf;
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::Insert(const Aabb<T>* bounds, const uint32_t* userData, size_t count, ProxyId* ids)
+	{
+		assert((bounds != nullptr && userData != nullptr && ids != nullptr) || count == 0);
+
+		const size_t existing = proxyCount;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t leaf = AllocateNode();
+			nodes[leaf].bounds = Fatten(bounds[i]);
+			nodes[leaf].userData = userData[i];
+			ids[i] = leaf;
+		}
+		proxyCount += count;
+
+		if (count >= existing)
+		{
+			Rebuild();
+			return;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			InsertLeaf(ids[i]);
+		}
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::Remove(ProxyId id)
+	{
+		assert(IsProxy(id));
+		RefitUpward(RemoveLeaf(id));
+		FreeNode(id);
+		--proxyCount;
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::Remove(const ProxyId* ids, size_t count)
+	{
+		assert(ids != nullptr || count == 0);
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert(IsProxy(ids[i]));
+			MarkDirty(RemoveLeaf(ids[i]));
+			FreeNode(ids[i]);
+		}
+		proxyCount -= count;
+		RefitDirty();
+	}
+
+	template <typename T>
+	bool DynamicBvh<T>::Move(ProxyId id, const Aabb<T>& bounds)
+	{
+		assert(IsProxy(id));
+		if (Encloses(nodes[id].bounds, bounds))
+		{
+			return false;
+		}
+		nodes[id].bounds = Fatten(bounds);
+		RefitUpward(nodes[id].parent);
+		return true;
+	}
+
+	template <typename T>
+	size_t DynamicBvh<T>::Move(const ProxyId* ids, const Aabb<T>* bounds, size_t count)
+	{
+		assert((ids != nullptr && bounds != nullptr) || count == 0);
+		size_t moved = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t leaf = ids[i];
+			assert(IsProxy(leaf));
+			if (Encloses(nodes[leaf].bounds, bounds[i]))
+			{
+				continue;
+			}
+			nodes[leaf].bounds = Fatten(bounds[i]);
+			MarkDirty(leaf);
+			++moved;
+		}
+		if (moved > 0)
+		{
+			RefitDirty();
+		}
+		return moved;
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::Rebuild()
+	{
+		std::vector<uint32_t> leaves;
+		leaves.reserve(proxyCount);
+		for (uint32_t i = 0; i < nodes.size(); ++i)
+		{
+			if (nodes[i].height == 0)
+			{
+				leaves.push_back(i);
+			}
+			else if (nodes[i].height > 0)
+			{
+				FreeNode(i);
+			}
+		}
+		assert(leaves.size() == proxyCount);
+
+		root = leaves.empty() ? k_nullProxy : BuildTopDown(leaves.data(), leaves.size());
+		if (root != k_nullProxy)
+		{
+			nodes[root].parent = k_nullProxy;
+		}
+	}
+
+	template <typename T>
+	uint32_t DynamicBvh<T>::AllocateNode()
+	{
+		uint32_t index;
+		if (freeList != k_nullProxy)
+		{
+			index = freeList;
+			freeList = nodes[index].parent;
+		}
+		else
+		{
+			index = static_cast<uint32_t>(nodes.size());
+			assert(index != k_nullProxy);
+			nodes.emplace_back();
+		}
+
+		Node& node = nodes[index];
+		node.bounds = Aabb<T>::Empty();
+		node.parent = k_nullProxy;
+		node.children[0] = k_nullProxy;
+		node.children[1] = k_nullProxy;
+		node.height = 0;
+		node.userData = 0;
+		node.dirty = false;
+		return index;
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::FreeNode(uint32_t index)
+	{
+		Node& node = nodes[index];
+		node.height = -1;
+		node.dirty = false;
+		node.parent = freeList;
+		freeList = index;
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::InsertLeaf(uint32_t leaf)
+	{
+		if (root == k_nullProxy)
+		{
+			root = leaf;
+			nodes[leaf].parent = k_nullProxy;
+			return;
+		}
+
+		// Walk down towards the sibling that grows the tree's surface area least. Moving
+		// below a node costs the growth of that node, which all of its children inherit.
+		const Aabb<T> leafBounds = nodes[leaf].bounds;
+		uint32_t index = root;
+		while (!nodes[index].IsLeaf())
+		{
+			const Node& node = nodes[index];
+			const T area = node.bounds.GetSurfaceArea();
+			const T combinedArea = Union(node.bounds, leafBounds).GetSurfaceArea();
+			const T cost = static_cast<T>(2) * combinedArea;
+			const T inheritance = static_cast<T>(2) * (combinedArea - area);
+
+			T childCosts[2];
+			for (int k = 0; k < 2; ++k)
+			{
+				const Node& child = nodes[node.children[k]];
+				const T grown = Union(child.bounds, leafBounds).GetSurfaceArea();
+				childCosts[k] = (child.IsLeaf() ? grown : grown - child.bounds.GetSurfaceArea()) + inheritance;
+			}
+			if (cost < childCosts[0] && cost < childCosts[1])
+			{
+				break;
+			}
+			index = node.children[childCosts[0] <= childCosts[1] ? 0 : 1];
+		}
+
+		const uint32_t sibling = index;
+		const uint32_t oldParent = nodes[sibling].parent;
+		const uint32_t newParent = AllocateNode();
+		Node& parent = nodes[newParent];
+		parent.parent = oldParent;
+		parent.children[0] = sibling;
+		parent.children[1] = leaf;
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+		if (oldParent == k_nullProxy)
+		{
+			root = newParent;
+		}
+		else
+		{
+			Node& grandparent = nodes[oldParent];
+			grandparent.children[grandparent.children[0] == sibling ? 0 : 1] = newParent;
+		}
+		RefitUpward(newParent);
+	}
+
+	template <typename T>
+	uint32_t DynamicBvh<T>::RemoveLeaf(uint32_t leaf)
+	{
+		if (leaf == root)
+		{
+			root = k_nullProxy;
+			return k_nullProxy;
+		}
+
+		const uint32_t parent = nodes[leaf].parent;
+		const uint32_t grandparent = nodes[parent].parent;
+		const uint32_t sibling = nodes[parent].children[nodes[parent].children[0] == leaf ? 1 : 0];
+		nodes[sibling].parent = grandparent;
+		nodes[leaf].parent = k_nullProxy;
+		if (grandparent == k_nullProxy)
+		{
+			root = sibling;
+		}
+		else
+		{
+			Node& node = nodes[grandparent];
+			node.children[node.children[0] == parent ? 0 : 1] = sibling;
+		}
+		FreeNode(parent);
+		return grandparent;
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::UpdateNode(uint32_t index)
+	{
+		Node& node = nodes[index];
+		const Node& a = nodes[node.children[0]];
+		const Node& b = nodes[node.children[1]];
+		node.bounds = Union(a.bounds, b.bounds);
+		node.height = 1 + std::max(a.height, b.height);
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::Rotate(uint32_t index)
+	{
+		// Candidates swap one child of index with a child of its sibling, which shrinks
+		// the sibling to the union of the swapped-in child and its remaining child
+		int bestSide = -1;
+		int bestGrandchild = 0;
+		T bestGain = static_cast<T>(0);
+		const Node& node = nodes[index];
+		for (int side = 0; side < 2; ++side)
+		{
+			const Node& child = nodes[node.children[side]];
+			const Node& other = nodes[node.children[1 - side]];
+			if (other.IsLeaf())
+			{
+				continue;
+			}
+			const T otherArea = other.bounds.GetSurfaceArea();
+			for (int k = 0; k < 2; ++k)
+			{
+				const T gain = otherArea - Union(child.bounds, nodes[other.children[1 - k]].bounds).GetSurfaceArea();
+				if (gain > bestGain)
+				{
+					bestGain = gain;
+					bestSide = side;
+					bestGrandchild = k;
+				}
+			}
+		}
+		if (bestSide < 0)
+		{
+			return;
+		}
+
+		const uint32_t child = node.children[bestSide];
+		const uint32_t other = node.children[1 - bestSide];
+		const uint32_t grandchild = nodes[other].children[bestGrandchild];
+		nodes[index].children[bestSide] = grandchild;
+		nodes[grandchild].parent = index;
+		nodes[other].children[bestGrandchild] = child;
+		nodes[child].parent = other;
+		UpdateNode(other);
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::RefitUpward(uint32_t index)
+	{
+		while (index != k_nullProxy)
+		{
+			Rotate(index);
+			UpdateNode(index);
+			index = nodes[index].parent;
+		}
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::MarkDirty(uint32_t index)
+	{
+		// Every ancestor of a dirty node is already dirty
+		while (index != k_nullProxy && !nodes[index].dirty)
+		{
+			nodes[index].dirty = true;
+			index = nodes[index].parent;
+		}
+	}
+
+	template <typename T>
+	void DynamicBvh<T>::RefitDirty()
+	{
+		if (root == k_nullProxy || !nodes[root].dirty)
+		{
+			return;
+		}
+
+		// Post-order over the dirty nodes only, so children are refit before parents
+		struct Entry
+		{
+			uint32_t index;
+			bool childrenDone;
+		};
+		std::vector<Entry> stack;
+		stack.push_back({ root, false });
+		while (!stack.empty())
+		{
+			const Entry entry = stack.back();
+			stack.pop_back();
+			Node& node = nodes[entry.index];
+			if (node.IsLeaf())
+			{
+				node.dirty = false;
+				continue;
+			}
+			if (!entry.childrenDone)
+			{
+				stack.push_back({ entry.index, true });
+				for (int k = 0; k < 2; ++k)
+				{
+					if (nodes[node.children[k]].dirty)
+					{
+						stack.push_back({ node.children[k], false });
+					}
+				}
+				continue;
+			}
+			Rotate(entry.index);
+			UpdateNode(entry.index);
+			nodes[entry.index].dirty = false;
+		}
+	}
+
+	template <typename T>
+	uint32_t DynamicBvh<T>::BuildTopDown(uint32_t* leaves, size_t count)
+	{
+		if (count == 1)
+		{
+			return leaves[0];
+		}
+
+		Aabb<T> centroids = Aabb<T>::Empty();
+		for (size_t i = 0; i < count; ++i)
+		{
+			centroids.Expand(nodes[leaves[i]].bounds.GetCenter());
+		}
+		const Vector3<T> extent = centroids.max - centroids.min;
+		int axis = 0;
+		if (extent.y > extent[axis])
+		{
+			axis = 1;
+		}
+		if (extent.z > extent[axis])
+		{
+			axis = 2;
+		}
+
+		const size_t mid = count / 2;
+		std::nth_element(leaves, leaves + mid, leaves + count, [this, axis](uint32_t a, uint32_t b) {
+			const T ca = nodes[a].bounds.min[axis] + nodes[a].bounds.max[axis];
+			const T cb = nodes[b].bounds.min[axis] + nodes[b].bounds.max[axis];
+			return ca < cb || (ca == cb && a < b);
+		});
+
+		const uint32_t left = BuildTopDown(leaves, mid);
+		const uint32_t right = BuildTopDown(leaves + mid, count - mid);
+		const uint32_t index = AllocateNode();
+		Node& node = nodes[index];
+		node.children[0] = left;
+		node.children[1] = right;
+		nodes[left].parent = index;
+		nodes[right].parent = index;
+		UpdateNode(index);
+		return index;
+	}
+
+	template class DynamicBvh<float>;
+	template class DynamicBvh<double>;
+}
@@ -0,0 +1,292 @@
+#include <Fixed.h>
+#include <Parallel.h>
+
+#include "Simd.h"
+
+namespace Math
+{
+	template<>
+	const Vector2x Vector2x::UNIT_X = Vector2x(1, 0);
+	template<>
+	const Vector2x Vector2x::UNIT_Y = Vector2x(0, 1);
+
+	template<>
+	const Vector3x Vector3x::UNIT_X = Vector3x(1, 0, 0);
+	template<>
+	const Vector3x Vector3x::UNIT_Y = Vector3x(0, 1, 0);
+	template<>
+	const Vector3x Vector3x::UNIT_Z = Vector3x(0, 0, 1);
+
+	template<>
+	const Vector4x Vector4x::UNIT_X = Vector4x(1, 0, 0, 0);
+	template<>
+	const Vector4x Vector4x::UNIT_Y = Vector4x(0, 1, 0, 0);
+	template<>
+	const Vector4x Vector4x::UNIT_Z = Vector4x(0, 0, 1, 0);
+	template<>
+	const Vector4x Vector4x::UNIT_W = Vector4x(0, 0, 0, 1);
+
+	template<>
+	const Matrix3x3x Matrix3x3x::IDENTITY =
+		Matrix3x3x(
+			Vector3x(1, 0, 0),
+			Vector3x(0, 1, 0),
+			Vector3x(0, 0, 1)
+		);
+
+	static_assert(sizeof(Fixed32) == 4, "Fixed32 must be a bare int32");
+	static_assert(sizeof(Vector3x) == 12 && sizeof(Vector4x) == 16, "Fixed vectors must be tightly packed");
+	static_assert(sizeof(Quaternionx) == 16, "Fixed quaternions must be tightly packed");
+
+	namespace
+	{
+		inline const int32_t* Raw(const void* p)
+		{
+			return static_cast<const int32_t*>(p);
+		}
+
+		inline int32_t* Raw(void* p)
+		{
+			return static_cast<int32_t*>(p);
+		}
+
+#if MATH_SIMD_SSE2
+		constexpr int k_fracBits = Fixed32::k_fracBits;
+
+		inline __m128i Load(const int32_t* p)
+		{
+			return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		}
+
+		inline void Store(int32_t* p, const __m128i v)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+		}
+
+		// Per-lane rounded (a * b) >> k_fracBits, bit-identical to Fixed32::operator*.
+		// Only bits [k_fracBits, k_fracBits + 32) of each 64-bit product survive, so a
+		// logical shift gives the same low half as the scalar arithmetic shift.
+		inline __m128i MulFixed(const __m128i a, const __m128i b)
+		{
+			const __m128i lowMask = _mm_set_epi32(0, -1, 0, -1);
+#if MATH_SIMD_SSE41
+			__m128i even = _mm_mul_epi32(a, b);
+			__m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+#else
+			// Unsigned products, corrected to signed by subtracting (a < 0 ? b : 0) + (b < 0 ? a : 0)
+			// from the high halves
+			__m128i even = _mm_mul_epu32(a, b);
+			__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+			const __m128i correction = _mm_add_epi32(
+				_mm_and_si128(_mm_srai_epi32(a, 31), b),
+				_mm_and_si128(_mm_srai_epi32(b, 31), a));
+			even = _mm_sub_epi64(even, _mm_slli_epi64(correction, 32));
+			odd = _mm_sub_epi64(odd, _mm_andnot_si128(lowMask, correction));
+#endif
+			const __m128i round = _mm_set1_epi64x(int64_t(1) << (k_fracBits - 1));
+			even = _mm_srli_epi64(_mm_add_epi64(even, round), k_fracBits);
+			odd = _mm_srli_epi64(_mm_add_epi64(odd, round), k_fracBits);
+			return _mm_or_si128(_mm_and_si128(even, lowMask), _mm_slli_epi64(odd, 32));
+		}
+
+		// Integer lanes reuse the float shuffles; shuffles move bits without touching them
+		inline void LoadTransposed3(const int32_t* p, __m128i& x, __m128i& y, __m128i& z)
+		{
+			Simd::Float4 fx, fy, fz;
+			Simd::LoadTransposed3(reinterpret_cast<const float*>(p), fx, fy, fz);
+			x = _mm_castps_si128(fx.v);
+			y = _mm_castps_si128(fy.v);
+			z = _mm_castps_si128(fz.v);
+		}
+
+		inline void StoreTransposed3(int32_t* p, const __m128i x, const __m128i y, const __m128i z)
+		{
+			Simd::StoreTransposed3(reinterpret_cast<float*>(p), { _mm_castsi128_ps(x) }, { _mm_castsi128_ps(y) }, { _mm_castsi128_ps(z) });
+		}
+
+		inline void LoadTransposed4(const int32_t* p, __m128i& x, __m128i& y, __m128i& z, __m128i& w)
+		{
+			Simd::Float4 fx, fy, fz, fw;
+			Simd::LoadTransposed4(reinterpret_cast<const float*>(p), fx, fy, fz, fw);
+			x = _mm_castps_si128(fx.v);
+			y = _mm_castps_si128(fy.v);
+			z = _mm_castps_si128(fz.v);
+			w = _mm_castps_si128(fw.v);
+		}
+
+		inline void StoreTransposed4(int32_t* p, const __m128i x, const __m128i y, const __m128i z, const __m128i w)
+		{
+			Simd::StoreTransposed4(reinterpret_cast<float*>(p),
+				{ _mm_castsi128_ps(x) }, { _mm_castsi128_ps(y) }, { _mm_castsi128_ps(z) }, { _mm_castsi128_ps(w) });
+		}
+#endif
+	}
+
+	void Add(const Vector4x* lhs, const Vector4x* rhs, Vector4x* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Vector4x)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+#if MATH_SIMD_SSE2
+			for (; i < last; ++i)
+			{
+				Store(Raw(out + i), _mm_add_epi32(Load(Raw(lhs + i)), Load(Raw(rhs + i))));
+			}
+#endif
+			for (; i < last; ++i)
+			{
+				out[i] = lhs[i] + rhs[i];
+			}
+		}, executor);
+	}
+
+	void Subtract(const Vector4x* lhs, const Vector4x* rhs, Vector4x* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Vector4x)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+#if MATH_SIMD_SSE2
+			for (; i < last; ++i)
+			{
+				Store(Raw(out + i), _mm_sub_epi32(Load(Raw(lhs + i)), Load(Raw(rhs + i))));
+			}
+#endif
+			for (; i < last; ++i)
+			{
+				out[i] = lhs[i] - rhs[i];
+			}
+		}, executor);
+	}
+
+	void Multiply(const Vector4x* lhs, const Vector4x* rhs, Vector4x* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Vector4x)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+#if MATH_SIMD_SSE2
+			for (; i < last; ++i)
+			{
+				Store(Raw(out + i), MulFixed(Load(Raw(lhs + i)), Load(Raw(rhs + i))));
+			}
+#endif
+			for (; i < last; ++i)
+			{
+				out[i] = lhs[i] * rhs[i];
+			}
+		}, executor);
+	}
+
+	void Scale(const Vector4x* src, const Fixed32 scale, Vector4x* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Vector4x)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+#if MATH_SIMD_SSE2
+			const __m128i s = _mm_set1_epi32(scale.GetRaw());
+			for (; i < last; ++i)
+			{
+				Store(Raw(out + i), MulFixed(Load(Raw(src + i)), s));
+			}
+#endif
+			for (; i < last; ++i)
+			{
+				out[i] = src[i] * scale;
+			}
+		}, executor);
+	}
+
+	void Dot(const Vector4x* lhs, const Vector4x* rhs, Fixed32* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Vector4x) + sizeof(Fixed32)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+#if MATH_SIMD_SSE2
+			for (; i + 4 <= last; i += 4)
+			{
+				__m128i ax, ay, az, aw, bx, by, bz, bw;
+				LoadTransposed4(Raw(lhs + i), ax, ay, az, aw);
+				LoadTransposed4(Raw(rhs + i), bx, by, bz, bw);
+				const __m128i xy = _mm_add_epi32(MulFixed(ax, bx), MulFixed(ay, by));
+				const __m128i zw = _mm_add_epi32(MulFixed(az, bz), MulFixed(aw, bw));
+				Store(Raw(out + i), _mm_add_epi32(xy, zw));
+			}
+#endif
+			for (; i < last; ++i)
+			{
+				out[i] = Math::Dot(lhs[i], rhs[i]);
+			}
+		}, executor);
+	}
+
+	void Dot(const Vector3x* lhs, const Vector3x* rhs, Fixed32* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Vector3x) + sizeof(Fixed32)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+#if MATH_SIMD_SSE2
+			for (; i + 4 <= last; i += 4)
+			{
+				__m128i ax, ay, az, bx, by, bz;
+				LoadTransposed3(Raw(lhs + i), ax, ay, az);
+				LoadTransposed3(Raw(rhs + i), bx, by, bz);
+				const __m128i xy = _mm_add_epi32(MulFixed(ax, bx), MulFixed(ay, by));
+				Store(Raw(out + i), _mm_add_epi32(xy, MulFixed(az, bz)));
+			}
+#endif
+			for (; i < last; ++i)
+			{
+				out[i] = Math::Dot(lhs[i], rhs[i]);
+			}
+		}, executor);
+	}
+
+	void Transform(const Matrix3x3x& m, const Vector3x* src, Vector3x* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Vector3x)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+#if MATH_SIMD_SSE2
+			__m128i rows[3][3];
+			for (int r = 0; r < 3; ++r)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					rows[r][c] = _mm_set1_epi32(m.GetRow(r).e[c].GetRaw());
+				}
+			}
+			for (; i + 4 <= last; i += 4)
+			{
+				__m128i x, y, z;
+				LoadTransposed3(Raw(src + i), x, y, z);
+				__m128i result[3];
+				for (int r = 0; r < 3; ++r)
+				{
+					result[r] = _mm_add_epi32(_mm_add_epi32(MulFixed(rows[r][0], x), MulFixed(rows[r][1], y)), MulFixed(rows[r][2], z));
+				}
+				StoreTransposed3(Raw(out + i), result[0], result[1], result[2]);
+			}
+#endif
+			for (; i < last; ++i)
+			{
+				out[i] = m * src[i];
+			}
+		}, executor);
+	}
+
+	void Multiply(const Quaternionx* lhs, const Quaternionx* rhs, Quaternionx* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Quaternionx)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+#if MATH_SIMD_SSE2
+			for (; i + 4 <= last; i += 4)
+			{
+				__m128i x1, y1, z1, w1, x2, y2, z2, w2;
+				LoadTransposed4(Raw(lhs + i), x1, y1, z1, w1);
+				LoadTransposed4(Raw(rhs + i), x2, y2, z2, w2);
+				const __m128i x = _mm_sub_epi32(_mm_add_epi32(_mm_add_epi32(MulFixed(w1, x2), MulFixed(x1, w2)), MulFixed(y1, z2)), MulFixed(z1, y2));
+				const __m128i y = _mm_sub_epi32(_mm_add_epi32(_mm_add_epi32(MulFixed(w1, y2), MulFixed(y1, w2)), MulFixed(z1, x2)), MulFixed(x1, z2));
+				const __m128i z = _mm_sub_epi32(_mm_add_epi32(_mm_add_epi32(MulFixed(w1, z2), MulFixed(z1, w2)), MulFixed(x1, y2)), MulFixed(y1, x2));
+				const __m128i w = _mm_sub_epi32(_mm_sub_epi32(_mm_sub_epi32(MulFixed(w1, w2), MulFixed(x1, x2)), MulFixed(y1, y2)), MulFixed(z1, z2));
+				StoreTransposed4(Raw(out + i), x, y, z, w);
+			}
+#endif
+			for (; i < last; ++i)
+			{
+				out[i] = lhs[i] * rhs[i];
+			}
+		}, executor);
+	}
+}
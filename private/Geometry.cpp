@@ -0,0 +1,249 @@
+#include <Geometry.h>
+
+#include <cstring>
+
+#include "Simd.h"
+
+namespace Math
+{
+	template struct Aabb<float>;
+	template struct Aabb<double>;
+	template struct Sphere<float>;
+	template struct Sphere<double>;
+	template struct Plane<float>;
+	template struct Plane<double>;
+	template struct Ray<float>;
+	template struct Ray<double>;
+	template struct Obb<float>;
+	template struct Obb<double>;
+
+	namespace
+	{
+		constexpr size_t k_blockSize = 4;
+
+		// Runs test over blocks of four elements, each taken as N component arrays, and
+		// packs the returned lane masks into hits. The final partial block is padded
+		// with zeros so it goes through the same arithmetic; its padding bits are dropped.
+		template <typename T, size_t N, typename Test>
+		void TestBlocks(const T* const (&arrays)[N], const size_t count, uint32_t* hits, Test test)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			assert(hits != nullptr || count == 0);
+			std::memset(hits, 0, GetMaskWordCount(count) * sizeof(uint32_t));
+
+			Lanes lanes[N];
+			size_t i = 0;
+			for (; i + k_blockSize <= count; i += k_blockSize)
+			{
+				for (size_t k = 0; k < N; ++k)
+				{
+					lanes[k] = Simd::Load(arrays[k] + i);
+				}
+				hits[i / 32] |= static_cast<uint32_t>(test(lanes)) << (i % 32);
+			}
+
+			const size_t remaining = count - i;
+			if (remaining > 0)
+			{
+				T padded[k_blockSize] = {};
+				for (size_t k = 0; k < N; ++k)
+				{
+					std::memcpy(padded, arrays[k] + i, remaining * sizeof(T));
+					lanes[k] = Simd::Load(padded);
+				}
+				const uint32_t mask = static_cast<uint32_t>(test(lanes)) & ((1u << remaining) - 1);
+				hits[i / 32] |= mask << (i % 32);
+			}
+		}
+
+		template <typename T>
+		void IntersectRayBoxes(const Ray<T>& ray, const T tMax, const AabbSoA<const T>& boxes, const size_t count, uint32_t* hits)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			const Vector3<T> invDirection = ray.GetInverseDirection();
+			Lanes origin[3];
+			Lanes inverse[3];
+			for (size_t c = 0; c < 3; ++c)
+			{
+				origin[c] = Simd::Set1(ray.origin[c]);
+				inverse[c] = Simd::Set1(invDirection[c]);
+			}
+			const Lanes zero = Simd::Set1(static_cast<T>(0));
+			const Lanes limit = Simd::Set1(tMax);
+
+			const T* const arrays[6] = { boxes.min[0], boxes.min[1], boxes.min[2], boxes.max[0], boxes.max[1], boxes.max[2] };
+			TestBlocks(arrays, count, hits, [&](const Lanes (&box)[6]) {
+				Lanes nearT = zero;
+				Lanes farT = limit;
+				for (size_t c = 0; c < 3; ++c)
+				{
+					const Lanes t1 = (box[c] - origin[c]) * inverse[c];
+					const Lanes t2 = (box[3 + c] - origin[c]) * inverse[c];
+					nearT = Simd::Max(nearT, Simd::Min(t1, t2));
+					farT = Simd::Min(farT, Simd::Max(t1, t2));
+				}
+				return Simd::MoveMask(Simd::CmpLe(nearT, farT));
+			});
+		}
+
+		template <typename T>
+		void OverlapBoxes(const Aabb<T>& box, const AabbSoA<const T>& boxes, const size_t count, uint32_t* hits)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			Lanes boxMin[3];
+			Lanes boxMax[3];
+			for (size_t c = 0; c < 3; ++c)
+			{
+				boxMin[c] = Simd::Set1(box.min[c]);
+				boxMax[c] = Simd::Set1(box.max[c]);
+			}
+
+			const T* const arrays[6] = { boxes.min[0], boxes.min[1], boxes.min[2], boxes.max[0], boxes.max[1], boxes.max[2] };
+			TestBlocks(arrays, count, hits, [&](const Lanes (&other)[6]) {
+				Lanes overlap = Simd::And(Simd::CmpLe(boxMin[0], other[3]), Simd::CmpLe(other[0], boxMax[0]));
+				for (size_t c = 1; c < 3; ++c)
+				{
+					overlap = Simd::And(overlap, Simd::And(Simd::CmpLe(boxMin[c], other[3 + c]), Simd::CmpLe(other[c], boxMax[c])));
+				}
+				return Simd::MoveMask(overlap);
+			});
+		}
+
+		template <typename T>
+		void OverlapSpheres(const Sphere<T>& sphere, const SphereSoA<const T>& spheres, const size_t count, uint32_t* hits)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			const Lanes center[3] = { Simd::Set1(sphere.center.x), Simd::Set1(sphere.center.y), Simd::Set1(sphere.center.z) };
+			const Lanes radius = Simd::Set1(sphere.radius);
+
+			const T* const arrays[4] = { spheres.center[0], spheres.center[1], spheres.center[2], spheres.radius };
+			TestBlocks(arrays, count, hits, [&](const Lanes (&other)[4]) {
+				const Lanes dx = other[0] - center[0];
+				const Lanes dy = other[1] - center[1];
+				const Lanes dz = other[2] - center[2];
+				const Lanes sum = radius + other[3];
+				return Simd::MoveMask(Simd::CmpLe(dx * dx + dy * dy + dz * dz, sum * sum));
+			});
+		}
+
+		// Lane-wise copy of the scalar Overlaps(Obb, Obb), with a broadcast and b in lanes
+		template <typename T>
+		void OverlapObbs(const Obb<T>& box, const ObbSoA<const T>& boxes, const size_t count, uint32_t* hits)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			Lanes center[3];
+			Lanes ea[3];
+			Lanes axes[9];
+			for (int c = 0; c < 3; ++c)
+			{
+				center[c] = Simd::Set1(box.center[c]);
+				ea[c] = Simd::Set1(box.halfExtents[c]);
+			}
+			for (int k = 0; k < 9; ++k)
+			{
+				axes[k] = Simd::Set1(box.axes(k / 3, k % 3));
+			}
+			const Lanes epsilon = Simd::Set1(GeometryDetail::ObbEpsilon<T>());
+
+			const T* const arrays[15] = {
+				boxes.center[0], boxes.center[1], boxes.center[2],
+				boxes.halfExtents[0], boxes.halfExtents[1], boxes.halfExtents[2],
+				boxes.axes[0], boxes.axes[1], boxes.axes[2], boxes.axes[3], boxes.axes[4],
+				boxes.axes[5], boxes.axes[6], boxes.axes[7], boxes.axes[8]
+			};
+			TestBlocks(arrays, count, hits, [&](const Lanes (&other)[15]) {
+				const Lanes* eb = other + 3;
+				const Lanes* b = other + 6;
+
+				Lanes r[3][3];
+				Lanes absR[3][3];
+				for (int i = 0; i < 3; ++i)
+				{
+					for (int j = 0; j < 3; ++j)
+					{
+						r[i][j] = axes[i] * b[j] + axes[3 + i] * b[3 + j] + axes[6 + i] * b[6 + j];
+						absR[i][j] = Simd::Abs(r[i][j]) + epsilon;
+					}
+				}
+				const Lanes d[3] = { other[0] - center[0], other[1] - center[1], other[2] - center[2] };
+				Lanes t[3];
+				for (int i = 0; i < 3; ++i)
+				{
+					t[i] = axes[i] * d[0] + axes[3 + i] * d[1] + axes[6 + i] * d[2];
+				}
+
+				// All bits clear, so no lane starts out separated
+				Lanes separated = Simd::Set1(static_cast<T>(0));
+				for (int i = 0; i < 3; ++i)
+				{
+					const Lanes rb = eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2];
+					separated = Simd::Or(separated, Simd::CmpGt(Simd::Abs(t[i]), ea[i] + rb));
+				}
+				for (int j = 0; j < 3; ++j)
+				{
+					const Lanes ra = ea[0] * absR[0][j] + ea[1] * absR[1][j] + ea[2] * absR[2][j];
+					separated = Simd::Or(separated, Simd::CmpGt(Simd::Abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]), ra + eb[j]));
+				}
+				for (int i = 0; i < 3; ++i)
+				{
+					const int i1 = (i + 1) % 3;
+					const int i2 = (i + 2) % 3;
+					for (int j = 0; j < 3; ++j)
+					{
+						const int j1 = (j + 1) % 3;
+						const int j2 = (j + 2) % 3;
+						const Lanes ra = ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j];
+						const Lanes rb = eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1];
+						separated = Simd::Or(separated, Simd::CmpGt(Simd::Abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]), ra + rb));
+					}
+				}
+				return ~Simd::MoveMask(separated) & 0xF;
+			});
+		}
+	}
+
+	void Intersect(const Rayf& ray, float tMax, const AabbSoA<const float>& boxes, size_t count, uint32_t* hits)
+	{
+		IntersectRayBoxes(ray, tMax, boxes, count, hits);
+	}
+
+	void Intersect(const Rayd& ray, double tMax, const AabbSoA<const double>& boxes, size_t count, uint32_t* hits)
+	{
+		IntersectRayBoxes(ray, tMax, boxes, count, hits);
+	}
+
+	void Overlaps(const Aabbf& box, const AabbSoA<const float>& boxes, size_t count, uint32_t* hits)
+	{
+		OverlapBoxes(box, boxes, count, hits);
+	}
+
+	void Overlaps(const Aabbd& box, const AabbSoA<const double>& boxes, size_t count, uint32_t* hits)
+	{
+		OverlapBoxes(box, boxes, count, hits);
+	}
+
+	void Overlaps(const Spheref& sphere, const SphereSoA<const float>& spheres, size_t count, uint32_t* hits)
+	{
+		OverlapSpheres(sphere, spheres, count, hits);
+	}
+
+	void Overlaps(const Sphered& sphere, const SphereSoA<const double>& spheres, size_t count, uint32_t* hits)
+	{
+		OverlapSpheres(sphere, spheres, count, hits);
+	}
+
+	void Overlaps(const Obbf& box, const ObbSoA<const float>& boxes, size_t count, uint32_t* hits)
+	{
+		OverlapObbs(box, boxes, count, hits);
+	}
+
+	void Overlaps(const Obbd& box, const ObbSoA<const double>& boxes, size_t count, uint32_t* hits)
+	{
+		OverlapObbs(box, boxes, count, hits);
+	}
+}
@@ -0,0 +1,105 @@
+#include <Gjk.h>
+
+#include <Parallel.h>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		// Pairs per task; each pair is a whole GJK run, so tasks can be small
+		constexpr size_t k_grainSize = 64;
+
+		// Each lane keeps the largest dot product it has seen and the first index it
+		// was seen at. Indices are carried as floating point lanes, which is exact for
+		// any vertex count a hull can reasonably have.
+		template <typename T>
+		size_t FindSupport(const T* x, const T* y, const T* z, const size_t count, const Vector3<T>& direction)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+			assert(x != nullptr && y != nullptr && z != nullptr && count > 0);
+			assert(count < (size_t(1) << std::numeric_limits<T>::digits));
+
+			size_t best = 0;
+			T bestDot = x[0] * direction.x + y[0] * direction.y + z[0] * direction.z;
+			size_t i = 0;
+			if (count >= 4)
+			{
+				const Lanes dx = Simd::Set1(direction.x);
+				const Lanes dy = Simd::Set1(direction.y);
+				const Lanes dz = Simd::Set1(direction.z);
+				const Lanes four = Simd::Set1(static_cast<T>(4));
+				const T firstIndices[4] = { static_cast<T>(0), static_cast<T>(1), static_cast<T>(2), static_cast<T>(3) };
+				Lanes index = Simd::Load(firstIndices);
+				Lanes bestIndices = index;
+				Lanes bestDots = Simd::MulAdd(Simd::Load(z), dz, Simd::MulAdd(Simd::Load(y), dy, Simd::Load(x) * dx));
+				for (i = 4; i + 4 <= count; i += 4)
+				{
+					index = index + four;
+					const Lanes dots = Simd::MulAdd(Simd::Load(z + i), dz, Simd::MulAdd(Simd::Load(y + i), dy, Simd::Load(x + i) * dx));
+					const Lanes greater = Simd::CmpGt(dots, bestDots);
+					bestDots = Simd::Select(greater, dots, bestDots);
+					bestIndices = Simd::Select(greater, index, bestIndices);
+				}
+				// Largest lane, the lowest index among equal ones
+				bestDot = Simd::GetLane(bestDots, 0);
+				T bestIndex = Simd::GetLane(bestIndices, 0);
+				for (int lane = 1; lane < 4; ++lane)
+				{
+					const T dot = Simd::GetLane(bestDots, lane);
+					const T laneIndex = Simd::GetLane(bestIndices, lane);
+					if (dot > bestDot || (dot == bestDot && laneIndex < bestIndex))
+					{
+						bestDot = dot;
+						bestIndex = laneIndex;
+					}
+				}
+				best = static_cast<size_t>(bestIndex);
+			}
+			for (; i < count; ++i)
+			{
+				const T dot = x[i] * direction.x + y[i] * direction.y + z[i] * direction.z;
+				if (dot > bestDot)
+				{
+					bestDot = dot;
+					best = i;
+				}
+			}
+			return best;
+		}
+
+		template <typename T>
+		void DistanceBatch(const ConvexHull<T>* a, const ConvexHull<T>* b, const size_t count, GjkCache<T>* caches,
+			GjkResult<T>* results)
+		{
+			assert((a != nullptr && b != nullptr && results != nullptr) || count == 0);
+			ParallelFor(count, k_grainSize, [=](size_t first, size_t last) {
+				for (size_t i = first; i < last; ++i)
+				{
+					results[i] = GjkDistance(a[i], b[i], caches != nullptr ? caches + i : nullptr);
+				}
+			});
+		}
+	}
+
+	size_t FindSupportVertex(const float* x, const float* y, const float* z, size_t count, const Vector3f& direction)
+	{
+		return FindSupport(x, y, z, count, direction);
+	}
+
+	size_t FindSupportVertex(const double* x, const double* y, const double* z, size_t count, const Vector3d& direction)
+	{
+		return FindSupport(x, y, z, count, direction);
+	}
+
+	void GjkDistance(const ConvexHullf* a, const ConvexHullf* b, size_t count, GjkCache<float>* caches, GjkResult<float>* results)
+	{
+		DistanceBatch(a, b, count, caches, results);
+	}
+
+	void GjkDistance(const ConvexHulld* a, const ConvexHulld* b, size_t count, GjkCache<double>* caches, GjkResult<double>* results)
+	{
+		DistanceBatch(a, b, count, caches, results);
+	}
+}
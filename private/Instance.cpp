@@ -0,0 +1,246 @@
+#include <Instance.h>
+
+#include <Parallel.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		using Simd::Float4;
+
+		constexpr size_t k_blockSize = 4;
+
+		// Everything shared by all instances, broadcast once per call
+		struct InstanceContext
+		{
+			Float4 viewProjection[16];
+			Float4 planes[6][4];
+			Float4 planeLengths[6];
+			Float4 center[3];
+			Float4 radius;
+		};
+
+		InstanceContext MakeContext(const Matrix4x4f& view, const PerspectiveMatrixf& projection, const InstanceBounds& bounds)
+		{
+			InstanceContext context;
+			const Matrix4x4f viewProjection = projection * view;
+			for (int k = 0; k < 16; ++k)
+			{
+				context.viewProjection[k] = Simd::Set1(viewProjection.Data()[k]);
+			}
+
+			// World-space frustum planes from the rows of the view projection. A point is
+			// inside when every plane evaluates to at least zero.
+			const Vector4f rows[4] = { viewProjection.GetRow(0), viewProjection.GetRow(1), viewProjection.GetRow(2), viewProjection.GetRow(3) };
+			const Vector4f planes[6] = {
+				rows[3] + rows[0],
+				rows[3] - rows[0],
+				rows[3] + rows[1],
+				rows[3] - rows[1],
+				rows[2],
+				rows[3] - rows[2]
+			};
+			for (int p = 0; p < 6; ++p)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					context.planes[p][c] = Simd::Set1(planes[p].e[c]);
+				}
+				context.planeLengths[p] = Simd::Set1(Vector3f(planes[p].x, planes[p].y, planes[p].z).Length());
+			}
+
+			for (int c = 0; c < 3; ++c)
+			{
+				context.center[c] = Simd::Set1(bounds.center.e[c]);
+			}
+			context.radius = Simd::Set1(bounds.radius);
+			return context;
+		}
+
+		// Outputs for one block of four instances, each possibly null
+		struct BlockOutput
+		{
+			Matrix4x4f* mvp;
+			Matrix3x3f* normal;
+			uint8_t* visible;
+		};
+
+		void BuildBlock(const InstanceContext& context, const Matrix4x4f* models, const BlockOutput& out)
+		{
+			// m[k] holds element k of the four models
+			Float4 m[16];
+			for (int row = 0; row < 4; ++row)
+			{
+				Simd::LoadTransposed4(models->Data() + row * 4, m[row * 4 + 0], m[row * 4 + 1], m[row * 4 + 2], m[row * 4 + 3], 16);
+			}
+
+			if (out.normal != nullptr)
+			{
+				const Float4 upper[9] = { m[0], m[1], m[2], m[4], m[5], m[6], m[8], m[9], m[10] };
+				Float4 adjugate[9];
+				const Float4 s = Simd::Set1(1.f) / MatrixDetail::Adjugate3x3(upper, adjugate);
+				for (int row = 0; row < 3; ++row)
+				{
+					// Row r of the inverse transpose is column r of the adjugate
+					Simd::StoreTransposed3(out.normal->Data() + row * 3,
+						adjugate[row] * s, adjugate[3 + row] * s, adjugate[6 + row] * s, 9);
+				}
+			}
+
+			if (out.visible != nullptr)
+			{
+				const Float4* c = context.center;
+				const Float4 x = m[0] * c[0] + m[1] * c[1] + m[2] * c[2] + m[3];
+				const Float4 y = m[4] * c[0] + m[5] * c[1] + m[6] * c[2] + m[7];
+				const Float4 z = m[8] * c[0] + m[9] * c[1] + m[10] * c[2] + m[11];
+
+				Float4 maxScale = Simd::Zero();
+				for (int column = 0; column < 3; ++column)
+				{
+					const Float4 lengthSq = m[column] * m[column] + m[4 + column] * m[4 + column] + m[8 + column] * m[8 + column];
+					maxScale = Simd::Max(maxScale, lengthSq);
+				}
+				const Float4 radius = context.radius * Simd::Sqrt(maxScale);
+
+				Float4 inside = Simd::CmpEq(Simd::Zero(), Simd::Zero());
+				for (int p = 0; p < 6; ++p)
+				{
+					const Float4* plane = context.planes[p];
+					const Float4 distance = plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+					inside = Simd::And(inside, Simd::CmpGe(distance, -(radius * context.planeLengths[p])));
+				}
+				const int mask = Simd::MoveMask(inside);
+				for (size_t j = 0; j < k_blockSize; ++j)
+				{
+					out.visible[j] = static_cast<uint8_t>((mask >> j) & 1);
+				}
+			}
+
+			// Last, so the MVP output may overwrite the models
+			if (out.mvp != nullptr)
+			{
+				Float4 mvp[16];
+				const Float4* vp = context.viewProjection;
+				for (int row = 0; row < 4; ++row)
+				{
+					for (int column = 0; column < 4; ++column)
+					{
+						mvp[row * 4 + column] = vp[row * 4 + 0] * m[column] + vp[row * 4 + 1] * m[4 + column]
+							+ vp[row * 4 + 2] * m[8 + column] + vp[row * 4 + 3] * m[12 + column];
+					}
+				}
+				for (int row = 0; row < 4; ++row)
+				{
+					Simd::StoreTransposed4(out.mvp->Data() + row * 4, mvp[row * 4 + 0], mvp[row * 4 + 1], mvp[row * 4 + 2], mvp[row * 4 + 3], 16);
+				}
+			}
+		}
+
+		BlockOutput Offset(const InstanceOutput& out, const size_t first)
+		{
+			return {
+				out.mvp != nullptr ? out.mvp + first : nullptr,
+				out.normal != nullptr ? out.normal + first : nullptr,
+				out.visible != nullptr ? out.visible + first : nullptr
+			};
+		}
+
+		// Runs whole blocks straight from the model array when getModels returns it, and
+		// pads the final partial block with identity matrices in scratch, so every
+		// instance goes through the same arithmetic. getModels(first, n, scratch)
+		// returns n models starting at first, either in place or written to scratch.
+		template <typename GetModels>
+		void BuildInstanceBlocks(size_t count, const InstanceContext& context, const InstanceOutput& out, GetModels getModels)
+		{
+			Matrix4x4f scratch[k_blockSize];
+			size_t i = 0;
+			for (; i + k_blockSize <= count; i += k_blockSize)
+			{
+				BuildBlock(context, getModels(i, k_blockSize, scratch), Offset(out, i));
+			}
+
+			const size_t remaining = count - i;
+			if (remaining == 0)
+			{
+				return;
+			}
+
+			const Matrix4x4f* models = getModels(i, remaining, scratch);
+			if (models != scratch)
+			{
+				std::copy(models, models + remaining, scratch);
+			}
+			for (size_t j = remaining; j < k_blockSize; ++j)
+			{
+				scratch[j] = Matrix4x4f::IDENTITY;
+			}
+
+			Matrix4x4f mvp[k_blockSize];
+			Matrix3x3f normal[k_blockSize];
+			uint8_t visible[k_blockSize];
+			BuildBlock(context, scratch, { mvp, normal, visible });
+			for (size_t j = 0; j < remaining; ++j)
+			{
+				if (out.mvp != nullptr)
+				{
+					out.mvp[i + j] = mvp[j];
+				}
+				if (out.normal != nullptr)
+				{
+					out.normal[i + j] = normal[j];
+				}
+				if (out.visible != nullptr)
+				{
+					out.visible[i + j] = visible[j];
+				}
+			}
+		}
+
+		// BuildInstanceBlocks over chunks of the instances, spread over executor. Chunks
+		// are whole blocks, so every instance gets the same result as in one pass.
+		template <typename GetModels>
+		void BuildInstanceChunks(size_t count, const InstanceContext& context, const InstanceOutput& out, Executor* executor,
+			GetModels getModels)
+		{
+			const size_t bytesPerInstance = 2 * sizeof(Matrix4x4f) + sizeof(Matrix3x3f) + sizeof(uint8_t);
+			ParallelFor(count, GetChunkSize(bytesPerInstance), [&](const size_t first, const size_t last) {
+				InstanceOutput chunk;
+				chunk.mvp = out.mvp != nullptr ? out.mvp + first : nullptr;
+				chunk.normal = out.normal != nullptr ? out.normal + first : nullptr;
+				chunk.visible = out.visible != nullptr ? out.visible + first : nullptr;
+				BuildInstanceBlocks(last - first, context, chunk, [&getModels, first](size_t begin, size_t n, Matrix4x4f* scratch) {
+					return getModels(first + begin, n, scratch);
+				});
+			}, executor);
+		}
+	}
+
+	void BuildInstances(const Matrix4x4f* models, size_t count, const Matrix4x4f& view, const PerspectiveMatrixf& projection,
+		const InstanceBounds& bounds, const InstanceOutput& out, Executor* executor)
+	{
+		assert(models != nullptr || count == 0);
+		const InstanceContext context = MakeContext(view, projection, bounds);
+		BuildInstanceChunks(count, context, out, executor, [models](size_t first, size_t, Matrix4x4f*) {
+			return models + first;
+		});
+	}
+
+	void BuildInstances(const TrsTransformf* transforms, size_t count, const Matrix4x4f& view, const PerspectiveMatrixf& projection,
+		const InstanceBounds& bounds, const InstanceOutput& out, Executor* executor)
+	{
+		assert(transforms != nullptr || count == 0);
+		const InstanceContext context = MakeContext(view, projection, bounds);
+		BuildInstanceChunks(count, context, out, executor, [transforms](size_t first, size_t n, Matrix4x4f* scratch) {
+			for (size_t j = 0; j < n; ++j)
+			{
+				scratch[j] = transforms[first + j].ToMatrix();
+			}
+			return static_cast<const Matrix4x4f*>(scratch);
+		});
+	}
+}
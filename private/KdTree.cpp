@@ -0,0 +1,315 @@
+#include <KdTree.h>
+
+#include <Parallel.h>
+
+#include <algorithm>
+#include <numeric>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		constexpr size_t k_blockSize = 4;
+		constexpr size_t k_grainSize = 4096;
+		constexpr size_t k_queryGrainSize = 64;
+		// Point counts fit 32 bits, so the tree is never deeper than this
+		constexpr int k_maxDepth = 32;
+
+		template <typename Neighbour>
+		bool NeighbourLess(const Neighbour& a, const Neighbour& b)
+		{
+			return a.distanceSq < b.distanceSq || (a.distanceSq == b.distanceSq && a.index < b.index);
+		}
+	}
+
+	template <typename T, int N>
+	void KdTree<T, N>::SplitNode(uint32_t* order, const VectorSpan<const T, N>& points, const uint32_t node, const size_t first,
+		const size_t last)
+	{
+		// Split at the median along the widest axis of the range
+		T low[N];
+		T high[N];
+		for (int c = 0; c < N; ++c)
+		{
+			low[c] = std::numeric_limits<T>::max();
+			high[c] = std::numeric_limits<T>::lowest();
+		}
+		for (size_t i = first; i < last; ++i)
+		{
+			const T* position = points[order[i]];
+			for (int c = 0; c < N; ++c)
+			{
+				low[c] = std::min(low[c], position[c]);
+				high[c] = std::max(high[c], position[c]);
+			}
+		}
+		int axis = 0;
+		for (int c = 1; c < N; ++c)
+		{
+			axis = high[c] - low[c] > high[axis] - low[axis] ? c : axis;
+		}
+
+		const size_t middle = first + (last - first) / 2;
+		std::nth_element(order + first, order + middle, order + last, [&points, axis](uint32_t a, uint32_t b) {
+			return points[a][axis] < points[b][axis];
+		});
+		splits[node] = points[order[middle]][axis];
+		splitAxes[node] = static_cast<uint8_t>(axis);
+	}
+
+	template <typename T, int N>
+	void KdTree<T, N>::BuildNode(uint32_t* order, const VectorSpan<const T, N>& points, const uint32_t node, const size_t first,
+		const size_t last, const int level)
+	{
+		if (level == depth)
+		{
+			return;
+		}
+		SplitNode(order, points, node, first, last);
+		const size_t middle = first + (last - first) / 2;
+		BuildNode(order, points, node * 2 + 1, first, middle, level + 1);
+		BuildNode(order, points, node * 2 + 2, middle, last, level + 1);
+	}
+
+	template <typename T, int N>
+	void KdTree<T, N>::Build(const VectorSpan<const T, N>& points)
+	{
+		const size_t count = points.Count();
+		assert(count < k_noPoint);
+
+		depth = 0;
+		while (count > (k_leafSize << depth))
+		{
+			++depth;
+		}
+		const size_t interiorCount = (size_t(1) << depth) - 1;
+		splits.assign(interiorCount, static_cast<T>(0));
+		splitAxes.assign(interiorCount, 0);
+		indices.resize(count);
+		std::iota(indices.begin(), indices.end(), 0u);
+
+		// The first levels are split in sequence, until there are enough subtrees to
+		// build the rest in parallel
+		struct Range
+		{
+			size_t first;
+			size_t last;
+		};
+		std::vector<Range> ranges(1, Range{ 0, count });
+		int level = 0;
+		for (; level < depth && ranges.size() < GetWorkerCount() * 4; ++level)
+		{
+			std::vector<Range> next;
+			next.reserve(ranges.size() * 2);
+			const uint32_t firstNode = (uint32_t(1) << level) - 1;
+			for (size_t j = 0; j < ranges.size(); ++j)
+			{
+				const Range range = ranges[j];
+				SplitNode(indices.data(), points, firstNode + static_cast<uint32_t>(j), range.first, range.last);
+				const size_t middle = range.first + (range.last - range.first) / 2;
+				next.push_back({ range.first, middle });
+				next.push_back({ middle, range.last });
+			}
+			ranges.swap(next);
+		}
+		const uint32_t firstNode = (uint32_t(1) << level) - 1;
+		ParallelFor(ranges.size(), 1, [&](size_t first, size_t last) {
+			for (size_t j = first; j < last; ++j)
+			{
+				BuildNode(indices.data(), points, firstNode + static_cast<uint32_t>(j), ranges[j].first, ranges[j].last, level);
+			}
+		});
+
+		// Positions in tree order, padded so that the last leaf loads whole blocks
+		for (int c = 0; c < N; ++c)
+		{
+			components[c].assign(count + k_blockSize, static_cast<T>(0));
+		}
+		ParallelFor(count, k_grainSize, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				const T* position = points[indices[i]];
+				for (int c = 0; c < N; ++c)
+				{
+					components[c][i] = position[c];
+				}
+			}
+		});
+	}
+
+	template <typename T, int N>
+	template <typename Limit, typename Visit>
+	void KdTree<T, N>::Traverse(const VectorType& center, Limit limit, Visit visit) const
+	{
+		if (indices.empty())
+		{
+			return;
+		}
+
+		const uint32_t interiorCount = (uint32_t(1) << depth) - 1;
+		Entry stack[k_maxDepth + 1];
+		size_t size = 0;
+		stack[size++] = { 0, 0, static_cast<uint32_t>(indices.size()), static_cast<T>(0) };
+		while (size > 0)
+		{
+			Entry entry = stack[--size];
+			if (entry.boundSq > limit())
+			{
+				continue;
+			}
+			while (entry.node < interiorCount)
+			{
+				const int axis = splitAxes[entry.node];
+				const T offset = center[axis] - splits[entry.node];
+				const uint32_t middle = entry.first + (entry.last - entry.first) / 2;
+				Entry left = { entry.node * 2 + 1, entry.first, middle, entry.boundSq };
+				Entry right = { entry.node * 2 + 2, middle, entry.last, entry.boundSq };
+				Entry& farSide = offset <= static_cast<T>(0) ? right : left;
+				farSide.boundSq = std::max(entry.boundSq, offset * offset);
+				if (farSide.boundSq <= limit())
+				{
+					stack[size++] = farSide;
+				}
+				entry = offset <= static_cast<T>(0) ? left : right;
+			}
+			visit(entry.first, entry.last);
+		}
+	}
+
+	namespace
+	{
+		// Calls consider(i, distanceSq) for each point i in [first, last) whose squared
+		// distance from center is at most limit(), four points at a time
+		template <typename T, int N, typename Center, typename Limit, typename Consider>
+		void ScanLeaf(const std::vector<T> (&components)[N], const Center& center, const uint32_t first, const uint32_t last,
+			Limit limit, Consider consider)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+			for (uint32_t i = first; i < last; i += k_blockSize)
+			{
+				Lanes distanceSq = Simd::Set1(static_cast<T>(0));
+				for (int c = 0; c < N; ++c)
+				{
+					const Lanes offset = Simd::Load(components[c].data() + i) - Simd::Set1(center[c]);
+					distanceSq = Simd::MulAdd(offset, offset, distanceSq);
+				}
+				const uint32_t valid = std::min<uint32_t>(static_cast<uint32_t>(k_blockSize), last - i);
+				const int mask = Simd::MoveMask(Simd::CmpLe(distanceSq, Simd::Set1(limit()))) & ((1 << valid) - 1);
+				for (int lane = 0; lane < static_cast<int>(k_blockSize); ++lane)
+				{
+					if ((mask >> lane) & 1)
+					{
+						consider(i + lane, Simd::GetLane(distanceSq, lane));
+					}
+				}
+			}
+		}
+	}
+
+	template <typename T, int N>
+	size_t KdTree<T, N>::FindNearest(const VectorType& center, const size_t k, Neighbour* nearest, const T maxRadius) const
+	{
+		assert(nearest != nullptr || k == 0);
+		if (k == 0)
+		{
+			return 0;
+		}
+
+		const T maxRadiusSq = maxRadius * maxRadius;
+		const auto less = NeighbourLess<Neighbour>;
+		size_t found = 0;
+		const auto limit = [&]() {
+			return found == k ? nearest[0].distanceSq : maxRadiusSq;
+		};
+		Traverse(center, limit, [&](uint32_t first, uint32_t last) {
+			ScanLeaf<T, N>(components, center, first, last, limit, [&](uint32_t i, T distanceSq) {
+				const Neighbour candidate = { indices[i], distanceSq };
+				if (found < k)
+				{
+					nearest[found++] = candidate;
+					std::push_heap(nearest, nearest + found, less);
+				}
+				else if (less(candidate, nearest[0]))
+				{
+					std::pop_heap(nearest, nearest + k, less);
+					nearest[k - 1] = candidate;
+					std::push_heap(nearest, nearest + k, less);
+				}
+			});
+		});
+		std::sort_heap(nearest, nearest + found, less);
+		return found;
+	}
+
+	template <typename T, int N>
+	void KdTree<T, N>::FindNearest(const VectorSpan<const T, N>& centers, const size_t k, Neighbour* nearest, const T maxRadius) const
+	{
+		assert(nearest != nullptr || k == 0 || centers.Count() == 0);
+		ParallelFor(centers.Count(), k_queryGrainSize, [&](size_t first, size_t last) {
+			for (size_t q = first; q < last; ++q)
+			{
+				Neighbour* result = nearest + q * k;
+				const size_t found = FindNearest(centers.Load(q), k, result, maxRadius);
+				std::fill(result + found, result + k, Neighbour{ k_noPoint, std::numeric_limits<T>::infinity() });
+			}
+		});
+	}
+
+	template <typename T, int N>
+	void KdTree<T, N>::FindWithin(const VectorType& center, const T radius, std::vector<Neighbour>& found) const
+	{
+		const T radiusSq = radius * radius;
+		const auto limit = [radiusSq]() {
+			return radiusSq;
+		};
+		Traverse(center, limit, [&](uint32_t first, uint32_t last) {
+			ScanLeaf<T, N>(components, center, first, last, limit, [&](uint32_t i, T distanceSq) {
+				found.push_back({ indices[i], distanceSq });
+			});
+		});
+	}
+
+	template <typename T, int N>
+	void KdTree<T, N>::FindWithin(const VectorSpan<const T, N>& centers, const T radius, std::vector<size_t>& offsets,
+		std::vector<Neighbour>& found) const
+	{
+		const size_t count = centers.Count();
+		offsets.assign(count + 1, 0);
+
+		// Each chunk of queries collects its points separately; the chunks are then
+		// joined in order
+		const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(GetWorkerCount() * 4, count / k_queryGrainSize));
+		std::vector<std::vector<Neighbour>> chunkFound(chunkCount);
+		ParallelFor(chunkCount, 1, [&](size_t firstChunk, size_t lastChunk) {
+			for (size_t c = firstChunk; c < lastChunk; ++c)
+			{
+				const size_t end = count * (c + 1) / chunkCount;
+				for (size_t q = count * c / chunkCount; q < end; ++q)
+				{
+					const size_t before = chunkFound[c].size();
+					FindWithin(centers.Load(q), radius, chunkFound[c]);
+					offsets[q + 1] = chunkFound[c].size() - before;
+				}
+			}
+		});
+
+		for (size_t q = 0; q < count; ++q)
+		{
+			offsets[q + 1] += offsets[q];
+		}
+		found.resize(offsets[count]);
+		size_t position = 0;
+		for (const std::vector<Neighbour>& chunk : chunkFound)
+		{
+			std::copy(chunk.begin(), chunk.end(), found.begin() + position);
+			position += chunk.size();
+		}
+	}
+
+	template class KdTree<float, 2>;
+	template class KdTree<double, 2>;
+	template class KdTree<float, 3>;
+	template class KdTree<double, 3>;
+}
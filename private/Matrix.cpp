@@ -1,5 +1,11 @@
 #include <Matrix.h>
 #include <Vector.h>
+#include <View.h>
+#include <Parallel.h>
+
+#include "Simd.h"
+
+#include <algorithm>
 
 namespace Math
 {
@@ -19,6 +25,14 @@ namespace Math
 			Vector3<int>(0.f, 0.f, 1.f)
 			);
 
+    template<>
+	const Matrix3x3<double> Matrix3x3<double>::IDENTITY =
+		Matrix3x3<double>(
+			Vector3<double>(1.0, 0.0, 0.0),
+			Vector3<double>(0.0, 1.0, 0.0),
+			Vector3<double>(0.0, 0.0, 1.0)
+		);
+
     template<>
 	const Matrix4x4<float> Matrix4x4<float>::IDENTITY =
 		Matrix4x4<float>(
@@ -28,6 +42,27 @@ namespace Math
 			Vector4<float>(0.f, 0.f, 0.f, 1.f)
 			);
 
+    template<>
+	const Matrix4x4<double> Matrix4x4<double>::IDENTITY =
+		Matrix4x4<double>(
+			Vector4<double>(1.0, 0.0, 0.0, 0.0),
+			Vector4<double>(0.0, 1.0, 0.0, 0.0),
+			Vector4<double>(0.0, 0.0, 1.0, 0.0),
+			Vector4<double>(0.0, 0.0, 0.0, 1.0)
+			);
+
+    template<>
+	const ColumnMajorMatrix3x3f ColumnMajorMatrix3x3f::IDENTITY = ColumnMajorMatrix3x3f(Matrix3x3f::IDENTITY);
+
+    template<>
+	const ColumnMajorMatrix3x3d ColumnMajorMatrix3x3d::IDENTITY = ColumnMajorMatrix3x3d(Matrix3x3d::IDENTITY);
+
+    template<>
+	const ColumnMajorMatrix4x4f ColumnMajorMatrix4x4f::IDENTITY = ColumnMajorMatrix4x4f(Matrix4x4f::IDENTITY);
+
+    template<>
+	const ColumnMajorMatrix4x4d ColumnMajorMatrix4x4d::IDENTITY = ColumnMajorMatrix4x4d(Matrix4x4d::IDENTITY);
+
     template<>
 	const Matrix4x4<int> Matrix4x4<int>::IDENTITY =
 		Matrix4x4<int>(
@@ -37,6 +72,328 @@ namespace Math
 			Vector4<int>(0.f, 0.f, 0.f, 1.f)
 			);
 
+	static_assert(sizeof(Matrix4x4d) == sizeof(double) * 16, "Double matrices must be tightly packed");
+
+	namespace
+	{
+		using Simd::Double4;
+
+		inline const double* Raw(const void* p)
+		{
+			return static_cast<const double*>(p);
+		}
+
+		inline double* Raw(void* p)
+		{
+			return static_cast<double*>(p);
+		}
+	}
+
+	void Multiply(const Matrix4x4d* lhs, const Matrix4x4d* rhs, Matrix4x4d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Matrix4x4d)), [&](const size_t first, const size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				const double* a = Raw(lhs + i);
+				const double* b = Raw(rhs + i);
+				const Double4 b0 = Simd::Load(b + 0);
+				const Double4 b1 = Simd::Load(b + 4);
+				const Double4 b2 = Simd::Load(b + 8);
+				const Double4 b3 = Simd::Load(b + 12);
+
+				// Each result row is a combination of the rows of rhs, summed in the same
+				// order as Matrix4x4::operator*
+				Double4 rows[4];
+				for (int r = 0; r < 4; ++r)
+				{
+					const double* ar = a + r * 4;
+					rows[r] = Simd::Set1(ar[0]) * b0 + Simd::Set1(ar[1]) * b1 + Simd::Set1(ar[2]) * b2 + Simd::Set1(ar[3]) * b3;
+				}
+
+				double* o = Raw(out + i);
+				for (int r = 0; r < 4; ++r)
+				{
+					Simd::Store(o + r * 4, rows[r]);
+				}
+			}
+		}, executor);
+	}
+
+	void Inverse(const Matrix4x4d* src, Matrix4x4d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Matrix4x4d)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				// Lane j of m[k] holds element k of matrix i + j
+				Double4 m[16];
+				for (int r = 0; r < 4; ++r)
+				{
+					Simd::LoadTransposed4(Raw(src + i) + r * 4, m[r * 4 + 0], m[r * 4 + 1], m[r * 4 + 2], m[r * 4 + 3], 16);
+				}
+
+				Double4 adjugate[16];
+				const Double4 determinant = MatrixDetail::Adjugate4x4(m, adjugate);
+				assert(Simd::MoveMask(Simd::CmpEq(determinant, Simd::Set1(0.0))) == 0);
+				const Double4 s = Simd::Set1(1.0) / determinant;
+
+				for (int r = 0; r < 4; ++r)
+				{
+					Simd::StoreTransposed4(Raw(out + i) + r * 4,
+						adjugate[r * 4 + 0] * s, adjugate[r * 4 + 1] * s, adjugate[r * 4 + 2] * s, adjugate[r * 4 + 3] * s, 16);
+				}
+			}
+			for (; i < last; ++i)
+			{
+				out[i] = src[i].InverseClone();
+			}
+		}, executor);
+	}
+
+	void Transform(const Matrix4x4d& m, const Vector4d* src, Vector4d* out, size_t count, Executor* executor)
+	{
+		Transform(m, VectorSpan<const double, 4>(src, count), VectorSpan<double, 4>(out, count), executor);
+	}
+
+	void TransformPoints(const Matrix4x4d& m, const Vector3d* src, Vector3d* out, size_t count, Executor* executor)
+	{
+		TransformPoints(m, VectorSpan<const double, 3>(src, count), VectorSpan<double, 3>(out, count), executor);
+	}
+
+	namespace
+	{
+		// Position of each element of the adjugate in the output: row-major for the
+		// inverse, transposed for the normal matrix
+		constexpr int k_identityOrder[9] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+		constexpr int k_transposeOrder[9] = { 0, 3, 6, 1, 4, 7, 2, 5, 8 };
+
+		// The scalar tails run the same operations on plain values, so every element
+		// of a batch gets identical results regardless of where it falls
+		template <typename T>
+		void Determinant3x3(const Matrix3x3SoA<const T>& src, T* out, const size_t first, const size_t last)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Lanes m[9];
+				Lanes adjugate[9];
+				for (int k = 0; k < 9; ++k)
+				{
+					m[k] = Simd::Load(src.e[k] + i);
+				}
+				Simd::Store(out + i, MatrixDetail::Adjugate3x3(m, adjugate));
+			}
+			for (; i < last; ++i)
+			{
+				T m[9];
+				T adjugate[9];
+				for (int k = 0; k < 9; ++k)
+				{
+					m[k] = src.e[k][i];
+				}
+				out[i] = MatrixDetail::Adjugate3x3(m, adjugate);
+			}
+		}
+
+		template <typename T>
+		void Inverse3x3(const Matrix3x3SoA<const T>& src, const Matrix3x3SoA<T>& out, const size_t first, const size_t last,
+			const int* order)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Lanes m[9];
+				Lanes adjugate[9];
+				for (int k = 0; k < 9; ++k)
+				{
+					m[k] = Simd::Load(src.e[k] + i);
+				}
+				const Lanes determinant = MatrixDetail::Adjugate3x3(m, adjugate);
+				assert(Simd::MoveMask(Simd::CmpEq(determinant, Simd::Set1(static_cast<T>(0)))) == 0);
+				const Lanes s = Simd::Set1(static_cast<T>(1)) / determinant;
+				for (int k = 0; k < 9; ++k)
+				{
+					Simd::Store(out.e[k] + i, adjugate[order[k]] * s);
+				}
+			}
+			for (; i < last; ++i)
+			{
+				T m[9];
+				T adjugate[9];
+				for (int k = 0; k < 9; ++k)
+				{
+					m[k] = src.e[k][i];
+				}
+				const T determinant = MatrixDetail::Adjugate3x3(m, adjugate);
+				assert(determinant != static_cast<T>(0));
+				const T s = static_cast<T>(1) / determinant;
+				for (int k = 0; k < 9; ++k)
+				{
+					out.e[k][i] = adjugate[order[k]] * s;
+				}
+			}
+		}
+
+		// Matrices per block of scratch for the array-of-structures overloads. At namespace
+		// scope so std::min can bind to it without an out-of-class definition.
+		constexpr size_t k_matrix3x3BlockSize = 64;
+
+		template <typename T>
+		struct Matrix3x3Block
+		{
+			T e[9][k_matrix3x3BlockSize];
+
+			Matrix3x3SoA<T> Soa()
+			{
+				return { { e[0], e[1], e[2], e[3], e[4], e[5], e[6], e[7], e[8] } };
+			}
+
+			template <typename Matrix>
+			void Gather(const Matrix* src, const size_t count)
+			{
+				for (size_t j = 0; j < count; ++j)
+				{
+					for (int k = 0; k < 9; ++k)
+					{
+						e[k][j] = src[j].GetRow(k / 3).e[k % 3];
+					}
+				}
+			}
+
+			void Scatter(Matrix3x3<T>* out, const size_t count) const
+			{
+				for (size_t j = 0; j < count; ++j)
+				{
+					for (int k = 0; k < 9; ++k)
+					{
+						out[j][k / 3].e[k % 3] = e[k][j];
+					}
+				}
+			}
+		};
+
+		template <typename T>
+		void Determinant3x3(const Matrix3x3SoA<const T>& src, T* out, const size_t count, Executor* executor)
+		{
+			ParallelFor(count, GetChunkSize(10 * sizeof(T)), [&](const size_t first, const size_t last) {
+				Determinant3x3(src, out, first, last);
+			}, executor);
+		}
+
+		template <typename T>
+		void Inverse3x3(const Matrix3x3SoA<const T>& src, const Matrix3x3SoA<T>& out, const size_t count, const int* order,
+			Executor* executor)
+		{
+			ParallelFor(count, GetChunkSize(18 * sizeof(T)), [&](const size_t first, const size_t last) {
+				Inverse3x3(src, out, first, last, order);
+			}, executor);
+		}
+
+		// Each chunk transposes through its own scratch block
+		template <typename T>
+		void Determinant3x3(const Matrix3x3<T>* src, T* out, const size_t count, Executor* executor)
+		{
+			ParallelFor(count, GetChunkSize(sizeof(Matrix3x3<T>) + sizeof(T)), [&](const size_t first, const size_t last) {
+				Matrix3x3Block<T> block;
+				for (size_t i = first; i < last; i += k_matrix3x3BlockSize)
+				{
+					const size_t n = std::min(last - i, k_matrix3x3BlockSize);
+					block.Gather(src + i, n);
+					Determinant3x3<T>(block.Soa(), out + i, 0, n);
+				}
+			}, executor);
+		}
+
+		template <typename T, typename Matrix>
+		void Inverse3x3(const Matrix* src, Matrix3x3<T>* out, const size_t count, const int* order, Executor* executor)
+		{
+			ParallelFor(count, GetChunkSize(sizeof(Matrix) + sizeof(Matrix3x3<T>)), [&](const size_t first, const size_t last) {
+				Matrix3x3Block<T> block;
+				for (size_t i = first; i < last; i += k_matrix3x3BlockSize)
+				{
+					const size_t n = std::min(last - i, k_matrix3x3BlockSize);
+					block.Gather(src + i, n);
+					Inverse3x3<T>(block.Soa(), block.Soa(), 0, n, order);
+					block.Scatter(out + i, n);
+				}
+			}, executor);
+		}
+	}
+
+	void Determinant(const Matrix3x3SoA<const float>& src, float* out, size_t count, Executor* executor)
+	{
+		Determinant3x3(src, out, count, executor);
+	}
+
+	void Inverse(const Matrix3x3SoA<const float>& src, const Matrix3x3SoA<float>& out, size_t count, Executor* executor)
+	{
+		Inverse3x3(src, out, count, k_identityOrder, executor);
+	}
+
+	void NormalMatrix(const Matrix3x3SoA<const float>& src, const Matrix3x3SoA<float>& out, size_t count, Executor* executor)
+	{
+		Inverse3x3(src, out, count, k_transposeOrder, executor);
+	}
+
+	void Determinant(const Matrix3x3SoA<const double>& src, double* out, size_t count, Executor* executor)
+	{
+		Determinant3x3(src, out, count, executor);
+	}
+
+	void Inverse(const Matrix3x3SoA<const double>& src, const Matrix3x3SoA<double>& out, size_t count, Executor* executor)
+	{
+		Inverse3x3(src, out, count, k_identityOrder, executor);
+	}
+
+	void NormalMatrix(const Matrix3x3SoA<const double>& src, const Matrix3x3SoA<double>& out, size_t count, Executor* executor)
+	{
+		Inverse3x3(src, out, count, k_transposeOrder, executor);
+	}
+
+	void Determinant(const Matrix3x3f* src, float* out, size_t count, Executor* executor)
+	{
+		Determinant3x3(src, out, count, executor);
+	}
+
+	void Inverse(const Matrix3x3f* src, Matrix3x3f* out, size_t count, Executor* executor)
+	{
+		Inverse3x3<float>(src, out, count, k_identityOrder, executor);
+	}
+
+	void NormalMatrix(const Matrix3x3f* src, Matrix3x3f* out, size_t count, Executor* executor)
+	{
+		Inverse3x3<float>(src, out, count, k_transposeOrder, executor);
+	}
+
+	void NormalMatrix(const Matrix4x4f* src, Matrix3x3f* out, size_t count, Executor* executor)
+	{
+		Inverse3x3<float>(src, out, count, k_transposeOrder, executor);
+	}
+
+	void Determinant(const Matrix3x3d* src, double* out, size_t count, Executor* executor)
+	{
+		Determinant3x3(src, out, count, executor);
+	}
+
+	void Inverse(const Matrix3x3d* src, Matrix3x3d* out, size_t count, Executor* executor)
+	{
+		Inverse3x3<double>(src, out, count, k_identityOrder, executor);
+	}
+
+	void NormalMatrix(const Matrix3x3d* src, Matrix3x3d* out, size_t count, Executor* executor)
+	{
+		Inverse3x3<double>(src, out, count, k_transposeOrder, executor);
+	}
+
+	void NormalMatrix(const Matrix4x4d* src, Matrix3x3d* out, size_t count, Executor* executor)
+	{
+		Inverse3x3<double>(src, out, count, k_transposeOrder, executor);
+	}
+
 	const Matrix3x3f TestMatrixRotationX =
 	{
 		{ 1.f,  0.f,  0.f },
@@ -0,0 +1,369 @@
+#include <Occlusion.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <Parallel.h>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		using Simd::Float4;
+
+		// Screen-space triangle ready for rasterization. Each edge function
+		// a * x + b * y + c is non-negative inside, and depth is the plane
+		// zx * x + zy * y + zc.
+		struct TriangleSetup
+		{
+			float edgeA[3];
+			float edgeB[3];
+			float edgeC[3];
+			float zx;
+			float zy;
+			float zc;
+			int minX;
+			int minY;
+			int maxX;
+			int maxY;
+		};
+
+		struct ScreenVertex
+		{
+			float x;
+			float y;
+			float z;
+		};
+
+		ScreenVertex ToScreen(const Vector4f& clip, const float width, const float height)
+		{
+			const float invW = 1.f / clip.w;
+			return { (clip.x * invW + 1.f) * 0.5f * width, (1.f - clip.y * invW) * 0.5f * height, clip.z * invW };
+		}
+
+		bool SetupTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2, const int width, const int height, TriangleSetup& setup)
+		{
+			float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+			if (!(area != 0.f))
+			{
+				return false;
+			}
+			if (area < 0.f)
+			{
+				std::swap(v1, v2);
+				area = -area;
+			}
+
+			const float minX = std::min(v0.x, std::min(v1.x, v2.x));
+			const float maxX = std::max(v0.x, std::max(v1.x, v2.x));
+			const float minY = std::min(v0.y, std::min(v1.y, v2.y));
+			const float maxY = std::max(v0.y, std::max(v1.y, v2.y));
+			if (maxX < 0.f || maxY < 0.f || minX >= static_cast<float>(width) || minY >= static_cast<float>(height))
+			{
+				return false;
+			}
+			// Clamped before converting, as coordinates near the near plane can be huge
+			setup.minX = static_cast<int>(std::max(minX, 0.f));
+			setup.minY = static_cast<int>(std::max(minY, 0.f));
+			setup.maxX = static_cast<int>(std::min(maxX, static_cast<float>(width - 1)));
+			setup.maxY = static_cast<int>(std::min(maxY, static_cast<float>(height - 1)));
+
+			// Edge k is opposite vertex k, so edge k / area is the barycentric weight of vertex k
+			const ScreenVertex* v[3] = { &v0, &v1, &v2 };
+			for (int k = 0; k < 3; ++k)
+			{
+				const ScreenVertex& a = *v[(k + 1) % 3];
+				const ScreenVertex& b = *v[(k + 2) % 3];
+				setup.edgeA[k] = a.y - b.y;
+				setup.edgeB[k] = b.x - a.x;
+				setup.edgeC[k] = a.x * b.y - a.y * b.x;
+			}
+
+			const float invArea = 1.f / area;
+			setup.zx = (v0.z * setup.edgeA[0] + v1.z * setup.edgeA[1] + v2.z * setup.edgeA[2]) * invArea;
+			setup.zy = (v0.z * setup.edgeB[0] + v1.z * setup.edgeB[1] + v2.z * setup.edgeB[2]) * invArea;
+			setup.zc = (v0.z * setup.edgeC[0] + v1.z * setup.edgeC[1] + v2.z * setup.edgeC[2]) * invArea;
+			return true;
+		}
+
+		// Sutherland-Hodgman against the near plane z >= 0, producing up to four vertices
+		int ClipNear(const Vector4f* in, Vector4f* out)
+		{
+			int count = 0;
+			for (int i = 0; i < 3; ++i)
+			{
+				const Vector4f& a = in[i];
+				const Vector4f& b = in[(i + 1) % 3];
+				const bool aInside = a.z >= 0.f;
+				const bool bInside = b.z >= 0.f;
+				if (aInside)
+				{
+					out[count++] = a;
+				}
+				if (aInside != bInside)
+				{
+					const float t = a.z / (a.z - b.z);
+					out[count++] = a + (b - a) * t;
+				}
+			}
+			return count;
+		}
+
+		// Rasterizes the part of a triangle inside [x0, x1) x [y0, y1), four pixels at a time
+		void RasterizeTriangle(const TriangleSetup& t, float* depth, const int stride, const int x0, const int y0, const int x1, const int y1)
+		{
+			const int startX = std::max(x0, t.minX & ~3);
+			const int endX = std::min(x1, t.maxX + 1);
+			const int startY = std::max(y0, t.minY);
+			const int endY = std::min(y1, t.maxY + 1);
+			if (startX >= endX || startY >= endY)
+			{
+				return;
+			}
+
+			Float4 a[3], b[3], c[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				a[k] = Simd::Set1(t.edgeA[k]);
+				b[k] = Simd::Set1(t.edgeB[k]);
+				c[k] = Simd::Set1(t.edgeC[k]);
+			}
+			const Float4 zx = Simd::Set1(t.zx);
+			const Float4 zy = Simd::Set1(t.zy);
+			const Float4 zc = Simd::Set1(t.zc);
+			const float offsets[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+			const Float4 laneOffsets = Simd::Load(offsets);
+			const Float4 zero = Simd::Zero();
+
+			for (int y = startY; y < endY; ++y)
+			{
+				const Float4 py = Simd::Set1(static_cast<float>(y) + 0.5f);
+				float* row = depth + static_cast<size_t>(y) * stride;
+				for (int x = startX; x < endX; x += 4)
+				{
+					const Float4 px = Simd::Set1(static_cast<float>(x)) + laneOffsets;
+					const Float4 e0 = a[0] * px + b[0] * py + c[0];
+					const Float4 e1 = a[1] * px + b[1] * py + c[1];
+					const Float4 e2 = a[2] * px + b[2] * py + c[2];
+					const Float4 inside = Simd::And(Simd::And(Simd::CmpGe(e0, zero), Simd::CmpGe(e1, zero)), Simd::CmpGe(e2, zero));
+					if (Simd::MoveMask(inside) == 0)
+					{
+						continue;
+					}
+					const Float4 z = Simd::Max(zx * px + zy * py + zc, zero);
+					const Float4 old = Simd::Load(row + x);
+					Simd::Store(row + x, Simd::Select(inside, Simd::Min(old, z), old));
+				}
+			}
+		}
+	}
+
+	OcclusionBuffer::OcclusionBuffer(int width, int height)
+	{
+		assert(width > 0 && height > 0 && width % 4 == 0);
+		size_t offset = 0;
+		for (;;)
+		{
+			levels.push_back({ width, height, offset });
+			offset += static_cast<size_t>(width) * height;
+			if (width == 1 && height == 1)
+			{
+				break;
+			}
+			width = (width + 1) / 2;
+			height = (height + 1) / 2;
+		}
+		depth.resize(offset);
+		Clear();
+	}
+
+	void OcclusionBuffer::Clear()
+	{
+		std::fill(depth.begin(), depth.end(), 1.f);
+	}
+
+	void OcclusionBuffer::RasterizeOccluders(const Matrix4x4f& viewProjection, const Vector3f* vertices, size_t vertexCount,
+		const uint32_t* indices, size_t triangleCount)
+	{
+		assert((vertices != nullptr || vertexCount == 0) && (indices != nullptr || triangleCount == 0));
+		const int width = GetWidth();
+		const int height = GetHeight();
+
+		std::vector<Vector4f> clip(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			clip[i] = viewProjection * Vector4f(vertices[i].x, vertices[i].y, vertices[i].z, 1.f);
+		}
+
+		std::vector<TriangleSetup> triangles;
+		triangles.reserve(triangleCount);
+		for (size_t i = 0; i < triangleCount; ++i)
+		{
+			const uint32_t* index = indices + i * 3;
+			assert(index[0] < vertexCount && index[1] < vertexCount && index[2] < vertexCount);
+			const Vector4f in[3] = { clip[index[0]], clip[index[1]], clip[index[2]] };
+
+			Vector4f polygon[4];
+			const int count = ClipNear(in, polygon);
+			if (count < 3)
+			{
+				continue;
+			}
+			ScreenVertex screen[4];
+			for (int k = 0; k < count; ++k)
+			{
+				screen[k] = ToScreen(polygon[k], static_cast<float>(width), static_cast<float>(height));
+			}
+			for (int k = 2; k < count; ++k)
+			{
+				TriangleSetup setup;
+				if (SetupTriangle(screen[0], screen[k - 1], screen[k], width, height, setup))
+				{
+					triangles.push_back(setup);
+				}
+			}
+		}
+
+		// Bin by tile, then rasterize the tiles in parallel; tiles never share pixels
+		const int tilesX = (width + k_tileSize - 1) / k_tileSize;
+		const int tilesY = (height + k_tileSize - 1) / k_tileSize;
+		std::vector<std::vector<uint32_t>> bins(static_cast<size_t>(tilesX) * tilesY);
+		for (size_t i = 0; i < triangles.size(); ++i)
+		{
+			const TriangleSetup& t = triangles[i];
+			for (int ty = t.minY / k_tileSize; ty <= t.maxY / k_tileSize; ++ty)
+			{
+				for (int tx = t.minX / k_tileSize; tx <= t.maxX / k_tileSize; ++tx)
+				{
+					bins[static_cast<size_t>(ty) * tilesX + tx].push_back(static_cast<uint32_t>(i));
+				}
+			}
+		}
+
+		float* level0 = GetLevelDepth(0);
+		ParallelFor(bins.size(), 4, [&](size_t begin, size_t end) {
+			for (size_t tile = begin; tile < end; ++tile)
+			{
+				const int x0 = static_cast<int>(tile % tilesX) * k_tileSize;
+				const int y0 = static_cast<int>(tile / tilesX) * k_tileSize;
+				const int x1 = std::min(x0 + k_tileSize, width);
+				const int y1 = std::min(y0 + k_tileSize, height);
+				for (const uint32_t i : bins[tile])
+				{
+					RasterizeTriangle(triangles[i], level0, width, x0, y0, x1, y1);
+				}
+			}
+		});
+	}
+
+	void OcclusionBuffer::BuildHierarchy()
+	{
+		for (int level = 1; level < GetLevelCount(); ++level)
+		{
+			const Level& below = levels[level - 1];
+			const Level& above = levels[level];
+			const float* src = GetDepth(level - 1);
+			float* dst = GetLevelDepth(level);
+			for (int y = 0; y < above.height; ++y)
+			{
+				// Odd sizes clamp to the last row or column below
+				const float* row0 = src + static_cast<size_t>(y * 2) * below.width;
+				const float* row1 = src + static_cast<size_t>(std::min(y * 2 + 1, below.height - 1)) * below.width;
+				for (int x = 0; x < above.width; ++x)
+				{
+					const int x0 = x * 2;
+					const int x1 = std::min(x0 + 1, below.width - 1);
+					dst[static_cast<size_t>(y) * above.width + x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+				}
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsVisible(const Matrix4x4f& viewProjection, const Vector3f& boxMin, const Vector3f& boxMax) const
+	{
+		// The eight corners as two blocks of four, near z first
+		const float xs[4] = { boxMin.x, boxMax.x, boxMin.x, boxMax.x };
+		const float ys[4] = { boxMin.y, boxMin.y, boxMax.y, boxMax.y };
+		const Float4 x = Simd::Load(xs);
+		const Float4 y = Simd::Load(ys);
+		const float* m = viewProjection.Data();
+
+		const float width = static_cast<float>(GetWidth());
+		const float height = static_cast<float>(GetHeight());
+		const float k_huge = std::numeric_limits<float>::max();
+		float minX = k_huge, maxX = -k_huge, minY = k_huge, maxY = -k_huge, minZ = k_huge;
+		for (int half = 0; half < 2; ++half)
+		{
+			const Float4 z = Simd::Set1(half == 0 ? boxMin.z : boxMax.z);
+			Float4 clip[4];
+			for (int row = 0; row < 4; ++row)
+			{
+				clip[row] = Simd::Set1(m[row * 4 + 0]) * x + Simd::Set1(m[row * 4 + 1]) * y + Simd::Set1(m[row * 4 + 2]) * z + Simd::Set1(m[row * 4 + 3]);
+			}
+			if (Simd::MoveMask(Simd::CmpLt(clip[2], Simd::Zero())) != 0)
+			{
+				return true;
+			}
+			const Float4 invW = Simd::Set1(1.f) / clip[3];
+			const Float4 one = Simd::Set1(1.f);
+			const Float4 half4 = Simd::Set1(0.5f);
+			const Float4 screenX = (clip[0] * invW + one) * half4 * Simd::Set1(width);
+			const Float4 screenY = (one - clip[1] * invW) * half4 * Simd::Set1(height);
+			const Float4 depth = clip[2] * invW;
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				minX = std::min(minX, Simd::GetLane(screenX, lane));
+				maxX = std::max(maxX, Simd::GetLane(screenX, lane));
+				minY = std::min(minY, Simd::GetLane(screenY, lane));
+				maxY = std::max(maxY, Simd::GetLane(screenY, lane));
+				minZ = std::min(minZ, Simd::GetLane(depth, lane));
+			}
+		}
+
+		if (maxX < 0.f || maxY < 0.f || minX >= width || minY >= height || minZ > 1.f)
+		{
+			return false;
+		}
+
+		const int x0 = static_cast<int>(std::max(minX, 0.f));
+		const int y0 = static_cast<int>(std::max(minY, 0.f));
+		const int x1 = static_cast<int>(std::min(maxX, width - 1.f));
+		const int y1 = static_cast<int>(std::min(maxY, height - 1.f));
+
+		// The coarsest level where the rectangle covers at most 3x3 texels
+		int level = 0;
+		while (level + 1 < GetLevelCount() && std::max(x1 - x0, y1 - y0) >> level > 1)
+		{
+			++level;
+		}
+
+		const int levelWidth = GetLevelWidth(level);
+		const float* levelDepth = GetDepth(level);
+		for (int ty = y0 >> level; ty <= y1 >> level; ++ty)
+		{
+			for (int tx = x0 >> level; tx <= x1 >> level; ++tx)
+			{
+				if (minZ <= levelDepth[static_cast<size_t>(ty) * levelWidth + tx])
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void OcclusionBuffer::TestVisibility(const Matrix4x4f& viewProjection, const Vector3f* boxMins, const Vector3f* boxMaxs,
+		size_t count, uint8_t* visible) const
+	{
+		ParallelFor(count, 256, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+			{
+				visible[i] = IsVisible(viewProjection, boxMins[i], boxMaxs[i]) ? 1 : 0;
+			}
+		});
+	}
+}
@@ -0,0 +1,255 @@
+#include <Parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Math
+{
+	namespace
+	{
+		// Share of a loop left to one participant. Its owner takes chunks from the
+		// front, and thieves split off the back half.
+		struct Slot
+		{
+			std::mutex mutex;
+			size_t first = 0;
+			size_t last = 0;
+			// Keeps neighbouring slots off each other's cache lines
+			char padding[64];
+		};
+
+		struct Loop
+		{
+			const std::function<void(size_t, size_t)>* body;
+			size_t grainSize;
+			std::unique_ptr<Slot[]> slots;
+			size_t slotCount;
+			// Slot of the next participant to join; the starting thread has slot 0
+			size_t nextSlot;
+
+			// Workers still inside the loop
+			std::mutex mutex;
+			std::condition_variable finished;
+			int helpers;
+		};
+
+		// Takes the next chunk of slot. Returns false if the slot is empty.
+		bool TakeChunk(Loop& loop, Slot& slot, size_t& first, size_t& last)
+		{
+			std::lock_guard<std::mutex> lock(slot.mutex);
+			if (slot.first == slot.last)
+			{
+				return false;
+			}
+			first = slot.first;
+			last = std::min(slot.last, first + loop.grainSize);
+			slot.first = last;
+			return true;
+		}
+
+		// Moves the back half of the first non-empty slot after own into own, keeping
+		// chunk boundaries where they were. Returns false once every slot is empty.
+		bool Steal(Loop& loop, const size_t own)
+		{
+			for (size_t k = 1; k < loop.slotCount; ++k)
+			{
+				Slot& victim = loop.slots[(own + k) % loop.slotCount];
+				size_t first;
+				size_t last;
+				{
+					std::lock_guard<std::mutex> lock(victim.mutex);
+					if (victim.first == victim.last)
+					{
+						continue;
+					}
+					const size_t chunks = (victim.last - victim.first + loop.grainSize - 1) / loop.grainSize;
+					first = victim.first + chunks / 2 * loop.grainSize;
+					last = victim.last;
+					victim.last = first;
+				}
+				Slot& slot = loop.slots[own];
+				std::lock_guard<std::mutex> lock(slot.mutex);
+				slot.first = first;
+				slot.last = last;
+				return true;
+			}
+			return false;
+		}
+
+		void Participate(Loop& loop, const size_t own)
+		{
+			Slot& slot = loop.slots[own];
+			do
+			{
+				size_t first;
+				size_t last;
+				while (TakeChunk(loop, slot, first, last))
+				{
+					(*loop.body)(first, last);
+				}
+			} while (Steal(loop, own));
+		}
+	}
+
+	struct Executor::Pool
+	{
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake;
+		// Loops with slots still to join, newest last
+		std::vector<Loop*> loops;
+		bool stopping = false;
+
+		void Withdraw(Loop* loop)
+		{
+			const auto found = std::find(loops.begin(), loops.end(), loop);
+			if (found != loops.end())
+			{
+				loops.erase(found);
+			}
+		}
+
+		void WorkerMain()
+		{
+			for (;;)
+			{
+				Loop* loop;
+				size_t own;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [this]() {
+						return stopping || !loops.empty();
+					});
+					if (stopping)
+					{
+						return;
+					}
+					// The newest loop first, which finishes nested loops before their parents
+					loop = loops.back();
+					own = loop->nextSlot++;
+					if (loop->nextSlot == loop->slotCount)
+					{
+						loops.pop_back();
+					}
+					std::lock_guard<std::mutex> loopLock(loop->mutex);
+					++loop->helpers;
+				}
+
+				Participate(*loop, own);
+
+				// Notified under the lock, as the loop is gone once the starting thread
+				// sees no helpers
+				std::lock_guard<std::mutex> loopLock(loop->mutex);
+				if (--loop->helpers == 0)
+				{
+					loop->finished.notify_all();
+				}
+			}
+		}
+	};
+
+	Executor::Executor(unsigned threadCount)
+		: pool(new Pool)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		pool->workers.reserve(threadCount - 1);
+		for (unsigned t = 1; t < threadCount; ++t)
+		{
+			pool->workers.emplace_back(&Pool::WorkerMain, pool.get());
+		}
+	}
+
+	Executor::~Executor()
+	{
+		{
+			std::lock_guard<std::mutex> lock(pool->mutex);
+			assert(pool->loops.empty());
+			pool->stopping = true;
+		}
+		pool->wake.notify_all();
+		for (std::thread& worker : pool->workers)
+		{
+			worker.join();
+		}
+	}
+
+	unsigned Executor::GetThreadCount() const
+	{
+		return static_cast<unsigned>(pool->workers.size()) + 1;
+	}
+
+	void Executor::ParallelFor(const size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		grainSize = std::max<size_t>(grainSize, 1);
+		const size_t chunkCount = (count + grainSize - 1) / grainSize;
+		const size_t slotCount = std::min<size_t>(GetThreadCount(), chunkCount);
+		if (slotCount <= 1)
+		{
+			body(0, count);
+			return;
+		}
+
+		// Deal whole chunks out evenly
+		Loop loop;
+		loop.body = &body;
+		loop.grainSize = grainSize;
+		loop.slots.reset(new Slot[slotCount]);
+		loop.slotCount = slotCount;
+		loop.nextSlot = 1;
+		loop.helpers = 0;
+		for (size_t s = 0; s < slotCount; ++s)
+		{
+			loop.slots[s].first = std::min(count, chunkCount * s / slotCount * grainSize);
+			loop.slots[s].last = std::min(count, chunkCount * (s + 1) / slotCount * grainSize);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(pool->mutex);
+			pool->loops.push_back(&loop);
+		}
+		for (size_t s = 1; s < slotCount; ++s)
+		{
+			pool->wake.notify_one();
+		}
+
+		Participate(loop, 0);
+
+		// Every chunk has been taken, so no more helpers are needed
+		{
+			std::lock_guard<std::mutex> lock(pool->mutex);
+			pool->Withdraw(&loop);
+		}
+		std::unique_lock<std::mutex> lock(loop.mutex);
+		loop.finished.wait(lock, [&loop]() {
+			return loop.helpers == 0;
+		});
+	}
+
+	Executor& Executor::GetDefault()
+	{
+		static Executor executor;
+		return executor;
+	}
+
+	unsigned GetWorkerCount(Executor* executor)
+	{
+		return (executor != nullptr ? *executor : Executor::GetDefault()).GetThreadCount();
+	}
+
+	void ParallelFor(const size_t count, const size_t grainSize, const std::function<void(size_t, size_t)>& body, Executor* executor)
+	{
+		(executor != nullptr ? *executor : Executor::GetDefault()).ParallelFor(count, grainSize, body);
+	}
+}
@@ -0,0 +1,235 @@
+#include <Pipeline.h>
+
+#include <Parallel.h>
+#include <SpaceFillingCurve.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace Math
+{
+	namespace
+	{
+		// One chunk loading, one processing and one writing
+		constexpr size_t k_bufferCount = 3;
+		constexpr size_t k_grainSize = 4096;
+
+		// Chunk buffers handed from one thread to the next
+		class ChunkQueue
+		{
+		public:
+			void Push(const size_t buffer)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					buffers.push_back(buffer);
+				}
+				ready.notify_one();
+			}
+
+			// Waits for a buffer. Returns false once the queue is closed and empty.
+			bool Pop(size_t& buffer)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				ready.wait(lock, [this]() {
+					return !buffers.empty() || closed;
+				});
+				if (buffers.empty())
+				{
+					return false;
+				}
+				buffer = buffers.front();
+				buffers.pop_front();
+				return true;
+			}
+
+			void Close()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					closed = true;
+				}
+				ready.notify_all();
+			}
+
+		private:
+			std::mutex mutex;
+			std::condition_variable ready;
+			std::deque<size_t> buffers;
+			bool closed = false;
+		};
+	}
+
+	constexpr size_t PointPipeline::k_defaultChunkSize;
+
+	PointStage TransformStage(const Matrix4x4f& m)
+	{
+		return [m](const VectorSpan<float, 3>& points) {
+			TransformPoints(Matrix4x4Ref<const float>(m), points, points);
+		};
+	}
+
+	PointStage NormalizeStage()
+	{
+		return [](const VectorSpan<float, 3>& points) {
+			Normalize(points, points);
+		};
+	}
+
+	PointStage QuantizeStage(const Aabbf& bounds, const int bits)
+	{
+		assert(bits > 0 && bits <= 21);
+		return [bounds, bits](const VectorSpan<float, 3>& points) {
+			const float cells = static_cast<float>(1 << bits);
+			for (size_t i = 0; i < points.Count(); ++i)
+			{
+				const Vector3i cell = Quantize(points.Load(i), bounds, bits);
+				float* position = points[i];
+				for (int a = 0; a < 3; ++a)
+				{
+					const float extent = bounds.max[a] - bounds.min[a];
+					position[a] = bounds.min[a] + (static_cast<float>(cell[a]) + 0.5f) * (extent / cells);
+				}
+			}
+		};
+	}
+
+	PointSource ReadPoints(std::FILE* file)
+	{
+		assert(file != nullptr);
+		return [file](const VectorSpan<float, 3>& chunk) {
+			assert(chunk.IsPacked());
+			const size_t count = std::fread(chunk.Data(), VectorSpan<float, 3>::k_packedStride, chunk.Count(), file);
+			return count < chunk.Count() && std::ferror(file) ? k_pointSourceFailed : count;
+		};
+	}
+
+	PointSource ReadPoints(const ArrayFileReader& reader, const size_t index)
+	{
+		const VectorSpan<const float, 3> points = reader.GetVectors<float, 3>(index);
+		size_t position = 0;
+		return [points, position](const VectorSpan<float, 3>& chunk) mutable {
+			assert(chunk.IsPacked());
+			const size_t count = std::min(chunk.Count(), points.Count() - position);
+			if (count > 0)
+			{
+				std::memcpy(chunk.Data(), points[position], count * VectorSpan<float, 3>::k_packedStride);
+			}
+			position += count;
+			return count;
+		};
+	}
+
+	PointSink WritePoints(std::FILE* file)
+	{
+		assert(file != nullptr);
+		return [file](const VectorSpan<const float, 3>& chunk) {
+			assert(chunk.IsPacked());
+			return std::fwrite(chunk.Data(), VectorSpan<float, 3>::k_packedStride, chunk.Count(), file) == chunk.Count();
+		};
+	}
+
+	PointSink AppendPoints(ArrayFileWriter& writer)
+	{
+		return [&writer](const VectorSpan<const float, 3>& chunk) {
+			assert(chunk.IsPacked());
+			return writer.Append(reinterpret_cast<const Vector3f*>(chunk.Data()), chunk.Count());
+		};
+	}
+
+	PointPipeline::PointPipeline(const size_t chunkSize)
+		: chunkSize(chunkSize)
+	{
+		assert(chunkSize > 0);
+	}
+
+	PointPipeline& PointPipeline::Then(PointStage stage)
+	{
+		stages.push_back(std::move(stage));
+		return *this;
+	}
+
+	bool PointPipeline::Run(const PointSource& source, const PointSink& sink) const
+	{
+		std::vector<Vector3f> buffers[k_bufferCount];
+		size_t counts[k_bufferCount] = {};
+		ChunkQueue freeChunks;
+		ChunkQueue loadedChunks;
+		ChunkQueue processedChunks;
+		for (size_t b = 0; b < k_bufferCount; ++b)
+		{
+			buffers[b].resize(chunkSize);
+			freeChunks.Push(b);
+		}
+		std::atomic<bool> stopped(false);
+		// Only written by the loader, and read after it is joined
+		bool sourceFailed = false;
+
+		std::thread loader([&]() {
+			size_t b;
+			while (!stopped.load(std::memory_order_relaxed) && freeChunks.Pop(b))
+			{
+				counts[b] = source(VectorSpan<float, 3>(buffers[b].data(), chunkSize));
+				if (counts[b] == k_pointSourceFailed)
+				{
+					sourceFailed = true;
+					break;
+				}
+				assert(counts[b] <= chunkSize);
+				if (counts[b] > 0)
+				{
+					loadedChunks.Push(b);
+				}
+				if (counts[b] < chunkSize)
+				{
+					break;
+				}
+			}
+			loadedChunks.Close();
+		});
+
+		std::thread writer([&]() {
+			size_t b;
+			while (processedChunks.Pop(b))
+			{
+				if (!stopped.load(std::memory_order_relaxed) && !sink(VectorSpan<const float, 3>(buffers[b].data(), counts[b])))
+				{
+					stopped.store(true, std::memory_order_relaxed);
+					freeChunks.Close();
+				}
+				freeChunks.Push(b);
+			}
+		});
+
+		// Each part of a chunk goes through every stage while it is in cache
+		size_t b;
+		while (loadedChunks.Pop(b))
+		{
+			if (!stopped.load(std::memory_order_relaxed))
+			{
+				const VectorSpan<float, 3> chunk(buffers[b].data(), counts[b]);
+				ParallelFor(counts[b], k_grainSize, [&](size_t first, size_t last) {
+					for (size_t block = first; block < last; block += k_grainSize)
+					{
+						const VectorSpan<float, 3> part = chunk.Subspan(block, std::min(k_grainSize, last - block));
+						for (const PointStage& stage : stages)
+						{
+							stage(part);
+						}
+					}
+				});
+			}
+			processedChunks.Push(b);
+		}
+		processedChunks.Close();
+
+		loader.join();
+		writer.join();
+		return !stopped.load(std::memory_order_relaxed) && !sourceFailed;
+	}
+}
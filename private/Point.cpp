@@ -0,0 +1,7 @@
+#include <Point.h>
+
+namespace Math
+{
+	template class Point<float>;
+	template class Point<int>;
+}
@@ -0,0 +1,159 @@
+#include <Projection.h>
+
+#include <Parallel.h>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		using Simd::Float4;
+
+		struct ProjectionContext
+		{
+			Float4 rows[16];
+			Float4 halfWidth;
+			Float4 halfHeight;
+			Float4 left;
+			Float4 top;
+			Float4 minDepth;
+			Float4 depthRange;
+		};
+
+		// Projects four points given as x, y and z lanes. Returns the near plane mask.
+		int ProjectBlock(const ProjectionContext& context, const Float4 x, const Float4 y, const Float4 z,
+			float* screenX, float* screenY, float* depth, uint8_t* clipCodes)
+		{
+			const Float4* m = context.rows;
+			const Float4 clipX = m[0] * x + m[1] * y + m[2] * z + m[3];
+			const Float4 clipY = m[4] * x + m[5] * y + m[6] * z + m[7];
+			const Float4 clipZ = m[8] * x + m[9] * y + m[10] * z + m[11];
+			const Float4 clipW = m[12] * x + m[13] * y + m[14] * z + m[15];
+
+			const Float4 one = Simd::Set1(1.f);
+			const Float4 invW = one / clipW;
+			Simd::Store(screenX, context.left + (clipX * invW + one) * context.halfWidth);
+			Simd::Store(screenY, context.top + (one - clipY * invW) * context.halfHeight);
+			if (depth != nullptr)
+			{
+				Simd::Store(depth, context.minDepth + clipZ * invW * context.depthRange);
+			}
+
+			const int nearMask = Simd::MoveMask(Simd::CmpLt(clipZ, Simd::Zero()));
+			if (clipCodes != nullptr)
+			{
+				const Float4 negW = -clipW;
+				const int masks[6] = {
+					nearMask,
+					Simd::MoveMask(Simd::CmpGt(clipZ, clipW)),
+					Simd::MoveMask(Simd::CmpLt(clipX, negW)),
+					Simd::MoveMask(Simd::CmpGt(clipX, clipW)),
+					Simd::MoveMask(Simd::CmpLt(clipY, negW)),
+					Simd::MoveMask(Simd::CmpGt(clipY, clipW))
+				};
+				for (int j = 0; j < 4; ++j)
+				{
+					uint8_t code = 0;
+					for (int plane = 0; plane < 6; ++plane)
+					{
+						code |= static_cast<uint8_t>(((masks[plane] >> j) & 1) << plane);
+					}
+					clipCodes[j] = code;
+				}
+			}
+			return nearMask;
+		}
+
+		int PopCount4(const int mask)
+		{
+			return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+		}
+
+		// Projects points [first, last), returning how many are behind the near plane
+		size_t ProjectRange(const ProjectionContext& context, const VectorSpan<const float, 3>& points,
+			const VectorSpan<float, 2>& screen, float* depth, uint8_t* clipCodes, const size_t first, const size_t last)
+		{
+			const size_t pointStride = points.GetStride() / sizeof(float);
+			size_t behind = 0;
+			float screenX[4];
+			float screenY[4];
+
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Float4 x, y, z;
+				Simd::LoadTransposed3(points.Data() + i * pointStride, x, y, z, pointStride);
+				const int nearMask = ProjectBlock(context, x, y, z, screenX, screenY,
+					depth != nullptr ? depth + i : nullptr, clipCodes != nullptr ? clipCodes + i : nullptr);
+				behind += PopCount4(nearMask);
+				for (size_t j = 0; j < 4; ++j)
+				{
+					screen.Store(i + j, Vector2f(screenX[j], screenY[j]));
+				}
+			}
+
+			// The remainder is padded to a full block so it takes the same arithmetic
+			const size_t remaining = last - i;
+			if (remaining > 0)
+			{
+				float lanes[3][4] = {};
+				for (size_t j = 0; j < remaining; ++j)
+				{
+					const Vector3f p = points.Load(i + j);
+					lanes[0][j] = p.x;
+					lanes[1][j] = p.y;
+					lanes[2][j] = p.z;
+				}
+				float tailDepth[4];
+				uint8_t tailCodes[4];
+				const int nearMask = ProjectBlock(context, Simd::Load(lanes[0]), Simd::Load(lanes[1]), Simd::Load(lanes[2]),
+					screenX, screenY, tailDepth, tailCodes);
+				behind += PopCount4(nearMask & ((1 << remaining) - 1));
+				for (size_t j = 0; j < remaining; ++j)
+				{
+					screen.Store(i + j, Vector2f(screenX[j], screenY[j]));
+					if (depth != nullptr)
+					{
+						depth[i + j] = tailDepth[j];
+					}
+					if (clipCodes != nullptr)
+					{
+						clipCodes[i + j] = tailCodes[j];
+					}
+				}
+			}
+			return behind;
+		}
+	}
+
+	size_t ProjectPoints(const Matrix4x4f& viewProjection, const Viewportf& viewport,
+		const VectorSpan<const float, 3>& points, const VectorSpan<float, 2>& screen, float* depth, uint8_t* clipCodes,
+		Executor* executor)
+	{
+		assert(points.Count() == screen.Count());
+
+		ProjectionContext context;
+		for (int k = 0; k < 16; ++k)
+		{
+			context.rows[k] = Simd::Set1(viewProjection.Data()[k]);
+		}
+		context.halfWidth = Simd::Set1(viewport.width * 0.5f);
+		context.halfHeight = Simd::Set1(viewport.height * 0.5f);
+		context.left = Simd::Set1(viewport.x);
+		context.top = Simd::Set1(viewport.y);
+		context.minDepth = Simd::Set1(viewport.minDepth);
+		context.depthRange = Simd::Set1(viewport.maxDepth - viewport.minDepth);
+
+		// Chunks are whole blocks of four, so only the last can have a padded remainder
+		const size_t count = points.Count();
+		const size_t behind = ParallelReduce(count, GetChunkSize(points.GetStride() + screen.GetStride()), size_t(0),
+			[&](const size_t first, const size_t last) {
+				return ProjectRange(context, points, screen, depth, clipCodes, first, last);
+			},
+			[](const size_t a, const size_t b) {
+				return a + b;
+			}, executor);
+		return count - behind;
+	}
+}
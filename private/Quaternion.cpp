@@ -1,5 +1,8 @@
 #include <Vector.h>
 #include <Quaternion.h>
+#include <Parallel.h>
+
+#include "Simd.h"
 
 namespace Math
 {
@@ -14,4 +17,102 @@ namespace Math
 		const Quaternionf axisTestf(Vector3f::UNIT_Z, 3.14159f);
 		const Quaterniond axisTestd(Vector3d::UNIT_Z, 3.14159);
 	}
-}
\ No newline at end of file
+
+	static_assert(sizeof(Quaterniond) == sizeof(double) * 4, "Double quaternions must be tightly packed");
+
+	namespace
+	{
+		using Simd::Double4;
+
+		// Four quaternions in SoA form
+		struct QuaternionLanes
+		{
+			Double4 x, y, z, w;
+		};
+
+		inline QuaternionLanes LoadQuaternions(const Quaterniond* q)
+		{
+			QuaternionLanes l;
+			Simd::LoadTransposed4(reinterpret_cast<const double*>(q), l.x, l.y, l.z, l.w);
+			return l;
+		}
+
+		inline void StoreQuaternions(Quaterniond* q, const QuaternionLanes& l)
+		{
+			Simd::StoreTransposed4(reinterpret_cast<double*>(q), l.x, l.y, l.z, l.w);
+		}
+
+		// Same term order as operator*(const Quaternion<T>&, const Quaternion<T>&)
+		inline QuaternionLanes Multiply(const QuaternionLanes& a, const QuaternionLanes& b)
+		{
+			return {
+				a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+				a.w * b.y + a.y * b.w + a.z * b.x - a.x * b.z,
+				a.w * b.z + a.z * b.w + a.x * b.y - a.y * b.x,
+				a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+			};
+		}
+	}
+
+	void Multiply(const Quaterniond* lhs, const Quaterniond* rhs, Quaterniond* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Quaterniond)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				StoreQuaternions(out + i, Multiply(LoadQuaternions(lhs + i), LoadQuaternions(rhs + i)));
+			}
+			for (; i < last; ++i)
+			{
+				out[i] = lhs[i] * rhs[i];
+			}
+		}, executor);
+	}
+
+	void Normalize(const Quaterniond* src, Quaterniond* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Quaterniond)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				const QuaternionLanes q = LoadQuaternions(src + i);
+				const Double4 length = Simd::Sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+
+				// Quaternion::operator/= scales by the reciprocal
+				const Double4 s = Simd::Set1(1.0) / length;
+				StoreQuaternions(out + i, { q.x * s, q.y * s, q.z * s, q.w * s });
+			}
+			for (; i < last; ++i)
+			{
+				out[i] = src[i].Normalized();
+			}
+		}, executor);
+	}
+
+	void Rotate(const Quaterniond* rotations, const Vector3d* src, Vector3d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(sizeof(Quaterniond) + 2 * sizeof(Vector3d)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				const QuaternionLanes r = LoadQuaternions(rotations + i);
+				Double4 vx, vy, vz;
+				Simd::LoadTransposed3(&src[i].x, vx, vy, vz);
+
+				// rotation * v, then * rotation.Inverse(), as in RotateQuaternion
+				const QuaternionLanes rv = {
+					r.w * vx + r.y * vz - r.z * vy,
+					r.w * vy + r.z * vx - r.x * vz,
+					r.w * vz + r.x * vy - r.y * vx,
+					-r.x * vx - r.y * vy - r.z * vz
+				};
+				const QuaternionLanes result = Multiply(rv, { -r.x, -r.y, -r.z, r.w });
+				Simd::StoreTransposed3(&out[i].x, result.x, result.y, result.z);
+			}
+			for (; i < last; ++i)
+			{
+				out[i] = RotateQuaternion(rotations[i], src[i]);
+			}
+		}, executor);
+	}
+}
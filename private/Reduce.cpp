@@ -0,0 +1,303 @@
+#include <Reduce.h>
+
+#include <Parallel.h>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		// Elements summed in lanes before Summation::Pairwise starts splitting; a multiple of 4
+		constexpr size_t k_pairwiseBlock = 256;
+
+		template <typename T, int N>
+		using VectorOf = typename ViewDetail::VectorOf<T, N>::Type;
+
+		// Chunks depend only on the element type, never on the thread count or stride
+		template <typename T, int N>
+		size_t GrainSize()
+		{
+			return GetChunkSize(sizeof(T) * N);
+		}
+
+		template <typename T, typename Lanes>
+		void LoadLanes(const T* p, const size_t stride, Lanes (&v)[2])
+		{
+			Simd::LoadTransposed2(p, v[0], v[1], stride);
+		}
+
+		template <typename T, typename Lanes>
+		void LoadLanes(const T* p, const size_t stride, Lanes (&v)[3])
+		{
+			Simd::LoadTransposed3(p, v[0], v[1], v[2], stride);
+		}
+
+		template <typename T, typename Lanes>
+		void LoadLanes(const T* p, const size_t stride, Lanes (&v)[4])
+		{
+			Simd::LoadTransposed4(p, v[0], v[1], v[2], v[3], stride);
+		}
+
+		// Adds x to sum, adding the rounding error of the addition to error. Exact
+		// whatever the magnitudes of sum and x, for scalars and SIMD lanes alike.
+		template <typename U>
+		void TwoSum(U& sum, U& error, const U x)
+		{
+			const U t = sum + x;
+			const U z = t - sum;
+			error = error + ((sum - (t - z)) + (x - z));
+			sum = t;
+		}
+
+		template <typename T, int N>
+		struct CompensatedSum
+		{
+			VectorOf<T, N> sum;
+			VectorOf<T, N> error;
+		};
+
+		template <typename T, int N>
+		VectorBounds<T, N> BoundsOf(const VectorSpan<const T, N>& points, const size_t first, const size_t last)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			const size_t stride = points.GetStride() / sizeof(T);
+			Lanes lo[N];
+			Lanes hi[N];
+			for (int c = 0; c < N; ++c)
+			{
+				lo[c] = Simd::Set1(std::numeric_limits<T>::max());
+				hi[c] = Simd::Set1(-std::numeric_limits<T>::max());
+			}
+
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Lanes v[N];
+				LoadLanes(points[i], stride, v);
+				for (int c = 0; c < N; ++c)
+				{
+					// The new value first, so NaN lanes keep the running bound
+					lo[c] = Simd::Min(v[c], lo[c]);
+					hi[c] = Simd::Max(v[c], hi[c]);
+				}
+			}
+
+			VectorBounds<T, N> bounds = VectorBounds<T, N>::Empty();
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				for (int c = 0; c < N; ++c)
+				{
+					bounds.min.e[c] = GeometryDetail::Min(Simd::GetLane(lo[c], lane), bounds.min.e[c]);
+					bounds.max.e[c] = GeometryDetail::Max(Simd::GetLane(hi[c], lane), bounds.max.e[c]);
+				}
+			}
+			for (; i < last; ++i)
+			{
+				bounds.Expand(points.Load(i));
+			}
+			return bounds;
+		}
+
+		template <typename T, int N>
+		VectorOf<T, N> PairwiseSumOf(const VectorSpan<const T, N>& points, const size_t first, const size_t last)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			if (last - first > k_pairwiseBlock)
+			{
+				// Split on a multiple of 4 from first, so both halves stay in whole lanes
+				const size_t middle = first + (last - first) / 8 * 4;
+				return PairwiseSumOf(points, first, middle) + PairwiseSumOf(points, middle, last);
+			}
+
+			const size_t stride = points.GetStride() / sizeof(T);
+			Lanes sums[N];
+			for (int c = 0; c < N; ++c)
+			{
+				sums[c] = Simd::Set1(static_cast<T>(0));
+			}
+
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Lanes v[N];
+				LoadLanes(points[i], stride, v);
+				for (int c = 0; c < N; ++c)
+				{
+					sums[c] = sums[c] + v[c];
+				}
+			}
+
+			VectorOf<T, N> sum;
+			for (int c = 0; c < N; ++c)
+			{
+				sum.e[c] = (Simd::GetLane(sums[c], 0) + Simd::GetLane(sums[c], 1)) + (Simd::GetLane(sums[c], 2) + Simd::GetLane(sums[c], 3));
+			}
+			for (; i < last; ++i)
+			{
+				sum += points.Load(i);
+			}
+			return sum;
+		}
+
+		template <typename T, int N>
+		CompensatedSum<T, N> CompensatedSumOf(const VectorSpan<const T, N>& points, const size_t first, const size_t last)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			const size_t stride = points.GetStride() / sizeof(T);
+			Lanes sums[N];
+			Lanes errors[N];
+			for (int c = 0; c < N; ++c)
+			{
+				sums[c] = Simd::Set1(static_cast<T>(0));
+				errors[c] = Simd::Set1(static_cast<T>(0));
+			}
+
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Lanes v[N];
+				LoadLanes(points[i], stride, v);
+				for (int c = 0; c < N; ++c)
+				{
+					TwoSum(sums[c], errors[c], v[c]);
+				}
+			}
+
+			CompensatedSum<T, N> result;
+			for (int c = 0; c < N; ++c)
+			{
+				T& sum = result.sum.e[c];
+				T& error = result.error.e[c];
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					TwoSum(sum, error, Simd::GetLane(sums[c], lane));
+					error += Simd::GetLane(errors[c], lane);
+				}
+			}
+			for (; i < last; ++i)
+			{
+				const T* components = points[i];
+				for (int c = 0; c < N; ++c)
+				{
+					TwoSum(result.sum.e[c], result.error.e[c], components[c]);
+				}
+			}
+			return result;
+		}
+
+		template <typename T, int N>
+		T MaxLengthSqOf(const VectorSpan<const T, N>& points, const size_t first, const size_t last)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+
+			const size_t stride = points.GetStride() / sizeof(T);
+			Lanes maxLengthSq = Simd::Set1(static_cast<T>(0));
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Lanes v[N];
+				LoadLanes(points[i], stride, v);
+				// Summed in the order of LengthSq
+				Lanes lengthSq = v[0] * v[0];
+				for (int c = 1; c < N; ++c)
+				{
+					lengthSq = lengthSq + v[c] * v[c];
+				}
+				maxLengthSq = Simd::Max(lengthSq, maxLengthSq);
+			}
+
+			T result = static_cast<T>(0);
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				result = GeometryDetail::Max(Simd::GetLane(maxLengthSq, lane), result);
+			}
+			for (; i < last; ++i)
+			{
+				result = GeometryDetail::Max(points.Load(i).LengthSq(), result);
+			}
+			return result;
+		}
+	}
+
+	namespace ReduceDetail
+	{
+		template <typename T, int N>
+		VectorBounds<T, N> ComputeBounds(const VectorSpan<const T, N>& points, Executor* executor)
+		{
+			return ParallelReduce(points.Count(), GrainSize<T, N>(), VectorBounds<T, N>::Empty(),
+				[&points](const size_t first, const size_t last) {
+					return BoundsOf(points, first, last);
+				},
+				[](VectorBounds<T, N> a, const VectorBounds<T, N>& b) {
+					a.Merge(b);
+					return a;
+				}, executor);
+		}
+
+		template <typename T, int N>
+		typename VectorSpan<const T, N>::VectorType Sum(const VectorSpan<const T, N>& points, const Summation summation, Executor* executor)
+		{
+			if (summation == Summation::Pairwise)
+			{
+				return ParallelReduce(points.Count(), GrainSize<T, N>(), VectorOf<T, N>(),
+					[&points](const size_t first, const size_t last) {
+						return PairwiseSumOf(points, first, last);
+					},
+					[](const VectorOf<T, N>& a, const VectorOf<T, N>& b) {
+						return a + b;
+					}, executor);
+			}
+
+			const CompensatedSum<T, N> total = ParallelReduce(points.Count(), GrainSize<T, N>(), CompensatedSum<T, N>(),
+				[&points](const size_t first, const size_t last) {
+					return CompensatedSumOf(points, first, last);
+				},
+				[](CompensatedSum<T, N> a, const CompensatedSum<T, N>& b) {
+					for (int c = 0; c < N; ++c)
+					{
+						TwoSum(a.sum.e[c], a.error.e[c], b.sum.e[c]);
+						a.error.e[c] += b.error.e[c];
+					}
+					return a;
+				}, executor);
+			return total.sum + total.error;
+		}
+
+		template <typename T, int N>
+		T MaxLengthSq(const VectorSpan<const T, N>& points, Executor* executor)
+		{
+			return ParallelReduce(points.Count(), GrainSize<T, N>(), static_cast<T>(0),
+				[&points](const size_t first, const size_t last) {
+					return MaxLengthSqOf(points, first, last);
+				},
+				[](const T a, const T b) {
+					return GeometryDetail::Max(b, a);
+				}, executor);
+		}
+
+		template VectorBounds<float, 2> ComputeBounds(const VectorSpan<const float, 2>&, Executor*);
+		template VectorBounds<float, 3> ComputeBounds(const VectorSpan<const float, 3>&, Executor*);
+		template VectorBounds<float, 4> ComputeBounds(const VectorSpan<const float, 4>&, Executor*);
+		template VectorBounds<double, 2> ComputeBounds(const VectorSpan<const double, 2>&, Executor*);
+		template VectorBounds<double, 3> ComputeBounds(const VectorSpan<const double, 3>&, Executor*);
+		template VectorBounds<double, 4> ComputeBounds(const VectorSpan<const double, 4>&, Executor*);
+
+		template Vector2f Sum(const VectorSpan<const float, 2>&, Summation, Executor*);
+		template Vector3f Sum(const VectorSpan<const float, 3>&, Summation, Executor*);
+		template Vector4f Sum(const VectorSpan<const float, 4>&, Summation, Executor*);
+		template Vector2d Sum(const VectorSpan<const double, 2>&, Summation, Executor*);
+		template Vector3d Sum(const VectorSpan<const double, 3>&, Summation, Executor*);
+		template Vector4d Sum(const VectorSpan<const double, 4>&, Summation, Executor*);
+
+		template float MaxLengthSq(const VectorSpan<const float, 2>&, Executor*);
+		template float MaxLengthSq(const VectorSpan<const float, 3>&, Executor*);
+		template float MaxLengthSq(const VectorSpan<const float, 4>&, Executor*);
+		template double MaxLengthSq(const VectorSpan<const double, 2>&, Executor*);
+		template double MaxLengthSq(const VectorSpan<const double, 3>&, Executor*);
+		template double MaxLengthSq(const VectorSpan<const double, 4>&, Executor*);
+	}
+}
@@ -0,0 +1,605 @@
+#pragma once
+
+// Compile-time instruction set detection for the batch kernels in private/.
+// Kernels always provide a scalar path, so these only ever select faster code.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATH_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#define MATH_SIMD_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define MATH_SIMD_SSE41 1
+#include <smmintrin.h>
+#endif
+
+// Enabled by the MATH_ENABLE_AVX2 build option
+#if defined(__AVX__)
+#define MATH_SIMD_AVX 1
+#include <immintrin.h>
+#endif
+
+// Bit deposit and extract, also enabled by MATH_ENABLE_AVX2. MSVC has no macro for
+// BMI2, but every AVX2 processor has it.
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define MATH_SIMD_BMI2 1
+#include <immintrin.h>
+#endif
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+
+namespace Math
+{
+	namespace Simd
+	{
+		// Four float lanes. Comparisons return lane masks with all bits set or clear,
+		// which are consumed by Select and the bitwise helpers.
+#if MATH_SIMD_SSE2
+		struct Float4
+		{
+			__m128 v;
+		};
+
+		inline Float4 Set1(const float f) { return { _mm_set1_ps(f) }; }
+		inline Float4 Zero() { return { _mm_setzero_ps() }; }
+		inline Float4 Load(const float* p) { return { _mm_loadu_ps(p) }; }
+		inline void Store(float* p, const Float4 a) { _mm_storeu_ps(p, a.v); }
+
+		inline Float4 operator+(const Float4 a, const Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+		inline Float4 operator-(const Float4 a, const Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+		inline Float4 operator*(const Float4 a, const Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+		inline Float4 operator/(const Float4 a, const Float4 b) { return { _mm_div_ps(a.v, b.v) }; }
+		inline Float4 operator-(const Float4 a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.f)) }; }
+
+		inline Float4 Min(const Float4 a, const Float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+		inline Float4 Max(const Float4 a, const Float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+		inline Float4 Sqrt(const Float4 a) { return { _mm_sqrt_ps(a.v) }; }
+		inline Float4 Abs(const Float4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.f), a.v) }; }
+
+		inline Float4 CmpEq(const Float4 a, const Float4 b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+		inline Float4 CmpLt(const Float4 a, const Float4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+		inline Float4 CmpLe(const Float4 a, const Float4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+		inline Float4 CmpGt(const Float4 a, const Float4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+		inline Float4 CmpGe(const Float4 a, const Float4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+
+		inline Float4 And(const Float4 a, const Float4 b) { return { _mm_and_ps(a.v, b.v) }; }
+		inline Float4 Or(const Float4 a, const Float4 b) { return { _mm_or_ps(a.v, b.v) }; }
+		inline Float4 AndNot(const Float4 mask, const Float4 a) { return { _mm_andnot_ps(mask.v, a.v) }; }
+
+		// mask ? a : b, per lane
+		inline Float4 Select(const Float4 mask, const Float4 a, const Float4 b)
+		{
+#if MATH_SIMD_SSE41
+			return { _mm_blendv_ps(b.v, a.v, mask.v) };
+#else
+			return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+#endif
+		}
+
+		// One bit per lane, lane 0 in bit 0
+		inline int MoveMask(const Float4 mask) { return _mm_movemask_ps(mask.v); }
+
+		inline Float4 Floor(const Float4 a)
+		{
+#if MATH_SIMD_SSE41
+			return { _mm_floor_ps(a.v) };
+#else
+			// Only valid within int32 range, which is all the kernels need
+			const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+			const __m128 correction = _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.f));
+			return { _mm_sub_ps(truncated, correction) };
+#endif
+		}
+
+		inline float GetLane(const Float4 a, const int lane)
+		{
+			float lanes[4];
+			_mm_storeu_ps(lanes, a.v);
+			return lanes[lane];
+		}
+
+		// Transpose two, three or four interleaved components of four elements into SoA lanes.
+		// stride is the distance in floats between consecutive elements.
+		inline void LoadTransposed2(const float* p, Float4& x, Float4& y, const size_t stride = 2)
+		{
+			if (stride != 2)
+			{
+				x.v = _mm_setr_ps(p[0], p[stride], p[stride * 2], p[stride * 3]);
+				y.v = _mm_setr_ps(p[1], p[stride + 1], p[stride * 2 + 1], p[stride * 3 + 1]);
+				return;
+			}
+
+			const __m128 a = _mm_loadu_ps(p + 0);
+			const __m128 b = _mm_loadu_ps(p + 4);
+			x.v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+			y.v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		}
+
+		inline void LoadTransposed3(const float* p, Float4& x, Float4& y, Float4& z, const size_t stride = 3)
+		{
+			if (stride != 3)
+			{
+				x.v = _mm_setr_ps(p[0], p[stride], p[stride * 2], p[stride * 3]);
+				y.v = _mm_setr_ps(p[1], p[stride + 1], p[stride * 2 + 1], p[stride * 3 + 1]);
+				z.v = _mm_setr_ps(p[2], p[stride + 2], p[stride * 2 + 2], p[stride * 3 + 2]);
+				return;
+			}
+
+			const __m128 a = _mm_loadu_ps(p + 0);
+			const __m128 b = _mm_loadu_ps(p + 4);
+			const __m128 c = _mm_loadu_ps(p + 8);
+			const __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+			const __m128 u = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+			const __m128 v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+			const __m128 w = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 3, 0));
+			x.v = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+			y.v = _mm_shuffle_ps(u, t, _MM_SHUFFLE(3, 1, 2, 0));
+			z.v = _mm_shuffle_ps(v, w, _MM_SHUFFLE(1, 0, 2, 0));
+		}
+
+		inline void StoreTransposed3(float* p, const Float4 x, const Float4 y, const Float4 z, const size_t stride = 3)
+		{
+			if (stride != 3)
+			{
+				float lanes[3][4];
+				_mm_storeu_ps(lanes[0], x.v);
+				_mm_storeu_ps(lanes[1], y.v);
+				_mm_storeu_ps(lanes[2], z.v);
+				for (size_t i = 0; i < 4; ++i)
+				{
+					p[i * stride + 0] = lanes[0][i];
+					p[i * stride + 1] = lanes[1][i];
+					p[i * stride + 2] = lanes[2][i];
+				}
+				return;
+			}
+
+			const __m128 xyLo = _mm_unpacklo_ps(x.v, y.v);
+			const __m128 xyHi = _mm_unpackhi_ps(x.v, y.v);
+			const __m128 s = _mm_shuffle_ps(z.v, xyLo, _MM_SHUFFLE(2, 2, 0, 0));
+			const __m128 t = _mm_shuffle_ps(xyLo, z.v, _MM_SHUFFLE(1, 1, 3, 3));
+			const __m128 u = _mm_shuffle_ps(z.v, xyHi, _MM_SHUFFLE(2, 2, 2, 2));
+			const __m128 v = _mm_shuffle_ps(xyHi, z.v, _MM_SHUFFLE(3, 3, 3, 3));
+			_mm_storeu_ps(p + 0, _mm_shuffle_ps(xyLo, s, _MM_SHUFFLE(2, 0, 1, 0)));
+			_mm_storeu_ps(p + 4, _mm_shuffle_ps(t, xyHi, _MM_SHUFFLE(1, 0, 2, 0)));
+			_mm_storeu_ps(p + 8, _mm_shuffle_ps(u, v, _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+
+		inline void Transpose4(Float4& a, Float4& b, Float4& c, Float4& d)
+		{
+			_MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+		}
+
+		inline void LoadTransposed4(const float* p, Float4& x, Float4& y, Float4& z, Float4& w, const size_t stride = 4)
+		{
+			__m128 r0 = _mm_loadu_ps(p);
+			__m128 r1 = _mm_loadu_ps(p + stride);
+			__m128 r2 = _mm_loadu_ps(p + stride * 2);
+			__m128 r3 = _mm_loadu_ps(p + stride * 3);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			x.v = r0;
+			y.v = r1;
+			z.v = r2;
+			w.v = r3;
+		}
+
+		inline void StoreTransposed4(float* p, const Float4 x, const Float4 y, const Float4 z, const Float4 w, const size_t stride = 4)
+		{
+			__m128 r0 = x.v;
+			__m128 r1 = y.v;
+			__m128 r2 = z.v;
+			__m128 r3 = w.v;
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(p, r0);
+			_mm_storeu_ps(p + stride, r1);
+			_mm_storeu_ps(p + stride * 2, r2);
+			_mm_storeu_ps(p + stride * 3, r3);
+		}
+#else
+		struct Float4
+		{
+			float v[4];
+		};
+
+		namespace Detail
+		{
+			inline uint32_t Bits(const float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+			inline float FromBits(const uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+			inline float Mask(const bool b) { return FromBits(b ? 0xFFFFFFFFu : 0u); }
+		}
+
+		inline Float4 Set1(const float f) { return { { f, f, f, f } }; }
+		inline Float4 Zero() { return Set1(0.f); }
+		inline Float4 Load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+		inline void Store(float* p, const Float4 a) { for (int i = 0; i < 4; ++i) p[i] = a.v[i]; }
+
+#define MATH_SIMD_FLOAT4_LANEWISE(expr) \
+		Float4 r; \
+		for (int i = 0; i < 4; ++i) r.v[i] = (expr); \
+		return r
+
+		inline Float4 operator+(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(a.v[i] + b.v[i]); }
+		inline Float4 operator-(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(a.v[i] - b.v[i]); }
+		inline Float4 operator*(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(a.v[i] * b.v[i]); }
+		inline Float4 operator/(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(a.v[i] / b.v[i]); }
+		inline Float4 operator-(const Float4 a) { MATH_SIMD_FLOAT4_LANEWISE(-a.v[i]); }
+
+		// Operand order matches minps/maxps: the second operand is returned for NaN
+		inline Float4 Min(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+		inline Float4 Max(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+		inline Float4 Sqrt(const Float4 a) { MATH_SIMD_FLOAT4_LANEWISE(std::sqrt(a.v[i])); }
+		inline Float4 Abs(const Float4 a) { MATH_SIMD_FLOAT4_LANEWISE(std::fabs(a.v[i])); }
+
+		inline Float4 CmpEq(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(Detail::Mask(a.v[i] == b.v[i])); }
+		inline Float4 CmpLt(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(Detail::Mask(a.v[i] < b.v[i])); }
+		inline Float4 CmpLe(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(Detail::Mask(a.v[i] <= b.v[i])); }
+		inline Float4 CmpGt(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(Detail::Mask(a.v[i] > b.v[i])); }
+		inline Float4 CmpGe(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(Detail::Mask(a.v[i] >= b.v[i])); }
+
+		inline Float4 And(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(Detail::FromBits(Detail::Bits(a.v[i]) & Detail::Bits(b.v[i]))); }
+		inline Float4 Or(const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(Detail::FromBits(Detail::Bits(a.v[i]) | Detail::Bits(b.v[i]))); }
+		inline Float4 AndNot(const Float4 mask, const Float4 a) { MATH_SIMD_FLOAT4_LANEWISE(Detail::FromBits(~Detail::Bits(mask.v[i]) & Detail::Bits(a.v[i]))); }
+		inline Float4 Select(const Float4 mask, const Float4 a, const Float4 b) { MATH_SIMD_FLOAT4_LANEWISE(Detail::Bits(mask.v[i]) ? a.v[i] : b.v[i]); }
+		inline Float4 Floor(const Float4 a) { MATH_SIMD_FLOAT4_LANEWISE(std::floor(a.v[i])); }
+
+#undef MATH_SIMD_FLOAT4_LANEWISE
+
+		inline int MoveMask(const Float4 mask)
+		{
+			int bits = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				bits |= static_cast<int>(Detail::Bits(mask.v[i]) >> 31) << i;
+			}
+			return bits;
+		}
+
+		inline float GetLane(const Float4 a, const int lane)
+		{
+			return a.v[lane];
+		}
+
+		inline void LoadTransposed2(const float* p, Float4& x, Float4& y, const size_t stride = 2)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				x.v[i] = p[i * stride + 0];
+				y.v[i] = p[i * stride + 1];
+			}
+		}
+
+		inline void LoadTransposed3(const float* p, Float4& x, Float4& y, Float4& z, const size_t stride = 3)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				x.v[i] = p[i * stride + 0];
+				y.v[i] = p[i * stride + 1];
+				z.v[i] = p[i * stride + 2];
+			}
+		}
+
+		inline void StoreTransposed3(float* p, const Float4 x, const Float4 y, const Float4 z, const size_t stride = 3)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				p[i * stride + 0] = x.v[i];
+				p[i * stride + 1] = y.v[i];
+				p[i * stride + 2] = z.v[i];
+			}
+		}
+
+		inline void Transpose4(Float4& a, Float4& b, Float4& c, Float4& d)
+		{
+			float* rows[4] = { a.v, b.v, c.v, d.v };
+			for (int i = 0; i < 4; ++i)
+			{
+				for (int j = i + 1; j < 4; ++j)
+				{
+					const float t = rows[i][j];
+					rows[i][j] = rows[j][i];
+					rows[j][i] = t;
+				}
+			}
+		}
+
+		inline void LoadTransposed4(const float* p, Float4& x, Float4& y, Float4& z, Float4& w, const size_t stride = 4)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				x.v[i] = p[i * stride + 0];
+				y.v[i] = p[i * stride + 1];
+				z.v[i] = p[i * stride + 2];
+				w.v[i] = p[i * stride + 3];
+			}
+		}
+
+		inline void StoreTransposed4(float* p, const Float4 x, const Float4 y, const Float4 z, const Float4 w, const size_t stride = 4)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				p[i * stride + 0] = x.v[i];
+				p[i * stride + 1] = y.v[i];
+				p[i * stride + 2] = z.v[i];
+				p[i * stride + 3] = w.v[i];
+			}
+		}
+#endif
+
+		inline Float4 MulAdd(const Float4 a, const Float4 b, const Float4 c)
+		{
+			return a * b + c;
+		}
+
+		// Four double lanes, with the same semantics as Float4. Without AVX the lanes
+		// are plain arrays, which compilers split into SSE2 pairs.
+#if MATH_SIMD_AVX
+		struct Double4
+		{
+			__m256d v;
+		};
+
+		inline Double4 Set1(const double d) { return { _mm256_set1_pd(d) }; }
+		inline Double4 Load(const double* p) { return { _mm256_loadu_pd(p) }; }
+		inline void Store(double* p, const Double4 a) { _mm256_storeu_pd(p, a.v); }
+
+		inline Double4 operator+(const Double4 a, const Double4 b) { return { _mm256_add_pd(a.v, b.v) }; }
+		inline Double4 operator-(const Double4 a, const Double4 b) { return { _mm256_sub_pd(a.v, b.v) }; }
+		inline Double4 operator*(const Double4 a, const Double4 b) { return { _mm256_mul_pd(a.v, b.v) }; }
+		inline Double4 operator/(const Double4 a, const Double4 b) { return { _mm256_div_pd(a.v, b.v) }; }
+		inline Double4 operator-(const Double4 a) { return { _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0)) }; }
+
+		inline Double4 Min(const Double4 a, const Double4 b) { return { _mm256_min_pd(a.v, b.v) }; }
+		inline Double4 Max(const Double4 a, const Double4 b) { return { _mm256_max_pd(a.v, b.v) }; }
+		inline Double4 Sqrt(const Double4 a) { return { _mm256_sqrt_pd(a.v) }; }
+		inline Double4 Abs(const Double4 a) { return { _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v) }; }
+
+		inline Double4 CmpEq(const Double4 a, const Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ) }; }
+		inline Double4 CmpLt(const Double4 a, const Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ) }; }
+		inline Double4 CmpLe(const Double4 a, const Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ) }; }
+		inline Double4 CmpGt(const Double4 a, const Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ) }; }
+		inline Double4 CmpGe(const Double4 a, const Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ) }; }
+
+		inline Double4 And(const Double4 a, const Double4 b) { return { _mm256_and_pd(a.v, b.v) }; }
+		inline Double4 Or(const Double4 a, const Double4 b) { return { _mm256_or_pd(a.v, b.v) }; }
+		inline Double4 AndNot(const Double4 mask, const Double4 a) { return { _mm256_andnot_pd(mask.v, a.v) }; }
+		inline Double4 Select(const Double4 mask, const Double4 a, const Double4 b) { return { _mm256_blendv_pd(b.v, a.v, mask.v) }; }
+		inline int MoveMask(const Double4 mask) { return _mm256_movemask_pd(mask.v); }
+
+		inline double GetLane(const Double4 a, const int lane)
+		{
+			double lanes[4];
+			_mm256_storeu_pd(lanes, a.v);
+			return lanes[lane];
+		}
+
+		namespace Detail
+		{
+			inline void Transpose4(__m256d& r0, __m256d& r1, __m256d& r2, __m256d& r3)
+			{
+				const __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+				const __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+				const __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+				const __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+				r0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+				r1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+				r2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+				r3 = _mm256_permute2f128_pd(t1, t3, 0x31);
+			}
+
+			// xyz of one element, with zero in the fourth lane, without reading past it
+			inline __m256d LoadXyz(const double* p)
+			{
+				return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(p)), _mm_load_sd(p + 2), 1);
+			}
+
+			inline void StoreXyz(double* p, const __m256d a)
+			{
+				_mm_storeu_pd(p, _mm256_castpd256_pd128(a));
+				_mm_store_sd(p + 2, _mm256_extractf128_pd(a, 1));
+			}
+		}
+
+		// Transpose two, three or four interleaved components of four elements into SoA lanes.
+		// stride is the distance in doubles between consecutive elements.
+		inline void LoadTransposed2(const double* p, Double4& x, Double4& y, const size_t stride = 2)
+		{
+			if (stride != 2)
+			{
+				x.v = _mm256_setr_pd(p[0], p[stride], p[stride * 2], p[stride * 3]);
+				y.v = _mm256_setr_pd(p[1], p[stride + 1], p[stride * 2 + 1], p[stride * 3 + 1]);
+				return;
+			}
+
+			const __m256d a = _mm256_loadu_pd(p + 0);
+			const __m256d b = _mm256_loadu_pd(p + 4);
+			const __m256d even = _mm256_permute2f128_pd(a, b, 0x20);
+			const __m256d odd = _mm256_permute2f128_pd(a, b, 0x31);
+			x.v = _mm256_unpacklo_pd(even, odd);
+			y.v = _mm256_unpackhi_pd(even, odd);
+		}
+
+		inline void LoadTransposed3(const double* p, Double4& x, Double4& y, Double4& z, const size_t stride = 3)
+		{
+			__m256d r0 = Detail::LoadXyz(p);
+			__m256d r1 = Detail::LoadXyz(p + stride);
+			__m256d r2 = Detail::LoadXyz(p + stride * 2);
+			__m256d r3 = Detail::LoadXyz(p + stride * 3);
+			Detail::Transpose4(r0, r1, r2, r3);
+			x.v = r0;
+			y.v = r1;
+			z.v = r2;
+		}
+
+		inline void StoreTransposed3(double* p, const Double4 x, const Double4 y, const Double4 z, const size_t stride = 3)
+		{
+			__m256d r0 = x.v;
+			__m256d r1 = y.v;
+			__m256d r2 = z.v;
+			__m256d r3 = _mm256_setzero_pd();
+			Detail::Transpose4(r0, r1, r2, r3);
+			Detail::StoreXyz(p, r0);
+			Detail::StoreXyz(p + stride, r1);
+			Detail::StoreXyz(p + stride * 2, r2);
+			Detail::StoreXyz(p + stride * 3, r3);
+		}
+
+		inline void LoadTransposed4(const double* p, Double4& x, Double4& y, Double4& z, Double4& w, const size_t stride = 4)
+		{
+			x.v = _mm256_loadu_pd(p);
+			y.v = _mm256_loadu_pd(p + stride);
+			z.v = _mm256_loadu_pd(p + stride * 2);
+			w.v = _mm256_loadu_pd(p + stride * 3);
+			Detail::Transpose4(x.v, y.v, z.v, w.v);
+		}
+
+		inline void StoreTransposed4(double* p, Double4 x, Double4 y, Double4 z, Double4 w, const size_t stride = 4)
+		{
+			Detail::Transpose4(x.v, y.v, z.v, w.v);
+			_mm256_storeu_pd(p, x.v);
+			_mm256_storeu_pd(p + stride, y.v);
+			_mm256_storeu_pd(p + stride * 2, z.v);
+			_mm256_storeu_pd(p + stride * 3, w.v);
+		}
+#else
+		struct Double4
+		{
+			double v[4];
+		};
+
+		namespace Detail
+		{
+			inline uint64_t Bits(const double d) { uint64_t u; std::memcpy(&u, &d, 8); return u; }
+			inline double FromBits(const uint64_t u) { double d; std::memcpy(&d, &u, 8); return d; }
+			inline double MaskDouble(const bool b) { return FromBits(b ? ~uint64_t(0) : uint64_t(0)); }
+		}
+
+		inline Double4 Set1(const double d) { return { { d, d, d, d } }; }
+		inline Double4 Load(const double* p) { return { { p[0], p[1], p[2], p[3] } }; }
+		inline void Store(double* p, const Double4 a) { for (int i = 0; i < 4; ++i) p[i] = a.v[i]; }
+
+#define MATH_SIMD_DOUBLE4_LANEWISE(expr) \
+		Double4 r; \
+		for (int i = 0; i < 4; ++i) r.v[i] = (expr); \
+		return r
+
+		inline Double4 operator+(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(a.v[i] + b.v[i]); }
+		inline Double4 operator-(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(a.v[i] - b.v[i]); }
+		inline Double4 operator*(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(a.v[i] * b.v[i]); }
+		inline Double4 operator/(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(a.v[i] / b.v[i]); }
+		inline Double4 operator-(const Double4 a) { MATH_SIMD_DOUBLE4_LANEWISE(-a.v[i]); }
+
+		inline Double4 Min(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+		inline Double4 Max(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+		inline Double4 Sqrt(const Double4 a) { MATH_SIMD_DOUBLE4_LANEWISE(std::sqrt(a.v[i])); }
+		inline Double4 Abs(const Double4 a) { MATH_SIMD_DOUBLE4_LANEWISE(std::fabs(a.v[i])); }
+
+		inline Double4 CmpEq(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(Detail::MaskDouble(a.v[i] == b.v[i])); }
+		inline Double4 CmpLt(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(Detail::MaskDouble(a.v[i] < b.v[i])); }
+		inline Double4 CmpLe(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(Detail::MaskDouble(a.v[i] <= b.v[i])); }
+		inline Double4 CmpGt(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(Detail::MaskDouble(a.v[i] > b.v[i])); }
+		inline Double4 CmpGe(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(Detail::MaskDouble(a.v[i] >= b.v[i])); }
+
+		inline Double4 And(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(Detail::FromBits(Detail::Bits(a.v[i]) & Detail::Bits(b.v[i]))); }
+		inline Double4 Or(const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(Detail::FromBits(Detail::Bits(a.v[i]) | Detail::Bits(b.v[i]))); }
+		inline Double4 AndNot(const Double4 mask, const Double4 a) { MATH_SIMD_DOUBLE4_LANEWISE(Detail::FromBits(~Detail::Bits(mask.v[i]) & Detail::Bits(a.v[i]))); }
+		inline Double4 Select(const Double4 mask, const Double4 a, const Double4 b) { MATH_SIMD_DOUBLE4_LANEWISE(Detail::Bits(mask.v[i]) ? a.v[i] : b.v[i]); }
+
+#undef MATH_SIMD_DOUBLE4_LANEWISE
+
+		inline int MoveMask(const Double4 mask)
+		{
+			int bits = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				bits |= static_cast<int>(Detail::Bits(mask.v[i]) >> 63) << i;
+			}
+			return bits;
+		}
+
+		inline double GetLane(const Double4 a, const int lane)
+		{
+			return a.v[lane];
+		}
+
+		inline void LoadTransposed2(const double* p, Double4& x, Double4& y, const size_t stride = 2)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				x.v[i] = p[i * stride + 0];
+				y.v[i] = p[i * stride + 1];
+			}
+		}
+
+		inline void LoadTransposed3(const double* p, Double4& x, Double4& y, Double4& z, const size_t stride = 3)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				x.v[i] = p[i * stride + 0];
+				y.v[i] = p[i * stride + 1];
+				z.v[i] = p[i * stride + 2];
+			}
+		}
+
+		inline void StoreTransposed3(double* p, const Double4 x, const Double4 y, const Double4 z, const size_t stride = 3)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				p[i * stride + 0] = x.v[i];
+				p[i * stride + 1] = y.v[i];
+				p[i * stride + 2] = z.v[i];
+			}
+		}
+
+		inline void LoadTransposed4(const double* p, Double4& x, Double4& y, Double4& z, Double4& w, const size_t stride = 4)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				x.v[i] = p[i * stride + 0];
+				y.v[i] = p[i * stride + 1];
+				z.v[i] = p[i * stride + 2];
+				w.v[i] = p[i * stride + 3];
+			}
+		}
+
+		inline void StoreTransposed4(double* p, const Double4 x, const Double4 y, const Double4 z, const Double4 w, const size_t stride = 4)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				p[i * stride + 0] = x.v[i];
+				p[i * stride + 1] = y.v[i];
+				p[i * stride + 2] = z.v[i];
+				p[i * stride + 3] = w.v[i];
+			}
+		}
+#endif
+
+		inline Double4 MulAdd(const Double4 a, const Double4 b, const Double4 c)
+		{
+			return a * b + c;
+		}
+
+		// Register type for a scalar type, for kernels written once for float and double
+		template <typename T>
+		struct LanesOf;
+
+		template <>
+		struct LanesOf<float>
+		{
+			using Type = Float4;
+		};
+
+		template <>
+		struct LanesOf<double>
+		{
+			using Type = Double4;
+		};
+	}
+}
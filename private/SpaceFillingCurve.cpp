@@ -0,0 +1,648 @@
+#include <SpaceFillingCurve.h>
+
+#include <Parallel.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		constexpr size_t k_grainSize = 16384;
+		constexpr int k_radixBits = 11;
+		constexpr size_t k_radixSize = size_t(1) << k_radixBits;
+
+		// Bits of the first component in an interleaved code; the others follow at
+		// shifts of one and two
+		constexpr uint32_t k_mask3d30 = 0x09249249u;
+		constexpr uint64_t k_mask3d63 = 0x1249249249249249ull;
+		constexpr uint32_t k_mask2d32 = 0x55555555u;
+		constexpr uint64_t k_mask2d64 = 0x5555555555555555ull;
+
+		// Spread the low bits of v out to every third or second bit, and back
+#if MATH_SIMD_BMI2
+		uint32_t Spread3(const uint32_t v)
+		{
+			return _pdep_u32(v, k_mask3d30);
+		}
+
+		uint64_t Spread3(const uint64_t v)
+		{
+			return _pdep_u64(v, k_mask3d63);
+		}
+
+		uint32_t Spread2(const uint32_t v)
+		{
+			return _pdep_u32(v, k_mask2d32);
+		}
+
+		uint64_t Spread2(const uint64_t v)
+		{
+			return _pdep_u64(v, k_mask2d64);
+		}
+
+		uint32_t Compact3(const uint32_t v)
+		{
+			return _pext_u32(v, k_mask3d30);
+		}
+
+		uint64_t Compact3(const uint64_t v)
+		{
+			return _pext_u64(v, k_mask3d63);
+		}
+
+		uint32_t Compact2(const uint32_t v)
+		{
+			return _pext_u32(v, k_mask2d32);
+		}
+
+		uint64_t Compact2(const uint64_t v)
+		{
+			return _pext_u64(v, k_mask2d64);
+		}
+#else
+		uint32_t Spread3(uint32_t v)
+		{
+			v &= 0x000003FFu;
+			v = (v | (v << 16)) & 0xFF0000FFu;
+			v = (v | (v << 8)) & 0x0300F00Fu;
+			v = (v | (v << 4)) & 0x030C30C3u;
+			v = (v | (v << 2)) & k_mask3d30;
+			return v;
+		}
+
+		uint64_t Spread3(uint64_t v)
+		{
+			v &= 0x1FFFFFull;
+			v = (v | (v << 32)) & 0x001F00000000FFFFull;
+			v = (v | (v << 16)) & 0x001F0000FF0000FFull;
+			v = (v | (v << 8)) & 0x100F00F00F00F00Full;
+			v = (v | (v << 4)) & 0x10C30C30C30C30C3ull;
+			v = (v | (v << 2)) & k_mask3d63;
+			return v;
+		}
+
+		uint32_t Spread2(uint32_t v)
+		{
+			v &= 0x0000FFFFu;
+			v = (v | (v << 8)) & 0x00FF00FFu;
+			v = (v | (v << 4)) & 0x0F0F0F0Fu;
+			v = (v | (v << 2)) & 0x33333333u;
+			v = (v | (v << 1)) & k_mask2d32;
+			return v;
+		}
+
+		uint64_t Spread2(uint64_t v)
+		{
+			v &= 0xFFFFFFFFull;
+			v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+			v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+			v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+			v = (v | (v << 2)) & 0x3333333333333333ull;
+			v = (v | (v << 1)) & k_mask2d64;
+			return v;
+		}
+
+		uint32_t Compact3(uint32_t v)
+		{
+			v &= k_mask3d30;
+			v = (v | (v >> 2)) & 0x030C30C3u;
+			v = (v | (v >> 4)) & 0x0300F00Fu;
+			v = (v | (v >> 8)) & 0xFF0000FFu;
+			v = (v | (v >> 16)) & 0x000003FFu;
+			return v;
+		}
+
+		uint64_t Compact3(uint64_t v)
+		{
+			v &= k_mask3d63;
+			v = (v | (v >> 2)) & 0x10C30C30C30C30C3ull;
+			v = (v | (v >> 4)) & 0x100F00F00F00F00Full;
+			v = (v | (v >> 8)) & 0x001F0000FF0000FFull;
+			v = (v | (v >> 16)) & 0x001F00000000FFFFull;
+			v = (v | (v >> 32)) & 0x1FFFFFull;
+			return v;
+		}
+
+		uint32_t Compact2(uint32_t v)
+		{
+			v &= k_mask2d32;
+			v = (v | (v >> 1)) & 0x33333333u;
+			v = (v | (v >> 2)) & 0x0F0F0F0Fu;
+			v = (v | (v >> 4)) & 0x00FF00FFu;
+			v = (v | (v >> 8)) & 0x0000FFFFu;
+			return v;
+		}
+
+		uint64_t Compact2(uint64_t v)
+		{
+			v &= k_mask2d64;
+			v = (v | (v >> 1)) & 0x3333333333333333ull;
+			v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+			v = (v | (v >> 4)) & 0x00FF00FF00FF00FFull;
+			v = (v | (v >> 8)) & 0x0000FFFF0000FFFFull;
+			v = (v | (v >> 16)) & 0xFFFFFFFFull;
+			return v;
+		}
+#endif
+
+		template <typename Code>
+		Code Interleave3(const Code x, const Code y, const Code z)
+		{
+			return Spread3(x) | (Spread3(y) << 1) | (Spread3(z) << 2);
+		}
+
+		template <typename Code>
+		Code Interleave2(const Code x, const Code y)
+		{
+			return Spread2(x) | (Spread2(y) << 1);
+		}
+
+		// Skilling's transform between axis coordinates and the transposed Hilbert
+		// index ("Programming the Hilbert curve", 2004). Interleaving the transposed
+		// coordinates, the first most significant, gives the Hilbert index.
+		template <typename Word, int N>
+		void AxesToTranspose(Word (&x)[N], const int bits)
+		{
+			const Word top = Word(1) << (bits - 1);
+			for (Word q = top; q > 1; q >>= 1)
+			{
+				const Word p = q - 1;
+				for (int i = 0; i < N; ++i)
+				{
+					if (x[i] & q)
+					{
+						x[0] ^= p;
+					}
+					else
+					{
+						const Word t = (x[0] ^ x[i]) & p;
+						x[0] ^= t;
+						x[i] ^= t;
+					}
+				}
+			}
+			// Gray encode
+			for (int i = 1; i < N; ++i)
+			{
+				x[i] ^= x[i - 1];
+			}
+			Word t = 0;
+			for (Word q = top; q > 1; q >>= 1)
+			{
+				if (x[N - 1] & q)
+				{
+					t ^= q - 1;
+				}
+			}
+			for (int i = 0; i < N; ++i)
+			{
+				x[i] ^= t;
+			}
+		}
+
+		template <typename Word, int N>
+		void TransposeToAxes(Word (&x)[N], const int bits)
+		{
+			const Word end = Word(2) << (bits - 1);
+			// Gray decode
+			const Word t = x[N - 1] >> 1;
+			for (int i = N - 1; i > 0; --i)
+			{
+				x[i] ^= x[i - 1];
+			}
+			x[0] ^= t;
+			for (Word q = 2; q != end; q <<= 1)
+			{
+				const Word p = q - 1;
+				for (int i = N - 1; i >= 0; --i)
+				{
+					if (x[i] & q)
+					{
+						x[0] ^= p;
+					}
+					else
+					{
+						const Word u = (x[0] ^ x[i]) & p;
+						x[0] ^= u;
+						x[i] ^= u;
+					}
+				}
+			}
+		}
+
+		template <typename Code, int Bits>
+		Code MortonEncode3(const Vector3i& cell)
+		{
+			const Code mask = (Code(1) << Bits) - 1;
+			return Interleave3<Code>(static_cast<Code>(cell.x) & mask, static_cast<Code>(cell.y) & mask,
+				static_cast<Code>(cell.z) & mask);
+		}
+
+		template <typename Code>
+		Vector3i MortonDecode3(const Code code)
+		{
+			return Vector3i(static_cast<int>(Compact3(code)), static_cast<int>(Compact3(code >> 1)),
+				static_cast<int>(Compact3(code >> 2)));
+		}
+
+		template <typename Code, int Bits>
+		Code MortonEncode2(const Vector2i& cell)
+		{
+			const Code mask = (Code(1) << Bits) - 1;
+			return Interleave2<Code>(static_cast<Code>(static_cast<uint32_t>(cell.x)) & mask,
+				static_cast<Code>(static_cast<uint32_t>(cell.y)) & mask);
+		}
+
+		template <typename Code>
+		Vector2i MortonDecode2(const Code code)
+		{
+			return Vector2i(static_cast<int>(static_cast<uint32_t>(Compact2(code))),
+				static_cast<int>(static_cast<uint32_t>(Compact2(code >> 1))));
+		}
+
+		template <typename Code, int Bits>
+		Code HilbertEncode3(const Vector3i& cell)
+		{
+			const Code mask = (Code(1) << Bits) - 1;
+			Code x[3] = { static_cast<Code>(cell.x) & mask, static_cast<Code>(cell.y) & mask, static_cast<Code>(cell.z) & mask };
+			AxesToTranspose(x, Bits);
+			return Interleave3<Code>(x[2], x[1], x[0]);
+		}
+
+		template <typename Code, int Bits>
+		Vector3i HilbertDecode3(const Code code)
+		{
+			Code x[3] = { Compact3(code >> 2), Compact3(code >> 1), Compact3(code) };
+			TransposeToAxes(x, Bits);
+			return Vector3i(static_cast<int>(x[0]), static_cast<int>(x[1]), static_cast<int>(x[2]));
+		}
+
+		template <typename Code, int Bits>
+		Code HilbertEncode2(const Vector2i& cell)
+		{
+			const Code mask = (Code(1) << Bits) - 1;
+			Code x[2] = { static_cast<Code>(static_cast<uint32_t>(cell.x)) & mask,
+				static_cast<Code>(static_cast<uint32_t>(cell.y)) & mask };
+			AxesToTranspose(x, Bits);
+			return Interleave2<Code>(x[1], x[0]);
+		}
+
+		template <typename Code, int Bits>
+		Vector2i HilbertDecode2(const Code code)
+		{
+			Code x[2] = { Compact2(code >> 1), Compact2(code) };
+			TransposeToAxes(x, Bits);
+			return Vector2i(static_cast<int>(static_cast<uint32_t>(x[0])), static_cast<int>(static_cast<uint32_t>(x[1])));
+		}
+
+		// Applies convert to each of count inputs
+		template <typename In, typename Out, typename Convert>
+		void Batch(const In* in, const size_t count, Out* out, Convert convert)
+		{
+			assert((in != nullptr && out != nullptr) || count == 0);
+			ParallelFor(count, k_grainSize, [=](size_t first, size_t last) {
+				for (size_t i = first; i < last; ++i)
+				{
+					out[i] = convert(in[i]);
+				}
+			});
+		}
+
+		// Quantizes each point into bounds and encodes its cell
+		template <typename Code, typename Encode>
+		void BatchPoints(const VectorSpan<const float, 3>& points, const Aabbf& bounds, const int bits, Code* codes, Encode encode)
+		{
+			assert(codes != nullptr || points.Count() == 0);
+			ParallelFor(points.Count(), k_grainSize, [&](size_t first, size_t last) {
+				for (size_t i = first; i < last; ++i)
+				{
+					codes[i] = encode(Quantize(points.Load(i), bounds, bits));
+				}
+			});
+		}
+
+		template <typename Key>
+		void RadixSortImpl(Key* keys, uint32_t* values, const size_t count)
+		{
+			assert((keys != nullptr && values != nullptr) || count == 0);
+			if (count < 2)
+			{
+				return;
+			}
+
+			// Contiguous chunks, scattered in order, keep each pass stable
+			const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(GetWorkerCount() * 4, count / k_grainSize));
+			std::vector<size_t> histograms(chunkCount * k_radixSize);
+			std::vector<Key> keyScratch(count);
+			std::vector<uint32_t> valueScratch(count);
+			Key* sourceKeys = keys;
+			uint32_t* sourceValues = values;
+			Key* targetKeys = keyScratch.data();
+			uint32_t* targetValues = valueScratch.data();
+
+			for (int shift = 0; shift < static_cast<int>(sizeof(Key) * 8); shift += k_radixBits)
+			{
+				const Key* const readKeys = sourceKeys;
+				ParallelFor(chunkCount, 1, [&, readKeys, shift](size_t firstChunk, size_t lastChunk) {
+					for (size_t c = firstChunk; c < lastChunk; ++c)
+					{
+						size_t* histogram = histograms.data() + c * k_radixSize;
+						std::fill(histogram, histogram + k_radixSize, size_t(0));
+						const size_t end = count * (c + 1) / chunkCount;
+						for (size_t i = count * c / chunkCount; i < end; ++i)
+						{
+							++histogram[(readKeys[i] >> shift) & (k_radixSize - 1)];
+						}
+					}
+				});
+
+				// Digit-major offsets: every chunk's keys with digit d come before any
+				// key with digit d + 1, in chunk order
+				size_t offset = 0;
+				bool shared = false;
+				for (size_t d = 0; d < k_radixSize; ++d)
+				{
+					size_t digitCount = 0;
+					for (size_t c = 0; c < chunkCount; ++c)
+					{
+						size_t& entry = histograms[c * k_radixSize + d];
+						const size_t n = entry;
+						entry = offset;
+						offset += n;
+						digitCount += n;
+					}
+					shared = shared || digitCount == count;
+				}
+				if (shared)
+				{
+					continue;
+				}
+
+				const uint32_t* const readValues = sourceValues;
+				Key* const writeKeys = targetKeys;
+				uint32_t* const writeValues = targetValues;
+				ParallelFor(chunkCount, 1, [&, readKeys, readValues, writeKeys, writeValues, shift](size_t firstChunk, size_t lastChunk) {
+					for (size_t c = firstChunk; c < lastChunk; ++c)
+					{
+						size_t* cursors = histograms.data() + c * k_radixSize;
+						const size_t end = count * (c + 1) / chunkCount;
+						for (size_t i = count * c / chunkCount; i < end; ++i)
+						{
+							const Key key = readKeys[i];
+							const size_t target = cursors[(key >> shift) & (k_radixSize - 1)]++;
+							writeKeys[target] = key;
+							writeValues[target] = readValues[i];
+						}
+					}
+				});
+				std::swap(sourceKeys, targetKeys);
+				std::swap(sourceValues, targetValues);
+			}
+
+			if (sourceKeys != keys)
+			{
+				std::copy_n(sourceKeys, count, keys);
+				std::copy_n(sourceValues, count, values);
+			}
+		}
+	}
+
+	uint32_t EncodeMorton30(const Vector3i& cell)
+	{
+		return MortonEncode3<uint32_t, 10>(cell);
+	}
+
+	uint64_t EncodeMorton63(const Vector3i& cell)
+	{
+		return MortonEncode3<uint64_t, 21>(cell);
+	}
+
+	uint32_t EncodeMorton32(const Vector2i& cell)
+	{
+		return MortonEncode2<uint32_t, 16>(cell);
+	}
+
+	uint64_t EncodeMorton64(const Vector2i& cell)
+	{
+		return MortonEncode2<uint64_t, 32>(cell);
+	}
+
+	Vector3i DecodeMorton30(const uint32_t code)
+	{
+		return MortonDecode3(code);
+	}
+
+	Vector3i DecodeMorton63(const uint64_t code)
+	{
+		return MortonDecode3(code);
+	}
+
+	Vector2i DecodeMorton32(const uint32_t code)
+	{
+		return MortonDecode2(code);
+	}
+
+	Vector2i DecodeMorton64(const uint64_t code)
+	{
+		return MortonDecode2(code);
+	}
+
+	uint32_t EncodeHilbert30(const Vector3i& cell)
+	{
+		return HilbertEncode3<uint32_t, 10>(cell);
+	}
+
+	uint64_t EncodeHilbert63(const Vector3i& cell)
+	{
+		return HilbertEncode3<uint64_t, 21>(cell);
+	}
+
+	uint32_t EncodeHilbert32(const Vector2i& cell)
+	{
+		return HilbertEncode2<uint32_t, 16>(cell);
+	}
+
+	uint64_t EncodeHilbert64(const Vector2i& cell)
+	{
+		return HilbertEncode2<uint64_t, 32>(cell);
+	}
+
+	Vector3i DecodeHilbert30(const uint32_t code)
+	{
+		return HilbertDecode3<uint32_t, 10>(code);
+	}
+
+	Vector3i DecodeHilbert63(const uint64_t code)
+	{
+		return HilbertDecode3<uint64_t, 21>(code);
+	}
+
+	Vector2i DecodeHilbert32(const uint32_t code)
+	{
+		return HilbertDecode2<uint32_t, 16>(code);
+	}
+
+	Vector2i DecodeHilbert64(const uint64_t code)
+	{
+		return HilbertDecode2<uint64_t, 32>(code);
+	}
+
+	Vector3i Quantize(const Vector3f& position, const Aabbf& bounds, const int bits)
+	{
+		assert(bits > 0 && bits <= 21);
+		const float cells = static_cast<float>(1 << bits);
+		const int last = (1 << bits) - 1;
+		Vector3i cell;
+		for (int a = 0; a < 3; ++a)
+		{
+			const float extent = bounds.max[a] - bounds.min[a];
+			const float scaled = extent > 0.f ? (position[a] - bounds.min[a]) * (cells / extent) : 0.f;
+			// Clamped as a float first, so that far outside positions don't overflow
+			cell[a] = scaled <= 0.f ? 0 : scaled >= static_cast<float>(last) ? last : static_cast<int>(scaled);
+		}
+		return cell;
+	}
+
+	void EncodeMorton30(const Vector3i* cells, size_t count, uint32_t* codes)
+	{
+		Batch(cells, count, codes, MortonEncode3<uint32_t, 10>);
+	}
+
+	void EncodeMorton63(const Vector3i* cells, size_t count, uint64_t* codes)
+	{
+		Batch(cells, count, codes, MortonEncode3<uint64_t, 21>);
+	}
+
+	void EncodeMorton32(const Vector2i* cells, size_t count, uint32_t* codes)
+	{
+		Batch(cells, count, codes, MortonEncode2<uint32_t, 16>);
+	}
+
+	void EncodeMorton64(const Vector2i* cells, size_t count, uint64_t* codes)
+	{
+		Batch(cells, count, codes, MortonEncode2<uint64_t, 32>);
+	}
+
+	void DecodeMorton30(const uint32_t* codes, size_t count, Vector3i* cells)
+	{
+		Batch(codes, count, cells, MortonDecode3<uint32_t>);
+	}
+
+	void DecodeMorton63(const uint64_t* codes, size_t count, Vector3i* cells)
+	{
+		Batch(codes, count, cells, MortonDecode3<uint64_t>);
+	}
+
+	void DecodeMorton32(const uint32_t* codes, size_t count, Vector2i* cells)
+	{
+		Batch(codes, count, cells, MortonDecode2<uint32_t>);
+	}
+
+	void DecodeMorton64(const uint64_t* codes, size_t count, Vector2i* cells)
+	{
+		Batch(codes, count, cells, MortonDecode2<uint64_t>);
+	}
+
+	void EncodeHilbert30(const Vector3i* cells, size_t count, uint32_t* codes)
+	{
+		Batch(cells, count, codes, HilbertEncode3<uint32_t, 10>);
+	}
+
+	void EncodeHilbert63(const Vector3i* cells, size_t count, uint64_t* codes)
+	{
+		Batch(cells, count, codes, HilbertEncode3<uint64_t, 21>);
+	}
+
+	void EncodeHilbert32(const Vector2i* cells, size_t count, uint32_t* codes)
+	{
+		Batch(cells, count, codes, HilbertEncode2<uint32_t, 16>);
+	}
+
+	void EncodeHilbert64(const Vector2i* cells, size_t count, uint64_t* codes)
+	{
+		Batch(cells, count, codes, HilbertEncode2<uint64_t, 32>);
+	}
+
+	void DecodeHilbert30(const uint32_t* codes, size_t count, Vector3i* cells)
+	{
+		Batch(codes, count, cells, HilbertDecode3<uint32_t, 10>);
+	}
+
+	void DecodeHilbert63(const uint64_t* codes, size_t count, Vector3i* cells)
+	{
+		Batch(codes, count, cells, HilbertDecode3<uint64_t, 21>);
+	}
+
+	void DecodeHilbert32(const uint32_t* codes, size_t count, Vector2i* cells)
+	{
+		Batch(codes, count, cells, HilbertDecode2<uint32_t, 16>);
+	}
+
+	void DecodeHilbert64(const uint64_t* codes, size_t count, Vector2i* cells)
+	{
+		Batch(codes, count, cells, HilbertDecode2<uint64_t, 32>);
+	}
+
+	void EncodeMorton30(const VectorSpan<const float, 3>& points, const Aabbf& bounds, uint32_t* codes)
+	{
+		BatchPoints(points, bounds, 10, codes, MortonEncode3<uint32_t, 10>);
+	}
+
+	void EncodeMorton63(const VectorSpan<const float, 3>& points, const Aabbf& bounds, uint64_t* codes)
+	{
+		BatchPoints(points, bounds, 21, codes, MortonEncode3<uint64_t, 21>);
+	}
+
+	void EncodeHilbert30(const VectorSpan<const float, 3>& points, const Aabbf& bounds, uint32_t* codes)
+	{
+		BatchPoints(points, bounds, 10, codes, HilbertEncode3<uint32_t, 10>);
+	}
+
+	void EncodeHilbert63(const VectorSpan<const float, 3>& points, const Aabbf& bounds, uint64_t* codes)
+	{
+		BatchPoints(points, bounds, 21, codes, HilbertEncode3<uint64_t, 21>);
+	}
+
+	void RadixSort(uint32_t* keys, uint32_t* values, size_t count)
+	{
+		RadixSortImpl(keys, values, count);
+	}
+
+	void RadixSort(uint64_t* keys, uint32_t* values, size_t count)
+	{
+		RadixSortImpl(keys, values, count);
+	}
+
+	void SortAlongCurve(const VectorSpan<const float, 3>& points, const SpaceFillingCurve curve, uint32_t* order)
+	{
+		const size_t count = points.Count();
+		assert(order != nullptr || count == 0);
+		assert(count <= 0xFFFFFFFFu);
+
+		Aabbf bounds = Aabbf::Empty();
+		for (size_t i = 0; i < count; ++i)
+		{
+			bounds.Expand(points.Load(i));
+		}
+
+		std::vector<uint64_t> codes(count);
+		if (curve == SpaceFillingCurve::Hilbert)
+		{
+			EncodeHilbert63(points, bounds, codes.data());
+		}
+		else
+		{
+			EncodeMorton63(points, bounds, codes.data());
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			order[i] = static_cast<uint32_t>(i);
+		}
+		RadixSort(codes.data(), order, count);
+	}
+}
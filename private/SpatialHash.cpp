@@ -0,0 +1,269 @@
+#include <SpatialHash.h>
+
+#include <Parallel.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace Math
+{
+	namespace
+	{
+		constexpr size_t k_grainSize = 4096;
+		constexpr size_t k_queryGrainSize = 64;
+
+		template <typename Neighbour>
+		bool NeighbourLess(const Neighbour& a, const Neighbour& b)
+		{
+			return a.distanceSq < b.distanceSq || (a.distanceSq == b.distanceSq && a.index < b.index);
+		}
+	}
+
+	template <typename T>
+	SpatialHashGrid<T>::SpatialHashGrid(const T cellSize)
+		: cellSize(cellSize)
+		, inverseCellSize(static_cast<T>(1) / cellSize)
+	{
+		assert(cellSize > static_cast<T>(0));
+	}
+
+	template <typename T>
+	void SpatialHashGrid<T>::Build(const VectorSpan<const T, 3>& points)
+	{
+		const size_t count = points.Count();
+		assert(count < k_noPoint);
+
+		// About two buckets per point keeps collisions rare
+		int bucketBits = 1;
+		while ((size_t(1) << bucketBits) < count * 2)
+		{
+			++bucketBits;
+		}
+		const size_t bucketCount = size_t(1) << bucketBits;
+		bucketShift = 64 - bucketBits;
+
+		std::vector<uint64_t> pointKeys(count);
+		std::vector<uint32_t> pointBuckets(count);
+		std::vector<std::atomic<uint32_t>> cursors(bucketCount);
+		ParallelFor(bucketCount, k_grainSize, [&cursors](size_t first, size_t last) {
+			for (size_t b = first; b < last; ++b)
+			{
+				cursors[b].store(0, std::memory_order_relaxed);
+			}
+		});
+
+		// Cells and bucket sizes, with each chunk's range of occupied cells
+		const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(GetWorkerCount() * 4, count / k_grainSize));
+		std::vector<Vector3i> chunkLows(chunkCount, Vector3i(k_maxCell, k_maxCell, k_maxCell));
+		std::vector<Vector3i> chunkHighs(chunkCount, Vector3i(-k_maxCell, -k_maxCell, -k_maxCell));
+		ParallelFor(chunkCount, 1, [&](size_t firstChunk, size_t lastChunk) {
+			for (size_t c = firstChunk; c < lastChunk; ++c)
+			{
+				Vector3i& low = chunkLows[c];
+				Vector3i& high = chunkHighs[c];
+				const size_t end = count * (c + 1) / chunkCount;
+				for (size_t i = count * c / chunkCount; i < end; ++i)
+				{
+					const Vector3i cell = GetCell(points.Load(i));
+					for (int a = 0; a < 3; ++a)
+					{
+						low[a] = std::min(low[a], cell[a]);
+						high[a] = std::max(high[a], cell[a]);
+					}
+					pointKeys[i] = PackCell(cell);
+					pointBuckets[i] = GetBucket(pointKeys[i]);
+					cursors[pointBuckets[i]].fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		});
+		lowCell = chunkLows[0];
+		highCell = chunkHighs[0];
+		for (size_t c = 1; c < chunkCount; ++c)
+		{
+			for (int a = 0; a < 3; ++a)
+			{
+				lowCell[a] = std::min(lowCell[a], chunkLows[c][a]);
+				highCell[a] = std::max(highCell[a], chunkHighs[c][a]);
+			}
+		}
+
+		bucketStarts.resize(bucketCount + 1);
+		uint32_t start = 0;
+		for (size_t b = 0; b < bucketCount; ++b)
+		{
+			bucketStarts[b] = start;
+			start += cursors[b].load(std::memory_order_relaxed);
+			cursors[b].store(bucketStarts[b], std::memory_order_relaxed);
+		}
+		bucketStarts[bucketCount] = start;
+
+		// Scatter into bucket order. Threads interleave within a bucket, so each
+		// bucket is then sorted by point index, which makes the layout independent of
+		// the thread count.
+		indices.resize(count);
+		ParallelFor(count, k_grainSize, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				indices[cursors[pointBuckets[i]].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(i);
+			}
+		});
+
+		xs.resize(count);
+		ys.resize(count);
+		zs.resize(count);
+		keys.resize(count);
+		ParallelFor(bucketCount, k_grainSize, [&](size_t first, size_t last) {
+			for (size_t b = first; b < last; ++b)
+			{
+				uint32_t* bucketFirst = indices.data() + bucketStarts[b];
+				uint32_t* bucketLast = indices.data() + bucketStarts[b + 1];
+				if (bucketLast - bucketFirst > 1)
+				{
+					std::sort(bucketFirst, bucketLast);
+				}
+				for (uint32_t i = bucketStarts[b]; i < bucketStarts[b + 1]; ++i)
+				{
+					const T* position = points[indices[i]];
+					xs[i] = position[0];
+					ys[i] = position[1];
+					zs[i] = position[2];
+					keys[i] = pointKeys[indices[i]];
+				}
+			}
+		});
+	}
+
+	template <typename T>
+	void SpatialHashGrid<T>::SearchShell(const Vector3<T>& center, const Vector3i& cell, const int ring, const size_t k,
+		const T maxRadiusSq, Neighbour* nearest, size_t& found) const
+	{
+		const auto less = NeighbourLess<Neighbour>;
+		for (int dz = -ring; dz <= ring; ++dz)
+		{
+			const int z = cell.z + dz;
+			if (z < lowCell.z || z > highCell.z)
+			{
+				continue;
+			}
+			for (int dy = -ring; dy <= ring; ++dy)
+			{
+				const int y = cell.y + dy;
+				if (y < lowCell.y || y > highCell.y)
+				{
+					continue;
+				}
+				// Inside the shell only the two end cells of each row are on it
+				const bool onShell = dz == -ring || dz == ring || dy == -ring || dy == ring;
+				const int step = onShell || ring == 0 ? 1 : 2 * ring;
+				for (int dx = -ring; dx <= ring; dx += step)
+				{
+					const int x = cell.x + dx;
+					if (x < lowCell.x || x > highCell.x)
+					{
+						continue;
+					}
+
+					// Skip cells entirely farther than the current kth point
+					const Vector3i neighbour(x, y, z);
+					T cellDistanceSq = static_cast<T>(0);
+					for (int a = 0; a < 3; ++a)
+					{
+						const T cellLow = static_cast<T>(neighbour[a]) * cellSize;
+						const T gap = std::max(cellLow - center[a], center[a] - (cellLow + cellSize));
+						cellDistanceSq += gap > static_cast<T>(0) ? gap * gap : static_cast<T>(0);
+					}
+					const T limitSq = found == k ? nearest[0].distanceSq : maxRadiusSq;
+					if (cellDistanceSq > limitSq)
+					{
+						continue;
+					}
+
+					const uint64_t key = PackCell(neighbour);
+					const uint32_t bucket = GetBucket(key);
+					for (uint32_t i = bucketStarts[bucket]; i < bucketStarts[bucket + 1]; ++i)
+					{
+						const T px = xs[i] - center.x;
+						const T py = ys[i] - center.y;
+						const T pz = zs[i] - center.z;
+						const Neighbour candidate = { indices[i], px * px + py * py + pz * pz };
+						if (keys[i] != key || candidate.distanceSq > maxRadiusSq)
+						{
+							continue;
+						}
+						if (found < k)
+						{
+							nearest[found++] = candidate;
+							std::push_heap(nearest, nearest + found, less);
+						}
+						else if (less(candidate, nearest[0]))
+						{
+							std::pop_heap(nearest, nearest + k, less);
+							nearest[k - 1] = candidate;
+							std::push_heap(nearest, nearest + k, less);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	template <typename T>
+	size_t SpatialHashGrid<T>::FindNearest(const Vector3<T>& center, const size_t k, Neighbour* nearest, const T maxRadius) const
+	{
+		assert(nearest != nullptr || k == 0);
+		if (k == 0 || indices.empty())
+		{
+			return 0;
+		}
+
+		const T maxRadiusSq = maxRadius * maxRadius;
+		const Vector3i cell = GetCell(center);
+		// Shells nearer than this hold no occupied cells
+		int firstRing = 0;
+		for (int a = 0; a < 3; ++a)
+		{
+			firstRing = std::max(firstRing, std::max(lowCell[a] - cell[a], cell[a] - highCell[a]));
+		}
+		size_t found = 0;
+		for (int ring = firstRing; ; ++ring)
+		{
+			SearchShell(center, cell, ring, k, maxRadiusSq, nearest, found);
+
+			// Distance from center to the outside of the searched cells, within which
+			// every point has been seen
+			T covered = std::numeric_limits<T>::max();
+			bool coversAll = true;
+			for (int a = 0; a < 3; ++a)
+			{
+				const T low = static_cast<T>(cell[a] - ring) * cellSize;
+				const T high = static_cast<T>(cell[a] + ring + 1) * cellSize;
+				covered = std::min(covered, std::min(center[a] - low, high - center[a]));
+				coversAll = coversAll && cell[a] - ring <= lowCell[a] && cell[a] + ring >= highCell[a];
+			}
+			if (coversAll || covered >= maxRadius || (found == k && nearest[0].distanceSq <= covered * covered))
+			{
+				break;
+			}
+		}
+		std::sort_heap(nearest, nearest + found, NeighbourLess<Neighbour>);
+		return found;
+	}
+
+	template <typename T>
+	void SpatialHashGrid<T>::FindNearest(const VectorSpan<const T, 3>& centers, const size_t k, Neighbour* nearest,
+		const T maxRadius) const
+	{
+		assert(nearest != nullptr || k == 0 || centers.Count() == 0);
+		ParallelFor(centers.Count(), k_queryGrainSize, [&](size_t first, size_t last) {
+			for (size_t q = first; q < last; ++q)
+			{
+				Neighbour* result = nearest + q * k;
+				const size_t found = FindNearest(centers.Load(q), k, result, maxRadius);
+				std::fill(result + found, result + k, Neighbour{ k_noPoint, std::numeric_limits<T>::infinity() });
+			}
+		});
+	}
+
+	template class SpatialHashGrid<float>;
+	template class SpatialHashGrid<double>;
+}
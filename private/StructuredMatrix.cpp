@@ -0,0 +1,14 @@
+#include <StructuredMatrix.h>
+#include <Projection.h>
+
+namespace Math
+{
+	template class ScaleMatrix<float>;
+	template class ScaleMatrix<double>;
+	template class TranslationMatrix<float>;
+	template class TranslationMatrix<double>;
+	template class RotationMatrix3<float>;
+	template class RotationMatrix3<double>;
+	template class PerspectiveMatrix<float>;
+	template class PerspectiveMatrix<double>;
+}
@@ -0,0 +1,380 @@
+#include <SweepAndPrune.h>
+
+#include <Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		// More boxes than this added in one frame are sorted in with a full sort,
+		// instead of one insertion each
+		constexpr size_t k_fullSortThreshold = 16;
+		constexpr size_t k_grainSize = 2048;
+		// Padding after the sorted boxes, so the last box's scan can load a whole block
+		constexpr size_t k_padding = 4;
+
+		bool IsMax(const uint32_t handle)
+		{
+			return (handle & 1) != 0;
+		}
+
+		// Endpoint order: by value, and minimums before maximums at equal values so
+		// that touching boxes overlap
+		template <typename T>
+		bool EndpointLess(const T a, const uint32_t handleA, const T b, const uint32_t handleB)
+		{
+			return a < b || (a == b && !IsMax(handleA) && IsMax(handleB));
+		}
+
+		// First i >= start at which values[i - 1] >= values[i], or count. Whole blocks of
+		// four ascending values are skipped with one compare.
+		template <typename T>
+		size_t FindDescent(const T* values, size_t i, const size_t count)
+		{
+			for (; i + 4 <= count; i += 4)
+			{
+				const int mask = Simd::MoveMask(Simd::CmpGe(Simd::Load(values + i - 1), Simd::Load(values + i)));
+				if (mask != 0)
+				{
+					int lane = 0;
+					while (((mask >> lane) & 1) == 0)
+					{
+						++lane;
+					}
+					return i + lane;
+				}
+			}
+			for (; i < count; ++i)
+			{
+				if (values[i - 1] >= values[i])
+				{
+					return i;
+				}
+			}
+			return count;
+		}
+
+		// Removed endpoints are moved to infinity, so live ones must sort before it
+		template <typename T>
+		bool IsFinite(const Aabb<T>& box)
+		{
+			for (int a = 0; a < 3; ++a)
+			{
+				if (!std::isfinite(box.min[a]) || !std::isfinite(box.max[a]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	template <typename T>
+	typename SweepAndPrune<T>::BoxId SweepAndPrune<T>::Add(const Aabb<T>& box)
+	{
+		assert(IsFinite(box));
+		BoxId id;
+		if (!freeIds.empty())
+		{
+			id = freeIds.back();
+			freeIds.pop_back();
+		}
+		else
+		{
+			id = static_cast<BoxId>(bounds.size());
+			assert(id < 0x7FFFFFFFu);
+			bounds.emplace_back();
+			alive.push_back(0);
+			for (Axis& axis : axes)
+			{
+				axis.positions.resize(2 * (id + 1));
+			}
+		}
+
+		bounds[id] = box;
+		alive[id] = 1;
+		for (int a = 0; a < 3; ++a)
+		{
+			Axis& axis = axes[a];
+			for (uint32_t end = 0; end < 2; ++end)
+			{
+				const uint32_t handle = id * 2 + end;
+				axis.positions[handle] = static_cast<uint32_t>(axis.values.size());
+				axis.values.push_back(end == 0 ? box.min[a] : box.max[a]);
+				axis.handles.push_back(handle);
+			}
+		}
+		++appendedCount;
+		++boxCount;
+		return id;
+	}
+
+	template <typename T>
+	void SweepAndPrune<T>::Add(const Aabb<T>* boxes, size_t count, BoxId* ids)
+	{
+		assert((boxes != nullptr && ids != nullptr) || count == 0);
+		for (size_t i = 0; i < count; ++i)
+		{
+			ids[i] = Add(boxes[i]);
+		}
+	}
+
+	template <typename T>
+	void SweepAndPrune<T>::Remove(BoxId id)
+	{
+		assert(IsBox(id));
+		// Infinite endpoints sort to the end of each axis, where Update drops them
+		const T infinity = std::numeric_limits<T>::infinity();
+		for (Axis& axis : axes)
+		{
+			axis.values[axis.positions[id * 2]] = infinity;
+			axis.values[axis.positions[id * 2 + 1]] = infinity;
+		}
+		alive[id] = 0;
+		removedIds.push_back(id);
+		--boxCount;
+	}
+
+	template <typename T>
+	void SweepAndPrune<T>::SetBounds(BoxId id, const Aabb<T>& box)
+	{
+		assert(IsBox(id));
+		assert(IsFinite(box));
+		bounds[id] = box;
+		for (int a = 0; a < 3; ++a)
+		{
+			Axis& axis = axes[a];
+			axis.values[axis.positions[id * 2]] = box.min[a];
+			axis.values[axis.positions[id * 2 + 1]] = box.max[a];
+		}
+	}
+
+	template <typename T>
+	void SweepAndPrune<T>::SetBounds(const BoxId* ids, const Aabb<T>* boxes, size_t count)
+	{
+		assert((ids != nullptr && boxes != nullptr) || count == 0);
+		for (size_t i = 0; i < count; ++i)
+		{
+			SetBounds(ids[i], boxes[i]);
+		}
+	}
+
+	template <typename T>
+	void SweepAndPrune<T>::SortAxis(int a)
+	{
+		Axis& axis = axes[a];
+		T* values = axis.values.data();
+		uint32_t* handles = axis.handles.data();
+		uint32_t* positions = axis.positions.data();
+		const size_t count = axis.values.size();
+
+		size_t i = 1;
+		while ((i = FindDescent(values, i, count)) < count)
+		{
+			const T value = values[i];
+			const uint32_t handle = handles[i];
+			size_t j = i;
+			for (; j > 0 && EndpointLess(value, handle, values[j - 1], handles[j - 1]); --j)
+			{
+				values[j] = values[j - 1];
+				handles[j] = handles[j - 1];
+				positions[handles[j]] = static_cast<uint32_t>(j);
+			}
+			values[j] = value;
+			handles[j] = handle;
+			positions[handle] = static_cast<uint32_t>(j);
+			++i;
+		}
+	}
+
+	template <typename T>
+	void SweepAndPrune<T>::FullSortAxis(int a)
+	{
+		Axis& axis = axes[a];
+		const size_t count = axis.values.size();
+		std::vector<uint32_t> order(count);
+		std::iota(order.begin(), order.end(), 0u);
+		std::sort(order.begin(), order.end(), [&axis](uint32_t i, uint32_t j) {
+			const uint32_t hi = axis.handles[i];
+			const uint32_t hj = axis.handles[j];
+			if (EndpointLess(axis.values[i], hi, axis.values[j], hj))
+			{
+				return true;
+			}
+			return !EndpointLess(axis.values[j], hj, axis.values[i], hi) && hi < hj;
+		});
+
+		std::vector<T> values(count);
+		std::vector<uint32_t> handles(count);
+		for (size_t k = 0; k < count; ++k)
+		{
+			values[k] = axis.values[order[k]];
+			handles[k] = axis.handles[order[k]];
+			axis.positions[handles[k]] = static_cast<uint32_t>(k);
+		}
+		axis.values.swap(values);
+		axis.handles.swap(handles);
+	}
+
+	template <typename T>
+	void SweepAndPrune<T>::CountOverlaps(int a)
+	{
+		Axis& axis = axes[a];
+		size_t open = 0;
+		size_t overlaps = 0;
+		for (const uint32_t handle : axis.handles)
+		{
+			if (IsMax(handle))
+			{
+				--open;
+			}
+			else
+			{
+				overlaps += open;
+				++open;
+			}
+		}
+		axis.overlapCount = overlaps;
+	}
+
+	template <typename T>
+	size_t SweepAndPrune<T>::Update(Pair* pairs, size_t capacity)
+	{
+		assert(pairs != nullptr || capacity == 0);
+
+		const bool fullSort = appendedCount > k_fullSortThreshold;
+		ParallelFor(3, 1, [this, fullSort](size_t first, size_t last) {
+			for (size_t a = first; a < last; ++a)
+			{
+				if (fullSort)
+				{
+					FullSortAxis(static_cast<int>(a));
+				}
+				else
+				{
+					SortAxis(static_cast<int>(a));
+				}
+
+				// Removed endpoints are now last
+				Axis& axis = axes[a];
+				while (!axis.handles.empty() && alive[axis.handles.back() >> 1] == 0)
+				{
+					axis.handles.pop_back();
+					axis.values.pop_back();
+				}
+				CountOverlaps(static_cast<int>(a));
+			}
+		});
+		appendedCount = 0;
+		freeIds.insert(freeIds.end(), removedIds.begin(), removedIds.end());
+		removedIds.clear();
+
+		sweepAxis = 0;
+		for (int a = 1; a < 3; ++a)
+		{
+			if (axes[a].overlapCount < axes[sweepAxis].overlapCount)
+			{
+				sweepAxis = a;
+			}
+		}
+		// Gather the boxes in order of their minimum on the sweep axis, as component
+		// arrays with the sweep axis first, padded with NaN, which fails every compare
+		// and so ends each scan whatever the bounds of the last box
+		const int order[3] = { sweepAxis, (sweepAxis + 1) % 3, (sweepAxis + 2) % 3 };
+		const size_t count = boxCount;
+		for (std::vector<T>& component : sorted)
+		{
+			component.resize(count + k_padding);
+		}
+		sortedIds.resize(count);
+		size_t k = 0;
+		for (const uint32_t handle : axes[sweepAxis].handles)
+		{
+			if (IsMax(handle))
+			{
+				continue;
+			}
+			const BoxId id = handle >> 1;
+			for (int c = 0; c < 3; ++c)
+			{
+				sorted[c][k] = bounds[id].min[order[c]];
+				sorted[3 + c][k] = bounds[id].max[order[c]];
+			}
+			sortedIds[k++] = id;
+		}
+		assert(k == count);
+		for (std::vector<T>& component : sorted)
+		{
+			std::fill(component.begin() + count, component.end(), std::numeric_limits<T>::quiet_NaN());
+		}
+
+		// Each box is tested against the boxes starting after it and before its own end
+		// on the sweep axis, four at a time
+		const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(GetWorkerCount() * 4, count / k_grainSize));
+		chunkPairs.resize(chunkCount);
+		ParallelFor(chunkCount, 1, [&](size_t firstChunk, size_t lastChunk) {
+			using Lanes = typename Simd::LanesOf<T>::Type;
+			for (size_t c = firstChunk; c < lastChunk; ++c)
+			{
+				std::vector<Pair>& out = chunkPairs[c];
+				out.clear();
+				const size_t end = count * (c + 1) / chunkCount;
+				for (size_t i = count * c / chunkCount; i < end; ++i)
+				{
+					const Lanes sweepMax = Simd::Set1(sorted[3][i]);
+					const Lanes min1 = Simd::Set1(sorted[1][i]);
+					const Lanes min2 = Simd::Set1(sorted[2][i]);
+					const Lanes max1 = Simd::Set1(sorted[4][i]);
+					const Lanes max2 = Simd::Set1(sorted[5][i]);
+					for (size_t j = i + 1; ; j += 4)
+					{
+						const Lanes inRange = Simd::CmpLe(Simd::Load(sorted[0].data() + j), sweepMax);
+						const int rangeMask = Simd::MoveMask(inRange);
+						if (rangeMask == 0)
+						{
+							break;
+						}
+						const Lanes overlap = Simd::And(Simd::And(inRange,
+							Simd::And(Simd::CmpLe(min1, Simd::Load(sorted[4].data() + j)), Simd::CmpLe(Simd::Load(sorted[1].data() + j), max1))),
+							Simd::And(Simd::CmpLe(min2, Simd::Load(sorted[5].data() + j)), Simd::CmpLe(Simd::Load(sorted[2].data() + j), max2)));
+						const int mask = Simd::MoveMask(overlap);
+						for (int lane = 0; lane < 4; ++lane)
+						{
+							if ((mask >> lane) & 1)
+							{
+								const BoxId a = sortedIds[i];
+								const BoxId b = sortedIds[j + lane];
+								out.push_back(a < b ? Pair{ a, b } : Pair{ b, a });
+							}
+						}
+						if (rangeMask != 0xF)
+						{
+							break;
+						}
+					}
+				}
+			}
+		});
+
+		size_t total = 0;
+		for (const std::vector<Pair>& chunk : chunkPairs)
+		{
+			if (total < capacity)
+			{
+				std::copy_n(chunk.begin(), std::min(chunk.size(), capacity - total), pairs + total);
+			}
+			total += chunk.size();
+		}
+		return total;
+	}
+
+	template class SweepAndPrune<float>;
+	template class SweepAndPrune<double>;
+}
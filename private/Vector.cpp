@@ -1,5 +1,8 @@
 #include <Vector.h>
 #include <MathTemplateUtil.h>
+#include <Parallel.h>
+
+#include "Simd.h"
 
 namespace Math
 {
@@ -66,6 +69,199 @@ namespace Math
     template<>
     const Vector4i Vector4i::UNIT_W = Vector4i(0, 0, 0, 1);
 	
+	static_assert(sizeof(Vector3d) == sizeof(double) * 3 && sizeof(Vector4d) == sizeof(double) * 4, "Double vectors must be tightly packed");
+
+	namespace
+	{
+		using Simd::Double4;
+
+		inline const double* Raw(const void* p)
+		{
+			return static_cast<const double*>(p);
+		}
+
+		inline double* Raw(void* p)
+		{
+			return static_cast<double*>(p);
+		}
+
+		// Component-wise kernels treat the vectors as one flat array of doubles
+		template <typename Op>
+		void ForEachDouble(const double* lhs, const double* rhs, double* out, const size_t count, Op op, Executor* executor)
+		{
+			ParallelFor(count, GetChunkSize(3 * sizeof(double)), [&](const size_t first, const size_t last) {
+				size_t i = first;
+				for (; i + 4 <= last; i += 4)
+				{
+					Simd::Store(out + i, op(Simd::Load(lhs + i), Simd::Load(rhs + i)));
+				}
+				for (; i < last; ++i)
+				{
+					out[i] = Simd::GetLane(op(Simd::Set1(lhs[i]), Simd::Set1(rhs[i])), 0);
+				}
+			}, executor);
+		}
+
+		inline Double4 Dot4(const Double4 ax, const Double4 ay, const Double4 az, const Double4 aw,
+			const Double4 bx, const Double4 by, const Double4 bz, const Double4 bw)
+		{
+			return ax * bx + ay * by + az * bz + aw * bw;
+		}
+
+		inline Double4 Dot3(const Double4 ax, const Double4 ay, const Double4 az,
+			const Double4 bx, const Double4 by, const Double4 bz)
+		{
+			return ax * bx + ay * by + az * bz;
+		}
+	}
+
+	void Add(const Vector4d* lhs, const Vector4d* rhs, Vector4d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Vector4d)), [&](const size_t first, const size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				Simd::Store(Raw(out + i), Simd::Load(Raw(lhs + i)) + Simd::Load(Raw(rhs + i)));
+			}
+		}, executor);
+	}
+
+	void Subtract(const Vector4d* lhs, const Vector4d* rhs, Vector4d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Vector4d)), [&](const size_t first, const size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				Simd::Store(Raw(out + i), Simd::Load(Raw(lhs + i)) - Simd::Load(Raw(rhs + i)));
+			}
+		}, executor);
+	}
+
+	void Multiply(const Vector4d* lhs, const Vector4d* rhs, Vector4d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Vector4d)), [&](const size_t first, const size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				Simd::Store(Raw(out + i), Simd::Load(Raw(lhs + i)) * Simd::Load(Raw(rhs + i)));
+			}
+		}, executor);
+	}
+
+	void Scale(const Vector4d* src, const double scale, Vector4d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Vector4d)), [&](const size_t first, const size_t last) {
+			const Double4 s = Simd::Set1(scale);
+			for (size_t i = first; i < last; ++i)
+			{
+				Simd::Store(Raw(out + i), Simd::Load(Raw(src + i)) * s);
+			}
+		}, executor);
+	}
+
+	void Dot(const Vector4d* lhs, const Vector4d* rhs, double* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Vector4d) + sizeof(double)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Double4 ax, ay, az, aw, bx, by, bz, bw;
+				Simd::LoadTransposed4(Raw(lhs + i), ax, ay, az, aw);
+				Simd::LoadTransposed4(Raw(rhs + i), bx, by, bz, bw);
+				Simd::Store(out + i, Dot4(ax, ay, az, aw, bx, by, bz, bw));
+			}
+			for (; i < last; ++i)
+			{
+				out[i] = Math::Dot(lhs[i], rhs[i]);
+			}
+		}, executor);
+	}
+
+	void Normalize(const Vector4d* src, Vector4d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Vector4d)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Double4 x, y, z, w;
+				Simd::LoadTransposed4(Raw(src + i), x, y, z, w);
+				const Double4 length = Simd::Sqrt(Dot4(x, y, z, w, x, y, z, w));
+				Simd::StoreTransposed4(Raw(out + i), x / length, y / length, z / length, w / length);
+			}
+			for (; i < last; ++i)
+			{
+				out[i] = src[i].Normalized();
+			}
+		}, executor);
+	}
+
+	void Add(const Vector3d* lhs, const Vector3d* rhs, Vector3d* out, const size_t count, Executor* executor)
+	{
+		ForEachDouble(Raw(lhs), Raw(rhs), Raw(out), count * 3, [](const Double4 a, const Double4 b) { return a + b; }, executor);
+	}
+
+	void Subtract(const Vector3d* lhs, const Vector3d* rhs, Vector3d* out, const size_t count, Executor* executor)
+	{
+		ForEachDouble(Raw(lhs), Raw(rhs), Raw(out), count * 3, [](const Double4 a, const Double4 b) { return a - b; }, executor);
+	}
+
+	void Scale(const Vector3d* src, const double scale, Vector3d* out, const size_t count, Executor* executor)
+	{
+		const Double4 s = Simd::Set1(scale);
+		ForEachDouble(Raw(src), Raw(src), Raw(out), count * 3, [s](const Double4 a, const Double4) { return a * s; }, executor);
+	}
+
+	void Dot(const Vector3d* lhs, const Vector3d* rhs, double* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Vector3d) + sizeof(double)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Double4 ax, ay, az, bx, by, bz;
+				Simd::LoadTransposed3(Raw(lhs + i), ax, ay, az);
+				Simd::LoadTransposed3(Raw(rhs + i), bx, by, bz);
+				Simd::Store(out + i, Dot3(ax, ay, az, bx, by, bz));
+			}
+			for (; i < last; ++i)
+			{
+				out[i] = Math::Dot(lhs[i], rhs[i]);
+			}
+		}, executor);
+	}
+
+	void Cross(const Vector3d* lhs, const Vector3d* rhs, Vector3d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(3 * sizeof(Vector3d)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Double4 ax, ay, az, bx, by, bz;
+				Simd::LoadTransposed3(Raw(lhs + i), ax, ay, az);
+				Simd::LoadTransposed3(Raw(rhs + i), bx, by, bz);
+				Simd::StoreTransposed3(Raw(out + i), ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx);
+			}
+			for (; i < last; ++i)
+			{
+				out[i] = Math::Cross(lhs[i], rhs[i]);
+			}
+		}, executor);
+	}
+
+	void Normalize(const Vector3d* src, Vector3d* out, const size_t count, Executor* executor)
+	{
+		ParallelFor(count, GetChunkSize(2 * sizeof(Vector3d)), [&](const size_t first, const size_t last) {
+			size_t i = first;
+			for (; i + 4 <= last; i += 4)
+			{
+				Double4 x, y, z;
+				Simd::LoadTransposed3(Raw(src + i), x, y, z);
+				const Double4 length = Simd::Sqrt(Dot3(x, y, z, x, y, z));
+				Simd::StoreTransposed3(Raw(out + i), x / length, y / length, z / length);
+			}
+			for (; i < last; ++i)
+			{
+				out[i] = src[i].Normalized();
+			}
+		}, executor);
+	}
+
 	void VectorTest()
 	{
 		{
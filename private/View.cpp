@@ -0,0 +1,165 @@
+#include <View.h>
+#include <Parallel.h>
+
+#include "Simd.h"
+
+namespace Math
+{
+	namespace
+	{
+		template <typename T, int N>
+		size_t ElementStride(const VectorSpan<T, N>& span)
+		{
+			return span.GetStride() / sizeof(T);
+		}
+
+		// Runs kernel(src, dst) over matching cache-sized parts of src and dst
+		template <typename T, int N, int M, typename Kernel>
+		void ForEachChunk(const VectorSpan<const T, N>& src, const VectorSpan<T, M>& dst, Executor* executor, Kernel kernel)
+		{
+			assert(src.Count() == dst.Count());
+			ParallelFor(src.Count(), GetChunkSize(src.GetStride() + dst.GetStride()), [&](const size_t first, const size_t last) {
+				kernel(src.Subspan(first, last - first), dst.Subspan(first, last - first));
+			}, executor);
+		}
+
+		// The matrix is loaded once, so column-major and strided views cost nothing per vector
+		template <typename T>
+		void Transform4(const Matrix4x4Ref<const T>& m, const VectorSpan<const T, 4>& src, const VectorSpan<T, 4>& dst)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+			assert(src.Count() == dst.Count());
+
+			const Matrix4x4<T> matrix = m.Load();
+			Lanes e[16];
+			for (int k = 0; k < 16; ++k)
+			{
+				e[k] = Simd::Set1(matrix.Data()[k]);
+			}
+
+			const size_t count = src.Count();
+			const size_t srcStride = ElementStride(src);
+			const size_t dstStride = ElementStride(dst);
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				Lanes x, y, z, w;
+				Simd::LoadTransposed4(src.Data() + i * srcStride, x, y, z, w, srcStride);
+
+				Lanes result[4];
+				for (int r = 0; r < 4; ++r)
+				{
+					const Lanes* row = e + r * 4;
+					result[r] = row[0] * x + row[1] * y + row[2] * z + row[3] * w;
+				}
+				Simd::StoreTransposed4(dst.Data() + i * dstStride, result[0], result[1], result[2], result[3], dstStride);
+			}
+			for (; i < count; ++i)
+			{
+				dst.Store(i, matrix * src.Load(i));
+			}
+		}
+
+		template <typename T>
+		void TransformPoints3(const Matrix4x4Ref<const T>& m, const VectorSpan<const T, 3>& src, const VectorSpan<T, 3>& dst)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+			assert(src.Count() == dst.Count());
+
+			const Matrix4x4<T> matrix = m.Load();
+			Lanes e[12];
+			for (int k = 0; k < 12; ++k)
+			{
+				e[k] = Simd::Set1(matrix.Data()[k]);
+			}
+
+			const size_t count = src.Count();
+			const size_t srcStride = ElementStride(src);
+			const size_t dstStride = ElementStride(dst);
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				Lanes x, y, z;
+				Simd::LoadTransposed3(src.Data() + i * srcStride, x, y, z, srcStride);
+
+				Lanes result[3];
+				for (int r = 0; r < 3; ++r)
+				{
+					const Lanes* row = e + r * 4;
+					result[r] = row[0] * x + row[1] * y + row[2] * z + row[3];
+				}
+				Simd::StoreTransposed3(dst.Data() + i * dstStride, result[0], result[1], result[2], dstStride);
+			}
+			for (; i < count; ++i)
+			{
+				const Vector3<T> v = src.Load(i);
+				const Vector4<T> p = matrix * Vector4<T>(v.x, v.y, v.z, static_cast<T>(1));
+				dst.Store(i, Vector3<T>(p.x, p.y, p.z));
+			}
+		}
+
+		template <typename T>
+		void Normalize3(const VectorSpan<const T, 3>& src, const VectorSpan<T, 3>& dst)
+		{
+			using Lanes = typename Simd::LanesOf<T>::Type;
+			assert(src.Count() == dst.Count());
+
+			const size_t count = src.Count();
+			const size_t srcStride = ElementStride(src);
+			const size_t dstStride = ElementStride(dst);
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				Lanes x, y, z;
+				Simd::LoadTransposed3(src.Data() + i * srcStride, x, y, z, srcStride);
+				const Lanes length = Simd::Sqrt(x * x + y * y + z * z);
+				Simd::StoreTransposed3(dst.Data() + i * dstStride, x / length, y / length, z / length, dstStride);
+			}
+			for (; i < count; ++i)
+			{
+				dst.Store(i, src.Load(i).Normalized());
+			}
+		}
+	}
+
+	void Transform(const Matrix4x4Ref<const float>& m, const VectorSpan<const float, 4>& src, const VectorSpan<float, 4>& dst, Executor* executor)
+	{
+		ForEachChunk(src, dst, executor, [&m](const VectorSpan<const float, 4>& part, const VectorSpan<float, 4>& out) {
+			Transform4(m, part, out);
+		});
+	}
+
+	void Transform(const Matrix4x4Ref<const double>& m, const VectorSpan<const double, 4>& src, const VectorSpan<double, 4>& dst, Executor* executor)
+	{
+		ForEachChunk(src, dst, executor, [&m](const VectorSpan<const double, 4>& part, const VectorSpan<double, 4>& out) {
+			Transform4(m, part, out);
+		});
+	}
+
+	void TransformPoints(const Matrix4x4Ref<const float>& m, const VectorSpan<const float, 3>& src, const VectorSpan<float, 3>& dst, Executor* executor)
+	{
+		ForEachChunk(src, dst, executor, [&m](const VectorSpan<const float, 3>& part, const VectorSpan<float, 3>& out) {
+			TransformPoints3(m, part, out);
+		});
+	}
+
+	void TransformPoints(const Matrix4x4Ref<const double>& m, const VectorSpan<const double, 3>& src, const VectorSpan<double, 3>& dst, Executor* executor)
+	{
+		ForEachChunk(src, dst, executor, [&m](const VectorSpan<const double, 3>& part, const VectorSpan<double, 3>& out) {
+			TransformPoints3(m, part, out);
+		});
+	}
+
+	void Normalize(const VectorSpan<const float, 3>& src, const VectorSpan<float, 3>& dst, Executor* executor)
+	{
+		ForEachChunk(src, dst, executor, Normalize3<float>);
+	}
+
+	void Normalize(const VectorSpan<const double, 3>& src, const VectorSpan<double, 3>& dst, Executor* executor)
+	{
+		ForEachChunk(src, dst, executor, Normalize3<double>);
+	}
+}
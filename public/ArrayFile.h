@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <Vector.h>
+#include <Matrix.h>
+#include <Quaternion.h>
+#include <View.h>
+
+namespace Math
+{
+	// Versioned binary container for bulk arrays of vectors, quaternions and matrices,
+	// read back through a memory mapping without parsing or copying.
+	//
+	// A file is a 64-byte file header followed by any number of arrays, each a 64-byte
+	// array header and then its elements. Elements are raw scalars in the in-memory
+	// layout of the types, either interleaved (AoS) or as one stream per component
+	// (SoA). Element data and every SoA stream start on a 64-byte boundary, so they
+	// can be handed straight to the batch kernels. Files are little-endian; readers
+	// reject other versions of the format.
+
+	enum class ArrayElementType : uint32_t
+	{
+		Vector2f = 1,
+		Vector3f,
+		Vector4f,
+		Quaternionf,
+		Matrix3x3f,
+		Matrix4x4f,
+		Vector2d,
+		Vector3d,
+		Vector4d,
+		Quaterniond,
+		Matrix3x3d,
+		Matrix4x4d
+	};
+
+	enum class ArrayLayout : uint32_t
+	{
+		AoS,	// Whole elements one after another
+		SoA		// One stream per component, e.g. all x, then all y; matrices by element in row-major order
+	};
+
+	namespace ArrayFileDetail
+	{
+		template <typename T, int N, ArrayElementType Type>
+		struct ElementTraits
+		{
+			using Scalar = T;
+			static constexpr int k_componentCount = N;
+			static constexpr ArrayElementType k_type = Type;
+		};
+
+		template <typename T, int N, ArrayElementType Type>
+		constexpr int ElementTraits<T, N, Type>::k_componentCount;
+		template <typename T, int N, ArrayElementType Type>
+		constexpr ArrayElementType ElementTraits<T, N, Type>::k_type;
+
+		template <typename T>
+		struct ElementOf;
+
+		template <> struct ElementOf<Vector2f> : ElementTraits<float, 2, ArrayElementType::Vector2f> {};
+		template <> struct ElementOf<Vector3f> : ElementTraits<float, 3, ArrayElementType::Vector3f> {};
+		template <> struct ElementOf<Vector4f> : ElementTraits<float, 4, ArrayElementType::Vector4f> {};
+		template <> struct ElementOf<Quaternionf> : ElementTraits<float, 4, ArrayElementType::Quaternionf> {};
+		template <> struct ElementOf<Matrix3x3f> : ElementTraits<float, 9, ArrayElementType::Matrix3x3f> {};
+		template <> struct ElementOf<Matrix4x4f> : ElementTraits<float, 16, ArrayElementType::Matrix4x4f> {};
+		template <> struct ElementOf<Vector2d> : ElementTraits<double, 2, ArrayElementType::Vector2d> {};
+		template <> struct ElementOf<Vector3d> : ElementTraits<double, 3, ArrayElementType::Vector3d> {};
+		template <> struct ElementOf<Vector4d> : ElementTraits<double, 4, ArrayElementType::Vector4d> {};
+		template <> struct ElementOf<Quaterniond> : ElementTraits<double, 4, ArrayElementType::Quaterniond> {};
+		template <> struct ElementOf<Matrix3x3d> : ElementTraits<double, 9, ArrayElementType::Matrix3x3d> {};
+		template <> struct ElementOf<Matrix4x4d> : ElementTraits<double, 16, ArrayElementType::Matrix4x4d> {};
+	}
+
+	struct ArrayInfo
+	{
+		ArrayElementType type;
+		ArrayLayout layout;
+		uint64_t count;
+	};
+
+	// Read-only view of an array file, mapped into memory. Pointers and spans handed
+	// out stay valid until the reader is closed or destroyed.
+	class ArrayFileReader
+	{
+	public:
+		ArrayFileReader() = default;
+		ArrayFileReader(const ArrayFileReader&) = delete;
+		ArrayFileReader& operator=(const ArrayFileReader&) = delete;
+		~ArrayFileReader();
+
+		// Maps the file at path and checks its headers. Returns false, leaving the
+		// reader closed, if the file cannot be mapped or is not a valid array file.
+		bool Open(const char* path);
+		void Close();
+
+		bool IsOpen() const
+		{
+			return mapping != nullptr;
+		}
+
+		size_t GetArrayCount() const
+		{
+			return arrays.size();
+		}
+
+		const ArrayInfo& GetArrayInfo(const size_t index) const
+		{
+			assert(index < arrays.size());
+			return arrays[index].info;
+		}
+
+		// Elements of an AoS array of T
+		template <typename T>
+		const T* GetElements(const size_t index) const
+		{
+			const Array& array = GetArray(index, ArrayFileDetail::ElementOf<T>::k_type);
+			assert(array.info.layout == ArrayLayout::AoS);
+			return reinterpret_cast<const T*>(array.data);
+		}
+
+		// Elements of an AoS array of vectors of N components
+		template <typename T, int N>
+		VectorSpan<const T, N> GetVectors(const size_t index) const
+		{
+			using VectorType = typename ViewDetail::VectorOf<T, N>::Type;
+			return VectorSpan<const T, N>(GetElements<VectorType>(index), static_cast<size_t>(arrays[index].info.count));
+		}
+
+		// Stream of one component of an SoA array of T
+		template <typename T>
+		const typename ArrayFileDetail::ElementOf<T>::Scalar* GetComponent(const size_t index, const int component) const
+		{
+			using Element = ArrayFileDetail::ElementOf<T>;
+			const Array& array = GetArray(index, Element::k_type);
+			assert(array.info.layout == ArrayLayout::SoA);
+			assert(component >= 0 && component < Element::k_componentCount);
+			return reinterpret_cast<const typename Element::Scalar*>(array.data + component * array.componentStride);
+		}
+
+	private:
+		struct Array
+		{
+			ArrayInfo info;
+			const uint8_t* data;
+			// Bytes between the SoA component streams
+			uint64_t componentStride;
+		};
+
+		const Array& GetArray(const size_t index, const ArrayElementType type) const
+		{
+			assert(index < arrays.size());
+			assert(arrays[index].info.type == type);
+			(void)type;
+			return arrays[index];
+		}
+
+	private:
+		const uint8_t* mapping = nullptr;
+		size_t size = 0;
+		std::vector<Array> arrays;
+	};
+
+	// Writes an array file front to back. Each array is started with BeginArray, given
+	// its elements in order over any number of Append calls, and finished with
+	// EndArray, so arrays larger than memory can be streamed out. Every function
+	// returns false once a write has failed.
+	class ArrayFileWriter
+	{
+	public:
+		ArrayFileWriter() = default;
+		ArrayFileWriter(const ArrayFileWriter&) = delete;
+		ArrayFileWriter& operator=(const ArrayFileWriter&) = delete;
+		~ArrayFileWriter();
+
+		// Creates or truncates the file at path
+		bool Open(const char* path);
+		// Finishes the file header and closes the file. An array still in progress
+		// is discarded.
+		bool Close();
+
+		template <typename T>
+		bool BeginArray(const uint64_t count, const ArrayLayout layout = ArrayLayout::AoS)
+		{
+			return BeginArray(ArrayFileDetail::ElementOf<T>::k_type, layout, count);
+		}
+
+		bool BeginArray(ArrayElementType type, ArrayLayout layout, uint64_t count);
+
+		template <typename T>
+		bool Append(const T* elements, const size_t n)
+		{
+			using Element = ArrayFileDetail::ElementOf<T>;
+			assert(current.type == Element::k_type);
+			return Append(elements, n, sizeof(typename Element::Scalar), Element::k_componentCount);
+		}
+
+		// Pads the finished array. Every element promised to BeginArray must have been
+		// appended.
+		bool EndArray();
+
+		// Writes a whole array at once
+		template <typename T>
+		bool WriteArray(const T* elements, const size_t count, const ArrayLayout layout = ArrayLayout::AoS)
+		{
+			return BeginArray<T>(count, layout) && Append(elements, count) && EndArray();
+		}
+
+	private:
+		bool Append(const void* elements, size_t n, size_t scalarSize, int componentCount);
+		bool Seek(uint64_t offset);
+		bool WriteZeros(uint64_t n);
+
+	private:
+		std::FILE* file = nullptr;
+		bool failed = false;
+		bool inArray = false;
+		uint64_t arrayCount = 0;
+		// End of the data written so far
+		uint64_t end = 0;
+		ArrayInfo current = {};
+		uint64_t appended = 0;
+		uint64_t dataOffset = 0;
+		uint64_t componentStride = 0;
+		std::vector<uint8_t> scratch;
+	};
+}
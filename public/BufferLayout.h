@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+
+#include <Vector.h>
+#include <Matrix.h>
+
+namespace Math
+{
+	// GLSL interface block layouts. In both, vec3 and vec4 occupy 16 bytes and a
+	// matrix is an array of vec4-aligned columns (or rows, for row_major members).
+	// std140 additionally rounds every array stride up to 16 bytes, so the two only
+	// differ for arrays of scalars and vec2s.
+	enum class BufferLayout
+	{
+		Std140,		// Uniform blocks
+		Std430		// Shader storage blocks and push constants
+	};
+
+	namespace BufferLayoutDetail
+	{
+		// Array stride in std430, which is the natural vec4-aligned size
+		template <typename T>
+		struct Std430Stride;
+
+		template <>
+		struct Std430Stride<float>
+		{
+			static constexpr size_t k_value = 4;
+		};
+
+		template <>
+		struct Std430Stride<Vector2f>
+		{
+			static constexpr size_t k_value = 8;
+		};
+
+		template <>
+		struct Std430Stride<Vector3f>
+		{
+			static constexpr size_t k_value = 16;
+		};
+
+		template <>
+		struct Std430Stride<Vector4f>
+		{
+			static constexpr size_t k_value = 16;
+		};
+
+		template <StorageOrder Order>
+		struct Std430Stride<Matrix3x3<float, Order>>
+		{
+			static constexpr size_t k_value = 48;
+		};
+
+		template <StorageOrder Order>
+		struct Std430Stride<Matrix4x4<float, Order>>
+		{
+			static constexpr size_t k_value = 64;
+		};
+	}
+
+	// Byte stride between consecutive elements of a T[] in the given layout
+	template <typename T>
+	constexpr size_t ArrayStride(const BufferLayout layout)
+	{
+		return layout == BufferLayout::Std140
+			? (BufferLayoutDetail::Std430Stride<T>::k_value + 15) / 16 * 16
+			: BufferLayoutDetail::Std430Stride<T>::k_value;
+	}
+
+	// Writes count elements as a GLSL array in the given layout, starting at dst, and
+	// returns the number of bytes written (count * ArrayStride). Padding is zeroed, so
+	// the output is deterministic and can be hashed or diffed. dst needs no particular
+	// alignment and must not overlap src. Elements are chunked over executor.
+	size_t WriteArray(const float* src, size_t count, BufferLayout layout, void* dst, Executor* executor = nullptr);
+	size_t WriteArray(const Vector2f* src, size_t count, BufferLayout layout, void* dst, Executor* executor = nullptr);
+	size_t WriteArray(const Vector3f* src, size_t count, BufferLayout layout, void* dst, Executor* executor = nullptr);
+	size_t WriteArray(const Vector4f* src, size_t count, BufferLayout layout, void* dst, Executor* executor = nullptr);
+
+	// Matrices are written in the given order, which should match the member's
+	// row_major/column_major qualifier; GLSL defaults to column_major. Sources of
+	// either storage order are accepted and transposed as needed.
+	size_t WriteArray(const Matrix3x3f* src, size_t count, BufferLayout layout, void* dst, StorageOrder order = StorageOrder::ColumnMajor,
+		Executor* executor = nullptr);
+	size_t WriteArray(const Matrix4x4f* src, size_t count, BufferLayout layout, void* dst, StorageOrder order = StorageOrder::ColumnMajor,
+		Executor* executor = nullptr);
+	size_t WriteArray(const ColumnMajorMatrix3x3f* src, size_t count, BufferLayout layout, void* dst, StorageOrder order = StorageOrder::ColumnMajor,
+		Executor* executor = nullptr);
+	size_t WriteArray(const ColumnMajorMatrix4x4f* src, size_t count, BufferLayout layout, void* dst, StorageOrder order = StorageOrder::ColumnMajor,
+		Executor* executor = nullptr);
+}
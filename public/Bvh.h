@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Vector.h>
+#include <View.h>
+#include <Geometry.h>
+
+namespace Math
+{
+	// Nearest triangle hit along a ray. u and v are the barycentric weights of the
+	// triangle's second and third vertices.
+	struct BvhHit
+	{
+		float t;
+		uint32_t triangle;
+		float u;
+		float v;
+	};
+
+	namespace BvhDetail
+	{
+		constexpr int k_width = 8;
+
+		// Children of an interior node. Child bounds are stored per component, one lane
+		// per child, and unused slots hold NaN bounds, which every slab test misses.
+		struct Node
+		{
+			float bounds[6][k_width];		// minX, minY, minZ, maxX, maxY, maxZ
+			uint32_t children[k_width];		// A node index, a leaf from MakeLeaf, or k_emptyChild
+		};
+
+		// A leaf is a run of up to 15 triangles in leaf order
+		constexpr uint32_t k_leafFlag = 0x80000000u;
+		constexpr uint32_t k_leafCountShift = 27;
+		constexpr uint32_t k_leafFirstMask = (1u << k_leafCountShift) - 1;
+		constexpr uint32_t k_emptyChild = 0xFFFFFFFFu;
+
+		inline uint32_t MakeLeaf(const uint32_t first, const uint32_t count)
+		{
+			return k_leafFlag | (count << k_leafCountShift) | first;
+		}
+
+		// Precomputed for the Moller-Trumbore test, in leaf order
+		struct Triangle
+		{
+			Vector3f v0;
+			Vector3f edge1;
+			Vector3f edge2;
+			uint32_t index;
+		};
+	}
+
+	// Static bounding volume hierarchy over a triangle mesh, for ray queries such as
+	// picking, line of sight and sound occlusion.
+	//
+	// Built top-down with binned surface area heuristic splits. The large splits near
+	// the root bin their triangles in parallel and the subtrees below them are built in
+	// parallel; the resulting tree does not depend on the number of threads. The binary
+	// tree is then collapsed into nodes of up to eight children, whose bounds are
+	// stored as structure-of-arrays so a ray is tested against all children at once.
+	class Bvh
+	{
+	public:
+		static constexpr int k_width = BvhDetail::k_width;
+		// Most triangles a leaf holds
+		static constexpr int k_maxLeafSize = 4;
+		static constexpr uint32_t k_noHit = 0xFFFFFFFFu;
+
+	public:
+		Bvh() = default;
+
+		// Builds over triangleCount triangles of three indices each into vertices.
+		// Without indices, each consecutive run of three vertices is a triangle.
+		// Triangle numbers reported in hits are positions in this list.
+		void Build(const VectorSpan<const float, 3>& vertices, const uint32_t* indices, size_t triangleCount);
+
+		bool IsEmpty() const
+		{
+			return nodes.empty();
+		}
+
+		size_t GetNodeCount() const
+		{
+			return nodes.size();
+		}
+
+		size_t GetTriangleCount() const
+		{
+			return triangles.size();
+		}
+
+		Aabbf GetBounds() const
+		{
+			return bounds;
+		}
+
+		// Nearest hit with t in [0, tMax]. Triangles are hit from either side.
+		bool Intersect(const Rayf& ray, float tMax, BvhHit& hit) const;
+
+		// True as soon as any triangle is hit with t in [0, tMax]
+		bool IsOccluded(const Rayf& ray, float tMax) const;
+
+		// Nearest hits for count rays, traversed four at a time as packets that share
+		// a node stack. Fastest when neighbouring rays are coherent, such as a grid of
+		// rays from one point. Rays that hit nothing get k_noHit as their triangle.
+		void Intersect(const Rayf* rays, size_t count, float tMax, BvhHit* hits) const;
+
+	private:
+		std::vector<BvhDetail::Node> nodes;
+		std::vector<BvhDetail::Triangle> triangles;
+		Aabbf bounds = Aabbf::Empty();
+	};
+}
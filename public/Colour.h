@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+
+#include <Vector.h>
+
+namespace Math
+{
+	// Batched colour format conversion.
+	//
+	// Integer colours are treated as unsigned normalized values, so 255 (or 65535,
+	// or 2^32 - 1) maps to 1.0f. Float to integer conversion saturates to [0, 1],
+	// maps NaN to 0, and rounds to nearest. The SIMD and scalar paths produce
+	// identical results, so output does not depend on the instruction set.
+	//
+	// Source and destination must not overlap, except for SwizzleRedBlue, which
+	// may be performed in place.
+
+	void ConvertColours(const Colour4b* src, Colour4f* dst, size_t count);
+	void ConvertColours(const Colour4s* src, Colour4f* dst, size_t count);
+	void ConvertColours(const Colour4i* src, Colour4f* dst, size_t count);
+
+	void ConvertColours(const Colour4f* src, Colour4b* dst, size_t count);
+	void ConvertColours(const Colour4f* src, Colour4s* dst, size_t count);
+	void ConvertColours(const Colour4f* src, Colour4i* dst, size_t count);
+
+	// Swap the red and blue channels, converting BGRA <-> RGBA
+	void SwizzleRedBlue(const Colour4b* src, Colour4b* dst, size_t count);
+	void SwizzleRedBlue(const Colour4f* src, Colour4f* dst, size_t count);
+
+	// Batched colour space conversion. Alpha is always passed through unchanged,
+	// and float kernels may be performed in place.
+	enum class ColourPrecision
+	{
+		Exact,	// Reference transfer functions, evaluated with powf
+		// Polynomial approximation (float) or lookup table (8-bit). Decoding is within
+		// 0.17% relative error, with the exact linear toe in the shadows. Encoding is
+		// within 0.0016 of full scale, under half an 8-bit step, and table lookups are
+		// within 1 step.
+		Fast
+	};
+
+	// sRGB <-> linear transfer functions (IEC 61966-2-1). Float inputs are clamped to [0, 1].
+	void SrgbToLinear(const Colour3f* src, Colour3f* dst, size_t count, ColourPrecision precision = ColourPrecision::Exact);
+	void SrgbToLinear(const Colour4f* src, Colour4f* dst, size_t count, ColourPrecision precision = ColourPrecision::Exact);
+	void SrgbToLinear(const Colour4b* src, Colour4f* dst, size_t count);	// Always exact, via a 256 entry table
+
+	void LinearToSrgb(const Colour3f* src, Colour3f* dst, size_t count, ColourPrecision precision = ColourPrecision::Exact);
+	void LinearToSrgb(const Colour4f* src, Colour4f* dst, size_t count, ColourPrecision precision = ColourPrecision::Exact);
+	void LinearToSrgb(const Colour4f* src, Colour4b* dst, size_t count, ColourPrecision precision = ColourPrecision::Exact);
+
+	// RGB <-> HSV/HSL. Hue, saturation and value/lightness are all in [0, 1],
+	// stored in the x, y and z components respectively.
+	void RgbToHsv(const Colour3f* src, Colour3f* dst, size_t count);
+	void HsvToRgb(const Colour3f* src, Colour3f* dst, size_t count);
+	void RgbToHsl(const Colour3f* src, Colour3f* dst, size_t count);
+	void HslToRgb(const Colour3f* src, Colour3f* dst, size_t count);
+
+	// Relative luminance of linear RGB, using the Rec. 709 primaries
+	void Luminance(const Colour3f* src, float* dst, size_t count);
+	void Luminance(const Colour4f* src, float* dst, size_t count);
+}
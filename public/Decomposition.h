@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+#include <Vector.h>
+#include <Matrix.h>
+#include <View.h>
+#include <Geometry.h>
+#include <Reduce.h>
+
+namespace Math
+{
+	// Eigen-decomposition of a symmetric matrix m, such that
+	// m = vectors * diag(values) * vectors^T
+	template <typename T>
+	struct SymmetricEigen
+	{
+		// Eigenvalues, largest first
+		Vector3<T> values;
+		// Unit eigenvectors in the columns, in the order of values. They form a
+		// rotation (determinant +1).
+		Matrix3x3<T> vectors;
+	};
+
+	using SymmetricEigenf = SymmetricEigen<float>;
+	using SymmetricEigend = SymmetricEigen<double>;
+
+	// vectors holds the nine elements of SymmetricEigen::vectors in row-major order
+	template <typename T>
+	struct SymmetricEigenSoA
+	{
+		T* values[3];
+		T* vectors[9];
+	};
+
+	// Singular value decomposition m = u * diag(singularValues) * v^T
+	template <typename T>
+	struct Svd
+	{
+		// Rotations (determinant +1), even when m is a reflection
+		Matrix3x3<T> u;
+		Matrix3x3<T> v;
+		// Largest magnitude first. Only the last can be negative, which it is when m
+		// has a negative determinant.
+		Vector3<T> singularValues;
+	};
+
+	using Svdf = Svd<float>;
+	using Svdd = Svd<double>;
+
+	// u and v hold the nine elements of Svd::u and Svd::v in row-major order
+	template <typename T>
+	struct SvdSoA
+	{
+		T* u[9];
+		T* v[9];
+		T* singularValues[3];
+	};
+
+	// Polar decomposition m = rotation * stretch
+	template <typename T>
+	struct PolarDecomposition
+	{
+		// The rotation closest to m in the Frobenius norm, including when m is a
+		// reflection, as shape matching needs
+		Matrix3x3<T> rotation;
+		// Symmetric, and positive semi-definite unless m has a negative determinant
+		Matrix3x3<T> stretch;
+	};
+
+	using PolarDecompositionf = PolarDecomposition<float>;
+	using PolarDecompositiond = PolarDecomposition<double>;
+
+	// rotation and stretch hold the nine elements of each matrix in row-major order
+	template <typename T>
+	struct PolarDecompositionSoA
+	{
+		T* rotation[9];
+		T* stretch[9];
+	};
+
+	namespace DecompositionDetail
+	{
+		// Instantiated for float and double. upper is { m00, m01, m02, m11, m12, m22 },
+		// and matrices are row-major.
+		template <typename T>
+		void DecomposeSymmetric(const T* upper, T* values, T* vectors);
+		template <typename T>
+		void DecomposeSvd(const T* m, T* u, T* singularValues, T* v);
+		template <typename T>
+		void DecomposePolar(const T* m, T* rotation, T* stretch);
+
+		template <typename T>
+		Matrix3x3<T> ComputeCovariance(const VectorSpan<const T, 3>& points, const Vector3<T>& mean, Executor* executor);
+		template <typename T>
+		Obb<T> FitObb(const VectorSpan<const T, 3>& points, Executor* executor);
+	}
+
+	// Eigenvalues and eigenvectors of m by cyclic Jacobi rotations, run for a fixed
+	// number of sweeps. The decomposition reproduces m to within rounding error
+	// relative to its largest element. m must be symmetric; only its upper triangle
+	// is read.
+	template <typename T, StorageOrder Order>
+	SymmetricEigen<T> DecomposeSymmetric(const Matrix3x3<T, Order>& m)
+	{
+		const T upper[6] = { m(0, 0), m(0, 1), m(0, 2), m(1, 1), m(1, 2), m(2, 2) };
+		T values[3];
+		T vectors[9];
+		DecompositionDetail::DecomposeSymmetric(upper, values, vectors);
+
+		SymmetricEigen<T> eigen;
+		eigen.values = Vector3<T>(values[0], values[1], values[2]);
+		for (int k = 0; k < 9; ++k)
+		{
+			eigen.vectors(k / 3, k % 3) = vectors[k];
+		}
+		return eigen;
+	}
+
+	// Batched DecomposeSymmetric, four matrices at a time in SIMD lanes. Every matrix
+	// gets exactly the result of the scalar function. Batches are chunked over executor.
+	void DecomposeSymmetric(const Matrix3x3SoA<const float>& src, const SymmetricEigenSoA<float>& out, size_t count,
+		Executor* executor = nullptr);
+	void DecomposeSymmetric(const Matrix3x3SoA<const double>& src, const SymmetricEigenSoA<double>& out, size_t count,
+		Executor* executor = nullptr);
+	void DecomposeSymmetric(const Matrix3x3f* src, SymmetricEigenf* out, size_t count, Executor* executor = nullptr);
+	void DecomposeSymmetric(const Matrix3x3d* src, SymmetricEigend* out, size_t count, Executor* executor = nullptr);
+
+	// Singular value decomposition, found as in McAdams et al.'s fast 3x3 SVD: v from
+	// DecomposeSymmetric of m^T * m, refined by one-sided Jacobi sweeps on m * v and
+	// ordered by the lengths of its columns, then u and the singular values from a QR
+	// factorization of m * v by Givens rotations. Branch-free like DecomposeSymmetric. m may be any finite matrix,
+	// including singular ones; it is scaled by its largest element first, and the
+	// decomposition reproduces it to within rounding error relative to that element.
+	template <typename T, StorageOrder Order>
+	Svd<T> DecomposeSvd(const Matrix3x3<T, Order>& m)
+	{
+		T elements[9];
+		for (int k = 0; k < 9; ++k)
+		{
+			elements[k] = m(k / 3, k % 3);
+		}
+		T u[9];
+		T singularValues[3];
+		T v[9];
+		DecompositionDetail::DecomposeSvd(elements, u, singularValues, v);
+
+		Svd<T> svd;
+		for (int k = 0; k < 9; ++k)
+		{
+			svd.u(k / 3, k % 3) = u[k];
+			svd.v(k / 3, k % 3) = v[k];
+		}
+		svd.singularValues = Vector3<T>(singularValues[0], singularValues[1], singularValues[2]);
+		return svd;
+	}
+
+	// Polar decomposition from DecomposeSvd: rotation = u * v^T and
+	// stretch = v * diag(singularValues) * v^T
+	template <typename T, StorageOrder Order>
+	PolarDecomposition<T> DecomposePolar(const Matrix3x3<T, Order>& m)
+	{
+		T elements[9];
+		for (int k = 0; k < 9; ++k)
+		{
+			elements[k] = m(k / 3, k % 3);
+		}
+		T rotation[9];
+		T stretch[9];
+		DecompositionDetail::DecomposePolar(elements, rotation, stretch);
+
+		PolarDecomposition<T> polar;
+		for (int k = 0; k < 9; ++k)
+		{
+			polar.rotation(k / 3, k % 3) = rotation[k];
+			polar.stretch(k / 3, k % 3) = stretch[k];
+		}
+		return polar;
+	}
+
+	// Batched DecomposeSvd and DecomposePolar, which match the scalar functions in the
+	// same way as the DecomposeSymmetric batches
+	void DecomposeSvd(const Matrix3x3SoA<const float>& src, const SvdSoA<float>& out, size_t count, Executor* executor = nullptr);
+	void DecomposeSvd(const Matrix3x3SoA<const double>& src, const SvdSoA<double>& out, size_t count, Executor* executor = nullptr);
+	void DecomposeSvd(const Matrix3x3f* src, Svdf* out, size_t count, Executor* executor = nullptr);
+	void DecomposeSvd(const Matrix3x3d* src, Svdd* out, size_t count, Executor* executor = nullptr);
+
+	void DecomposePolar(const Matrix3x3SoA<const float>& src, const PolarDecompositionSoA<float>& out, size_t count,
+		Executor* executor = nullptr);
+	void DecomposePolar(const Matrix3x3SoA<const double>& src, const PolarDecompositionSoA<double>& out, size_t count,
+		Executor* executor = nullptr);
+	void DecomposePolar(const Matrix3x3f* src, PolarDecompositionf* out, size_t count, Executor* executor = nullptr);
+	void DecomposePolar(const Matrix3x3d* src, PolarDecompositiond* out, size_t count, Executor* executor = nullptr);
+
+	// Covariance of the points about mean, divided by the number of points, which
+	// must not be zero. For a unit point mass at each point, the inertia tensor about
+	// mean is count * (trace(C) * I - C).
+	template <typename T>
+	Matrix3x3<typename std::remove_const<T>::type> ComputeCovariance(const VectorSpan<T, 3>& points,
+		const Vector3<typename std::remove_const<T>::type>& mean, Executor* executor = nullptr)
+	{
+		return DecompositionDetail::ComputeCovariance<typename std::remove_const<T>::type>(points, mean, executor);
+	}
+
+	// Principal component analysis of a point set
+	template <typename T>
+	struct PrincipalComponents
+	{
+		Vector3<T> mean;
+		// Variance along each axis, largest first
+		Vector3<T> variances;
+		// Unit axes in the columns, in the order of variances, forming a rotation
+		Matrix3x3<T> axes;
+	};
+
+	// Principal components of the points, which must not be empty
+	template <typename T>
+	PrincipalComponents<typename std::remove_const<T>::type> ComputePrincipalComponents(const VectorSpan<T, 3>& points,
+		Executor* executor = nullptr)
+	{
+		using Scalar = typename std::remove_const<T>::type;
+		PrincipalComponents<Scalar> components;
+		components.mean = Centroid(points, Summation::Pairwise, executor);
+		const SymmetricEigen<Scalar> eigen = DecomposeSymmetric(ComputeCovariance(points, components.mean, executor));
+		components.variances = eigen.values;
+		components.axes = eigen.vectors;
+		return components;
+	}
+
+	// Smallest box holding every point with the principal axes of the points, which
+	// must not be empty. This is not the minimum volume box; the axes follow the
+	// density of the points, so unevenly sampled surfaces can give looser boxes.
+	template <typename T>
+	Obb<typename std::remove_const<T>::type> FitObb(const VectorSpan<T, 3>& points, Executor* executor = nullptr)
+	{
+		return DecompositionDetail::FitObb<typename std::remove_const<T>::type>(points, executor);
+	}
+}
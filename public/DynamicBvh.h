@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Vector.h>
+#include <Matrix.h>
+#include <Geometry.h>
+
+namespace Math
+{
+	// Bounding volume tree over moving boxes, for broadphase collision and scene
+	// queries that change every tick.
+	//
+	// Each proxy is stored with fat bounds, its box grown by a margin on every side, so
+	// small movements don't touch the tree at all. When a box escapes its fat bounds
+	// only the leaf is updated and its ancestors are refit bottom-up; the batched Move
+	// marks every moved leaf first and then refits each dirty ancestor once. Refits
+	// apply tree rotations, swapping a child with a grandchild when that shrinks the
+	// surface area, which keeps query cost close to a fresh build without rebuilding.
+	template <typename T>
+	class DynamicBvh
+	{
+	public:
+		using ProxyId = uint32_t;
+		static constexpr ProxyId k_nullProxy = 0xFFFFFFFFu;
+
+	public:
+		explicit DynamicBvh(T margin = static_cast<T>(0.1));
+
+		T GetMargin() const
+		{
+			return margin;
+		}
+
+		size_t GetProxyCount() const
+		{
+			return proxyCount;
+		}
+
+		// Height of the root, 0 for a single proxy and -1 when empty
+		int GetHeight() const
+		{
+			return root == k_nullProxy ? -1 : nodes[root].height;
+		}
+
+		// Sum of the surface areas of the interior nodes, which query cost grows with
+		T GetAreaCost() const;
+
+		const Aabb<T>& GetFatBounds(const ProxyId id) const
+		{
+			assert(IsProxy(id));
+			return nodes[id].bounds;
+		}
+
+		uint32_t GetUserData(const ProxyId id) const
+		{
+			assert(IsProxy(id));
+			return nodes[id].userData;
+		}
+
+		ProxyId Insert(const Aabb<T>& bounds, uint32_t userData);
+
+		// Inserts count proxies, writing their ids. Into an empty tree, or one smaller
+		// than the batch, the whole tree is rebuilt top-down over old and new proxies.
+		void Insert(const Aabb<T>* bounds, const uint32_t* userData, size_t count, ProxyId* ids);
+
+		void Remove(ProxyId id);
+
+		// Removes every proxy first and refits the remaining ancestors once
+		void Remove(const ProxyId* ids, size_t count);
+
+		// Gives a proxy new bounds. Returns false, leaving the tree alone, while the
+		// bounds stay inside the fat bounds.
+		bool Move(ProxyId id, const Aabb<T>& bounds);
+
+		// Moves a proxy to localBounds under transform
+		template <StorageOrder Order>
+		bool Move(const ProxyId id, const Aabb<T>& localBounds, const Matrix4x4<T, Order>& transform)
+		{
+			return Move(id, TransformBounds(localBounds, transform));
+		}
+
+		// Batched Move, refitting only the ancestors of the proxies whose fat bounds
+		// changed. Returns how many of them there were.
+		size_t Move(const ProxyId* ids, const Aabb<T>* bounds, size_t count);
+
+		// Rebuilds the whole tree top-down, splitting at the median centroid along the
+		// longest axis. Proxy ids are kept.
+		void Rebuild();
+
+		// Calls callback(id) for every proxy whose fat bounds overlap box, stopping early
+		// if it returns false
+		template <typename Callback>
+		void Query(const Aabb<T>& box, Callback callback) const
+		{
+			if (root == k_nullProxy)
+			{
+				return;
+			}
+			QueryStack stack(nodes[root].height);
+			stack.Push(root);
+			while (!stack.IsEmpty())
+			{
+				const uint32_t index = stack.Pop();
+				const Node& node = nodes[index];
+				if (!Overlaps(node.bounds, box))
+				{
+					continue;
+				}
+				if (node.IsLeaf())
+				{
+					if (!callback(static_cast<ProxyId>(index)))
+					{
+						return;
+					}
+				}
+				else
+				{
+					stack.Push(node.children[0]);
+					stack.Push(node.children[1]);
+				}
+			}
+		}
+
+		// Calls callback(id, tNear) for every proxy whose fat bounds the ray enters
+		// within [0, tMax], nearest subtrees first. The callback returns the new tMax,
+		// a smaller one clipping the rest of the search, or a negative one to stop.
+		template <typename Callback>
+		void RayCast(const Ray<T>& ray, T tMax, Callback callback) const
+		{
+			if (root == k_nullProxy)
+			{
+				return;
+			}
+			QueryStack stack(nodes[root].height);
+			stack.Push(root);
+			while (!stack.IsEmpty())
+			{
+				const uint32_t index = stack.Pop();
+				const Node& node = nodes[index];
+				T tNear;
+				if (!Intersect(ray, node.bounds, tMax, tNear))
+				{
+					continue;
+				}
+				if (node.IsLeaf())
+				{
+					tMax = callback(static_cast<ProxyId>(index), tNear);
+					if (tMax < static_cast<T>(0))
+					{
+						return;
+					}
+				}
+				else
+				{
+					// The child whose centre is nearer along the ray is popped first
+					const Node& a = nodes[node.children[0]];
+					const Node& b = nodes[node.children[1]];
+					const bool aFirst = Dot(a.bounds.GetCenter() - b.bounds.GetCenter(), ray.direction) <= static_cast<T>(0);
+					stack.Push(node.children[aFirst ? 1 : 0]);
+					stack.Push(node.children[aFirst ? 0 : 1]);
+				}
+			}
+		}
+
+	private:
+		// Leaves are proxies; free nodes chain through parent
+		struct Node
+		{
+			Aabb<T> bounds;
+			uint32_t parent;
+			uint32_t children[2];
+			int height;
+			uint32_t userData;
+			bool dirty;
+
+			bool IsLeaf() const
+			{
+				return children[0] == k_nullProxy;
+			}
+		};
+
+		bool IsProxy(const ProxyId id) const
+		{
+			return id < nodes.size() && nodes[id].height == 0;
+		}
+
+		Aabb<T> Fatten(const Aabb<T>& bounds) const
+		{
+			const Vector3<T> grow(margin, margin, margin);
+			return { bounds.min - grow, bounds.max + grow };
+		}
+
+		// Depth-first traversal never holds more than height + 1 nodes, which fit on
+		// the machine stack unless the tree is unusually deep
+		class QueryStack
+		{
+		public:
+			explicit QueryStack(const int height)
+				: entries(local)
+			{
+				if (height + 1 > k_localSize)
+				{
+					heap.resize(height + 1);
+					entries = heap.data();
+				}
+			}
+
+			void Push(const uint32_t index)
+			{
+				entries[size++] = index;
+			}
+
+			uint32_t Pop()
+			{
+				return entries[--size];
+			}
+
+			bool IsEmpty() const
+			{
+				return size == 0;
+			}
+
+		private:
+			static constexpr int k_localSize = 64;
+			uint32_t local[k_localSize];
+			std::vector<uint32_t> heap;
+			uint32_t* entries;
+			size_t size = 0;
+		};
+
+		uint32_t AllocateNode();
+		void FreeNode(uint32_t index);
+		void InsertLeaf(uint32_t leaf);
+		// Unlinks a leaf and returns the ancestor that needs refitting, if any
+		uint32_t RemoveLeaf(uint32_t leaf);
+		void UpdateNode(uint32_t index);
+		void Rotate(uint32_t index);
+		void RefitUpward(uint32_t index);
+		void MarkDirty(uint32_t index);
+		void RefitDirty();
+		uint32_t BuildTopDown(uint32_t* leaves, size_t count);
+
+	private:
+		std::vector<Node> nodes;
+		uint32_t root = k_nullProxy;
+		uint32_t freeList = k_nullProxy;
+		size_t proxyCount = 0;
+		T margin;
+	};
+
+	template <typename T>
+	constexpr typename DynamicBvh<T>::ProxyId DynamicBvh<T>::k_nullProxy;
+
+	using DynamicBvhf = DynamicBvh<float>;
+	using DynamicBvhd = DynamicBvh<double>;
+}
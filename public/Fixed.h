@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include <MathTemplateUtil.h>
+#include <Vector.h>
+#include <Matrix.h>
+#include <Quaternion.h>
+
+namespace Math
+{
+	// Signed fixed-point scalar with IntBits integer bits (including the sign) and
+	// FracBits fractional bits, stored in 32 bits.
+	//
+	// All arithmetic, including Sqrt<T> and the trigonometric functions, is done in
+	// integer registers, so results are bit-identical across compilers, flags and
+	// platforms. Products round to nearest, quotients truncate toward zero, and
+	// overflow wraps to IntBits + FracBits bits. Conversions from float are only deterministic for values that
+	// are themselves deterministic, so convert once at load time rather than per step.
+	template <int IntBits, int FracBits>
+	class Fixed
+	{
+		static_assert(IntBits > 0 && FracBits > 0, "Fixed needs at least one integer and one fractional bit");
+		static_assert(IntBits + FracBits <= 32, "Fixed is limited to 32 bits of storage");
+
+	public:
+		using RawType = int32_t;
+		static constexpr int k_intBits = IntBits;
+		static constexpr int k_fracBits = FracBits;
+		static constexpr RawType k_one = static_cast<RawType>(int64_t(1) << FracBits);
+
+	public:
+		constexpr Fixed()
+			: raw(0)
+		{
+		}
+
+		// Integers in range convert exactly, so this is implicit; others wrap like any
+		// overflow. It is a template so floats cannot silently truncate through it on
+		// their way to an operator.
+		template <typename I, typename = typename std::enable_if<std::is_integral<I>::value>::type>
+		constexpr Fixed(const I value)
+			: raw(WrapBits(static_cast<uint64_t>(value) << FracBits))
+		{
+		}
+
+		explicit Fixed(const float value)
+			: raw(static_cast<RawType>(value * static_cast<float>(k_one) + (value < 0.f ? -0.5f : 0.5f)))
+		{
+		}
+
+		explicit Fixed(const double value)
+			: raw(static_cast<RawType>(value * static_cast<double>(k_one) + (value < 0.0 ? -0.5 : 0.5)))
+		{
+		}
+
+		static constexpr Fixed FromRaw(const RawType value)
+		{
+			Fixed f;
+			f.raw = value;
+			return f;
+		}
+
+		constexpr RawType GetRaw() const
+		{
+			return raw;
+		}
+
+		float ToFloat() const
+		{
+			return static_cast<float>(raw) * (1.f / static_cast<float>(k_one));
+		}
+
+		double ToDouble() const
+		{
+			return static_cast<double>(raw) * (1.0 / static_cast<double>(k_one));
+		}
+
+		// Rounds toward negative infinity
+		int ToInt() const
+		{
+			return static_cast<int>(raw >> FracBits);
+		}
+
+		Fixed operator-() const
+		{
+			return FromRaw(Wrap(-static_cast<int64_t>(raw)));
+		}
+
+		Fixed& operator+=(const Fixed rhs)
+		{
+			raw = Wrap(static_cast<int64_t>(raw) + rhs.raw);
+			return *this;
+		}
+
+		Fixed& operator-=(const Fixed rhs)
+		{
+			raw = Wrap(static_cast<int64_t>(raw) - rhs.raw);
+			return *this;
+		}
+
+		Fixed& operator*=(const Fixed rhs)
+		{
+			const int64_t product = static_cast<int64_t>(raw) * rhs.raw;
+			raw = Wrap((product + (int64_t(1) << (FracBits - 1))) >> FracBits);
+			return *this;
+		}
+
+		Fixed& operator/=(const Fixed rhs)
+		{
+			assert(rhs.raw != 0);
+			raw = Wrap((static_cast<int64_t>(raw) * k_one) / rhs.raw);
+			return *this;
+		}
+
+		// Hidden friends, so mixed Fixed/int expressions convert the int implicitly
+		friend Fixed operator+(Fixed lhs, const Fixed rhs) { return lhs += rhs; }
+		friend Fixed operator-(Fixed lhs, const Fixed rhs) { return lhs -= rhs; }
+		friend Fixed operator*(Fixed lhs, const Fixed rhs) { return lhs *= rhs; }
+		friend Fixed operator/(Fixed lhs, const Fixed rhs) { return lhs /= rhs; }
+
+		friend bool operator==(const Fixed lhs, const Fixed rhs) { return lhs.raw == rhs.raw; }
+		friend bool operator!=(const Fixed lhs, const Fixed rhs) { return lhs.raw != rhs.raw; }
+		friend bool operator<(const Fixed lhs, const Fixed rhs) { return lhs.raw < rhs.raw; }
+		friend bool operator<=(const Fixed lhs, const Fixed rhs) { return lhs.raw <= rhs.raw; }
+		friend bool operator>(const Fixed lhs, const Fixed rhs) { return lhs.raw > rhs.raw; }
+		friend bool operator>=(const Fixed lhs, const Fixed rhs) { return lhs.raw >= rhs.raw; }
+
+	private:
+		// Two's complement wrap to IntBits + FracBits bits, sign-extended to RawType and
+		// spelled out so it is well defined
+		static constexpr RawType Wrap(const int64_t value)
+		{
+			return WrapBits(static_cast<uint64_t>(value));
+		}
+
+		static constexpr RawType WrapBits(const uint64_t bits)
+		{
+			constexpr uint64_t k_sign = uint64_t(1) << (IntBits + FracBits - 1);
+			constexpr uint64_t k_mask = (k_sign << 1) - 1;
+			return static_cast<RawType>(static_cast<int64_t>((bits & k_mask) ^ k_sign) - static_cast<int64_t>(k_sign));
+		}
+
+	private:
+		RawType raw;
+	};
+
+	// 16.16 is the format used for lockstep simulation state
+	using Fixed32 = Fixed<16, 16>;
+
+	using Vector2x = Vector2<Fixed32>;
+	using Vector3x = Vector3<Fixed32>;
+	using Vector4x = Vector4<Fixed32>;
+	using Matrix3x3x = Matrix3x3<Fixed32>;
+	using Quaternionx = Quaternion<Fixed32>;
+
+	// Batched Fixed32 kernels, using SIMD integer arithmetic where available. Every
+	// kernel produces exactly the same bits as the equivalent scalar operators, and
+	// may be performed in place. Chunks of large batches run in parallel on executor,
+	// which leaves the results unchanged.
+	void Add(const Vector4x* lhs, const Vector4x* rhs, Vector4x* out, size_t count, Executor* executor = nullptr);
+	void Subtract(const Vector4x* lhs, const Vector4x* rhs, Vector4x* out, size_t count, Executor* executor = nullptr);
+	void Multiply(const Vector4x* lhs, const Vector4x* rhs, Vector4x* out, size_t count, Executor* executor = nullptr);
+	void Scale(const Vector4x* src, const Fixed32 scale, Vector4x* out, size_t count, Executor* executor = nullptr);
+	void Dot(const Vector4x* lhs, const Vector4x* rhs, Fixed32* out, size_t count, Executor* executor = nullptr);
+	void Dot(const Vector3x* lhs, const Vector3x* rhs, Fixed32* out, size_t count, Executor* executor = nullptr);
+
+	// out[i] = m * src[i], matching Matrix3x3::operator*(const Vector3&)
+	void Transform(const Matrix3x3x& m, const Vector3x* src, Vector3x* out, size_t count, Executor* executor = nullptr);
+
+	// out[i] = lhs[i] * rhs[i], matching the Quaternion product
+	void Multiply(const Quaternionx* lhs, const Quaternionx* rhs, Quaternionx* out, size_t count, Executor* executor = nullptr);
+}
+
+namespace std
+{
+	template <int IntBits, int FracBits>
+	class numeric_limits<Math::Fixed<IntBits, FracBits>>
+	{
+		using Type = Math::Fixed<IntBits, FracBits>;
+
+	public:
+		static constexpr bool is_specialized = true;
+		static constexpr bool is_signed = true;
+		static constexpr bool is_integer = false;
+		static constexpr bool is_exact = true;
+		static constexpr bool has_infinity = false;
+		static constexpr bool has_quiet_NaN = false;
+		static constexpr bool is_bounded = true;
+		static constexpr bool is_modulo = true;
+		static constexpr int digits = IntBits + FracBits - 1;
+		static constexpr int radix = 2;
+
+		static constexpr Type min() { return Type::FromRaw(1); }
+		static constexpr Type lowest() { return Type::FromRaw(static_cast<int32_t>(-(int64_t(1) << digits))); }
+		static constexpr Type max() { return Type::FromRaw(static_cast<int32_t>((int64_t(1) << digits) - 1)); }
+		static constexpr Type epsilon() { return Type::FromRaw(1); }
+		static constexpr Type round_error() { return Type::FromRaw(1); }
+	};
+}
@@ -0,0 +1,453 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include <Vector.h>
+#include <Matrix.h>
+#include <MathTemplateUtil.h>
+
+namespace Math
+{
+	namespace GeometryDetail
+	{
+		// Same operand order as the SIMD Min and Max, so the scalar tests give the
+		// batched tests' answers even when a slab produces NaN
+		template <typename T>
+		T Min(const T a, const T b)
+		{
+			return a < b ? a : b;
+		}
+
+		template <typename T>
+		T Max(const T a, const T b)
+		{
+			return a > b ? a : b;
+		}
+
+		// Added to the absolute rotation terms of the OBB separating axis test, so that
+		// near parallel edges don't produce a degenerate cross product axis
+		template <typename T>
+		T ObbEpsilon()
+		{
+			return std::numeric_limits<T>::epsilon() * static_cast<T>(16);
+		}
+	}
+
+	// Axis-aligned box
+	template <typename T>
+	struct Aabb
+	{
+		Vector3<T> min;
+		Vector3<T> max;
+
+		// An inverted box, which Expand and Merge grow from
+		static Aabb<T> Empty()
+		{
+			const T big = std::numeric_limits<T>::max();
+			return { Vector3<T>(big, big, big), Vector3<T>(-big, -big, -big) };
+		}
+
+		static Aabb<T> FromCenterExtents(const Vector3<T>& center, const Vector3<T>& halfExtents)
+		{
+			return { center - halfExtents, center + halfExtents };
+		}
+
+		Vector3<T> GetCenter() const
+		{
+			return (min + max) * static_cast<T>(0.5);
+		}
+
+		Vector3<T> GetHalfExtents() const
+		{
+			return (max - min) * static_cast<T>(0.5);
+		}
+
+		T GetSurfaceArea() const
+		{
+			const Vector3<T> d = max - min;
+			return static_cast<T>(2) * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		bool IsEmpty() const
+		{
+			return min.x > max.x || min.y > max.y || min.z > max.z;
+		}
+
+		bool Contains(const Vector3<T>& point) const
+		{
+			return point.x >= min.x && point.x <= max.x
+				&& point.y >= min.y && point.y <= max.y
+				&& point.z >= min.z && point.z <= max.z;
+		}
+
+		void Expand(const Vector3<T>& point)
+		{
+			for (size_t i = 0; i < 3; ++i)
+			{
+				min[i] = GeometryDetail::Min(min[i], point[i]);
+				max[i] = GeometryDetail::Max(max[i], point[i]);
+			}
+		}
+
+		void Merge(const Aabb<T>& other)
+		{
+			for (size_t i = 0; i < 3; ++i)
+			{
+				min[i] = GeometryDetail::Min(min[i], other.min[i]);
+				max[i] = GeometryDetail::Max(max[i], other.max[i]);
+			}
+		}
+	};
+
+	template <typename T>
+	struct Sphere
+	{
+		Vector3<T> center;
+		T radius;
+
+		bool Contains(const Vector3<T>& point) const
+		{
+			const Vector3<T> d = point - center;
+			return d.x * d.x + d.y * d.y + d.z * d.z <= radius * radius;
+		}
+	};
+
+	// Points p with Dot(normal, p) + distance == 0. The normal is expected to be unit
+	// length for SignedDistance to be a true distance.
+	template <typename T>
+	struct Plane
+	{
+		Vector3<T> normal;
+		T distance;
+
+		static Plane<T> FromPointNormal(const Vector3<T>& point, const Vector3<T>& normal)
+		{
+			return { normal, -Dot(normal, point) };
+		}
+
+		T SignedDistance(const Vector3<T>& point) const
+		{
+			return Dot(normal, point) + distance;
+		}
+
+		Plane<T> Normalized() const
+		{
+			const T invLength = static_cast<T>(1) / normal.Length();
+			return { normal * invLength, distance * invLength };
+		}
+	};
+
+	template <typename T>
+	struct Ray
+	{
+		Vector3<T> origin;
+		Vector3<T> direction;
+
+		Vector3<T> At(const T t) const
+		{
+			return origin + direction * t;
+		}
+
+		// Per-axis reciprocal used by the slab tests. Zero components give infinities,
+		// which the slab test handles for rays starting outside the slab.
+		Vector3<T> GetInverseDirection() const
+		{
+			const T one = static_cast<T>(1);
+			return Vector3<T>(one / direction.x, one / direction.y, one / direction.z);
+		}
+	};
+
+	// Oriented box. The columns of axes are the box's unit local axes in world space.
+	template <typename T>
+	struct Obb
+	{
+		Vector3<T> center;
+		Vector3<T> halfExtents;
+		Matrix3x3<T> axes;
+
+		static Obb<T> FromAabb(const Aabb<T>& box)
+		{
+			return { box.GetCenter(), box.GetHalfExtents(), Matrix3x3<T>::IDENTITY };
+		}
+
+		Vector3<T> GetAxis(const int i) const
+		{
+			return axes.GetColumn(i);
+		}
+
+		// Smallest axis-aligned box holding this one
+		Aabb<T> GetBounds() const
+		{
+			Vector3<T> extents;
+			for (int row = 0; row < 3; ++row)
+			{
+				extents[row] = Abs(axes(row, 0)) * halfExtents.x + Abs(axes(row, 1)) * halfExtents.y
+					+ Abs(axes(row, 2)) * halfExtents.z;
+			}
+			return Aabb<T>::FromCenterExtents(center, extents);
+		}
+	};
+
+	using Aabbf = Aabb<float>;
+	using Aabbd = Aabb<double>;
+	using Spheref = Sphere<float>;
+	using Sphered = Sphere<double>;
+	using Planef = Plane<float>;
+	using Planed = Plane<double>;
+	using Rayf = Ray<float>;
+	using Rayd = Ray<double>;
+	using Obbf = Obb<float>;
+	using Obbd = Obb<double>;
+
+	// Axis-aligned bounds of a box under an affine transform (Arvo's method): each
+	// output axis takes the smaller and larger product of every matrix element
+	template <typename T, StorageOrder Order>
+	Aabb<T> TransformBounds(const Aabb<T>& box, const Matrix4x4<T, Order>& m)
+	{
+		Aabb<T> result;
+		for (int row = 0; row < 3; ++row)
+		{
+			result.min[row] = m(row, 3);
+			result.max[row] = m(row, 3);
+			for (int column = 0; column < 3; ++column)
+			{
+				const T a = m(row, column) * box.min[column];
+				const T b = m(row, column) * box.max[column];
+				result.min[row] += GeometryDetail::Min(a, b);
+				result.max[row] += GeometryDetail::Max(a, b);
+			}
+		}
+		return result;
+	}
+
+	// Scalar tests. Touching shapes overlap.
+
+	template <typename T>
+	bool Overlaps(const Aabb<T>& a, const Aabb<T>& b)
+	{
+		return a.min.x <= b.max.x && b.min.x <= a.max.x
+			&& a.min.y <= b.max.y && b.min.y <= a.max.y
+			&& a.min.z <= b.max.z && b.min.z <= a.max.z;
+	}
+
+	template <typename T>
+	bool Overlaps(const Sphere<T>& a, const Sphere<T>& b)
+	{
+		const Vector3<T> d = b.center - a.center;
+		const T radius = a.radius + b.radius;
+		return d.x * d.x + d.y * d.y + d.z * d.z <= radius * radius;
+	}
+
+	template <typename T>
+	bool Overlaps(const Aabb<T>& box, const Sphere<T>& sphere)
+	{
+		T distanceSq = static_cast<T>(0);
+		for (size_t i = 0; i < 3; ++i)
+		{
+			const T c = sphere.center[i];
+			const T d = c < box.min[i] ? box.min[i] - c : (c > box.max[i] ? c - box.max[i] : static_cast<T>(0));
+			distanceSq += d * d;
+		}
+		return distanceSq <= sphere.radius * sphere.radius;
+	}
+
+	// Separating axis test over the 15 candidate axes: the face normals of each box
+	// and the cross products of their edges
+	template <typename T>
+	bool Overlaps(const Obb<T>& a, const Obb<T>& b)
+	{
+		// Rotation of b and translation between centres, both in a's frame
+		T r[3][3];
+		T absR[3][3];
+		const T epsilon = GeometryDetail::ObbEpsilon<T>();
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				r[i][j] = a.axes(0, i) * b.axes(0, j) + a.axes(1, i) * b.axes(1, j) + a.axes(2, i) * b.axes(2, j);
+				absR[i][j] = Abs(r[i][j]) + epsilon;
+			}
+		}
+		const Vector3<T> d = b.center - a.center;
+		T t[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			t[i] = a.axes(0, i) * d.x + a.axes(1, i) * d.y + a.axes(2, i) * d.z;
+		}
+
+		const Vector3<T>& ea = a.halfExtents;
+		const Vector3<T>& eb = b.halfExtents;
+		for (int i = 0; i < 3; ++i)
+		{
+			const T rb = eb.x * absR[i][0] + eb.y * absR[i][1] + eb.z * absR[i][2];
+			if (Abs(t[i]) > ea[i] + rb)
+			{
+				return false;
+			}
+		}
+		for (int j = 0; j < 3; ++j)
+		{
+			const T ra = ea.x * absR[0][j] + ea.y * absR[1][j] + ea.z * absR[2][j];
+			if (Abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > ra + eb[j])
+			{
+				return false;
+			}
+		}
+		for (int i = 0; i < 3; ++i)
+		{
+			const int i1 = (i + 1) % 3;
+			const int i2 = (i + 2) % 3;
+			for (int j = 0; j < 3; ++j)
+			{
+				const int j1 = (j + 1) % 3;
+				const int j2 = (j + 2) % 3;
+				const T ra = ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j];
+				const T rb = eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1];
+				if (Abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Slab test against [0, tMax] along the ray. On a hit, tNear receives the entry
+	// distance, which is 0 when the ray starts inside the box.
+	template <typename T>
+	bool Intersect(const Ray<T>& ray, const Aabb<T>& box, const T tMax, T& tNear)
+	{
+		const Vector3<T> invDirection = ray.GetInverseDirection();
+		T nearT = static_cast<T>(0);
+		T farT = tMax;
+		for (size_t i = 0; i < 3; ++i)
+		{
+			const T t1 = (box.min[i] - ray.origin[i]) * invDirection[i];
+			const T t2 = (box.max[i] - ray.origin[i]) * invDirection[i];
+			nearT = GeometryDetail::Max(nearT, GeometryDetail::Min(t1, t2));
+			farT = GeometryDetail::Min(farT, GeometryDetail::Max(t1, t2));
+		}
+		if (nearT <= farT)
+		{
+			tNear = nearT;
+			return true;
+		}
+		return false;
+	}
+
+	// Nearest non-negative hit distance, 0 when the ray starts inside the sphere.
+	// The ray direction must be unit length.
+	template <typename T>
+	bool Intersect(const Ray<T>& ray, const Sphere<T>& sphere, T& t)
+	{
+		const Vector3<T> m = ray.origin - sphere.center;
+		const T b = Dot(m, ray.direction);
+		const T c = Dot(m, m) - sphere.radius * sphere.radius;
+		if (c > static_cast<T>(0) && b > static_cast<T>(0))
+		{
+			return false;
+		}
+		const T discriminant = b * b - c;
+		if (discriminant < static_cast<T>(0))
+		{
+			return false;
+		}
+		const T root = -b - Sqrt(discriminant);
+		t = root > static_cast<T>(0) ? root : static_cast<T>(0);
+		return true;
+	}
+
+	// Non-negative distance to the plane along the ray. Rays parallel to the plane miss.
+	template <typename T>
+	bool Intersect(const Ray<T>& ray, const Plane<T>& plane, T& t)
+	{
+		const T denominator = Dot(plane.normal, ray.direction);
+		if (Abs(denominator) <= std::numeric_limits<T>::epsilon())
+		{
+			return false;
+		}
+		const T hit = -plane.SignedDistance(ray.origin) / denominator;
+		if (hit < static_cast<T>(0))
+		{
+			return false;
+		}
+		t = hit;
+		return true;
+	}
+
+	// Structure-of-arrays inputs for the batched tests, one array per component so the
+	// kernels load a whole register of the same component at once. Kernel inputs take
+	// the const form, which the mutable form converts to.
+	template <typename T>
+	struct AabbSoA
+	{
+		T* min[3];
+		T* max[3];
+
+		template <typename U = T, typename = typename std::enable_if<!std::is_const<U>::value>::type>
+		operator AabbSoA<const U>() const
+		{
+			return { { min[0], min[1], min[2] }, { max[0], max[1], max[2] } };
+		}
+	};
+
+	template <typename T>
+	struct SphereSoA
+	{
+		T* center[3];
+		T* radius;
+
+		template <typename U = T, typename = typename std::enable_if<!std::is_const<U>::value>::type>
+		operator SphereSoA<const U>() const
+		{
+			return { { center[0], center[1], center[2] }, radius };
+		}
+	};
+
+	// axes holds the nine elements of Obb::axes in row-major order
+	template <typename T>
+	struct ObbSoA
+	{
+		T* center[3];
+		T* halfExtents[3];
+		T* axes[9];
+
+		template <typename U = T, typename = typename std::enable_if<!std::is_const<U>::value>::type>
+		operator ObbSoA<const U>() const
+		{
+			return {
+				{ center[0], center[1], center[2] },
+				{ halfExtents[0], halfExtents[1], halfExtents[2] },
+				{ axes[0], axes[1], axes[2], axes[3], axes[4], axes[5], axes[6], axes[7], axes[8] }
+			};
+		}
+	};
+
+	// The batched tests write one bit per element: bit i % 32 of hits[i / 32] is set
+	// when element i is hit. hits must hold GetMaskWordCount(count) words, all of which
+	// are overwritten.
+	inline size_t GetMaskWordCount(const size_t count)
+	{
+		return (count + 31) / 32;
+	}
+
+	inline bool IsMaskBitSet(const uint32_t* hits, const size_t i)
+	{
+		return ((hits[i / 32] >> (i % 32)) & 1u) != 0;
+	}
+
+	// Batched tests of one shape against count shapes, four at a time. Each bit agrees
+	// with the matching scalar test above.
+	void Intersect(const Rayf& ray, float tMax, const AabbSoA<const float>& boxes, size_t count, uint32_t* hits);
+	void Intersect(const Rayd& ray, double tMax, const AabbSoA<const double>& boxes, size_t count, uint32_t* hits);
+	void Overlaps(const Aabbf& box, const AabbSoA<const float>& boxes, size_t count, uint32_t* hits);
+	void Overlaps(const Aabbd& box, const AabbSoA<const double>& boxes, size_t count, uint32_t* hits);
+	void Overlaps(const Spheref& sphere, const SphereSoA<const float>& spheres, size_t count, uint32_t* hits);
+	void Overlaps(const Sphered& sphere, const SphereSoA<const double>& spheres, size_t count, uint32_t* hits);
+	void Overlaps(const Obbf& box, const ObbSoA<const float>& boxes, size_t count, uint32_t* hits);
+	void Overlaps(const Obbd& box, const ObbSoA<const double>& boxes, size_t count, uint32_t* hits);
+}
@@ -0,0 +1,959 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <Vector.h>
+#include <Matrix.h>
+#include <Geometry.h>
+#include <MathTemplateUtil.h>
+
+namespace Math
+{
+	// GJK and EPA narrowphase over convex shapes given as support mappings: any
+	// callable taking a direction and returning the shape's farthest point along it,
+	// as a Vector3<T>. The direction is not normalized and may be any length.
+	//
+	// GjkDistance finds the closest points of two shapes, GjkIntersect only whether
+	// they overlap, and GjkPenetration runs EPA on overlapping shapes to find the
+	// depth and direction that separates them.
+
+	// Search directions of the simplex GJK last finished on for a pair. The next call
+	// evaluates the supports along them again and starts from that simplex, which
+	// for shapes that only moved a little is already at or near the answer.
+	template <typename T>
+	struct GjkCache
+	{
+		Vector3<T> directions[4];
+		int count = 0;
+	};
+
+	template <typename T>
+	struct GjkResult
+	{
+		// Closest points on A and B. When the shapes overlap these are a common point.
+		Vector3<T> pointA;
+		Vector3<T> pointB;
+		T distance;
+		int iterations;
+		bool intersecting;
+	};
+
+	// Moving B by normal * depth, or A by the opposite, separates the shapes. pointA is
+	// the point of A deepest inside B and pointB the point of B deepest inside A, so
+	// pointA - pointB is normal * depth.
+	template <typename T>
+	struct GjkContact
+	{
+		Vector3<T> pointA;
+		Vector3<T> pointB;
+		Vector3<T> normal;
+		T depth;
+		// False when EPA used up its iterations, or could not grow the polytope, before
+		// reaching its tolerance. The contact is then from the nearest face found, and the depth
+		// is an underestimate.
+		bool converged;
+	};
+
+	// Support mappings of the geometry primitives
+	template <typename T>
+	Vector3<T> GetSupport(const Sphere<T>& sphere, const Vector3<T>& direction)
+	{
+		const T lengthSq = direction.LengthSq();
+		if (lengthSq <= static_cast<T>(0))
+		{
+			return sphere.center;
+		}
+		return sphere.center + direction * (sphere.radius / Sqrt(lengthSq));
+	}
+
+	template <typename T>
+	Vector3<T> GetSupport(const Aabb<T>& box, const Vector3<T>& direction)
+	{
+		return Vector3<T>(direction.x >= static_cast<T>(0) ? box.max.x : box.min.x,
+			direction.y >= static_cast<T>(0) ? box.max.y : box.min.y,
+			direction.z >= static_cast<T>(0) ? box.max.z : box.min.z);
+	}
+
+	template <typename T>
+	Vector3<T> GetSupport(const Obb<T>& box, const Vector3<T>& direction)
+	{
+		Vector3<T> support = box.center;
+		for (int i = 0; i < 3; ++i)
+		{
+			const Vector3<T> axis = box.GetAxis(i);
+			const T extent = Dot(axis, direction) >= static_cast<T>(0) ? box.halfExtents[i] : -box.halfExtents[i];
+			support += axis * extent;
+		}
+		return support;
+	}
+
+	// Index of the first of count vertices, given as component arrays, with the
+	// largest dot product with direction
+	size_t FindSupportVertex(const float* x, const float* y, const float* z, size_t count, const Vector3f& direction);
+	size_t FindSupportVertex(const double* x, const double* y, const double* z, size_t count, const Vector3d& direction);
+
+	// Convex polyhedron given by its vertices in local space, placed by a rotation and
+	// a position. The support search tests four vertices at a time.
+	template <typename T>
+	struct ConvexHull
+	{
+		const T* x;
+		const T* y;
+		const T* z;
+		size_t count;
+		Matrix3x3<T> rotation;
+		Vector3<T> position;
+
+		Vector3<T> operator()(const Vector3<T>& direction) const
+		{
+			assert(count > 0);
+			const Vector3<T> local(Dot(rotation.GetColumn(0), direction), Dot(rotation.GetColumn(1), direction),
+				Dot(rotation.GetColumn(2), direction));
+			const size_t i = FindSupportVertex(x, y, z, count, local);
+			return rotation * Vector3<T>(x[i], y[i], z[i]) + position;
+		}
+	};
+
+	using ConvexHullf = ConvexHull<float>;
+	using ConvexHulld = ConvexHull<double>;
+
+	namespace GjkDetail
+	{
+		constexpr int k_maxIterations = 64;
+		// EPA expansions before it gives up, each adding a vertex to the polytope
+		constexpr int k_maxEpaIterations = 124;
+		constexpr int k_maxPolytopeVertices = 4 + k_maxEpaIterations;
+		// A closed triangulated polytope with V vertices has 2V - 4 faces, and a horizon
+		// is a simple loop through at most every vertex
+		constexpr int k_maxPolytopeFaces = 2 * k_maxPolytopeVertices - 4;
+		constexpr int k_maxHorizonEdges = k_maxPolytopeVertices;
+
+		// Relative tolerance of GJK's progress test on squared distances, and of its
+		// touching and flatness tests on distances
+		template <typename T>
+		T Tolerance()
+		{
+			return std::numeric_limits<T>::epsilon() * static_cast<T>(64);
+		}
+
+		// Relative tolerance EPA stops at, on distances
+		template <typename T>
+		T EpaTolerance()
+		{
+			return Sqrt(std::numeric_limits<T>::epsilon());
+		}
+
+		template <typename T>
+		Vector3<T> Negate(const Vector3<T>& v)
+		{
+			return Vector3<T>(-v.x, -v.y, -v.z);
+		}
+
+		// Point of the Minkowski difference A - B, with the points of A and B it came from
+		template <typename T>
+		struct Vertex
+		{
+			Vector3<T> w;
+			Vector3<T> a;
+			Vector3<T> b;
+			Vector3<T> direction;
+		};
+
+		template <typename T, typename SupportA, typename SupportB>
+		Vertex<T> GetVertex(const SupportA& supportA, const SupportB& supportB, const Vector3<T>& direction)
+		{
+			Vertex<T> vertex;
+			vertex.a = supportA(direction);
+			vertex.b = supportB(Negate(direction));
+			vertex.w = vertex.a - vertex.b;
+			vertex.direction = direction;
+			return vertex;
+		}
+
+		// Vertices with the barycentric weights of the point nearest the origin
+		template <typename T>
+		struct Simplex
+		{
+			Vertex<T> vertices[4];
+			T weights[4] = {};
+			int count = 0;
+
+			void Set(const Vertex<T>& a)
+			{
+				vertices[0] = a;
+				weights[0] = static_cast<T>(1);
+				count = 1;
+			}
+
+			void Set(const Vertex<T>& a, const Vertex<T>& b, const T u)
+			{
+				vertices[0] = a;
+				vertices[1] = b;
+				weights[0] = static_cast<T>(1) - u;
+				weights[1] = u;
+				count = 2;
+			}
+
+			void Set(const Vertex<T>& a, const Vertex<T>& b, const Vertex<T>& c, const T v, const T w)
+			{
+				vertices[0] = a;
+				vertices[1] = b;
+				vertices[2] = c;
+				weights[0] = static_cast<T>(1) - v - w;
+				weights[1] = v;
+				weights[2] = w;
+				count = 3;
+			}
+
+			Vector3<T> GetPoint() const
+			{
+				Vector3<T> point = vertices[0].w * weights[0];
+				for (int i = 1; i < count; ++i)
+				{
+					point += vertices[i].w * weights[i];
+				}
+				return point;
+			}
+
+			void GetWitnesses(Vector3<T>& pointA, Vector3<T>& pointB) const
+			{
+				pointA = vertices[0].a * weights[0];
+				pointB = vertices[0].b * weights[0];
+				for (int i = 1; i < count; ++i)
+				{
+					pointA += vertices[i].a * weights[i];
+					pointB += vertices[i].b * weights[i];
+				}
+			}
+
+			T GetMaxLengthSq() const
+			{
+				T maxLengthSq = static_cast<T>(0);
+				for (int i = 0; i < count; ++i)
+				{
+					const T lengthSq = vertices[i].w.LengthSq();
+					maxLengthSq = lengthSq > maxLengthSq ? lengthSq : maxLengthSq;
+				}
+				return maxLengthSq;
+			}
+
+			bool Contains(const Vector3<T>& w, const T toleranceSq) const
+			{
+				for (int i = 0; i < count; ++i)
+				{
+					if ((vertices[i].w - w).LengthSq() <= toleranceSq)
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+		};
+
+		template <typename T>
+		void ClosestOnSegment(const Vertex<T>& a, const Vertex<T>& b, Simplex<T>& out)
+		{
+			const Vector3<T> ab = b.w - a.w;
+			const T t = -Dot(a.w, ab);
+			const T lengthSq = ab.LengthSq();
+			if (t <= static_cast<T>(0))
+			{
+				out.Set(a);
+			}
+			else if (t >= lengthSq)
+			{
+				out.Set(b);
+			}
+			else
+			{
+				out.Set(a, b, t / lengthSq);
+			}
+		}
+
+		// Voronoi region search for the origin against a triangle (Ericson 5.1.5)
+		template <typename T>
+		void ClosestOnTriangle(const Vertex<T>& a, const Vertex<T>& b, const Vertex<T>& c, Simplex<T>& out)
+		{
+			const T zero = static_cast<T>(0);
+			const Vector3<T> ab = b.w - a.w;
+			const Vector3<T> ac = c.w - a.w;
+			const T d1 = -Dot(ab, a.w);
+			const T d2 = -Dot(ac, a.w);
+			if (d1 <= zero && d2 <= zero)
+			{
+				out.Set(a);
+				return;
+			}
+			const T d3 = -Dot(ab, b.w);
+			const T d4 = -Dot(ac, b.w);
+			if (d3 >= zero && d4 <= d3)
+			{
+				out.Set(b);
+				return;
+			}
+			const T vc = d1 * d4 - d3 * d2;
+			if (vc <= zero && d1 >= zero && d3 <= zero)
+			{
+				out.Set(a, b, d1 / (d1 - d3));
+				return;
+			}
+			const T d5 = -Dot(ab, c.w);
+			const T d6 = -Dot(ac, c.w);
+			if (d6 >= zero && d5 <= d6)
+			{
+				out.Set(c);
+				return;
+			}
+			const T vb = d5 * d2 - d1 * d6;
+			if (vb <= zero && d2 >= zero && d6 <= zero)
+			{
+				out.Set(a, c, d2 / (d2 - d6));
+				return;
+			}
+			const T va = d3 * d6 - d5 * d4;
+			if (va <= zero && d4 - d3 >= zero && d5 - d6 >= zero)
+			{
+				out.Set(b, c, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+				return;
+			}
+			const T denominator = va + vb + vc;
+			if (denominator <= zero)
+			{
+				// Collinear vertices: the nearest of the three edges
+				const Vertex<T>* ends[3][2] = { { &a, &b }, { &a, &c }, { &b, &c } };
+				T bestSq = std::numeric_limits<T>::max();
+				for (const auto& edge : ends)
+				{
+					Simplex<T> candidate = {};
+					ClosestOnSegment(*edge[0], *edge[1], candidate);
+					const T distanceSq = candidate.GetPoint().LengthSq();
+					if (distanceSq < bestSq)
+					{
+						bestSq = distanceSq;
+						out = candidate;
+					}
+				}
+				return;
+			}
+			out.Set(a, b, c, vb / denominator, vc / denominator);
+		}
+
+		// Volume of the tetrahedron (p, a, b, c) times six, positive when p is on the
+		// side of abc its winding faces away from
+		template <typename T>
+		T SignedVolume(const Vector3<T>& p, const Vector3<T>& a, const Vector3<T>& b, const Vector3<T>& c)
+		{
+			return Dot(a - p, Cross(b - p, c - p));
+		}
+
+		// Returns true when the origin is inside the tetrahedron, leaving it whole;
+		// otherwise reduces it to the nearest face, edge or vertex
+		template <typename T>
+		bool ClosestOnTetrahedron(Simplex<T>& simplex)
+		{
+			const Vertex<T> vertices[4] = { simplex.vertices[0], simplex.vertices[1], simplex.vertices[2], simplex.vertices[3] };
+			// Each face with the vertex opposite it
+			static const int k_faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+			const Vector3<T> origin;
+			// A nearly flat tetrahedron has no reliable inside, so every face is searched
+			T scaleSq = static_cast<T>(0);
+			for (int i = 1; i < 4; ++i)
+			{
+				const T lengthSq = (vertices[i].w - vertices[0].w).LengthSq();
+				scaleSq = lengthSq > scaleSq ? lengthSq : scaleSq;
+			}
+			const T volume = SignedVolume(vertices[0].w, vertices[1].w, vertices[2].w, vertices[3].w);
+			const T tolerance = Tolerance<T>();
+			const bool flat = volume * volume <= tolerance * tolerance * scaleSq * scaleSq * scaleSq;
+			bool inside = true;
+			T bestSq = std::numeric_limits<T>::max();
+			for (const int* face : k_faces)
+			{
+				const Vector3<T>& a = vertices[face[0]].w;
+				const Vector3<T>& b = vertices[face[1]].w;
+				const Vector3<T>& c = vertices[face[2]].w;
+				const T sideOrigin = SignedVolume(origin, a, b, c);
+				const T sideOpposite = SignedVolume(vertices[face[3]].w, a, b, c);
+				if (!flat && sideOrigin * sideOpposite >= static_cast<T>(0))
+				{
+					continue;
+				}
+				inside = false;
+				Simplex<T> candidate = {};
+				ClosestOnTriangle(vertices[face[0]], vertices[face[1]], vertices[face[2]], candidate);
+				const T distanceSq = candidate.GetPoint().LengthSq();
+				if (distanceSq < bestSq)
+				{
+					bestSq = distanceSq;
+					simplex = candidate;
+				}
+			}
+			if (inside)
+			{
+				simplex.weights[0] = SignedVolume(origin, vertices[1].w, vertices[2].w, vertices[3].w) / volume;
+				simplex.weights[1] = SignedVolume(vertices[0].w, origin, vertices[2].w, vertices[3].w) / volume;
+				simplex.weights[2] = SignedVolume(vertices[0].w, vertices[1].w, origin, vertices[3].w) / volume;
+				simplex.weights[3] = SignedVolume(vertices[0].w, vertices[1].w, vertices[2].w, origin) / volume;
+			}
+			return inside;
+		}
+
+		// Reduces the simplex to the smallest feature holding its point nearest the
+		// origin. Returns true when that point is the origin inside a tetrahedron.
+		template <typename T>
+		bool Solve(Simplex<T>& simplex)
+		{
+			switch (simplex.count)
+			{
+			case 1:
+				simplex.weights[0] = static_cast<T>(1);
+				return false;
+			case 2:
+			{
+				const Vertex<T> a = simplex.vertices[0];
+				const Vertex<T> b = simplex.vertices[1];
+				ClosestOnSegment(a, b, simplex);
+				return false;
+			}
+			case 3:
+			{
+				const Vertex<T> a = simplex.vertices[0];
+				const Vertex<T> b = simplex.vertices[1];
+				const Vertex<T> c = simplex.vertices[2];
+				ClosestOnTriangle(a, b, c, simplex);
+				return false;
+			}
+			default:
+				assert(simplex.count == 4);
+				return ClosestOnTetrahedron(simplex);
+			}
+		}
+
+		// Runs GJK from the cached simplex, or from a single vertex without one, and
+		// leaves the final simplex in simplex. With separation set it stops as soon as
+		// a separating axis is found, without finding the closest points. Returns
+		// whether the shapes overlap.
+		template <typename T, typename SupportA, typename SupportB>
+		bool Run(const SupportA& supportA, const SupportB& supportB, GjkCache<T>* cache, const bool separation,
+			Simplex<T>& simplex, int& iterations)
+		{
+			const T tolerance = Tolerance<T>();
+			simplex.count = 0;
+			if (cache != nullptr)
+			{
+				assert(cache->count >= 0 && cache->count <= 4);
+				for (int i = 0; i < cache->count; ++i)
+				{
+					const Vertex<T> vertex = GetVertex(supportA, supportB, cache->directions[i]);
+					if (!simplex.Contains(vertex.w, tolerance * vertex.w.LengthSq()))
+					{
+						simplex.vertices[simplex.count++] = vertex;
+					}
+				}
+			}
+			if (simplex.count == 0)
+			{
+				simplex.vertices[simplex.count++] = GetVertex(supportA, supportB, Vector3<T>(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0)));
+			}
+
+			bool intersecting = false;
+			T previousSq = std::numeric_limits<T>::max();
+			Simplex<T> previous = simplex;
+			for (iterations = 0; iterations < k_maxIterations; ++iterations)
+			{
+				if (Solve(simplex))
+				{
+					intersecting = true;
+					break;
+				}
+				const Vector3<T> v = simplex.GetPoint();
+				const T distanceSq = v.LengthSq();
+				if (distanceSq <= tolerance * tolerance * simplex.GetMaxLengthSq())
+				{
+					// Touching
+					intersecting = true;
+					break;
+				}
+				if (distanceSq >= previousSq)
+				{
+					// Rounding stopped the distance shrinking; the last vertex didn't help
+					simplex = previous;
+					break;
+				}
+				previousSq = distanceSq;
+
+				const Vertex<T> vertex = GetVertex(supportA, supportB, Negate(v));
+				const T progress = Dot(v, vertex.w);
+				if (separation && progress > static_cast<T>(0))
+				{
+					break;
+				}
+				// Nothing along -v is nearer the origin than v already is
+				if (distanceSq - progress <= tolerance * distanceSq || simplex.Contains(vertex.w, tolerance * distanceSq))
+				{
+					break;
+				}
+				previous = simplex;
+				simplex.vertices[simplex.count] = vertex;
+				simplex.weights[simplex.count] = static_cast<T>(0);
+				++simplex.count;
+			}
+
+			if (cache != nullptr)
+			{
+				cache->count = simplex.count;
+				for (int i = 0; i < simplex.count; ++i)
+				{
+					cache->directions[i] = simplex.vertices[i].direction;
+				}
+			}
+			return intersecting;
+		}
+
+		template <typename T>
+		struct Face
+		{
+			int vertices[3];
+			// Face across each edge, from vertices[e] to vertices[(e + 1) % 3]
+			int neighbours[3];
+			Vector3<T> normal;
+			T distance;
+			bool alive;
+		};
+
+		// Polytope edge on the boundary of the faces a new vertex can see, with the face
+		// beyond it that stays
+		struct HorizonEdge
+		{
+			int from;
+			int to;
+			int outside;
+			int outsideEdge;
+		};
+
+		// Convex polytope inside the Minkowski difference, with outward faces, that EPA
+		// grows toward the difference's surface nearest the origin
+		template <typename T>
+		class Polytope
+		{
+		public:
+			Polytope(const Vertex<T>* initial, const int count)
+			{
+				assert(count == 4);
+				for (int i = 0; i < count; ++i)
+				{
+					vertices[i] = initial[i];
+				}
+				vertexCount = count;
+				// Wound so that vertex 3 is behind face 0, 1, 2, which makes every face
+				// below outward
+				if (Dot(Cross(vertices[1].w - vertices[0].w, vertices[2].w - vertices[0].w), vertices[3].w - vertices[0].w) > static_cast<T>(0))
+				{
+					const Vertex<T> swap = vertices[1];
+					vertices[1] = vertices[2];
+					vertices[2] = swap;
+				}
+				const int corners[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+				for (int f = 0; f < 4; ++f)
+				{
+					SetFace(f, corners[f][0], corners[f][1], corners[f][2]);
+				}
+				faceCount = 4;
+				aliveCount = 4;
+
+				// Neighbours share an edge, which runs the opposite way in each
+				for (int f = 0; f < 4; ++f)
+				{
+					for (int e = 0; e < 3; ++e)
+					{
+						const int from = faces[f].vertices[e];
+						const int to = faces[f].vertices[(e + 1) % 3];
+						for (int g = 0; g < 4; ++g)
+						{
+							for (int k = 0; k < 3; ++k)
+							{
+								if (faces[g].vertices[k] == to && faces[g].vertices[(k + 1) % 3] == from)
+								{
+									faces[f].neighbours[e] = g;
+								}
+							}
+						}
+					}
+				}
+			}
+
+			int GetClosestFace() const
+			{
+				int closest = -1;
+				for (int i = 0; i < faceCount; ++i)
+				{
+					if (faces[i].alive && (closest < 0 || faces[i].distance < faces[closest].distance))
+					{
+						closest = i;
+					}
+				}
+				return closest;
+			}
+
+			const Face<T>& GetFace(const int i) const
+			{
+				return faces[i];
+			}
+
+			const Vertex<T>& GetVertex(const int i) const
+			{
+				return vertices[i];
+			}
+
+			bool HasVertex(const Vector3<T>& w, const T toleranceSq) const
+			{
+				for (int i = 0; i < vertexCount; ++i)
+				{
+					if ((vertices[i].w - w).LengthSq() <= toleranceSq)
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			// Adds vertex, replacing the faces it can see with a fan from their boundary.
+			// The faces are flood-filled from closest, which the vertex must see, so
+			// they are one patch and the polytope stays convex. Returns false, leaving
+			// the polytope alone, when the horizon is not a single loop or the fan would
+			// not fit.
+			bool Expand(const int closest, const Vertex<T>& vertex)
+			{
+				if (vertexCount == k_maxPolytopeVertices)
+				{
+					return false;
+				}
+
+				// Depth-first over the visible faces, which walks the horizon in order
+				struct Visit
+				{
+					int face;
+					int edge;
+					int remaining;
+				};
+				bool removed[k_maxPolytopeFaces] = {};
+				Visit stack[k_maxPolytopeFaces];
+				HorizonEdge horizon[k_maxHorizonEdges];
+				int depth = 0;
+				int horizonCount = 0;
+				int removedCount = 1;
+				removed[closest] = true;
+				stack[depth++] = { closest, 0, 3 };
+				while (depth > 0)
+				{
+					Visit& visit = stack[depth - 1];
+					if (visit.remaining == 0)
+					{
+						--depth;
+						continue;
+					}
+					const int e = visit.edge;
+					visit.edge = (e + 1) % 3;
+					--visit.remaining;
+
+					const Face<T>& face = faces[visit.face];
+					const int next = face.neighbours[e];
+					if (removed[next])
+					{
+						continue;
+					}
+					int back = 0;
+					while (faces[next].neighbours[back] != visit.face)
+					{
+						++back;
+					}
+					if (IsVisible(faces[next], vertex.w))
+					{
+						removed[next] = true;
+						++removedCount;
+						stack[depth++] = { next, (back + 1) % 3, 2 };
+					}
+					else
+					{
+						if (horizonCount == k_maxHorizonEdges)
+						{
+							return false;
+						}
+						horizon[horizonCount++] = { face.vertices[e], face.vertices[(e + 1) % 3], next, back };
+					}
+				}
+
+				if (horizonCount < 3 || aliveCount - removedCount + horizonCount > k_maxPolytopeFaces)
+				{
+					return false;
+				}
+				for (int k = 0; k < horizonCount; ++k)
+				{
+					if (horizon[k].to != horizon[(k + 1) % horizonCount].from)
+					{
+						return false;
+					}
+				}
+
+				for (int f = 0; f < faceCount; ++f)
+				{
+					faces[f].alive = faces[f].alive && !removed[f];
+				}
+				aliveCount -= removedCount;
+
+				// New faces take the freed slots first
+				const int index = vertexCount++;
+				vertices[index] = vertex;
+				int created[k_maxHorizonEdges];
+				int slot = 0;
+				for (int k = 0; k < horizonCount; ++k)
+				{
+					while (slot < faceCount && faces[slot].alive)
+					{
+						++slot;
+					}
+					if (slot == faceCount)
+					{
+						++faceCount;
+					}
+					created[k] = slot;
+					SetFace(slot, horizon[k].from, horizon[k].to, index);
+					faces[slot].neighbours[0] = horizon[k].outside;
+					faces[horizon[k].outside].neighbours[horizon[k].outsideEdge] = slot;
+				}
+				for (int k = 0; k < horizonCount; ++k)
+				{
+					faces[created[k]].neighbours[1] = created[(k + 1) % horizonCount];
+					faces[created[k]].neighbours[2] = created[(k + horizonCount - 1) % horizonCount];
+				}
+				aliveCount += horizonCount;
+				return true;
+			}
+
+		private:
+			bool IsVisible(const Face<T>& face, const Vector3<T>& w) const
+			{
+				return Dot(face.normal, w - vertices[face.vertices[0]].w) > static_cast<T>(0);
+			}
+
+			void SetFace(const int f, const int a, const int b, const int c)
+			{
+				const Vector3<T> normal = Cross(vertices[b].w - vertices[a].w, vertices[c].w - vertices[a].w);
+				const T length = normal.Length();
+				Face<T>& face = faces[f];
+				face.vertices[0] = a;
+				face.vertices[1] = b;
+				face.vertices[2] = c;
+				face.alive = true;
+				if (length > static_cast<T>(0))
+				{
+					face.normal = normal / length;
+					face.distance = Dot(face.normal, vertices[a].w);
+				}
+				else
+				{
+					// A sliver is never seen and never becomes the closest face
+					face.normal = Vector3<T>();
+					face.distance = std::numeric_limits<T>::max();
+				}
+			}
+
+		private:
+			Vertex<T> vertices[k_maxPolytopeVertices];
+			Face<T> faces[k_maxPolytopeFaces];
+			int vertexCount = 0;
+			// Slots in use, alive or freed
+			int faceCount = 0;
+			int aliveCount = 0;
+		};
+
+		// Grows a simplex holding the origin into a tetrahedron, searching along
+		// directions that leave its span. Returns false when the difference is flat.
+		template <typename T, typename SupportA, typename SupportB>
+		bool MakeTetrahedron(const SupportA& supportA, const SupportB& supportB, Simplex<T>& simplex)
+		{
+			const T zero = static_cast<T>(0);
+			const T one = static_cast<T>(1);
+			const T tolerance = EpaTolerance<T>();
+			const T scaleSq = simplex.GetMaxLengthSq();
+			while (simplex.count < 4)
+			{
+				Vector3<T> directions[6];
+				int directionCount = 0;
+				const Vector3<T>& origin = simplex.vertices[0].w;
+				if (simplex.count == 1)
+				{
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						Vector3<T> direction;
+						direction[axis] = one;
+						directions[directionCount++] = direction;
+						directions[directionCount++] = Negate(direction);
+					}
+				}
+				else if (simplex.count == 2)
+				{
+					// Perpendiculars of the segment, from the axis least aligned with it
+					const Vector3<T> segment = simplex.vertices[1].w - origin;
+					int axis = 0;
+					for (int i = 1; i < 3; ++i)
+					{
+						axis = Abs(segment[i]) < Abs(segment[axis]) ? i : axis;
+					}
+					Vector3<T> unit;
+					unit[axis] = one;
+					const Vector3<T> first = Cross(segment, unit);
+					const Vector3<T> second = Cross(segment, first);
+					directions[directionCount++] = first;
+					directions[directionCount++] = Negate(first);
+					directions[directionCount++] = second;
+					directions[directionCount++] = Negate(second);
+				}
+				else
+				{
+					const Vector3<T> normal = Cross(simplex.vertices[1].w - origin, simplex.vertices[2].w - origin);
+					directions[directionCount++] = normal;
+					directions[directionCount++] = Negate(normal);
+				}
+
+				bool grown = false;
+				for (int d = 0; d < directionCount && !grown; ++d)
+				{
+					const Vertex<T> vertex = GetVertex(supportA, supportB, directions[d]);
+					const Vector3<T> offset = vertex.w - origin;
+					T outsideSq;
+					if (simplex.count == 1)
+					{
+						outsideSq = offset.LengthSq();
+					}
+					else if (simplex.count == 2)
+					{
+						const Vector3<T> segment = simplex.vertices[1].w - origin;
+						outsideSq = Cross(offset, segment).LengthSq() / segment.LengthSq();
+					}
+					else
+					{
+						const Vector3<T> normal = Cross(simplex.vertices[1].w - origin, simplex.vertices[2].w - origin);
+						const T lengthSq = normal.LengthSq();
+						const T height = Dot(offset, normal);
+						outsideSq = lengthSq > zero ? height * height / lengthSq : zero;
+					}
+					if (outsideSq > tolerance * tolerance * scaleSq)
+					{
+						simplex.vertices[simplex.count++] = vertex;
+						grown = true;
+					}
+				}
+				if (!grown)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	template <typename T, typename SupportA, typename SupportB>
+	GjkResult<T> GjkDistance(const SupportA& supportA, const SupportB& supportB, GjkCache<T>* cache = nullptr)
+	{
+		GjkDetail::Simplex<T> simplex;
+		GjkResult<T> result;
+		result.intersecting = GjkDetail::Run(supportA, supportB, cache, false, simplex, result.iterations);
+		simplex.GetWitnesses(result.pointA, result.pointB);
+		result.distance = result.intersecting ? static_cast<T>(0) : (result.pointA - result.pointB).Length();
+		return result;
+	}
+
+	// Stops at the first separating axis, so it is cheaper than GjkDistance when the
+	// distance isn't needed
+	template <typename T, typename SupportA, typename SupportB>
+	bool GjkIntersect(const SupportA& supportA, const SupportB& supportB, GjkCache<T>* cache = nullptr)
+	{
+		GjkDetail::Simplex<T> simplex;
+		int iterations;
+		return GjkDetail::Run(supportA, supportB, cache, true, simplex, iterations);
+	}
+
+	// Returns false when the shapes don't overlap. Otherwise expands the GJK simplex
+	// with EPA to the face of the Minkowski difference nearest the origin, which
+	// gives the contact. Touching shapes give a depth near zero; shapes too flat to
+	// hold a tetrahedron at the contact give zero depth along the first axis tried.
+	// Curved shapes can exhaust EPA's budget, which contact.converged reports.
+	template <typename T, typename SupportA, typename SupportB>
+	bool GjkPenetration(const SupportA& supportA, const SupportB& supportB, GjkContact<T>& contact, GjkCache<T>* cache = nullptr)
+	{
+		GjkDetail::Simplex<T> simplex;
+		int iterations;
+		if (!GjkDetail::Run(supportA, supportB, cache, false, simplex, iterations))
+		{
+			return false;
+		}
+		if (!GjkDetail::MakeTetrahedron(supportA, supportB, simplex))
+		{
+			simplex.GetWitnesses(contact.pointA, contact.pointB);
+			contact.normal = Vector3<T>(static_cast<T>(1), static_cast<T>(0), static_cast<T>(0));
+			contact.depth = static_cast<T>(0);
+			contact.converged = true;
+			return true;
+		}
+
+		const T tolerance = GjkDetail::EpaTolerance<T>() * Sqrt(simplex.GetMaxLengthSq());
+		GjkDetail::Polytope<T> polytope(simplex.vertices, 4);
+		int closest = polytope.GetClosestFace();
+		contact.converged = false;
+		for (;;)
+		{
+			const GjkDetail::Face<T>& face = polytope.GetFace(closest);
+			const GjkDetail::Vertex<T> vertex = GjkDetail::GetVertex(supportA, supportB, face.normal);
+			// Done when the support point is no further than the face, or is one the
+			// polytope already has
+			if (Dot(vertex.w, face.normal) - face.distance <= tolerance || polytope.HasVertex(vertex.w, tolerance * tolerance))
+			{
+				contact.converged = true;
+				break;
+			}
+			if (!polytope.Expand(closest, vertex))
+			{
+				break;
+			}
+			closest = polytope.GetClosestFace();
+		}
+
+		// Barycentric weights of the origin's projection onto the closest face
+		const GjkDetail::Face<T>& face = polytope.GetFace(closest);
+		const GjkDetail::Vertex<T>& a = polytope.GetVertex(face.vertices[0]);
+		const GjkDetail::Vertex<T>& b = polytope.GetVertex(face.vertices[1]);
+		const GjkDetail::Vertex<T>& c = polytope.GetVertex(face.vertices[2]);
+		const Vector3<T> ab = b.w - a.w;
+		const Vector3<T> ac = c.w - a.w;
+		const Vector3<T> ap = face.normal * face.distance - a.w;
+		const T d00 = Dot(ab, ab);
+		const T d01 = Dot(ab, ac);
+		const T d11 = Dot(ac, ac);
+		const T d20 = Dot(ap, ab);
+		const T d21 = Dot(ap, ac);
+		const T denominator = d00 * d11 - d01 * d01;
+		T v = static_cast<T>(0);
+		T w = static_cast<T>(0);
+		if (denominator > static_cast<T>(0))
+		{
+			v = (d11 * d20 - d01 * d21) / denominator;
+			w = (d00 * d21 - d01 * d20) / denominator;
+		}
+		const T u = static_cast<T>(1) - v - w;
+		contact.pointA = a.a * u + b.a * v + c.a * w;
+		contact.pointB = a.b * u + b.b * v + c.b * w;
+		contact.normal = face.normal;
+		contact.depth = face.distance > static_cast<T>(0) ? face.distance : static_cast<T>(0);
+		return true;
+	}
+
+	// GjkDistance of a[i] against b[i] for each of count pairs, spread over the worker
+	// threads. caches is either null or holds one cache per pair, which warm-starts
+	// the pair and is updated.
+	void GjkDistance(const ConvexHullf* a, const ConvexHullf* b, size_t count, GjkCache<float>* caches, GjkResult<float>* results);
+	void GjkDistance(const ConvexHulld* a, const ConvexHulld* b, size_t count, GjkCache<double>* caches, GjkResult<double>* results);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Vector.h>
+#include <Matrix.h>
+#include <Quaternion.h>
+#include <StructuredMatrix.h>
+
+namespace Math
+{
+	// Scale, then rotate, then translate
+	template <typename T>
+	struct TrsTransform
+	{
+		Vector3<T> translation;
+		Quaternion<T> rotation;
+		Vector3<T> scale;
+
+		Matrix4x4<T> ToMatrix() const
+		{
+			return TranslationMatrix<T>(translation) * (RotationMatrix3<T>(rotation) * ScaleMatrix<T>(scale));
+		}
+	};
+
+	using TrsTransformf = TrsTransform<float>;
+
+	// Local-space bounding sphere shared by every instance of a mesh
+	struct InstanceBounds
+	{
+		Vector3f center;
+		float radius;
+	};
+
+	// Per-instance outputs of BuildInstances, each an array of count elements. Null
+	// outputs are skipped.
+	struct InstanceOutput
+	{
+		Matrix4x4f* mvp = nullptr;			// projection * view * model
+		Matrix3x3f* normal = nullptr;		// Inverse transpose of the model's upper-left 3x3, for world-space normals
+		uint8_t* visible = nullptr;			// 1 if the transformed bounds touch the view frustum, else 0
+	};
+
+	// Builds everything the renderer needs per instance in a single pass over the
+	// models, four instances at a time, instead of one pass per output.
+	//
+	// MVP matrices match (projection * view) * model with the scalar operators, and
+	// normal matrices match InverseTransposeClone. Culling tests the bounding sphere,
+	// scaled by the largest axis scale of the model, against the six planes of the
+	// [0, 1] depth frustum; it is conservative, never rejecting a visible instance.
+	// Models must be invertible if normal matrices are requested. out.mvp may alias models.
+	// Instances are chunked over executor.
+	void BuildInstances(const Matrix4x4f* models, size_t count, const Matrix4x4f& view, const PerspectiveMatrixf& projection,
+		const InstanceBounds& bounds, const InstanceOutput& out, Executor* executor = nullptr);
+
+	// As above, composing each model matrix from its transform on the fly
+	void BuildInstances(const TrsTransformf* transforms, size_t count, const Matrix4x4f& view, const PerspectiveMatrixf& projection,
+		const InstanceBounds& bounds, const InstanceOutput& out, Executor* executor = nullptr);
+}
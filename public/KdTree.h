@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <Vector.h>
+#include <View.h>
+
+namespace Math
+{
+	// Static k-d tree over a 2D or 3D point set, for nearest neighbour and radius
+	// queries.
+	//
+	// The tree is implicit: every node splits its range of points in half at the
+	// median along its widest axis, down to a fixed depth, so a node's children and
+	// range follow from its position and only the split planes are stored. The points
+	// are copied in tree order as component arrays, and queries scan each leaf four
+	// points at a time. Subtrees below the first few levels are built in parallel;
+	// the result does not depend on the number of threads.
+	template <typename T, int N>
+	class KdTree
+	{
+	public:
+		static_assert(N == 2 || N == 3, "KdTree supports 2D and 3D points");
+
+		using VectorType = typename ViewDetail::VectorOf<T, N>::Type;
+
+		static constexpr uint32_t k_noPoint = 0xFFFFFFFFu;
+		// Most points a leaf holds
+		static constexpr size_t k_leafSize = 8;
+
+		struct Neighbour
+		{
+			uint32_t index;
+			T distanceSq;
+		};
+
+	public:
+		// Rebuilds the tree over points. Queries report positions in this span.
+		void Build(const VectorSpan<const T, N>& points);
+
+		size_t GetPointCount() const
+		{
+			return indices.size();
+		}
+
+		// Levels of interior nodes above the leaves
+		int GetDepth() const
+		{
+			return depth;
+		}
+
+		// Finds up to k points nearest center within maxRadius. Writes them to
+		// nearest, nearest first, and returns how many there were.
+		size_t FindNearest(const VectorType& center, size_t k, Neighbour* nearest,
+			T maxRadius = std::numeric_limits<T>::infinity()) const;
+
+		// FindNearest for every point in centers, spread over the worker threads. Each
+		// query gets k entries of nearest, with the unused ones set to k_noPoint.
+		void FindNearest(const VectorSpan<const T, N>& centers, size_t k, Neighbour* nearest,
+			T maxRadius = std::numeric_limits<T>::infinity()) const;
+
+		// Appends every point within radius of center to found, in tree order
+		void FindWithin(const VectorType& center, T radius, std::vector<Neighbour>& found) const;
+
+		// FindWithin for every point in centers, spread over the worker threads. The
+		// points found for query q are found[offsets[q]] up to found[offsets[q + 1]].
+		void FindWithin(const VectorSpan<const T, N>& centers, T radius, std::vector<size_t>& offsets,
+			std::vector<Neighbour>& found) const;
+
+	private:
+		// Range of points and lower bound on the squared distance to them of a node
+		// waiting on the traversal stack
+		struct Entry
+		{
+			uint32_t node;
+			uint32_t first;
+			uint32_t last;
+			T boundSq;
+		};
+
+		void SplitNode(uint32_t* order, const VectorSpan<const T, N>& points, uint32_t node, size_t first, size_t last);
+		void BuildNode(uint32_t* order, const VectorSpan<const T, N>& points, uint32_t node, size_t first, size_t last, int level);
+
+		// Visits the leaves that may hold points within the current limit of center,
+		// nearest side first. limit() is read again after every leaf.
+		template <typename Limit, typename Visit>
+		void Traverse(const VectorType& center, Limit limit, Visit visit) const;
+
+	private:
+		// Points in tree order, each array padded to a whole block
+		std::vector<T> components[N];
+		std::vector<uint32_t> indices;
+		// Split plane of each interior node, in breadth-first order
+		std::vector<T> splits;
+		std::vector<uint8_t> splitAxes;
+		int depth = 0;
+	};
+
+	template <typename T, int N>
+	constexpr uint32_t KdTree<T, N>::k_noPoint;
+	template <typename T, int N>
+	constexpr size_t KdTree<T, N>::k_leafSize;
+
+	using KdTree2f = KdTree<float, 2>;
+	using KdTree2d = KdTree<double, 2>;
+	using KdTree3f = KdTree<float, 3>;
+	using KdTree3d = KdTree<double, 3>;
+}
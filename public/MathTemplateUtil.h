@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
+#include <cassert>
 #include <MathUtil.h>
 
 namespace Math
@@ -8,32 +10,64 @@ namespace Math
 	static constexpr float k_invSqrt2f = 0.7071067811865475244008443621048490f;
 	static constexpr float k_fltPi = 3.14159265358979323846264338327950288f;
 
+	// Scalar types without a standard library implementation (such as Fixed) provide
+	// their functions by specializing ScalarFunctions<T>.
 	template <typename T>
-	inline T Sqrt(const T arg);
+	struct ScalarFunctions;
 
 	template <typename T>
-	T Abs(const T arg);
+	inline T Sqrt(const T arg)
+	{
+		return ScalarFunctions<T>::Sqrt(arg);
+	}
+
+	template <typename T>
+	T Abs(const T arg)
+	{
+		return ScalarFunctions<T>::Abs(arg);
+	}
 
 	template <typename T>
-	T Sin(const T arg);
+	T Sin(const T arg)
+	{
+		return ScalarFunctions<T>::Sin(arg);
+	}
 
 	template <typename T>
-	T Cos(const T arg);
+	T Cos(const T arg)
+	{
+		return ScalarFunctions<T>::Cos(arg);
+	}
 
 	template <typename T>
-	T Tan(const T arg);
+	T Tan(const T arg)
+	{
+		return ScalarFunctions<T>::Tan(arg);
+	}
 
 	template <typename T>
-	T Asin(const T arg);
+	T Asin(const T arg)
+	{
+		return ScalarFunctions<T>::Asin(arg);
+	}
 
 	template <typename T>
-	T Acos(const T arg);
+	T Acos(const T arg)
+	{
+		return ScalarFunctions<T>::Acos(arg);
+	}
 
 	template <typename T>
-	T Atan(const T arg);
+	T Atan(const T arg)
+	{
+		return ScalarFunctions<T>::Atan(arg);
+	}
 
 	template <typename T>
-	T Atan2(const T arg1, const T arg2);	
+	T Atan2(const T arg1, const T arg2)
+	{
+		return ScalarFunctions<T>::Atan2(arg1, arg2);
+	}
 
 // Sqrt specializations
 	template <>
@@ -146,4 +180,224 @@ namespace Math
 	{
 		return std::atan2(arg1, arg2);
 	}
+
+// Fixed-point specializations
+	template <int IntBits, int FracBits>
+	class Fixed;
+
+	// Integer-only kernels shared by every Fixed format. Angles and results are
+	// carried in Q30 with 64-bit intermediates, so they are bit-identical on every
+	// compiler, flag set and platform.
+	namespace FixedDetail
+	{
+		static constexpr int64_t k_oneQ30 = int64_t(1) << 30;
+		static constexpr int64_t k_piQ30 = 3373259426;
+		static constexpr int64_t k_halfPiQ30 = 1686629713;
+		static constexpr int64_t k_quarterPiQ30 = 843314857;
+		static constexpr int64_t k_turnsPerRadianQ32 = 683565276;	// 2^32 / 2pi
+
+		inline int64_t MulQ30(const int64_t a, const int64_t b)
+		{
+			return (a * b + (int64_t(1) << 29)) >> 30;
+		}
+
+		inline int64_t DivQ30(const int64_t a, const int64_t b)
+		{
+			assert(b != 0);
+			return (a * k_oneQ30) / b;
+		}
+
+		// Round-to-nearest integer square root
+		inline uint64_t Isqrt(uint64_t v)
+		{
+			uint64_t result = 0;
+			uint64_t bit = uint64_t(1) << 62;
+			while (bit > v)
+			{
+				bit >>= 2;
+			}
+			while (bit != 0)
+			{
+				if (v >= result + bit)
+				{
+					v -= result + bit;
+					result = (result >> 1) + bit;
+				}
+				else
+				{
+					result >>= 1;
+				}
+				bit >>= 2;
+			}
+			return v > result ? result + 1 : result;
+		}
+
+		// sin(pi/2 * u) for u in [0, 1], Taylor series to u^11 (error < 6e-8)
+		inline int64_t SinQuarterQ30(const int64_t u)
+		{
+			const int64_t u2 = MulQ30(u, u);
+			int64_t poly = -3864;
+			poly = 172272 + MulQ30(u2, poly);
+			poly = -5026995 + MulQ30(u2, poly);
+			poly = 85569306 + MulQ30(u2, poly);
+			poly = -693598668 + MulQ30(u2, poly);
+			poly = 1686629713 + MulQ30(u2, poly);
+			return MulQ30(u, poly);
+		}
+
+		// Sine of an angle expressed in turns, where 2^32 is a full revolution
+		inline int64_t SinTurnsQ30(const uint32_t phase)
+		{
+			const uint32_t quadrant = phase >> 30;
+			int64_t u = phase & 0x3FFFFFFFu;
+			if (quadrant & 1u)
+			{
+				u = k_oneQ30 - u;
+			}
+			const int64_t s = SinQuarterQ30(u);
+			return (quadrant & 2u) ? -s : s;
+		}
+
+		// atan(z) for |z| <= tan(pi/8), Taylor series to z^15 (error < 2e-8)
+		inline int64_t AtanSmallQ30(const int64_t z)
+		{
+			const int64_t z2 = MulQ30(z, z);
+			int64_t poly = -71582788;
+			poly = 82595525 + MulQ30(z2, poly);
+			poly = -97612893 + MulQ30(z2, poly);
+			poly = 119304647 + MulQ30(z2, poly);
+			poly = -153391689 + MulQ30(z2, poly);
+			poly = 214748365 + MulQ30(z2, poly);
+			poly = -357913941 + MulQ30(z2, poly);
+			poly = k_oneQ30 + MulQ30(z2, poly);
+			return MulQ30(z, poly);
+		}
+
+		// atan2 of two raw values sharing a scale, in Q30 radians
+		inline int64_t Atan2Q30(const int64_t y, const int64_t x)
+		{
+			const int64_t ax = x < 0 ? -x : x;
+			const int64_t ay = y < 0 ? -y : y;
+			if (ax == 0 && ay == 0)
+			{
+				return 0;
+			}
+
+			// Reduce to t in [0, 1], then to z in [-tan(pi/8), tan(pi/8)]
+			const bool swapped = ay > ax;
+			const int64_t t = swapped ? DivQ30(ax, ay) : DivQ30(ay, ax);
+			int64_t angle = 0;
+			if (t > 444759054)	// tan(pi/8) in Q30
+			{
+				angle = k_quarterPiQ30 + AtanSmallQ30(DivQ30(t - k_oneQ30, t + k_oneQ30));
+			}
+			else
+			{
+				angle = AtanSmallQ30(t);
+			}
+
+			if (swapped)
+			{
+				angle = k_halfPiQ30 - angle;
+			}
+			if (x < 0)
+			{
+				angle = k_piQ30 - angle;
+			}
+			return y < 0 ? -angle : angle;
+		}
+
+		template <int FracBits>
+		inline int64_t FromQ30(const int64_t v)
+		{
+			static_assert(FracBits <= 30, "Fixed trigonometry supports at most 30 fractional bits");
+			constexpr int shift = 30 - FracBits;
+			constexpr int64_t half = shift > 0 ? int64_t(1) << (shift > 0 ? shift - 1 : 0) : 0;
+			return (v + half) >> shift;
+		}
+	}
+
+	template <int IntBits, int FracBits>
+	struct ScalarFunctions<Fixed<IntBits, FracBits>>
+	{
+		using Type = Fixed<IntBits, FracBits>;
+
+		static Type Sqrt(const Type arg)
+		{
+			assert(arg.GetRaw() >= 0);
+			if (arg.GetRaw() <= 0)
+			{
+				return Type();
+			}
+			const uint64_t scaled = static_cast<uint64_t>(arg.GetRaw()) << FracBits;
+			return Type::FromRaw(static_cast<typename Type::RawType>(FixedDetail::Isqrt(scaled)));
+		}
+
+		static Type Abs(const Type arg)
+		{
+			return arg.GetRaw() < 0 ? -arg : arg;
+		}
+
+		static Type Sin(const Type arg)
+		{
+			return FromQ30(FixedDetail::SinTurnsQ30(ToTurns(arg)));
+		}
+
+		static Type Cos(const Type arg)
+		{
+			return FromQ30(FixedDetail::SinTurnsQ30(ToTurns(arg) + 0x40000000u));
+		}
+
+		// Saturates to the largest raw value of the sign of the sine where the tangent
+		// is out of range, including at exact quarter turns, where the cosine is 0
+		static Type Tan(const Type arg)
+		{
+			constexpr int64_t maxRaw = (int64_t(1) << (IntBits + FracBits - 1)) - 1;
+
+			const uint32_t turns = ToTurns(arg);
+			const int64_t s = FixedDetail::SinTurnsQ30(turns);
+			const int64_t c = FixedDetail::SinTurnsQ30(turns + 0x40000000u);
+			if (c == 0)
+			{
+				return Type::FromRaw(static_cast<typename Type::RawType>(s < 0 ? -maxRaw : maxRaw));
+			}
+			int64_t raw = FixedDetail::FromQ30<FracBits>(FixedDetail::DivQ30(s, c));
+			raw = raw > maxRaw ? maxRaw : raw;
+			raw = raw < -maxRaw ? -maxRaw : raw;
+			return Type::FromRaw(static_cast<typename Type::RawType>(raw));
+		}
+
+		static Type Asin(const Type arg)
+		{
+			return Atan2(arg, Sqrt(Type(1) - arg * arg));
+		}
+
+		static Type Acos(const Type arg)
+		{
+			return Atan2(Sqrt(Type(1) - arg * arg), arg);
+		}
+
+		static Type Atan(const Type arg)
+		{
+			return Atan2(arg, Type(1));
+		}
+
+		static Type Atan2(const Type arg1, const Type arg2)
+		{
+			return FromQ30(FixedDetail::Atan2Q30(arg1.GetRaw(), arg2.GetRaw()));
+		}
+
+	private:
+		// Radians to turns of a full revolution; wrapping to 32 bits reduces the range for free
+		static uint32_t ToTurns(const Type arg)
+		{
+			const int64_t scaled = static_cast<int64_t>(arg.GetRaw()) * FixedDetail::k_turnsPerRadianQ32;
+			return static_cast<uint32_t>((scaled + (int64_t(1) << (FracBits - 1))) >> FracBits);
+		}
+
+		static Type FromQ30(const int64_t v)
+		{
+			return Type::FromRaw(static_cast<typename Type::RawType>(FixedDetail::FromQ30<FracBits>(v)));
+		}
+	};
 }
\ No newline at end of file
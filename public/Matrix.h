@@ -2,377 +2,652 @@
 
 #include <Vector.h>
 #include <cassert>
+#include <type_traits>
 
 namespace Math
 {
-	template <typename T>
+	// Element storage order of a matrix. Matrices are always indexed (row, column) and
+	// multiply column vectors; only the memory layout changes.
+	enum class StorageOrder
+	{
+		RowMajor,		// Rows are contiguous, as in HLSL row_major and C arrays
+		ColumnMajor		// Columns are contiguous, as in GLSL and most GPU buffers
+	};
+
+	namespace MatrixDetail
+	{
+		// Adjugate and determinant of a row-major 3x3 matrix, by cofactor expansion
+		// along the first row. Shared with the batch kernels, like Adjugate4x4.
+		template <typename S>
+		S Adjugate3x3(const S* m, S* out)
+		{
+			out[0] = m[4] * m[8] - m[5] * m[7];
+			out[1] = m[2] * m[7] - m[1] * m[8];
+			out[2] = m[1] * m[5] - m[2] * m[4];
+			out[3] = m[5] * m[6] - m[3] * m[8];
+			out[4] = m[0] * m[8] - m[2] * m[6];
+			out[5] = m[2] * m[3] - m[0] * m[5];
+			out[6] = m[3] * m[7] - m[4] * m[6];
+			out[7] = m[1] * m[6] - m[0] * m[7];
+			out[8] = m[0] * m[4] - m[1] * m[3];
+			return m[0] * out[0] + m[1] * out[3] + m[2] * out[6];
+		}
+
+		// Adjugate and determinant of a row-major 4x4 matrix, by expansion in 2x2
+		// minors. Written over a generic scalar so the batch kernels can evaluate
+		// four matrices at once with exactly the same operations.
+		template <typename S>
+		S Adjugate4x4(const S* m, S* out)
+		{
+			const S s0 = m[0] * m[5] - m[4] * m[1];
+			const S s1 = m[0] * m[6] - m[4] * m[2];
+			const S s2 = m[0] * m[7] - m[4] * m[3];
+			const S s3 = m[1] * m[6] - m[5] * m[2];
+			const S s4 = m[1] * m[7] - m[5] * m[3];
+			const S s5 = m[2] * m[7] - m[6] * m[3];
+
+			const S c5 = m[10] * m[15] - m[14] * m[11];
+			const S c4 = m[9] * m[15] - m[13] * m[11];
+			const S c3 = m[9] * m[14] - m[13] * m[10];
+			const S c2 = m[8] * m[15] - m[12] * m[11];
+			const S c1 = m[8] * m[14] - m[12] * m[10];
+			const S c0 = m[8] * m[13] - m[12] * m[9];
+
+			out[0] = m[5] * c5 - m[6] * c4 + m[7] * c3;
+			out[1] = m[2] * c4 - m[1] * c5 - m[3] * c3;
+			out[2] = m[13] * s5 - m[14] * s4 + m[15] * s3;
+			out[3] = m[10] * s4 - m[9] * s5 - m[11] * s3;
+
+			out[4] = m[6] * c2 - m[4] * c5 - m[7] * c1;
+			out[5] = m[0] * c5 - m[2] * c2 + m[3] * c1;
+			out[6] = m[14] * s2 - m[12] * s5 - m[15] * s1;
+			out[7] = m[8] * s5 - m[10] * s2 + m[11] * s1;
+
+			out[8] = m[4] * c4 - m[5] * c2 + m[7] * c0;
+			out[9] = m[1] * c2 - m[0] * c4 - m[3] * c0;
+			out[10] = m[12] * s4 - m[13] * s2 + m[15] * s0;
+			out[11] = m[9] * s2 - m[8] * s4 - m[11] * s0;
+
+			out[12] = m[5] * c1 - m[4] * c3 - m[6] * c0;
+			out[13] = m[0] * c3 - m[1] * c1 + m[2] * c0;
+			out[14] = m[13] * s1 - m[12] * s3 - m[14] * s0;
+			out[15] = m[8] * s3 - m[9] * s1 + m[10] * s0;
+
+			return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+		}
+	}
+
+	template <typename T, StorageOrder Order = StorageOrder::RowMajor>
 	class Matrix3x3
 	{
 	public:
-		static const Matrix3x3<T> IDENTITY;
+		static const Matrix3x3 IDENTITY;
+		static constexpr StorageOrder k_order = Order;
+
+		// Rows are returned by reference from row-major matrices, and columns from
+		// column-major ones; the other direction is gathered into a copy
+		using RowType = typename std::conditional<Order == StorageOrder::RowMajor, const Vector3<T>&, Vector3<T>>::type;
+		using ColumnType = typename std::conditional<Order == StorageOrder::ColumnMajor, const Vector3<T>&, Vector3<T>>::type;
 
 	public:
-		Matrix3x3<T>()
+		Matrix3x3()
+		{
+		}
+
+		// Always takes rows, whatever the storage order
+		Matrix3x3(const Vector3<T>& r0, const Vector3<T>& r1, const Vector3<T>& r2)
+			: v{ MajorVector(r0, r1, r2, 0), MajorVector(r0, r1, r2, 1), MajorVector(r0, r1, r2, 2) }
+		{
+		}
+
+		static Matrix3x3 FromColumns(const Vector3<T>& c0, const Vector3<T>& c1, const Vector3<T>& c2)
+		{
+			return Matrix3x3(c0, c1, c2).Transposed();
+		}
+
+		// Converts between storage orders
+		template <StorageOrder Other>
+		explicit Matrix3x3(const Matrix3x3<T, Other>& m)
+		{
+			for (int row = 0; row < 3; ++row)
+			{
+				for (int column = 0; column < 3; ++column)
+				{
+					(*this)(row, column) = m(row, column);
+				}
+			}
+		}
+
+		T& operator()(const int row, const int column)
 		{
+			assert(row >= 0 && row < 3 && column >= 0 && column < 3);
+			return Order == StorageOrder::RowMajor ? v[row].e[column] : v[column].e[row];
 		}
 
-		Matrix3x3<T>(const Vector3<T>& r0, const Vector3<T>& r1, const Vector3<T>& r2)
-			: r{ r0, r1, r2 }
+		const T& operator()(const int row, const int column) const
 		{
+			assert(row >= 0 && row < 3 && column >= 0 && column < 3);
+			return Order == StorageOrder::RowMajor ? v[row].e[column] : v[column].e[row];
 		}
 
+		// Row i of a row-major matrix, or column i of a column-major one
 		Vector3<T>& operator[](const size_t element)
 		{
 			assert(element < 3);
-			return r[element];
+			return v[element];
 		}
 
-		Vector3<T> operator[](const size_t element) const
+		const Vector3<T>& operator[](const size_t element) const
 		{
 			assert(element < 3);
-			return r[element];
+			return v[element];
 		}
-		
-		bool operator==(const Matrix3x3<T>& rhs) const
+
+		bool operator==(const Matrix3x3& rhs) const
 		{
-			return r[0] == rhs.r[0] && r[1] == rhs.r[1] && r[2] == rhs.r[2];
+			return v[0] == rhs.v[0] && v[1] == rhs.v[1] && v[2] == rhs.v[2];
 		}
 
-		bool operator!=(const Matrix3x3<T>& rhs) const
+		bool operator!=(const Matrix3x3& rhs) const
 		{
 			return !(*this == rhs);
 		}
 
-		const Vector3<T>& GetRow(int i) const
+		RowType GetRow(int i) const
 		{
 			assert(i < 3 && i >= 0);
-			return  r[i];
+			return Line(i, std::integral_constant<bool, Order == StorageOrder::RowMajor>());
 		}
 
-		Vector3<T> GetColumn(int i) const
+		ColumnType GetColumn(int i) const
 		{
 			assert(i < 3 && i >= 0);
-			return { r[0].e[i], r[1].e[i], r[2].e[i] };
+			return Line(i, std::integral_constant<bool, Order == StorageOrder::ColumnMajor>());
 		}
 
-		Matrix3x3<T> operator+(const Matrix3x3<T>& rhs) const
+		// Element storage in Order, for views and batch kernels
+		T* Data()
 		{
-			return {
-				{ r[0] + rhs.r[0] },
-				{ r[1] + rhs.r[1] },
-				{ r[2] + rhs.r[2] }
-			};
+			return &v[0].e[0];
 		}
 
-		Matrix3x3<T> operator-(const Matrix3x3<T>& rhs) const
+		const T* Data() const
 		{
-			return {
-				{ r[0] - rhs.r[0] },
-				{ r[1] - rhs.r[1] },
-				{ r[2] - rhs.r[2] }
-			};
+			return &v[0].e[0];
 		}
 
-		Matrix3x3<T> operator*(const Matrix3x3<T>& rhs) const
+		Matrix3x3 Transposed() const
 		{
-			return
+			Matrix3x3 t;
+			for (int row = 0; row < 3; ++row)
 			{
+				for (int column = 0; column < 3; ++column)
 				{
-					(r[0].x * rhs.r[0].x) + (r[0].y * rhs.r[1].x) + (r[0].z * rhs.r[2].x),
-					(r[0].x * rhs.r[0].y) + (r[0].y * rhs.r[1].y) + (r[0].z * rhs.r[2].y),
-					(r[0].x * rhs.r[0].z) + (r[0].y * rhs.r[1].z) + (r[0].z * rhs.r[2].z)
-				},
-				{
-					(r[1].x * rhs.r[0].x) + (r[1].y * rhs.r[1].x) + (r[1].z * rhs.r[2].x),
-					(r[1].x * rhs.r[0].y) + (r[1].y * rhs.r[1].y) + (r[1].z * rhs.r[2].y),
-					(r[1].x * rhs.r[0].z) + (r[1].y * rhs.r[1].z) + (r[1].z * rhs.r[2].z)
-				},
-				{
-					(r[2].x * rhs.r[0].x) + (r[2].y * rhs.r[1].x) + (r[2].z * rhs.r[2].x),
-					(r[2].x * rhs.r[0].y) + (r[2].y * rhs.r[1].y) + (r[2].z * rhs.r[2].y),
-					(r[2].x * rhs.r[0].z) + (r[2].y * rhs.r[1].z) + (r[2].z * rhs.r[2].z)
+					t(row, column) = (*this)(column, row);
 				}
-			};
+			}
+			return t;
 		}
 
-		Vector3<T> operator*(const Vector3<T>& rhs) const
+		Matrix3x3 operator+(const Matrix3x3& rhs) const
 		{
-			return
+			Matrix3x3 sum;
+			for (int i = 0; i < 3; ++i)
 			{
-				r[0].x * rhs.x + r[0].y * rhs.y + r[0].z * rhs.z,
-				r[1].x * rhs.x + r[1].y * rhs.y + r[1].z * rhs.z,
-				r[2].x * rhs.x + r[2].y * rhs.y + r[2].z * rhs.z
-			};
+				sum.v[i] = v[i] + rhs.v[i];
+			}
+			return sum;
 		}
 
-		Matrix3x3<T>& operator+=(const Matrix3x3<T>& rhs)
+		Matrix3x3 operator-(const Matrix3x3& rhs) const
 		{
-			r[0] += rhs.r[0];
-			r[1] += rhs.r[1];
-			r[2] += rhs.r[2];
-			return *this;
+			Matrix3x3 difference;
+			for (int i = 0; i < 3; ++i)
+			{
+				difference.v[i] = v[i] - rhs.v[i];
+			}
+			return difference;
 		}
 
-		Matrix3x3<T>& operator-=(const Matrix3x3<T>& rhs)
+		// Each element sums its products left to right, so every storage order and the
+		// batch kernels produce identical results
+		Matrix3x3 operator*(const Matrix3x3& rhs) const
 		{
-			r[0] -= rhs.r[0];
-			r[1] -= rhs.r[1];
-			r[2] -= rhs.r[2];
-			return *this;
+			Matrix3x3 product;
+			for (int row = 0; row < 3; ++row)
+			{
+				for (int column = 0; column < 3; ++column)
+				{
+					T sum = (*this)(row, 0) * rhs(0, column);
+					for (int k = 1; k < 3; ++k)
+					{
+						sum = sum + (*this)(row, k) * rhs(k, column);
+					}
+					product(row, column) = sum;
+				}
+			}
+			return product;
 		}
 
-		Matrix3x3<T>& operator*=(const Matrix3x3<T>& rhs)
+		Vector3<T> operator*(const Vector3<T>& rhs) const
 		{
-			r[0] =
+			Vector3<T> product;
+			for (int row = 0; row < 3; ++row)
 			{
-				(r[0].x * rhs.r[0].x) + (r[0].y * rhs.r[1].x) + (r[0].z * rhs.r[2].x),
-				(r[0].x * rhs.r[0].y) + (r[0].y * rhs.r[1].y) + (r[0].z * rhs.r[2].y),
-				(r[0].x * rhs.r[0].z) + (r[0].y * rhs.r[1].z) + (r[0].z * rhs.r[2].z)
-			};
+				T sum = (*this)(row, 0) * rhs.e[0];
+				for (int k = 1; k < 3; ++k)
+				{
+					sum = sum + (*this)(row, k) * rhs.e[k];
+				}
+				product.e[row] = sum;
+			}
+			return product;
+		}
 
-			r[1] = 
+		Matrix3x3& operator+=(const Matrix3x3& rhs)
+		{
+			for (int i = 0; i < 3; ++i)
 			{
-				(r[1].x * rhs.r[0].x) + (r[1].y * rhs.r[1].x) + (r[1].z * rhs.r[2].x),
-				(r[1].x * rhs.r[0].y) + (r[1].y * rhs.r[1].y) + (r[1].z * rhs.r[2].y),
-				(r[1].x * rhs.r[0].z) + (r[1].y * rhs.r[1].z) + (r[1].z * rhs.r[2].z)
-			};
+				v[i] += rhs.v[i];
+			}
+			return *this;
+		}
 
-			r[2] =
+		Matrix3x3& operator-=(const Matrix3x3& rhs)
+		{
+			for (int i = 0; i < 3; ++i)
 			{
-				(r[2].x * rhs.r[0].x) + (r[2].y * rhs.r[1].x) + (r[2].z * rhs.r[2].x),
-				(r[2].x * rhs.r[0].y) + (r[2].y * rhs.r[1].y) + (r[2].z * rhs.r[2].y),
-				(r[2].x * rhs.r[0].z) + (r[2].y * rhs.r[1].z) + (r[2].z * rhs.r[2].z)
-			};
+				v[i] -= rhs.v[i];
+			}
 			return *this;
 		}
 
-		Matrix3x3<T>& InverseSelf()
+		Matrix3x3& operator*=(const Matrix3x3& rhs)
 		{
-			const Vector3<T> cofactorVector(Cofactor(1, 1, 2, 2), Cofactor(1, 2, 2, 0), Cofactor(1, 0, 2, 1));
-			const T determinant = (*this)[0].Dot(cofactorVector);
-			assert(determinant != static_cast<T>(0));
-			const T s = static_cast<T>(1) / determinant;
-			*this = Matrix3x3<T>({ cofactorVector.x * s, Cofactor(0, 2, 2, 1) * s, Cofactor(0, 1, 1, 2) * s },
-				{ cofactorVector.y * s, Cofactor(0, 0, 2, 2) * s, Cofactor(0, 2, 1, 0) * s },
-				{ cofactorVector.z * s, Cofactor(0, 1, 2, 0) * s, Cofactor(0, 0, 1, 1) * s });
-			
+			*this = *this * rhs;
+			return *this;
+		}
+
+		// The adjugate and determinant of the transpose are the transpose of the adjugate
+		// and the same determinant, so these work on Data() in either storage order
+		Matrix3x3& InverseSelf()
+		{
+			*this = InverseClone();
 			return *this;
 		}
 
-		Matrix3x3<T> InverseClone() const
+		Matrix3x3 InverseClone() const
 		{
-			const Vector3<T> cofactorVector(Cofactor(1, 1, 2, 2), Cofactor(1, 2, 2, 0), Cofactor(1, 0, 2, 1));
-			const T determinant = (*this)[0].Dot(cofactorVector);
+			return ScaledAdjugate(false);
+		}
+
+		// Inverse transpose, which transforms normals by the transform this matrix applies to points
+		Matrix3x3 InverseTransposeClone() const
+		{
+			return ScaledAdjugate(true);
+		}
+
+		T Determinant() const
+		{
+			T adjugate[9];
+			return MatrixDetail::Adjugate3x3(Data(), adjugate);
+		}
+
+	private:
+		Matrix3x3 ScaledAdjugate(const bool transpose) const
+		{
+			T adjugate[9];
+			const T determinant = MatrixDetail::Adjugate3x3(Data(), adjugate);
 			assert(determinant != static_cast<T>(0));
 			const T s = static_cast<T>(1) / determinant;
-			return { { cofactorVector.x * s, Cofactor(0, 2, 2, 1) * s, Cofactor(0, 1, 1, 2) * s },
-				{ cofactorVector.y * s, Cofactor(0, 0, 2, 2) * s, Cofactor(0, 2, 1, 0) * s },
-				{ cofactorVector.z * s, Cofactor(0, 1, 2, 0) * s, Cofactor(0, 0, 1, 1) * s }
-			};
+
+			Matrix3x3 result;
+			T* e = result.Data();
+			for (int k = 0; k < 9; ++k)
+			{
+				e[k] = adjugate[transpose ? (k % 3) * 3 + k / 3 : k] * s;
+			}
+			return result;
 		}
 
+		// A stored vector returns by reference, a strided one is gathered
+		const Vector3<T>& Line(const int i, std::true_type) const
+		{
+			return v[i];
+		}
 
-	private:
-		T Cofactor(int r1, int c1, int r2, int c2) const
+		Vector3<T> Line(const int i, std::false_type) const
 		{
-			return r[r1][c1] * r[r2][c2] - r[r1][c2] * r[r2][c1];
+			return { v[0].e[i], v[1].e[i], v[2].e[i] };
 		}
-	private:
-		Vector3<T> r[3];
-	};
 
+		static Vector3<T> MajorVector(const Vector3<T>& r0, const Vector3<T>& r1, const Vector3<T>& r2, const int i)
+		{
+			return Order == StorageOrder::RowMajor
+				? (i == 0 ? r0 : i == 1 ? r1 : r2)
+				: Vector3<T>(r0.e[i], r1.e[i], r2.e[i]);
+		}
 
+	private:
+		// Rows, or columns for column-major storage
+		Vector3<T> v[3];
+	};
 
-	template <typename T>
+	template <typename T, StorageOrder Order = StorageOrder::RowMajor>
 	class Matrix4x4
 	{
 	public:
-		static const Matrix4x4<T> IDENTITY;
+		static const Matrix4x4 IDENTITY;
+		static constexpr StorageOrder k_order = Order;
+
+		// Rows are returned by reference from row-major matrices, and columns from
+		// column-major ones; the other direction is gathered into a copy
+		using RowType = typename std::conditional<Order == StorageOrder::RowMajor, const Vector4<T>&, Vector4<T>>::type;
+		using ColumnType = typename std::conditional<Order == StorageOrder::ColumnMajor, const Vector4<T>&, Vector4<T>>::type;
 
 	public:
-		Matrix4x4<T>()
+		Matrix4x4()
+		{
+		}
+
+		// Always takes rows, whatever the storage order
+		Matrix4x4(const Vector4<T>& r0, const Vector4<T>& r1, const Vector4<T>& r2, const Vector4<T>& r3)
+			: v{ MajorVector(r0, r1, r2, r3, 0), MajorVector(r0, r1, r2, r3, 1), MajorVector(r0, r1, r2, r3, 2), MajorVector(r0, r1, r2, r3, 3) }
 		{
 		}
 
-		Matrix4x4<T>(const Vector4<T>& r0, const Vector4<T>& r1, const Vector4<T>& r2, const Vector4<T>& r3)
-			: r{ r0, r1, r2, r3 }
+		static Matrix4x4 FromColumns(const Vector4<T>& c0, const Vector4<T>& c1, const Vector4<T>& c2, const Vector4<T>& c3)
 		{
+			return Matrix4x4(c0, c1, c2, c3).Transposed();
 		}
 
+		// Converts between storage orders
+		template <StorageOrder Other>
+		explicit Matrix4x4(const Matrix4x4<T, Other>& m)
+		{
+			for (int row = 0; row < 4; ++row)
+			{
+				for (int column = 0; column < 4; ++column)
+				{
+					(*this)(row, column) = m(row, column);
+				}
+			}
+		}
+
+		T& operator()(const int row, const int column)
+		{
+			assert(row >= 0 && row < 4 && column >= 0 && column < 4);
+			return Order == StorageOrder::RowMajor ? v[row].e[column] : v[column].e[row];
+		}
+
+		const T& operator()(const int row, const int column) const
+		{
+			assert(row >= 0 && row < 4 && column >= 0 && column < 4);
+			return Order == StorageOrder::RowMajor ? v[row].e[column] : v[column].e[row];
+		}
+
+		// Row i of a row-major matrix, or column i of a column-major one
 		Vector4<T>& operator[](const size_t element)
 		{
 			assert(element < 4);
-			return r[element];
+			return v[element];
 		}
 
-		Vector4<T> operator[](const size_t element) const
+		const Vector4<T>& operator[](const size_t element) const
 		{
 			assert(element < 4);
-			return r[element];
+			return v[element];
 		}
 
-		bool operator==(const Matrix4x4<T>& rhs) const
+		bool operator==(const Matrix4x4& rhs) const
 		{
-			return r[0] == rhs.r[0] && r[1] == rhs.r[1] && r[2] == rhs.r[2] && r[3] == rhs.r[3];
+			return v[0] == rhs.v[0] && v[1] == rhs.v[1] && v[2] == rhs.v[2] && v[3] == rhs.v[3];
 		}
 
-		bool operator!=(const Matrix4x4<T>& rhs) const
+		bool operator!=(const Matrix4x4& rhs) const
 		{
 			return !(*this == rhs);
 		}
 
-		const Vector4<T>& GetRow(int i) const
+		RowType GetRow(int i) const
 		{
 			assert(i < 4 && i >= 0);
-			return  r[i];
+			return Line(i, std::integral_constant<bool, Order == StorageOrder::RowMajor>());
 		}
 
-		Vector4<T> GetColumn(int i) const
+		ColumnType GetColumn(int i) const
 		{
 			assert(i < 4 && i >= 0);
-			return { r[0].e[i], r[1].e[i], r[2].e[i], r[3].e[i] };
+			return Line(i, std::integral_constant<bool, Order == StorageOrder::ColumnMajor>());
 		}
 
-		Matrix4x4<T> operator+(const Matrix4x4<T>& rhs) const
+		// Element storage in Order, for views and batch kernels
+		T* Data()
 		{
-			return {
-				{ r[0] + rhs.r[0] },
-				{ r[1] + rhs.r[1] },
-				{ r[2] + rhs.r[2] },
-				{ r[3] + rhs.r[3] }
-			};
+			return &v[0].e[0];
 		}
 
-		Matrix4x4<T> operator-(const Matrix4x4<T>& rhs) const
+		const T* Data() const
 		{
-			return {
-				{ r[0] - rhs.r[0] },
-				{ r[1] - rhs.r[1] },
-				{ r[2] - rhs.r[2] },
-				{ r[3] - rhs.r[3] }
-			};
+			return &v[0].e[0];
 		}
 
-		Matrix4x4<T> operator*(const Matrix4x4<T>& rhs) const
+		Matrix4x4 Transposed() const
 		{
-			return
+			Matrix4x4 t;
+			for (int row = 0; row < 4; ++row)
 			{
+				for (int column = 0; column < 4; ++column)
 				{
-					(r[0].x * rhs.r[0].x) + (r[0].y * rhs.r[1].x) + (r[0].z * rhs.r[2].x) + (r[0].w * rhs.r[3].x),
-					(r[0].x * rhs.r[0].y) + (r[0].y * rhs.r[1].y) + (r[0].z * rhs.r[2].y) + (r[0].w * rhs.r[3].y),
-					(r[0].x * rhs.r[0].z) + (r[0].y * rhs.r[1].z) + (r[0].z * rhs.r[2].z) + (r[0].w * rhs.r[3].z),
-					(r[0].x * rhs.r[0].w) + (r[0].y * rhs.r[1].w) + (r[0].z * rhs.r[2].w) + (r[0].w * rhs.r[3].w)
-				},
-				{
-					(r[1].x * rhs.r[0].x) + (r[1].y * rhs.r[1].x) + (r[1].z * rhs.r[2].x) + (r[1].w * rhs.r[3].x),
-					(r[1].x * rhs.r[0].y) + (r[1].y * rhs.r[1].y) + (r[1].z * rhs.r[2].y) + (r[1].w * rhs.r[3].y),
-					(r[1].x * rhs.r[0].z) + (r[1].y * rhs.r[1].z) + (r[1].z * rhs.r[2].z) + (r[1].w * rhs.r[3].z),
-					(r[1].x * rhs.r[0].w) + (r[1].y * rhs.r[1].w) + (r[1].z * rhs.r[2].w) + (r[1].w * rhs.r[3].w)
-				},
-				{
-					(r[2].x * rhs.r[0].x) + (r[2].y * rhs.r[1].x) + (r[2].z * rhs.r[2].x) + (r[2].w * rhs.r[3].x),
-					(r[2].x * rhs.r[0].y) + (r[2].y * rhs.r[1].y) + (r[2].z * rhs.r[2].y) + (r[2].w * rhs.r[3].y),
-					(r[2].x * rhs.r[0].z) + (r[2].y * rhs.r[1].z) + (r[2].z * rhs.r[2].z) + (r[2].w * rhs.r[3].z),
-					(r[2].x * rhs.r[0].w) + (r[2].y * rhs.r[1].w) + (r[2].z * rhs.r[2].w) + (r[2].w * rhs.r[3].w)
-				},
-				{
-					(r[3].x * rhs.r[0].x) + (r[3].y * rhs.r[1].x) + (r[3].z * rhs.r[2].x) + (r[3].w * rhs.r[3].x),
-					(r[3].x * rhs.r[0].y) + (r[3].y * rhs.r[1].y) + (r[3].z * rhs.r[2].y) + (r[3].w * rhs.r[3].y),
-					(r[3].x * rhs.r[0].z) + (r[3].y * rhs.r[1].z) + (r[3].z * rhs.r[2].z) + (r[3].w * rhs.r[3].z),
-					(r[3].x * rhs.r[0].w) + (r[3].y * rhs.r[1].w) + (r[3].z * rhs.r[2].w) + (r[3].w * rhs.r[3].w)
+					t(row, column) = (*this)(column, row);
 				}
-			};
+			}
+			return t;
 		}
 
-		Vector4<T> operator*(const Vector4<T>& rhs) const
+		Matrix4x4 operator+(const Matrix4x4& rhs) const
 		{
-			return
+			Matrix4x4 sum;
+			for (int i = 0; i < 4; ++i)
 			{
-				r[0].x * rhs.x + r[0].y * rhs.y + r[0].z * rhs.z,
-				r[1].x * rhs.x + r[1].y * rhs.y + r[1].z * rhs.z,
-				r[2].x * rhs.x + r[2].y * rhs.y + r[2].z * rhs.z,
-				r[3].x * rhs.x + r[3].y * rhs.y + r[3].z * rhs.z
-			};
+				sum.v[i] = v[i] + rhs.v[i];
+			}
+			return sum;
 		}
 
-		Matrix4x4<T>& operator+=(const Matrix4x4<T>& rhs)
+		Matrix4x4 operator-(const Matrix4x4& rhs) const
 		{
-			r[0] += rhs.r[0];
-			r[1] += rhs.r[1];
-			r[2] += rhs.r[2];
-			r[3] += rhs.r[3];
-			return *this;
+			Matrix4x4 difference;
+			for (int i = 0; i < 4; ++i)
+			{
+				difference.v[i] = v[i] - rhs.v[i];
+			}
+			return difference;
 		}
 
-		Matrix4x4<T>& operator-=(const Matrix4x4<T>& rhs)
+		// Each element sums its products left to right, so every storage order and the
+		// batch kernels produce identical results
+		Matrix4x4 operator*(const Matrix4x4& rhs) const
 		{
-			r[0] -= rhs.r[0];
-			r[1] -= rhs.r[1];
-			r[2] -= rhs.r[2];
-			r[3] -= rhs.r[3];
-			return *this;
-		}
-
-		Matrix4x4<T>& operator*=(const Matrix4x4<T>& rhs)
-		{			
-			/*
-			 * [a11b11 + a12b21 + a13b31 + a14b41]   [a11b12 + a12b22 + a13b32 + a14b42]   [a11b13 + a12b23 + a13b33 + a14b43]   [a11b14 + a12b24 + a13b34 + a14b44]
-			 * [a21b11 + a22b21 + a23b31 + a24b41]   [a21b12 + a22b22 + a23b32 + a24b42]   [a21b13 + a22b23 + a23b33 + a24b43]   [a21b14 + a22b24 + a23b34 + a24b44]
-			 * [a31b11 + a32b21 + a33b31 + a34b41]   [a31b12 + a32b22 + a33b32 + a34b42]   [a31b13 + a32b23 + a33b33 + a34b43]   [a31b14 + a32b24 + a33b34 + a34b44]
-			 * [a41b11 + a42b21 + a43b31 + a44b41]   [a41b12 + a42b22 + a43b32 + a44b42]   [a41b13 + a42b23 + a43b33 + a44b43]   [a41b14 + a42b24 + a43b34 + a44b44]
-			 */
-			r[0] =
+			Matrix4x4 product;
+			for (int row = 0; row < 4; ++row)
 			{
-				(r[0].x * rhs.r[0].x) + (r[0].y * rhs.r[1].x) + (r[0].z * rhs.r[2].x) + (r[0].w * rhs.r[3].x),
-				(r[0].x * rhs.r[0].y) + (r[0].y * rhs.r[1].y) + (r[0].z * rhs.r[2].y) + (r[0].w * rhs.r[3].y),
-				(r[0].x * rhs.r[0].z) + (r[0].y * rhs.r[1].z) + (r[0].z * rhs.r[2].z) + (r[0].w * rhs.r[3].z),
-				(r[0].x * rhs.r[0].w) + (r[0].y * rhs.r[1].w) + (r[0].z * rhs.r[2].w) + (r[0].w * rhs.r[3].w)
-			};
+				for (int column = 0; column < 4; ++column)
+				{
+					T sum = (*this)(row, 0) * rhs(0, column);
+					for (int k = 1; k < 4; ++k)
+					{
+						sum = sum + (*this)(row, k) * rhs(k, column);
+					}
+					product(row, column) = sum;
+				}
+			}
+			return product;
+		}
 
-			r[1] =
+		Vector4<T> operator*(const Vector4<T>& rhs) const
+		{
+			Vector4<T> product;
+			for (int row = 0; row < 4; ++row)
 			{
-				(r[1].x * rhs.r[0].x) + (r[1].y * rhs.r[1].x) + (r[1].z * rhs.r[2].x) + (r[1].w * rhs.r[3].x),
-				(r[1].x * rhs.r[0].y) + (r[1].y * rhs.r[1].y) + (r[1].z * rhs.r[2].y) + (r[1].w * rhs.r[3].y),
-				(r[1].x * rhs.r[0].z) + (r[1].y * rhs.r[1].z) + (r[1].z * rhs.r[2].z) + (r[1].w * rhs.r[3].z),
-				(r[1].x * rhs.r[0].w) + (r[1].y * rhs.r[1].w) + (r[1].z * rhs.r[2].w) + (r[1].w * rhs.r[3].w)
-			};
+				T sum = (*this)(row, 0) * rhs.e[0];
+				for (int k = 1; k < 4; ++k)
+				{
+					sum = sum + (*this)(row, k) * rhs.e[k];
+				}
+				product.e[row] = sum;
+			}
+			return product;
+		}
 
-			r[2] =
+		Matrix4x4& operator+=(const Matrix4x4& rhs)
+		{
+			for (int i = 0; i < 4; ++i)
 			{
-				(r[2].x * rhs.r[0].x) + (r[2].y * rhs.r[1].x) + (r[2].z * rhs.r[2].x) + (r[2].w * rhs.r[3].x),
-				(r[2].x * rhs.r[0].y) + (r[2].y * rhs.r[1].y) + (r[2].z * rhs.r[2].y) + (r[2].w * rhs.r[3].y),
-				(r[2].x * rhs.r[0].z) + (r[2].y * rhs.r[1].z) + (r[2].z * rhs.r[2].z) + (r[2].w * rhs.r[3].z),
-				(r[2].x * rhs.r[0].w) + (r[2].y * rhs.r[1].w) + (r[2].z * rhs.r[2].w) + (r[2].w * rhs.r[3].w)
-			};
+				v[i] += rhs.v[i];
+			}
+			return *this;
+		}
 
-			r[3] =
+		Matrix4x4& operator-=(const Matrix4x4& rhs)
+		{
+			for (int i = 0; i < 4; ++i)
 			{
-				(r[3].x * rhs.r[0].x) + (r[3].y * rhs.r[1].x) + (r[3].z * rhs.r[2].x) + (r[3].w * rhs.r[3].x),
-				(r[3].x * rhs.r[0].y) + (r[3].y * rhs.r[1].y) + (r[3].z * rhs.r[2].y) + (r[3].w * rhs.r[3].y),
-				(r[3].x * rhs.r[0].z) + (r[3].y * rhs.r[1].z) + (r[3].z * rhs.r[2].z) + (r[3].w * rhs.r[3].z),
-				(r[3].x * rhs.r[0].w) + (r[3].y * rhs.r[1].w) + (r[3].z * rhs.r[2].w) + (r[3].w * rhs.r[3].w)
-			};
+				v[i] -= rhs.v[i];
+			}
 			return *this;
 		}
 
-		Matrix4x4<T>& InverseSelf()
+		Matrix4x4& operator*=(const Matrix4x4& rhs)
 		{
+			*this = *this * rhs;
 			return *this;
 		}
 
-		Matrix4x4<T> InverseClone() const
+		// The adjugate and determinant of the transpose are the transpose of the adjugate
+		// and the same determinant, so these work on Data() in either storage order
+		Matrix4x4& InverseSelf()
 		{
+			*this = InverseClone();
 			return *this;
 		}
+
+		Matrix4x4 InverseClone() const
+		{
+			T adjugate[16];
+			const T determinant = MatrixDetail::Adjugate4x4(Data(), adjugate);
+			assert(determinant != static_cast<T>(0));
+			const T s = static_cast<T>(1) / determinant;
+
+			Matrix4x4 inverse;
+			T* e = inverse.Data();
+			for (int k = 0; k < 16; ++k)
+			{
+				e[k] = adjugate[k] * s;
+			}
+			return inverse;
+		}
+
+		T Determinant() const
+		{
+			T adjugate[16];
+			return MatrixDetail::Adjugate4x4(Data(), adjugate);
+		}
+
 	private:
-		Vector4<T> r[4];
+		// A stored vector returns by reference, a strided one is gathered
+		const Vector4<T>& Line(const int i, std::true_type) const
+		{
+			return v[i];
+		}
+
+		Vector4<T> Line(const int i, std::false_type) const
+		{
+			return { v[0].e[i], v[1].e[i], v[2].e[i], v[3].e[i] };
+		}
+
+		static Vector4<T> MajorVector(const Vector4<T>& r0, const Vector4<T>& r1, const Vector4<T>& r2, const Vector4<T>& r3, const int i)
+		{
+			return Order == StorageOrder::RowMajor
+				? (i == 0 ? r0 : i == 1 ? r1 : i == 2 ? r2 : r3)
+				: Vector4<T>(r0.e[i], r1.e[i], r2.e[i], r3.e[i]);
+		}
+
+	private:
+		// Rows, or columns for column-major storage
+		Vector4<T> v[4];
 	};
 
 	using Matrix3x3f = Matrix3x3<float>;
 	using Matrix4x4f = Matrix4x4<float>;
 
+	using Matrix3x3d = Matrix3x3<double>;
+	using Matrix4x4d = Matrix4x4<double>;
+
+	template <typename T>
+	using ColumnMajorMatrix3x3 = Matrix3x3<T, StorageOrder::ColumnMajor>;
+	template <typename T>
+	using ColumnMajorMatrix4x4 = Matrix4x4<T, StorageOrder::ColumnMajor>;
+
+	using ColumnMajorMatrix3x3f = ColumnMajorMatrix3x3<float>;
+	using ColumnMajorMatrix4x4f = ColumnMajorMatrix4x4<float>;
+	using ColumnMajorMatrix3x3d = ColumnMajorMatrix3x3<double>;
+	using ColumnMajorMatrix4x4d = ColumnMajorMatrix4x4<double>;
+
 	using Matrix3x3i = Matrix3x3<int>;
 	using Matrix4x4i = Matrix4x4<int>;
 
+	// Batched double precision kernels, vectorized with AVX when the library is built
+	// with MATH_ENABLE_AVX2. Results match the scalar operators, and every kernel may
+	// be performed in place. As with the Vector kernels, large batches run in chunks
+	// on executor.
+	void Multiply(const Matrix4x4d* lhs, const Matrix4x4d* rhs, Matrix4x4d* out, size_t count, Executor* executor = nullptr);
+	void Inverse(const Matrix4x4d* src, Matrix4x4d* out, size_t count, Executor* executor = nullptr);
+
+	// out[i] = m * src[i]
+	void Transform(const Matrix4x4d& m, const Vector4d* src, Vector4d* out, size_t count, Executor* executor = nullptr);
+
+	// out[i] = (m * Vector4d(src[i], 1)).xyz, without a perspective divide
+	void TransformPoints(const Matrix4x4d& m, const Vector3d* src, Vector3d* out, size_t count, Executor* executor = nullptr);
+
+	// Nine separate arrays, one per element in row-major order, so the batch kernels
+	// read a whole register of the same element at once. Kernel inputs take
+	// Matrix3x3SoA<const T>, which a Matrix3x3SoA<T> converts to.
+	template <typename T>
+	struct Matrix3x3SoA
+	{
+		T* e[9];
+
+		template <typename U = T, typename = typename std::enable_if<!std::is_const<U>::value>::type>
+		operator Matrix3x3SoA<const U>() const
+		{
+			return { { e[0], e[1], e[2], e[3], e[4], e[5], e[6], e[7], e[8] } };
+		}
+	};
+
+	// Batched Matrix3x3 determinant, inverse and normal matrix (inverse transpose),
+	// matching Determinant, InverseClone and InverseTransposeClone. Matrices passed to
+	// Inverse and NormalMatrix must be invertible, and outputs may alias inputs.
+	// Batches are chunked over executor.
+	void Determinant(const Matrix3x3SoA<const float>& src, float* out, size_t count, Executor* executor = nullptr);
+	void Inverse(const Matrix3x3SoA<const float>& src, const Matrix3x3SoA<float>& out, size_t count, Executor* executor = nullptr);
+	void NormalMatrix(const Matrix3x3SoA<const float>& src, const Matrix3x3SoA<float>& out, size_t count, Executor* executor = nullptr);
+
+	void Determinant(const Matrix3x3SoA<const double>& src, double* out, size_t count, Executor* executor = nullptr);
+	void Inverse(const Matrix3x3SoA<const double>& src, const Matrix3x3SoA<double>& out, size_t count, Executor* executor = nullptr);
+	void NormalMatrix(const Matrix3x3SoA<const double>& src, const Matrix3x3SoA<double>& out, size_t count, Executor* executor = nullptr);
+
+	// Array-of-structures versions, which transpose through SoA scratch in blocks.
+	// The Matrix4x4 overloads use the upper-left 3x3 block of each matrix.
+	void Determinant(const Matrix3x3f* src, float* out, size_t count, Executor* executor = nullptr);
+	void Inverse(const Matrix3x3f* src, Matrix3x3f* out, size_t count, Executor* executor = nullptr);
+	void NormalMatrix(const Matrix3x3f* src, Matrix3x3f* out, size_t count, Executor* executor = nullptr);
+	void NormalMatrix(const Matrix4x4f* src, Matrix3x3f* out, size_t count, Executor* executor = nullptr);
+
+	void Determinant(const Matrix3x3d* src, double* out, size_t count, Executor* executor = nullptr);
+	void Inverse(const Matrix3x3d* src, Matrix3x3d* out, size_t count, Executor* executor = nullptr);
+	void NormalMatrix(const Matrix3x3d* src, Matrix3x3d* out, size_t count, Executor* executor = nullptr);
+	void NormalMatrix(const Matrix4x4d* src, Matrix3x3d* out, size_t count, Executor* executor = nullptr);
+
 	bool TestMatrixMultiplication();
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Vector.h>
+#include <Matrix.h>
+#include <Geometry.h>
+
+namespace Math
+{
+	// Low resolution software depth buffer for occlusion culling. Occluder triangles
+	// are rasterized into it with the same view projection as the scene, a Hi-Z mip
+	// chain is built on top, and bounding boxes are then tested against the chain.
+	//
+	// Depth follows MakePerspective: 0 at the near plane and 1 at the far plane.
+	// Screen space matches ProjectPoints with a (0, 0, width, height) viewport.
+	class OcclusionBuffer
+	{
+	public:
+		// Triangles are binned into square tiles of this many pixels, which are
+		// rasterized in parallel
+		static constexpr int k_tileSize = 32;
+
+	public:
+		// width must be a multiple of 4
+		OcclusionBuffer(int width, int height);
+
+		int GetWidth() const
+		{
+			return levels[0].width;
+		}
+
+		int GetHeight() const
+		{
+			return levels[0].height;
+		}
+
+		// Level 0 is the full resolution buffer and the last level is 1x1
+		int GetLevelCount() const
+		{
+			return static_cast<int>(levels.size());
+		}
+
+		int GetLevelWidth(const int level) const
+		{
+			return levels[level].width;
+		}
+
+		int GetLevelHeight(const int level) const
+		{
+			return levels[level].height;
+		}
+
+		// Row-major depths of a level
+		const float* GetDepth(const int level = 0) const
+		{
+			return depth.data() + levels[level].offset;
+		}
+
+		// Resets every level to the far plane
+		void Clear();
+
+		// Rasterizes indexed world-space triangles into level 0, keeping the nearest
+		// depth per pixel. Triangles of either winding are drawn and are clipped
+		// against the near plane.
+		void RasterizeOccluders(const Matrix4x4f& viewProjection, const Vector3f* vertices, size_t vertexCount,
+			const uint32_t* indices, size_t triangleCount);
+
+		// Rebuilds every level above 0, each texel holding the farthest depth of the
+		// texels below it. Call after rasterizing and before testing.
+		void BuildHierarchy();
+
+		// Conservative: false only when the box is outside the view or hidden behind the
+		// occluders. Boxes crossing the near plane are always visible.
+		bool IsVisible(const Matrix4x4f& viewProjection, const Vector3f& boxMin, const Vector3f& boxMax) const;
+
+		bool IsVisible(const Matrix4x4f& viewProjection, const Aabbf& box) const
+		{
+			return IsVisible(viewProjection, box.min, box.max);
+		}
+
+		// Batched IsVisible, writing 1 or 0 per box. Boxes are tested in parallel.
+		void TestVisibility(const Matrix4x4f& viewProjection, const Vector3f* boxMins, const Vector3f* boxMaxs,
+			size_t count, uint8_t* visible) const;
+
+	private:
+		struct Level
+		{
+			int width;
+			int height;
+			size_t offset;
+		};
+
+		float* GetLevelDepth(const int level)
+		{
+			return depth.data() + levels[level].offset;
+		}
+
+	private:
+		std::vector<Level> levels;
+		// Every level, one after another
+		std::vector<float> depth;
+	};
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Math
+{
+	// Pool of worker threads that runs parallel loops. A loop's range is dealt out
+	// evenly to the threads taking part, each of which works through its own share a
+	// chunk at a time and, once done, steals half of what is left of another's. The
+	// thread that starts a loop always takes part, so loops nested inside loop bodies
+	// make progress even when every worker is busy.
+	class Executor
+	{
+	public:
+		// Runs loops on threadCount threads, including the one starting each loop.
+		// Zero uses one per hardware thread, and one runs everything on the caller.
+		explicit Executor(unsigned threadCount = 0);
+		Executor(const Executor&) = delete;
+		Executor& operator=(const Executor&) = delete;
+		~Executor();
+
+		unsigned GetThreadCount() const;
+
+		// Calls body(begin, end) on disjoint ranges that together cover [0, count),
+		// in parallel, and returns once every range is done. Ranges start at multiples
+		// of grainSize, and inputs of a single grain run entirely on the calling
+		// thread. body must be safe to call concurrently on different ranges.
+		void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+		// The pool used when no executor is given, with one thread per hardware thread
+		static Executor& GetDefault();
+
+	private:
+		struct Pool;
+		std::unique_ptr<Pool> pool;
+	};
+
+	// Number of threads executor spreads work over, including the calling thread
+	unsigned GetWorkerCount(Executor* executor = nullptr);
+
+	// Executor::ParallelFor on executor, or on the default executor
+	void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body, Executor* executor = nullptr);
+
+	// Elements per chunk for batch kernels that read and write bytesPerElement bytes
+	// per element, so that a chunk's data stays well within the L2 cache. Chunks are
+	// whole multiples of 16 elements, which keeps SIMD blocks intact.
+	inline size_t GetChunkSize(const size_t bytesPerElement)
+	{
+		const size_t k_chunkBytes = 64 * 1024;
+		return std::max<size_t>(16, k_chunkBytes / bytesPerElement / 16 * 16);
+	}
+
+	// Reduces [0, count) in chunks of grainSize: reduce(begin, end) gives the result of
+	// a chunk, and combine(a, b) joins the results of neighbouring ranges, a before b.
+	// Results are combined pairwise in a fixed order, so for a given grain size the
+	// result does not depend on the number of threads.
+	template <typename T, typename Reduce, typename Combine>
+	T ParallelReduce(const size_t count, size_t grainSize, const T& identity, const Reduce& reduce, const Combine& combine,
+		Executor* executor = nullptr)
+	{
+		grainSize = std::max<size_t>(grainSize, 1);
+		const size_t chunkCount = (count + grainSize - 1) / grainSize;
+		if (chunkCount <= 1)
+		{
+			return count > 0 ? reduce(size_t(0), count) : identity;
+		}
+
+		std::vector<T> partials(chunkCount, identity);
+		ParallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+			for (size_t c = first; c < last; ++c)
+			{
+				partials[c] = reduce(c * grainSize, std::min(count, (c + 1) * grainSize));
+			}
+		}, executor);
+		for (size_t width = 1; width < chunkCount; width *= 2)
+		{
+			for (size_t c = 0; c + width < chunkCount; c += 2 * width)
+			{
+				partials[c] = combine(partials[c], partials[c + width]);
+			}
+		}
+		return partials[0];
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include <Vector.h>
+#include <Matrix.h>
+#include <View.h>
+#include <Geometry.h>
+#include <ArrayFile.h>
+
+namespace Math
+{
+	// Streams point data through a chain of batch kernels in fixed-size chunks, so
+	// data sets larger than memory are processed in bounded memory.
+	//
+	// A source fills chunks on a loader thread, the stages run on the calling thread,
+	// and a sink consumes finished chunks on a writer thread. Three chunk buffers
+	// rotate between them, so the next chunk loads and the previous one is written
+	// while the current one is processed.
+
+	// Fills up to chunk.Count() points from the start of chunk and returns how many it
+	// wrote. Returning fewer than requested ends the stream after those points, and
+	// returning k_pointSourceFailed ends it as failed.
+	using PointSource = std::function<size_t(const VectorSpan<float, 3>& chunk)>;
+
+	constexpr size_t k_pointSourceFailed = static_cast<size_t>(-1);
+
+	// Transforms points in place. Stages are given parts of a chunk in parallel, so a
+	// stage must treat each point independently.
+	using PointStage = std::function<void(const VectorSpan<float, 3>& points)>;
+
+	// Consumes processed points in order, and returns false to stop the stream
+	using PointSink = std::function<bool(const VectorSpan<const float, 3>& chunk)>;
+
+	// Stages for the batch kernels
+
+	// (m * Vector4(p, 1)).xyz, without a perspective divide
+	PointStage TransformStage(const Matrix4x4f& m);
+	// p.Normalized()
+	PointStage NormalizeStage();
+	// Snaps p to the center of its cell in a grid of 2^bits cells per axis spanning
+	// bounds, as found by Quantize
+	PointStage QuantizeStage(const Aabbf& bounds, int bits);
+
+	// Sources and sinks of packed Vector3f data. Files must be opened in binary mode
+	// and stay open while the pipeline runs; the reader must outlive the source. A
+	// read error fails the source rather than ending it.
+	PointSource ReadPoints(std::FILE* file);
+	// An AoS Vector3f array of an array file
+	PointSource ReadPoints(const ArrayFileReader& reader, size_t index);
+	PointSink WritePoints(std::FILE* file);
+	// Appends to the array in progress in writer, which must hold Vector3f elements
+	PointSink AppendPoints(ArrayFileWriter& writer);
+
+	class PointPipeline
+	{
+	public:
+		static constexpr size_t k_defaultChunkSize = 65536;
+
+	public:
+		explicit PointPipeline(size_t chunkSize = k_defaultChunkSize);
+
+		// Adds a stage after the existing ones
+		PointPipeline& Then(PointStage stage);
+
+		// Streams every point of source through the stages into sink. Returns false if
+		// the sink stopped the stream early, or if the source failed, in which case the
+		// sink still gets the points read before the failure.
+		bool Run(const PointSource& source, const PointSink& sink) const;
+
+		size_t GetChunkSize() const
+		{
+			return chunkSize;
+		}
+
+	private:
+		size_t chunkSize;
+		std::vector<PointStage> stages;
+	};
+}
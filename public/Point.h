@@ -28,39 +28,49 @@ namespace Math
 			return *this;
 		}
 
-		Point<T>& operator=(const T ex, const T ey)
+		Point<T>& Set(const T ex, const T ey)
 		{
 			e[0] = ex;
 			e[1] = ey;
 			return *this;
 		}
 
-		bool operator==(const Point<T>& other)
+		T GetX() const
+		{
+			return e[0];
+		}
+
+		T GetY() const
+		{
+			return e[1];
+		}
+
+		bool operator==(const Point<T>& other) const
 		{
 			return e[0] == other.e[0] && e[1] == other.e[1];
 		}
 
-		bool operator!=(const Point<T>& other)
+		bool operator!=(const Point<T>& other) const
 		{
 			return e[0] != other.e[0] || e[1] != other.e[1];
 		}
 
-		Point<T> operator+(const Point<T>& other)
+		Point<T> operator+(const Point<T>& other) const
 		{
 			return Point<T>(e[0] + other.e[0], e[1] + other.e[1]);
 		}
 
-		Point<T> operator-(const Point<T>& other)
+		Point<T> operator-(const Point<T>& other) const
 		{
 			return Point<T>(e[0] - other.e[0], e[1] - other.e[1]);
 		}
 
-		Point<T> operator*(const T other)
+		Point<T> operator*(const T other) const
 		{
 			return Point<T>(e[0] * other, e[1] * other);
 		}
 
-		Point<T> operator/(const T other)
+		Point<T> operator/(const T other) const
 		{
 			return Point<T>(e[0] / other, e[1] / other);
 		}
@@ -78,5 +88,5 @@ namespace Math
 	};
 
 	using Pointf = Point<float>;
-	using Point2i
-}
\ No newline at end of file
+	using Point2i = Point<int>;
+}
@@ -2,40 +2,113 @@
 
 #include <Vector.h>
 #include <Matrix.h>
-#include <cassert.h>
+#include <StructuredMatrix.h>
+#include <View.h>
+#include <MathTemplateUtil.h>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
 
 namespace Math
 {
-	
+	// Left-handed projections onto a [0, 1] depth range, for column vectors (clip = P * view).
+	// Both return a PerspectiveMatrix, which converts to a dense Matrix4x4 on assignment.
+
 	template<typename T>
-	Matrix4x4<T> MakePerspective(T yFoV, T aspectRatio, T nearZ, T farZ)
+	PerspectiveMatrix<T> MakePerspective(T yFoV, T aspectRatio, T nearZ, T farZ)
 	{
-		assert(abs(aspect - std::numeric_limits<T>::epsilon()) > static_cast<T>(0));
+		assert(Abs(aspectRatio) > std::numeric_limits<T>::epsilon());
+		assert(farZ != nearZ);
 
-		const T tanHalfFoV = tan(yFoV / static_cast<T>(2));
+		const T tanHalfFoV = Tan(yFoV / static_cast<T>(2));
 
-		Matrix4x4<T> perspectiveMat();
-		perspectiveMat[0][0] = static_cast<T>(1) / (aspectRatio * tanHalfFoV);
-		perspectiveMat[1][1] = static_cast<T>(1) / (tanHalfFoV);
-		perspectiveMat[2][2] = farZ / (farZ - nearZ);
-		perspectiveMat[2][3] = static_cast<T>(1);
-		perspectiveMat[3][2] = -(farZ * nearZ) / (farZ - nearZ);
-		return perspectiveMat;
+		return PerspectiveMatrix<T>(
+			static_cast<T>(1) / (aspectRatio * tanHalfFoV),
+			static_cast<T>(1) / (tanHalfFoV),
+			farZ / (farZ - nearZ),
+			-(farZ * nearZ) / (farZ - nearZ));
 	}
 
 	template<typename T>
-	Matrix4x4<T> MakeFrustumProjection(T left, T right, T bottom, T top, T nearZ, T farZ)
+	PerspectiveMatrix<T> MakeFrustumProjection(T left, T right, T bottom, T top, T nearZ, T farZ)
+	{
+		assert(right != left && top != bottom && farZ != nearZ);
+
+		return PerspectiveMatrix<T>(
+			(static_cast<T>(2) * nearZ) / (right - left),
+			(static_cast<T>(2) * nearZ) / (top - bottom),
+			farZ / (farZ - nearZ),
+			-(farZ * nearZ) / (farZ - nearZ),
+			-(right + left) / (right - left),
+			-(top + bottom) / (top - bottom));
+	}
+
+	// Window rectangle and depth range that normalized device coordinates map onto.
+	// Screen y points down, with the origin at the top left.
+	template <typename T>
+	struct Viewport
+	{
+		T x;
+		T y;
+		T width;
+		T height;
+		T minDepth;
+		T maxDepth;
+	};
+
+	using Viewportf = Viewport<float>;
+	using Viewportd = Viewport<double>;
+
+	// Bits of the clip code written by ProjectPoints, set for each clip plane a point
+	// lies outside of. Screen positions are only meaningful for points without ClipNear.
+	enum ClipCode : uint8_t
+	{
+		ClipNear = 1 << 0,
+		ClipFar = 1 << 1,
+		ClipLeft = 1 << 2,
+		ClipRight = 1 << 3,
+		ClipBottom = 1 << 4,
+		ClipTop = 1 << 5
+	};
+
+	// Projects world-space points to screen positions, with the perspective divide
+	// done four points at a time. depth and clipCodes are optional arrays of
+	// points.Count() elements receiving the viewport depth and the ClipCode bits.
+	// Returns the number of points in front of the near plane. Points are chunked over
+	// executor.
+	size_t ProjectPoints(const Matrix4x4f& viewProjection, const Viewportf& viewport,
+		const VectorSpan<const float, 3>& points, const VectorSpan<float, 2>& screen, float* depth = nullptr, uint8_t* clipCodes = nullptr,
+		Executor* executor = nullptr);
+
+	// Inverse of ProjectPoints for a single point: screen.xy is the window position
+	// and screen.z the viewport depth. Takes the inverse of the view projection, which
+	// for a PerspectiveMatrix is cheapest as view.InverseClone() * projection.InverseClone().
+	template <typename T>
+	Vector3<T> Unproject(const Matrix4x4<T>& inverseViewProjection, const Viewport<T>& viewport, const Vector3<T>& screen)
+	{
+		assert(viewport.width != static_cast<T>(0) && viewport.height != static_cast<T>(0));
+		assert(viewport.maxDepth != viewport.minDepth);
+
+		const T one = static_cast<T>(1);
+		const T two = static_cast<T>(2);
+		const T ndcX = (screen.x - viewport.x) / viewport.width * two - one;
+		const T ndcY = one - (screen.y - viewport.y) / viewport.height * two;
+		const T ndcZ = (screen.z - viewport.minDepth) / (viewport.maxDepth - viewport.minDepth);
+		const Vector4<T> p = inverseViewProjection * Vector4<T>(ndcX, ndcY, ndcZ, one);
+		assert(p.w != static_cast<T>(0));
+		return Vector3<T>(p.x / p.w, p.y / p.w, p.z / p.w);
+	}
+
+	// World-space ray under a cursor, starting on the near plane and pointing through
+	// the far plane
+	template <typename T>
+	void UnprojectRay(const Matrix4x4<T>& inverseViewProjection, const Viewport<T>& viewport, const Vector2<T>& cursor,
+		Vector3<T>& origin, Vector3<T>& direction)
 	{
-		Matrix4x4<T> projectionMat();
-		projectionMat[0][0] = (static_cast<T>(2) * nearZ) / (right - left);
-		projectionMat[1][1] = (static_cast<T>(2) * nearZ) / (top - bottom);
-		projectionMat[2][0] = -(right + left) / (right - left);
-		projectionMat[2][1] = -(top + bottom) / (top - bottom);
-		projectionMat[2][2] = farZ / (farZ - nearZ);
-		projectionMat[2][3] = static_cast<T>(1);
-		projectionMat[3][2] = -(farZ * nearZ) / (farZ - nearZ);
-		return projectionMat;
+		origin = Unproject(inverseViewProjection, viewport, Vector3<T>(cursor.x, cursor.y, viewport.minDepth));
+		const Vector3<T> end = Unproject(inverseViewProjection, viewport, Vector3<T>(cursor.x, cursor.y, viewport.maxDepth));
+		direction = (end - origin).Normalized();
 	}
 
-}
\ No newline at end of file
+}
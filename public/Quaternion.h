@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <limits>
 
 #include <MathUtil.h>
@@ -57,12 +58,12 @@ namespace Math
 				const T halfYaw = yaw * static_cast<T>(0.5f);
 				const T halfPitch = pitch * static_cast<T>(0.5f);
 				const T halfRoll = roll * static_cast<T>(0.5f);
-				const T cosYaw = std::cosf(halfYaw);
-				const T sinYaw = std::sinf(halfYaw);
-				const T cosPitch = std::cosf(halfPitch);
-				const T sinPitch = std::sinf(halfPitch);
-				const T cosRoll = std::cosf(halfRoll);
-				const T sinRoll = std::sinf(halfRoll);
+				const T cosYaw = Cos<T>(halfYaw);
+				const T sinYaw = Sin<T>(halfYaw);
+				const T cosPitch = Cos<T>(halfPitch);
+				const T sinPitch = Sin<T>(halfPitch);
+				const T cosRoll = Cos<T>(halfRoll);
+				const T sinRoll = Sin<T>(halfRoll);
 				x = cosRoll * sinPitch* cosYaw + sinRoll * cosPitch * sinYaw;
 				y = cosRoll * cosPitch* sinYaw - sinRoll * sinPitch * cosYaw;
 				z = sinRoll * cosPitch* cosYaw - cosRoll * sinPitch * sinYaw;
@@ -75,12 +76,12 @@ namespace Math
 				const T halfYaw = yawZ * static_cast<T>(0.5f);
 				const T halfPitch = pitchY * static_cast<T>(0.5f);
 				const T halfRoll = rollX * static_cast<T>(0.5f);
-				const T cosYaw = std::cosf(halfYaw);
-				const T sinYaw = std::sinf(halfYaw);
-				const T cosPitch = std::cosf(halfPitch);
-				const T sinPitch = std::sinf(halfPitch);
-				const T cosRoll = std::cosf(halfRoll);
-				const T sinRoll = std::sinf(halfRoll);
+				const T cosYaw = Cos<T>(halfYaw);
+				const T sinYaw = Sin<T>(halfYaw);
+				const T cosPitch = Cos<T>(halfPitch);
+				const T sinPitch = Sin<T>(halfPitch);
+				const T cosRoll = Cos<T>(halfRoll);
+				const T sinRoll = Sin<T>(halfRoll);
 				x = sinRoll * cosPitch * cosYaw - cosRoll * sinPitch * sinYaw;
 				y = cosRoll * sinPitch * cosYaw + sinRoll * cosPitch * sinYaw;
 				z =	cosRoll * cosPitch * sinYaw - sinRoll * sinPitch * cosYaw;
@@ -162,11 +163,13 @@ namespace Math
 			// Multiply this quaternion by q (i.e. this = this * q)
 			Quaternion<T>& operator*=(const Quaternion<T>& q)
 			{
-				x = e[3] * q.x + e[0] * q.e[3] + e[1] * q.z - e[2] * q.y;
-				y = e[3] * q.y + e[1] * q.e[3] + e[2] * q.x - e[0] * q.z;
-				z = e[3] * q.z + e[2] * q.e[3] + e[0] * q.y - e[1] * q.x;
-				w = e[3] * q.w - e[0] * q.x    - e[1] * q.y - e[2] * q.z;
-				return *this;
+				// Every component reads the old x, y, z and w, so compute into a temporary
+				const Quaternion<T> p(
+					e[3] * q.x + e[0] * q.e[3] + e[1] * q.z - e[2] * q.y,
+					e[3] * q.y + e[1] * q.e[3] + e[2] * q.x - e[0] * q.z,
+					e[3] * q.z + e[2] * q.e[3] + e[0] * q.y - e[1] * q.x,
+					e[3] * q.w - e[0] * q.x    - e[1] * q.y - e[2] * q.z);
+				return *this = p;
 			}
 
 			// Dot product between this quaternion and q
@@ -330,12 +333,12 @@ namespace Math
 			Quaternion<T> Slerp(const Quaternion<T>& q, const T& t) const
 			{
 				const T magnitude = Sqrt<T>(LengthSq() * q.LengthSq());
-				assert(magnitude > 0.f);
+				assert(magnitude > static_cast<T>(0.f));
 
 				const T product = Dot(q) / magnitude;
 				const T absProduct = Abs<T>(product);
 
-				if (absProduct < 1.0f - std::numeric_limits<T>::epsilon())
+				if (absProduct < static_cast<T>(1.0f) - std::numeric_limits<T>::epsilon())
 				{
 					// Long angle case (see http://en.wikipedia.org/wiki/Slerp)
 					const T theta = Cos<T>(absProduct);
@@ -343,7 +346,7 @@ namespace Math
 					assert(d > static_cast<T>(0.f));
 
 					const T sign = (product < static_cast<T>(0.f)) ? static_cast<T>(-1.f) : static_cast<T>(1.f);
-					const T s0 = Sin<T>((1.0f - t) * theta) / d;
+					const T s0 = Sin<T>((static_cast<T>(1.0f) - t) * theta) / d;
 					const T s1 = Sin<T>(sign * t * theta) / d;
 
 					return {
@@ -522,4 +525,13 @@ namespace Math
 	// Convenience Aliases
 	using Quaternionf = Quaternion<float>;
 	using Quaterniond = Quaternion<double>;
+
+	// Batched double precision kernels, vectorized with AVX when the library is built
+	// with MATH_ENABLE_AVX2. Results match the scalar operators, and every kernel may
+	// be performed in place. Large batches run in chunks on executor.
+	void Multiply(const Quaterniond* lhs, const Quaterniond* rhs, Quaterniond* out, size_t count, Executor* executor = nullptr);
+	void Normalize(const Quaterniond* src, Quaterniond* out, size_t count, Executor* executor = nullptr);
+
+	// out[i] = RotateQuaternion(rotations[i], src[i])
+	void Rotate(const Quaterniond* rotations, const Vector3d* src, Vector3d* out, size_t count, Executor* executor = nullptr);
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+#include <Vector.h>
+#include <View.h>
+#include <Geometry.h>
+
+namespace Math
+{
+	// Reductions over spans of vectors, vectorized across the elements of a chunk and
+	// spread over threads by ParallelReduce. Chunk boundaries are fixed, so every
+	// reduction gives the same bits for any number of threads.
+
+	// How Sum and Centroid add up elements
+	enum class Summation
+	{
+		// Short runs are summed in SIMD lanes, and the run sums are added pairwise, so
+		// the rounding error grows with the logarithm of the count rather than the count
+		Pairwise,
+		// Compensated (Kahan-Babuska) summation within the lanes and between chunks,
+		// accurate to a few units in the last place for any count, at about twice
+		// the cost. Must not be built with -ffast-math or /fp:fast.
+		Kahan,
+	};
+
+	// Component-wise bounds of a set of vectors; the N-dimensional Aabb
+	template <typename T, int N>
+	struct VectorBounds
+	{
+		using VectorType = typename ViewDetail::VectorOf<T, N>::Type;
+
+		VectorType min;
+		VectorType max;
+
+		// Inverted bounds, which Expand and Merge grow from. Both skip NaN components
+		// of their argument.
+		static VectorBounds<T, N> Empty()
+		{
+			VectorBounds<T, N> bounds;
+			for (int c = 0; c < N; ++c)
+			{
+				bounds.min.e[c] = std::numeric_limits<T>::max();
+				bounds.max.e[c] = -std::numeric_limits<T>::max();
+			}
+			return bounds;
+		}
+
+		bool IsEmpty() const
+		{
+			for (int c = 0; c < N; ++c)
+			{
+				if (min.e[c] > max.e[c])
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void Expand(const VectorType& point)
+		{
+			for (int c = 0; c < N; ++c)
+			{
+				min.e[c] = GeometryDetail::Min(point.e[c], min.e[c]);
+				max.e[c] = GeometryDetail::Max(point.e[c], max.e[c]);
+			}
+		}
+
+		void Merge(const VectorBounds<T, N>& other)
+		{
+			for (int c = 0; c < N; ++c)
+			{
+				min.e[c] = GeometryDetail::Min(other.min.e[c], min.e[c]);
+				max.e[c] = GeometryDetail::Max(other.max.e[c], max.e[c]);
+			}
+		}
+	};
+
+	namespace ReduceDetail
+	{
+		// Instantiated for float and double with N of 2, 3 and 4
+		template <typename T, int N>
+		VectorBounds<T, N> ComputeBounds(const VectorSpan<const T, N>& points, Executor* executor);
+		template <typename T, int N>
+		typename VectorSpan<const T, N>::VectorType Sum(const VectorSpan<const T, N>& points, Summation summation, Executor* executor);
+		template <typename T, int N>
+		T MaxLengthSq(const VectorSpan<const T, N>& points, Executor* executor);
+	}
+
+	// Smallest bounds containing every point, or VectorBounds::Empty() for no points.
+	// NaN components are ignored.
+	template <typename T, int N>
+	VectorBounds<typename std::remove_const<T>::type, N> ComputeBounds(const VectorSpan<T, N>& points, Executor* executor = nullptr)
+	{
+		return ReduceDetail::ComputeBounds<typename std::remove_const<T>::type, N>(points, executor);
+	}
+
+	template <typename T>
+	Aabb<typename std::remove_const<T>::type> ComputeAabb(const VectorSpan<T, 3>& points, Executor* executor = nullptr)
+	{
+		const auto bounds = ComputeBounds(points, executor);
+		return { bounds.min, bounds.max };
+	}
+
+	// Sum of the points, or zero for no points
+	template <typename T, int N>
+	typename VectorSpan<T, N>::VectorType Sum(const VectorSpan<T, N>& points, const Summation summation = Summation::Pairwise,
+		Executor* executor = nullptr)
+	{
+		return ReduceDetail::Sum<typename std::remove_const<T>::type, N>(points, summation, executor);
+	}
+
+	// Mean of the points, which must not be empty
+	template <typename T, int N>
+	typename VectorSpan<T, N>::VectorType Centroid(const VectorSpan<T, N>& points, const Summation summation = Summation::Pairwise,
+		Executor* executor = nullptr)
+	{
+		assert(points.Count() > 0);
+		using Scalar = typename std::remove_const<T>::type;
+		return Sum(points, summation, executor) / static_cast<Scalar>(points.Count());
+	}
+
+	// Largest LengthSq of the points, or zero for no points. Its square root is the
+	// radius of a bounding sphere about the origin.
+	template <typename T, int N>
+	typename std::remove_const<T>::type MaxLengthSq(const VectorSpan<T, N>& points, Executor* executor = nullptr)
+	{
+		return ReduceDetail::MaxLengthSq<typename std::remove_const<T>::type, N>(points, executor);
+	}
+}
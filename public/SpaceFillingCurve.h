@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Vector.h>
+#include <View.h>
+#include <Geometry.h>
+
+namespace Math
+{
+	// Morton (Z-order) and Hilbert codes of integer grid cells, and sorting by them.
+	// Points sorted along either curve keep spatial neighbours close in memory;
+	// Hilbert order never jumps between distant cells, at a higher encoding cost.
+	//
+	// Cell components must be non-negative and fit the code: 10 bits each for 30-bit
+	// and 21 bits each for 63-bit codes of Vector3i, 16 and 32 bits for the 32 and
+	// 64-bit codes of Vector2i. Higher bits are ignored.
+
+	enum class SpaceFillingCurve
+	{
+		Morton,
+		Hilbert
+	};
+
+	uint32_t EncodeMorton30(const Vector3i& cell);
+	uint64_t EncodeMorton63(const Vector3i& cell);
+	uint32_t EncodeMorton32(const Vector2i& cell);
+	uint64_t EncodeMorton64(const Vector2i& cell);
+	Vector3i DecodeMorton30(uint32_t code);
+	Vector3i DecodeMorton63(uint64_t code);
+	Vector2i DecodeMorton32(uint32_t code);
+	Vector2i DecodeMorton64(uint64_t code);
+
+	uint32_t EncodeHilbert30(const Vector3i& cell);
+	uint64_t EncodeHilbert63(const Vector3i& cell);
+	uint32_t EncodeHilbert32(const Vector2i& cell);
+	uint64_t EncodeHilbert64(const Vector2i& cell);
+	Vector3i DecodeHilbert30(uint32_t code);
+	Vector3i DecodeHilbert63(uint64_t code);
+	Vector2i DecodeHilbert32(uint32_t code);
+	Vector2i DecodeHilbert64(uint64_t code);
+
+	// Cell of position in a grid of 2^bits cells per axis spanning bounds. Positions
+	// outside bounds are clamped to the border cells.
+	Vector3i Quantize(const Vector3f& position, const Aabbf& bounds, int bits);
+
+	// Batched versions, spread over the worker threads for large counts
+	void EncodeMorton30(const Vector3i* cells, size_t count, uint32_t* codes);
+	void EncodeMorton63(const Vector3i* cells, size_t count, uint64_t* codes);
+	void EncodeMorton32(const Vector2i* cells, size_t count, uint32_t* codes);
+	void EncodeMorton64(const Vector2i* cells, size_t count, uint64_t* codes);
+	void DecodeMorton30(const uint32_t* codes, size_t count, Vector3i* cells);
+	void DecodeMorton63(const uint64_t* codes, size_t count, Vector3i* cells);
+	void DecodeMorton32(const uint32_t* codes, size_t count, Vector2i* cells);
+	void DecodeMorton64(const uint64_t* codes, size_t count, Vector2i* cells);
+
+	void EncodeHilbert30(const Vector3i* cells, size_t count, uint32_t* codes);
+	void EncodeHilbert63(const Vector3i* cells, size_t count, uint64_t* codes);
+	void EncodeHilbert32(const Vector2i* cells, size_t count, uint32_t* codes);
+	void EncodeHilbert64(const Vector2i* cells, size_t count, uint64_t* codes);
+	void DecodeHilbert30(const uint32_t* codes, size_t count, Vector3i* cells);
+	void DecodeHilbert63(const uint64_t* codes, size_t count, Vector3i* cells);
+	void DecodeHilbert32(const uint32_t* codes, size_t count, Vector2i* cells);
+	void DecodeHilbert64(const uint64_t* codes, size_t count, Vector2i* cells);
+
+	// Codes of points quantized into bounds, with 10 or 21 bits per axis
+	void EncodeMorton30(const VectorSpan<const float, 3>& points, const Aabbf& bounds, uint32_t* codes);
+	void EncodeMorton63(const VectorSpan<const float, 3>& points, const Aabbf& bounds, uint64_t* codes);
+	void EncodeHilbert30(const VectorSpan<const float, 3>& points, const Aabbf& bounds, uint32_t* codes);
+	void EncodeHilbert63(const VectorSpan<const float, 3>& points, const Aabbf& bounds, uint64_t* codes);
+
+	// Stable sort of keys in ascending order, applying the same permutation to values.
+	// Parallel least significant digit radix sort; digits every key shares are skipped.
+	void RadixSort(uint32_t* keys, uint32_t* values, size_t count);
+	void RadixSort(uint64_t* keys, uint32_t* values, size_t count);
+
+	// Writes the order of points along curve through their bounds, with 21 bits per
+	// axis: order[i] is the index of the ith point along the curve
+	void SortAlongCurve(const VectorSpan<const float, 3>& points, SpaceFillingCurve curve, uint32_t* order);
+}
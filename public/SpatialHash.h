@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <Vector.h>
+#include <View.h>
+#include <MathTemplateUtil.h>
+
+namespace Math
+{
+	// Uniform grid of cubic cells over a point set, stored as a hash table so only
+	// occupied cells cost memory, for neighbour queries over points that move every
+	// frame.
+	//
+	// Build hashes each point's cell to a bucket and counting sorts the points by
+	// bucket, in parallel, copying their positions into the sorted order so that a
+	// query walks contiguous memory. A bucket can hold several cells whose hashes
+	// collide; each point keeps its cell's key so queries skip the other cells.
+	template <typename T>
+	class SpatialHashGrid
+	{
+	public:
+		static constexpr uint32_t k_noPoint = 0xFFFFFFFFu;
+
+		// Cell coordinates are limited to this magnitude, so that a cell packs into a
+		// 64-bit key
+		static constexpr int k_maxCell = (1 << 20) - 1;
+
+		struct Neighbour
+		{
+			uint32_t index;
+			T distanceSq;
+		};
+
+	public:
+		explicit SpatialHashGrid(T cellSize);
+
+		T GetCellSize() const
+		{
+			return cellSize;
+		}
+
+		size_t GetPointCount() const
+		{
+			return indices.size();
+		}
+
+		// Cell holding position
+		Vector3i GetCell(const Vector3<T>& position) const
+		{
+			Vector3i cell;
+			for (int c = 0; c < 3; ++c)
+			{
+				const T scaled = Floor(position[c] * inverseCellSize);
+				assert(scaled >= static_cast<T>(-k_maxCell) && scaled <= static_cast<T>(k_maxCell));
+				cell[c] = static_cast<int>(scaled);
+			}
+			return cell;
+		}
+
+		// Rebuilds the grid over points. Queries report positions in this span.
+		void Build(const VectorSpan<const T, 3>& points);
+
+		// Calls callback(index) for every point in cell
+		template <typename Callback>
+		void ForEachInCell(const Vector3i& cell, Callback callback) const
+		{
+			if (indices.empty())
+			{
+				return;
+			}
+			const uint64_t key = PackCell(cell);
+			const uint32_t bucket = GetBucket(key);
+			for (uint32_t i = bucketStarts[bucket]; i < bucketStarts[bucket + 1]; ++i)
+			{
+				if (keys[i] == key)
+				{
+					callback(indices[i]);
+				}
+			}
+		}
+
+		// Calls callback(index, distanceSq) for every point within radius of center
+		template <typename Callback>
+		void QueryRadius(const Vector3<T>& center, const T radius, Callback callback) const
+		{
+			if (indices.empty())
+			{
+				return;
+			}
+			// Only the occupied cell range is visited, so large radii cost no more than
+			// the grid itself
+			Vector3i low;
+			Vector3i high;
+			for (int c = 0; c < 3; ++c)
+			{
+				ClampCellRange(center[c] - radius, center[c] + radius, c, low[c], high[c]);
+				if (low[c] > high[c])
+				{
+					return;
+				}
+			}
+			const T radiusSq = radius * radius;
+			for (int z = low.z; z <= high.z; ++z)
+			{
+				for (int y = low.y; y <= high.y; ++y)
+				{
+					for (int x = low.x; x <= high.x; ++x)
+					{
+						const uint64_t key = PackCell(Vector3i(x, y, z));
+						const uint32_t bucket = GetBucket(key);
+						for (uint32_t i = bucketStarts[bucket]; i < bucketStarts[bucket + 1]; ++i)
+						{
+							const T dx = xs[i] - center.x;
+							const T dy = ys[i] - center.y;
+							const T dz = zs[i] - center.z;
+							const T distanceSq = dx * dx + dy * dy + dz * dz;
+							if (distanceSq <= radiusSq && keys[i] == key)
+							{
+								callback(indices[i], distanceSq);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// Finds up to k points nearest center within maxRadius, searching outward one
+		// shell of cells at a time. Writes them to nearest, nearest first, and returns
+		// how many there were.
+		size_t FindNearest(const Vector3<T>& center, size_t k, Neighbour* nearest,
+			T maxRadius = std::numeric_limits<T>::infinity()) const;
+
+		// FindNearest for every point in centers, spread over the worker threads. Each
+		// query gets k entries of nearest, with the unused ones set to k_noPoint.
+		void FindNearest(const VectorSpan<const T, 3>& centers, size_t k, Neighbour* nearest,
+			T maxRadius = std::numeric_limits<T>::infinity()) const;
+
+	private:
+		static T Floor(const T value)
+		{
+			const T truncated = static_cast<T>(static_cast<int64_t>(value));
+			return truncated > value ? truncated - static_cast<T>(1) : truncated;
+		}
+
+		// Cells along axis of the occupied range that [low, high] covers, with
+		// first > last when there are none
+		void ClampCellRange(const T low, const T high, const int axis, int& first, int& last) const
+		{
+			const T lowest = static_cast<T>(lowCell[axis]);
+			const T highest = static_cast<T>(highCell[axis]);
+			T scaledLow = low * inverseCellSize;
+			T scaledHigh = high * inverseCellSize;
+			scaledLow = scaledLow < lowest ? lowest : (scaledLow > highest + static_cast<T>(1) ? highest + static_cast<T>(1) : scaledLow);
+			scaledHigh = scaledHigh > highest ? highest : (scaledHigh < lowest - static_cast<T>(1) ? lowest - static_cast<T>(1) : scaledHigh);
+			first = static_cast<int>(Floor(scaledLow));
+			last = static_cast<int>(Floor(scaledHigh));
+		}
+
+		static uint64_t PackCell(const Vector3i& cell)
+		{
+			const uint64_t bias = static_cast<uint64_t>(k_maxCell);
+			return (static_cast<uint64_t>(cell.x) + bias) | ((static_cast<uint64_t>(cell.y) + bias) << 21)
+				| ((static_cast<uint64_t>(cell.z) + bias) << 42);
+		}
+
+		uint32_t GetBucket(const uint64_t key) const
+		{
+			// Fibonacci hashing of the packed cell
+			return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> bucketShift);
+		}
+
+		// Visits the cells at Chebyshev distance ring from cell, adding their points to
+		// the max-heap in nearest
+		void SearchShell(const Vector3<T>& center, const Vector3i& cell, int ring, size_t k, T maxRadiusSq,
+			Neighbour* nearest, size_t& found) const;
+
+	private:
+		T cellSize;
+		T inverseCellSize;
+		int bucketShift = 64;
+		// Points in bucket order
+		std::vector<T> xs;
+		std::vector<T> ys;
+		std::vector<T> zs;
+		std::vector<uint64_t> keys;
+		std::vector<uint32_t> indices;
+		// Points of bucket b are [bucketStarts[b], bucketStarts[b + 1])
+		std::vector<uint32_t> bucketStarts;
+		// Occupied cell range, which bounds the nearest search
+		Vector3i lowCell;
+		Vector3i highCell;
+	};
+
+	template <typename T>
+	constexpr uint32_t SpatialHashGrid<T>::k_noPoint;
+	template <typename T>
+	constexpr int SpatialHashGrid<T>::k_maxCell;
+
+	using SpatialHashGridf = SpatialHashGrid<float>;
+	using SpatialHashGridd = SpatialHashGrid<double>;
+}
@@ -0,0 +1,580 @@
+#pragma once
+
+#include <cassert>
+
+#include <Vector.h>
+#include <Matrix.h>
+#include <Quaternion.h>
+
+namespace Math
+{
+	// Matrices whose structure is known from how they were built. Each stores only its
+	// free coefficients and converts implicitly to the dense matrix it stands for, but
+	// products and inverses taking it by type skip the known zeros and ones, so the
+	// sparse kernel is chosen at compile time. Results match the dense operators for
+	// finite values, up to the sign of zero.
+
+	// diag(x, y, z), or diag(x, y, z, 1) as a 4x4
+	template <typename T>
+	class ScaleMatrix
+	{
+	public:
+		ScaleMatrix()
+			: scale(static_cast<T>(1), static_cast<T>(1), static_cast<T>(1))
+		{
+		}
+
+		explicit ScaleMatrix(const Vector3<T>& scale)
+			: scale(scale)
+		{
+		}
+
+		explicit ScaleMatrix(const T uniform)
+			: scale(uniform, uniform, uniform)
+		{
+		}
+
+		const Vector3<T>& GetScale() const
+		{
+			return scale;
+		}
+
+		ScaleMatrix operator*(const ScaleMatrix& rhs) const
+		{
+			return ScaleMatrix(scale * rhs.scale);
+		}
+
+		Vector3<T> operator*(const Vector3<T>& rhs) const
+		{
+			return scale * rhs;
+		}
+
+		Vector4<T> operator*(const Vector4<T>& rhs) const
+		{
+			return Vector4<T>(scale.x * rhs.x, scale.y * rhs.y, scale.z * rhs.z, rhs.w);
+		}
+
+		ScaleMatrix InverseClone() const
+		{
+			assert(scale.x != static_cast<T>(0) && scale.y != static_cast<T>(0) && scale.z != static_cast<T>(0));
+			const T one = static_cast<T>(1);
+			return ScaleMatrix(Vector3<T>(one / scale.x, one / scale.y, one / scale.z));
+		}
+
+		T Determinant() const
+		{
+			return scale.x * scale.y * scale.z;
+		}
+
+		template <StorageOrder Order>
+		operator Matrix3x3<T, Order>() const
+		{
+			const T zero = static_cast<T>(0);
+			return Matrix3x3<T, Order>(
+				Vector3<T>(scale.x, zero, zero),
+				Vector3<T>(zero, scale.y, zero),
+				Vector3<T>(zero, zero, scale.z));
+		}
+
+		template <StorageOrder Order>
+		operator Matrix4x4<T, Order>() const
+		{
+			const T zero = static_cast<T>(0);
+			return Matrix4x4<T, Order>(
+				Vector4<T>(scale.x, zero, zero, zero),
+				Vector4<T>(zero, scale.y, zero, zero),
+				Vector4<T>(zero, zero, scale.z, zero),
+				Vector4<T>(zero, zero, zero, static_cast<T>(1)));
+		}
+
+	private:
+		Vector3<T> scale;
+	};
+
+	// Identity with the translation in the last column
+	template <typename T>
+	class TranslationMatrix
+	{
+	public:
+		TranslationMatrix()
+			: translation(static_cast<T>(0), static_cast<T>(0), static_cast<T>(0))
+		{
+		}
+
+		explicit TranslationMatrix(const Vector3<T>& translation)
+			: translation(translation)
+		{
+		}
+
+		const Vector3<T>& GetTranslation() const
+		{
+			return translation;
+		}
+
+		TranslationMatrix operator*(const TranslationMatrix& rhs) const
+		{
+			return TranslationMatrix(translation + rhs.translation);
+		}
+
+		Vector4<T> operator*(const Vector4<T>& rhs) const
+		{
+			return Vector4<T>(
+				rhs.x + translation.x * rhs.w,
+				rhs.y + translation.y * rhs.w,
+				rhs.z + translation.z * rhs.w,
+				rhs.w);
+		}
+
+		// Transforms a point, with an implied w of 1
+		Vector3<T> TransformPoint(const Vector3<T>& point) const
+		{
+			return point + translation;
+		}
+
+		TranslationMatrix InverseClone() const
+		{
+			const T zero = static_cast<T>(0);
+			return TranslationMatrix(Vector3<T>(zero, zero, zero) - translation);
+		}
+
+		T Determinant() const
+		{
+			return static_cast<T>(1);
+		}
+
+		template <StorageOrder Order>
+		operator Matrix4x4<T, Order>() const
+		{
+			const T zero = static_cast<T>(0);
+			const T one = static_cast<T>(1);
+			return Matrix4x4<T, Order>(
+				Vector4<T>(one, zero, zero, translation.x),
+				Vector4<T>(zero, one, zero, translation.y),
+				Vector4<T>(zero, zero, one, translation.z),
+				Vector4<T>(zero, zero, zero, one));
+		}
+
+	private:
+		Vector3<T> translation;
+	};
+
+	// Orthonormal 3x3 with determinant 1, whose inverse is its transpose. Building one
+	// from an arbitrary matrix is a promise by the caller; nothing is checked.
+	template <typename T>
+	class RotationMatrix3
+	{
+	public:
+		RotationMatrix3()
+			: m(Matrix3x3<T>::IDENTITY)
+		{
+		}
+
+		explicit RotationMatrix3(const Matrix3x3<T>& rotation)
+			: m(rotation)
+		{
+		}
+
+		// q must be a unit quaternion
+		explicit RotationMatrix3(const Quaternion<T>& q)
+		{
+			const T one = static_cast<T>(1);
+			const T two = static_cast<T>(2);
+			const T xx = q.GetX() * q.GetX();
+			const T yy = q.GetY() * q.GetY();
+			const T zz = q.GetZ() * q.GetZ();
+			const T xy = q.GetX() * q.GetY();
+			const T xz = q.GetX() * q.GetZ();
+			const T yz = q.GetY() * q.GetZ();
+			const T wx = q.GetW() * q.GetX();
+			const T wy = q.GetW() * q.GetY();
+			const T wz = q.GetW() * q.GetZ();
+			m = Matrix3x3<T>(
+				Vector3<T>(one - two * (yy + zz), two * (xy - wz), two * (xz + wy)),
+				Vector3<T>(two * (xy + wz), one - two * (xx + zz), two * (yz - wx)),
+				Vector3<T>(two * (xz - wy), two * (yz + wx), one - two * (xx + yy)));
+		}
+
+		const Matrix3x3<T>& GetMatrix() const
+		{
+			return m;
+		}
+
+		RotationMatrix3 operator*(const RotationMatrix3& rhs) const
+		{
+			return RotationMatrix3(m * rhs.m);
+		}
+
+		Vector3<T> operator*(const Vector3<T>& rhs) const
+		{
+			return m * rhs;
+		}
+
+		Vector4<T> operator*(const Vector4<T>& rhs) const
+		{
+			const Vector3<T> v = m * Vector3<T>(rhs.x, rhs.y, rhs.z);
+			return Vector4<T>(v.x, v.y, v.z, rhs.w);
+		}
+
+		RotationMatrix3 InverseClone() const
+		{
+			return RotationMatrix3(m.Transposed());
+		}
+
+		T Determinant() const
+		{
+			return static_cast<T>(1);
+		}
+
+		template <StorageOrder Order>
+		operator Matrix3x3<T, Order>() const
+		{
+			return Matrix3x3<T, Order>(m.GetRow(0), m.GetRow(1), m.GetRow(2));
+		}
+
+		template <StorageOrder Order>
+		operator Matrix4x4<T, Order>() const
+		{
+			const T zero = static_cast<T>(0);
+			Matrix4x4<T, Order> result;
+			for (int row = 0; row < 3; ++row)
+			{
+				for (int column = 0; column < 3; ++column)
+				{
+					result(row, column) = m(row, column);
+				}
+				result(row, 3) = zero;
+				result(3, row) = zero;
+			}
+			result(3, 3) = static_cast<T>(1);
+			return result;
+		}
+
+	private:
+		Matrix3x3<T> m;
+	};
+
+	// Perspective projection of column vectors, as built by Projection.h:
+	//
+	//   | xScale  0       xOffset  0       |
+	//   | 0       yScale  yOffset  0       |
+	//   | 0       0       zScale   zOffset |
+	//   | 0       0       1        0       |
+	//
+	// The offsets are zero for symmetric frusta.
+	template <typename T>
+	class PerspectiveMatrix
+	{
+	public:
+		PerspectiveMatrix(const T xScale, const T yScale, const T zScale, const T zOffset,
+			const T xOffset = static_cast<T>(0), const T yOffset = static_cast<T>(0))
+			: xScale(xScale)
+			, yScale(yScale)
+			, zScale(zScale)
+			, zOffset(zOffset)
+			, xOffset(xOffset)
+			, yOffset(yOffset)
+		{
+		}
+
+		T GetXScale() const { return xScale; }
+		T GetYScale() const { return yScale; }
+		T GetZScale() const { return zScale; }
+		T GetZOffset() const { return zOffset; }
+		T GetXOffset() const { return xOffset; }
+		T GetYOffset() const { return yOffset; }
+
+		Vector4<T> operator*(const Vector4<T>& rhs) const
+		{
+			return Vector4<T>(
+				xScale * rhs.x + xOffset * rhs.z,
+				yScale * rhs.y + yOffset * rhs.z,
+				zScale * rhs.z + zOffset * rhs.w,
+				rhs.z);
+		}
+
+		// Closed form; the inverse maps clip space back to view space and is not a
+		// perspective matrix itself, so it is returned dense
+		template <StorageOrder Order = StorageOrder::RowMajor>
+		Matrix4x4<T, Order> InverseClone() const
+		{
+			assert(xScale != static_cast<T>(0) && yScale != static_cast<T>(0) && zOffset != static_cast<T>(0));
+			const T zero = static_cast<T>(0);
+			const T one = static_cast<T>(1);
+			const T invX = one / xScale;
+			const T invY = one / yScale;
+			const T invZ = one / zOffset;
+			return Matrix4x4<T, Order>(
+				Vector4<T>(invX, zero, zero, -xOffset * invX),
+				Vector4<T>(zero, invY, zero, -yOffset * invY),
+				Vector4<T>(zero, zero, zero, one),
+				Vector4<T>(zero, zero, invZ, -zScale * invZ));
+		}
+
+		T Determinant() const
+		{
+			return -(xScale * yScale * zOffset);
+		}
+
+		template <StorageOrder Order>
+		operator Matrix4x4<T, Order>() const
+		{
+			const T zero = static_cast<T>(0);
+			return Matrix4x4<T, Order>(
+				Vector4<T>(xScale, zero, xOffset, zero),
+				Vector4<T>(zero, yScale, yOffset, zero),
+				Vector4<T>(zero, zero, zScale, zOffset),
+				Vector4<T>(zero, zero, static_cast<T>(1), zero));
+		}
+
+	private:
+		T xScale;
+		T yScale;
+		T zScale;
+		T zOffset;
+		T xOffset;
+		T yOffset;
+	};
+
+	using ScaleMatrixf = ScaleMatrix<float>;
+	using ScaleMatrixd = ScaleMatrix<double>;
+	using TranslationMatrixf = TranslationMatrix<float>;
+	using TranslationMatrixd = TranslationMatrix<double>;
+	using RotationMatrix3f = RotationMatrix3<float>;
+	using RotationMatrix3d = RotationMatrix3<double>;
+	using PerspectiveMatrixf = PerspectiveMatrix<float>;
+	using PerspectiveMatrixd = PerspectiveMatrix<double>;
+
+	// Products between structured matrices. A rotation or scale composed with a
+	// translation is an affine 4x4 with the 3x3 in the upper left and the translation
+	// in the last column, written out directly.
+
+	template <typename T>
+	Matrix3x3<T> operator*(const RotationMatrix3<T>& lhs, const ScaleMatrix<T>& rhs)
+	{
+		const Vector3<T>& s = rhs.GetScale();
+		Matrix3x3<T> product;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				product(row, column) = lhs.GetMatrix()(row, column) * s.e[column];
+			}
+		}
+		return product;
+	}
+
+	template <typename T>
+	Matrix3x3<T> operator*(const ScaleMatrix<T>& lhs, const RotationMatrix3<T>& rhs)
+	{
+		const Vector3<T>& s = lhs.GetScale();
+		Matrix3x3<T> product;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				product(row, column) = s.e[row] * rhs.GetMatrix()(row, column);
+			}
+		}
+		return product;
+	}
+
+	// Translation * linear part, the usual T * (R * S) model matrix
+	template <typename T, StorageOrder Order>
+	Matrix4x4<T, Order> operator*(const TranslationMatrix<T>& lhs, const Matrix3x3<T, Order>& rhs)
+	{
+		const T zero = static_cast<T>(0);
+		const Vector3<T>& t = lhs.GetTranslation();
+		Matrix4x4<T, Order> product;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				product(row, column) = rhs(row, column);
+			}
+			product(row, 3) = t.e[row];
+			product(3, row) = zero;
+		}
+		product(3, 3) = static_cast<T>(1);
+		return product;
+	}
+
+	template <typename T>
+	Matrix4x4<T> operator*(const TranslationMatrix<T>& lhs, const RotationMatrix3<T>& rhs)
+	{
+		return lhs * rhs.GetMatrix();
+	}
+
+	template <typename T>
+	Matrix4x4<T> operator*(const TranslationMatrix<T>& lhs, const ScaleMatrix<T>& rhs)
+	{
+		return lhs * static_cast<Matrix3x3<T>>(rhs);
+	}
+
+	// Products with dense matrices. Only the rows or columns the structured operand
+	// can change are computed.
+
+	template <typename T, StorageOrder Order>
+	Matrix3x3<T, Order> operator*(const ScaleMatrix<T>& lhs, const Matrix3x3<T, Order>& rhs)
+	{
+		const Vector3<T>& s = lhs.GetScale();
+		Matrix3x3<T, Order> product;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				product(row, column) = s.e[row] * rhs(row, column);
+			}
+		}
+		return product;
+	}
+
+	template <typename T, StorageOrder Order>
+	Matrix3x3<T, Order> operator*(const Matrix3x3<T, Order>& lhs, const ScaleMatrix<T>& rhs)
+	{
+		const Vector3<T>& s = rhs.GetScale();
+		Matrix3x3<T, Order> product;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				product(row, column) = lhs(row, column) * s.e[column];
+			}
+		}
+		return product;
+	}
+
+	template <typename T, StorageOrder Order>
+	Matrix4x4<T, Order> operator*(const ScaleMatrix<T>& lhs, const Matrix4x4<T, Order>& rhs)
+	{
+		const Vector3<T>& s = lhs.GetScale();
+		Matrix4x4<T, Order> product;
+		for (int column = 0; column < 4; ++column)
+		{
+			for (int row = 0; row < 3; ++row)
+			{
+				product(row, column) = s.e[row] * rhs(row, column);
+			}
+			product(3, column) = rhs(3, column);
+		}
+		return product;
+	}
+
+	template <typename T, StorageOrder Order>
+	Matrix4x4<T, Order> operator*(const Matrix4x4<T, Order>& lhs, const ScaleMatrix<T>& rhs)
+	{
+		const Vector3<T>& s = rhs.GetScale();
+		Matrix4x4<T, Order> product;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				product(row, column) = lhs(row, column) * s.e[column];
+			}
+			product(row, 3) = lhs(row, 3);
+		}
+		return product;
+	}
+
+	// Adds translation * last row to the first three rows
+	template <typename T, StorageOrder Order>
+	Matrix4x4<T, Order> operator*(const TranslationMatrix<T>& lhs, const Matrix4x4<T, Order>& rhs)
+	{
+		const Vector3<T>& t = lhs.GetTranslation();
+		Matrix4x4<T, Order> product;
+		for (int column = 0; column < 4; ++column)
+		{
+			for (int row = 0; row < 3; ++row)
+			{
+				product(row, column) = rhs(row, column) + t.e[row] * rhs(3, column);
+			}
+			product(3, column) = rhs(3, column);
+		}
+		return product;
+	}
+
+	// Only the last column changes
+	template <typename T, StorageOrder Order>
+	Matrix4x4<T, Order> operator*(const Matrix4x4<T, Order>& lhs, const TranslationMatrix<T>& rhs)
+	{
+		const Vector3<T>& t = rhs.GetTranslation();
+		Matrix4x4<T, Order> product = lhs;
+		for (int row = 0; row < 4; ++row)
+		{
+			product(row, 3) = lhs(row, 0) * t.x + lhs(row, 1) * t.y + lhs(row, 2) * t.z + lhs(row, 3);
+		}
+		return product;
+	}
+
+	template <typename T, StorageOrder Order>
+	Matrix3x3<T, Order> operator*(const RotationMatrix3<T>& lhs, const Matrix3x3<T, Order>& rhs)
+	{
+		return static_cast<Matrix3x3<T, Order>>(lhs) * rhs;
+	}
+
+	template <typename T, StorageOrder Order>
+	Matrix3x3<T, Order> operator*(const Matrix3x3<T, Order>& lhs, const RotationMatrix3<T>& rhs)
+	{
+		return lhs * static_cast<Matrix3x3<T, Order>>(rhs);
+	}
+
+	// Only the first three rows change
+	template <typename T, StorageOrder Order>
+	Matrix4x4<T, Order> operator*(const RotationMatrix3<T>& lhs, const Matrix4x4<T, Order>& rhs)
+	{
+		const Matrix3x3<T>& r = lhs.GetMatrix();
+		Matrix4x4<T, Order> product = rhs;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				product(row, column) = r(row, 0) * rhs(0, column) + r(row, 1) * rhs(1, column) + r(row, 2) * rhs(2, column);
+			}
+		}
+		return product;
+	}
+
+	// Only the first three columns change
+	template <typename T, StorageOrder Order>
+	Matrix4x4<T, Order> operator*(const Matrix4x4<T, Order>& lhs, const RotationMatrix3<T>& rhs)
+	{
+		const Matrix3x3<T>& r = rhs.GetMatrix();
+		Matrix4x4<T, Order> product = lhs;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				product(row, column) = lhs(row, 0) * r(0, column) + lhs(row, 1) * r(1, column) + lhs(row, 2) * r(2, column);
+			}
+		}
+		return product;
+	}
+
+	// Projection * view: each row is a combination of at most two rows of rhs
+	template <typename T, StorageOrder Order>
+	Matrix4x4<T, Order> operator*(const PerspectiveMatrix<T>& lhs, const Matrix4x4<T, Order>& rhs)
+	{
+		Matrix4x4<T, Order> product;
+		for (int column = 0; column < 4; ++column)
+		{
+			product(0, column) = lhs.GetXScale() * rhs(0, column) + lhs.GetXOffset() * rhs(2, column);
+			product(1, column) = lhs.GetYScale() * rhs(1, column) + lhs.GetYOffset() * rhs(2, column);
+			product(2, column) = lhs.GetZScale() * rhs(2, column) + lhs.GetZOffset() * rhs(3, column);
+			product(3, column) = rhs(2, column);
+		}
+		return product;
+	}
+
+	template <typename T, StorageOrder Order>
+	Matrix4x4<T, Order> operator*(const Matrix4x4<T, Order>& lhs, const PerspectiveMatrix<T>& rhs)
+	{
+		Matrix4x4<T, Order> product;
+		for (int row = 0; row < 4; ++row)
+		{
+			product(row, 0) = lhs(row, 0) * rhs.GetXScale();
+			product(row, 1) = lhs(row, 1) * rhs.GetYScale();
+			product(row, 2) = lhs(row, 0) * rhs.GetXOffset() + lhs(row, 1) * rhs.GetYOffset() + lhs(row, 2) * rhs.GetZScale() + lhs(row, 3);
+			product(row, 3) = lhs(row, 2) * rhs.GetZOffset();
+		}
+		return product;
+	}
+}
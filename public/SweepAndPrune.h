@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Vector.h>
+#include <Geometry.h>
+
+namespace Math
+{
+	// Sweep-and-prune broadphase over axis-aligned boxes.
+	//
+	// Each axis keeps the box endpoints sorted. Boxes move only a little between
+	// frames, so Update re-sorts with insertion sort, which is close to linear on
+	// nearly sorted input; SIMD compares skip the runs that are still in order. The
+	// three axes are sorted in parallel, and each also counts its overlapping
+	// intervals. Pairs are then found by sweeping the axis with the fewest overlaps,
+	// in parallel over ranges of that axis, testing four candidates at a time.
+	template <typename T>
+	class SweepAndPrune
+	{
+	public:
+		using BoxId = uint32_t;
+
+		// a < b
+		struct Pair
+		{
+			BoxId a;
+			BoxId b;
+		};
+
+	public:
+		size_t GetBoxCount() const
+		{
+			return boxCount;
+		}
+
+		const Aabb<T>& GetBounds(const BoxId id) const
+		{
+			assert(IsBox(id));
+			return bounds[id];
+		}
+
+		// Axis the last Update swept along
+		int GetSweepAxis() const
+		{
+			return sweepAxis;
+		}
+
+		// New boxes are sorted into place by the next Update. Ids of removed boxes are
+		// reused after the Update following their removal. Bounds must be finite.
+		BoxId Add(const Aabb<T>& box);
+		void Add(const Aabb<T>* boxes, size_t count, BoxId* ids);
+		void Remove(BoxId id);
+
+		// New bounds take effect at the next Update
+		void SetBounds(BoxId id, const Aabb<T>& box);
+		void SetBounds(const BoxId* ids, const Aabb<T>* boxes, size_t count);
+
+		// Re-sorts the axes and writes up to capacity overlapping pairs, in an order that
+		// only depends on the calls made, not on threading. Returns the total number of
+		// pairs, which is more than capacity when the buffer was too small.
+		size_t Update(Pair* pairs, size_t capacity);
+
+	private:
+		// Endpoint handles are id * 2 for a box's minimum and id * 2 + 1 for its maximum
+		struct Axis
+		{
+			std::vector<T> values;
+			std::vector<uint32_t> handles;
+			// Index in values of each handle
+			std::vector<uint32_t> positions;
+			size_t overlapCount;
+		};
+
+		bool IsBox(const BoxId id) const
+		{
+			return id < alive.size() && alive[id] != 0;
+		}
+
+		void SortAxis(int axis);
+		void FullSortAxis(int axis);
+		void CountOverlaps(int axis);
+
+	private:
+		Axis axes[3];
+		std::vector<Aabb<T>> bounds;
+		std::vector<uint8_t> alive;
+		std::vector<BoxId> freeIds;
+		// Removed, with endpoints still waiting to be swept to the end of each axis
+		std::vector<BoxId> removedIds;
+		// Added since the last Update, at the end of each axis
+		size_t appendedCount = 0;
+		size_t boxCount = 0;
+		int sweepAxis = 0;
+		// Boxes in order along the sweep axis: minimums then maximums per axis, with the
+		// sweep axis first
+		std::vector<T> sorted[6];
+		std::vector<BoxId> sortedIds;
+		std::vector<std::vector<Pair>> chunkPairs;
+	};
+
+	using SweepAndPrunef = SweepAndPrune<float>;
+	using SweepAndPruned = SweepAndPrune<double>;
+}
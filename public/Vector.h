@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <cfloat>
+#include <cstddef>
 #include <cinttypes>
 #include <cassert>
 
@@ -27,7 +28,7 @@ namespace Math
     template<typename T>
     Vector2<T> Cross(const Vector2<T>& lhs, const Vector2<T>& rhs);
     template<typename T>
-	Vector2<T> Cross(const Vector3<T>& lhs, const Vector3<T>& rhs);
+	Vector3<T> Cross(const Vector3<T>& lhs, const Vector3<T>& rhs);
     template<typename T>
 	Vector2<T> Cross(const Vector4<T>& lhs, const Vector4<T>& rhs);
 
@@ -4845,5 +4846,26 @@ namespace Math
 	using Colour4i = Vector4<uint32_t>;
 	using Color4ib = Vector4<uint32_t>; // Americans
 
+	// Runs batch kernels over threads; see Parallel.h
+	class Executor;
+
+	// Batched double precision kernels, vectorized with AVX when the library is built
+	// with MATH_ENABLE_AVX2. Results match the scalar operators, and every kernel may
+	// be performed in place. Large batches are split into cache-sized chunks that run
+	// in parallel on executor, or on Executor::GetDefault() if it is null.
+	void Add(const Vector4d* lhs, const Vector4d* rhs, Vector4d* out, size_t count, Executor* executor = nullptr);
+	void Subtract(const Vector4d* lhs, const Vector4d* rhs, Vector4d* out, size_t count, Executor* executor = nullptr);
+	void Multiply(const Vector4d* lhs, const Vector4d* rhs, Vector4d* out, size_t count, Executor* executor = nullptr);
+	void Scale(const Vector4d* src, const double scale, Vector4d* out, size_t count, Executor* executor = nullptr);
+	void Dot(const Vector4d* lhs, const Vector4d* rhs, double* out, size_t count, Executor* executor = nullptr);
+	void Normalize(const Vector4d* src, Vector4d* out, size_t count, Executor* executor = nullptr);
+
+	void Add(const Vector3d* lhs, const Vector3d* rhs, Vector3d* out, size_t count, Executor* executor = nullptr);
+	void Subtract(const Vector3d* lhs, const Vector3d* rhs, Vector3d* out, size_t count, Executor* executor = nullptr);
+	void Scale(const Vector3d* src, const double scale, Vector3d* out, size_t count, Executor* executor = nullptr);
+	void Dot(const Vector3d* lhs, const Vector3d* rhs, double* out, size_t count, Executor* executor = nullptr);
+	void Cross(const Vector3d* lhs, const Vector3d* rhs, Vector3d* out, size_t count, Executor* executor = nullptr);
+	void Normalize(const Vector3d* src, Vector3d* out, size_t count, Executor* executor = nullptr);
+
     void VectorTest();
 }
\ No newline at end of file
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <Vector.h>
+#include <Matrix.h>
+
+namespace Math
+{
+	namespace ViewDetail
+	{
+		template <typename T, int N>
+		struct VectorOf;
+
+		template <typename T>
+		struct VectorOf<T, 2>
+		{
+			using Type = Vector2<T>;
+		};
+
+		template <typename T>
+		struct VectorOf<T, 3>
+		{
+			using Type = Vector3<T>;
+		};
+
+		template <typename T>
+		struct VectorOf<T, 4>
+		{
+			using Type = Vector4<T>;
+		};
+
+		template <typename T, int N, StorageOrder Order>
+		struct MatrixOf;
+
+		template <typename T, StorageOrder Order>
+		struct MatrixOf<T, 3, Order>
+		{
+			using Type = Matrix3x3<T, Order>;
+		};
+
+		template <typename T, StorageOrder Order>
+		struct MatrixOf<T, 4, Order>
+		{
+			using Type = Matrix4x4<T, Order>;
+		};
+
+		// Carries the constness of T over to U
+		template <typename T, typename U>
+		using LikeConst = typename std::conditional<std::is_const<T>::value, const U, U>::type;
+	}
+
+	// Non-owning view of a square matrix in external memory, such as mapped GPU staging
+	// memory or a network packet. Element (row, column) is
+	// data[row * rowStride + column * columnStride], with strides counted in elements.
+	// Use a const T for read-only views.
+	template <typename T, int N>
+	class MatrixRef
+	{
+	public:
+		using Scalar = typename std::remove_const<T>::type;
+		using MatrixType = typename ViewDetail::MatrixOf<Scalar, N, StorageOrder::RowMajor>::Type;
+		using ColumnMajorType = typename ViewDetail::MatrixOf<Scalar, N, StorageOrder::ColumnMajor>::Type;
+
+	public:
+		MatrixRef(T* data, const StorageOrder order = StorageOrder::RowMajor)
+			: data(data)
+			, rowStride(order == StorageOrder::RowMajor ? N : 1)
+			, columnStride(order == StorageOrder::RowMajor ? 1 : N)
+		{
+			assert(data != nullptr);
+		}
+
+		MatrixRef(T* data, const size_t rowStride, const size_t columnStride)
+			: data(data)
+			, rowStride(rowStride)
+			, columnStride(columnStride)
+		{
+			assert(data != nullptr);
+		}
+
+		// Views a matrix in place
+		MatrixRef(ViewDetail::LikeConst<T, MatrixType>& m)
+			: MatrixRef(m.Data())
+		{
+		}
+
+		MatrixRef(ViewDetail::LikeConst<T, ColumnMajorType>& m)
+			: MatrixRef(m.Data(), StorageOrder::ColumnMajor)
+		{
+		}
+
+		template <typename U = T, typename = typename std::enable_if<!std::is_const<U>::value>::type>
+		operator MatrixRef<const U, N>() const
+		{
+			return MatrixRef<const U, N>(data, rowStride, columnStride);
+		}
+
+		T& operator()(const int row, const int column) const
+		{
+			assert(row >= 0 && row < N && column >= 0 && column < N);
+			return data[row * rowStride + column * columnStride];
+		}
+
+		T* Data() const
+		{
+			return data;
+		}
+
+		size_t GetRowStride() const
+		{
+			return rowStride;
+		}
+
+		size_t GetColumnStride() const
+		{
+			return columnStride;
+		}
+
+		bool IsRowMajor() const
+		{
+			return rowStride == N && columnStride == 1;
+		}
+
+		MatrixType Load() const
+		{
+			MatrixType m;
+			Scalar* e = m.Data();
+			for (int row = 0; row < N; ++row)
+			{
+				for (int column = 0; column < N; ++column)
+				{
+					e[row * N + column] = (*this)(row, column);
+				}
+			}
+			return m;
+		}
+
+		void Store(const MatrixType& m) const
+		{
+			static_assert(!std::is_const<T>::value, "Cannot store through a read-only view");
+			const Scalar* e = m.Data();
+			for (int row = 0; row < N; ++row)
+			{
+				for (int column = 0; column < N; ++column)
+				{
+					(*this)(row, column) = e[row * N + column];
+				}
+			}
+		}
+
+	private:
+		T* data;
+		size_t rowStride;
+		size_t columnStride;
+	};
+
+	template <typename T>
+	using Matrix3x3Ref = MatrixRef<T, 3>;
+	template <typename T>
+	using Matrix4x4Ref = MatrixRef<T, 4>;
+
+	// Non-owning view of count vectors of N components in external memory. The stride
+	// is in bytes, so a span can pick one attribute out of interleaved vertex data;
+	// it must be a multiple of sizeof(T). Use a const T for read-only spans.
+	template <typename T, int N>
+	class VectorSpan
+	{
+	public:
+		using Scalar = typename std::remove_const<T>::type;
+		using VectorType = typename ViewDetail::VectorOf<Scalar, N>::Type;
+		static constexpr size_t k_packedStride = sizeof(T) * N;
+
+	public:
+		VectorSpan()
+			: data(nullptr)
+			, count(0)
+			, stride(k_packedStride)
+		{
+		}
+
+		VectorSpan(T* data, const size_t count, const size_t stride = k_packedStride)
+			: data(data)
+			, count(count)
+			, stride(stride)
+		{
+			assert(data != nullptr || count == 0);
+			assert(stride >= k_packedStride && stride % sizeof(T) == 0);
+		}
+
+		// Views an array of vectors in place
+		VectorSpan(ViewDetail::LikeConst<T, VectorType>* vectors, const size_t count)
+			: VectorSpan(&vectors->e[0], count)
+		{
+		}
+
+		template <typename U = T, typename = typename std::enable_if<!std::is_const<U>::value>::type>
+		operator VectorSpan<const U, N>() const
+		{
+			return VectorSpan<const U, N>(data, count, stride);
+		}
+
+		// Components of element i
+		T* operator[](const size_t i) const
+		{
+			assert(i < count);
+			return reinterpret_cast<T*>(reinterpret_cast<ViewDetail::LikeConst<T, uint8_t>*>(data) + i * stride);
+		}
+
+		VectorType Load(const size_t i) const
+		{
+			const T* components = (*this)[i];
+			VectorType v;
+			for (int c = 0; c < N; ++c)
+			{
+				v.e[c] = components[c];
+			}
+			return v;
+		}
+
+		void Store(const size_t i, const VectorType& v) const
+		{
+			static_assert(!std::is_const<T>::value, "Cannot store through a read-only span");
+			T* components = (*this)[i];
+			for (int c = 0; c < N; ++c)
+			{
+				components[c] = v.e[c];
+			}
+		}
+
+		VectorSpan Subspan(const size_t first, const size_t n) const
+		{
+			assert(first + n <= count);
+			return VectorSpan(n > 0 ? (*this)[first] : data, n, stride);
+		}
+
+		T* Data() const
+		{
+			return data;
+		}
+
+		size_t Count() const
+		{
+			return count;
+		}
+
+		size_t GetStride() const
+		{
+			return stride;
+		}
+
+		bool IsPacked() const
+		{
+			return stride == k_packedStride;
+		}
+
+	private:
+		T* data;
+		size_t count;
+		size_t stride;
+	};
+
+	// Transform kernels over views, reading and writing external memory in place.
+	// Results match the scalar Matrix4x4 operators. dst must have as many elements as
+	// src, and may alias it only exactly (same data and stride). Long spans are split
+	// into parts that run in parallel on executor.
+
+	// dst[i] = m * src[i]
+	void Transform(const Matrix4x4Ref<const float>& m, const VectorSpan<const float, 4>& src, const VectorSpan<float, 4>& dst, Executor* executor = nullptr);
+	void Transform(const Matrix4x4Ref<const double>& m, const VectorSpan<const double, 4>& src, const VectorSpan<double, 4>& dst, Executor* executor = nullptr);
+
+	// dst[i] = (m * Vector4(src[i], 1)).xyz, without a perspective divide
+	void TransformPoints(const Matrix4x4Ref<const float>& m, const VectorSpan<const float, 3>& src, const VectorSpan<float, 3>& dst, Executor* executor = nullptr);
+	void TransformPoints(const Matrix4x4Ref<const double>& m, const VectorSpan<const double, 3>& src, const VectorSpan<double, 3>& dst, Executor* executor = nullptr);
+
+	// dst[i] = src[i].Normalized()
+	void Normalize(const VectorSpan<const float, 3>& src, const VectorSpan<float, 3>& dst, Executor* executor = nullptr);
+	void Normalize(const VectorSpan<const double, 3>& src, const VectorSpan<double, 3>& dst, Executor* executor = nullptr);
+}